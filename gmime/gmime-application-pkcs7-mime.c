@@ -410,6 +410,11 @@ g_mime_application_pkcs7_mime_encrypt (GMimeObject *entity, GMimeEncryptFlags fl
  * status information as well as a list of recipients that the part was
  * encrypted to.
  *
+ * Note: application/pkcs7-mime content is almost always base64
+ * encoded, so the ciphertext is decoded into a buffer before it is
+ * decrypted. With %GMIME_DECRYPT_SPILL_TO_DISK, that buffer is an
+ * unlinked temporary file when the content is larger than 1 MiB.
+ *
  * Returns: (nullable) (transfer full): the decrypted MIME part on success or
  * %NULL on fail. If the decryption fails, an exception will be set on
  * @err to provide information as to why the failure occurred.
@@ -419,12 +424,10 @@ g_mime_application_pkcs7_mime_decrypt (GMimeApplicationPkcs7Mime *pkcs7_mime,
 				       GMimeDecryptFlags flags, const char *session_key,
 				       GMimeDecryptResult **result, GError **err)
 {
-	GMimeStream *filtered, *ciphertext, *stream;
 	GMimeDataWrapper *content;
 	GMimeCryptoContext *ctx;
 	GMimeDecryptResult *res;
 	GMimeObject *decrypted;
-	GMimeFilter *filter;
 	GMimeParser *parser;
 	
 	g_return_val_if_fail (GMIME_IS_APPLICATION_PKCS7_MIME (pkcs7_mime), NULL);
@@ -439,37 +442,13 @@ g_mime_application_pkcs7_mime_decrypt (GMimeApplicationPkcs7Mime *pkcs7_mime,
 		return NULL;
 	}
 	
-	/* get the ciphertext stream */
+	/* get the cleartext */
 	content = g_mime_part_get_content ((GMimePart *) pkcs7_mime);
-	ciphertext = g_mime_stream_mem_new ();
-	g_mime_data_wrapper_write_to_stream (content, ciphertext);
-	g_mime_stream_reset (ciphertext);
-	
-	stream = g_mime_stream_mem_new ();
-	filtered = g_mime_stream_filter_new (stream);
-	filter = g_mime_filter_dos2unix_new (FALSE);
-	g_mime_stream_filter_add ((GMimeStreamFilter *) filtered, filter);
-	g_object_unref (filter);
-	
-	/* decrypt the content stream */
-	if (!(res = g_mime_crypto_context_decrypt (ctx, flags, session_key, ciphertext, filtered, err))) {
-		g_object_unref (ciphertext);
-		g_object_unref (filtered);
-		g_object_unref (stream);
-		g_object_unref (ctx);
-		
-		return NULL;
-	}
-	
-	g_mime_stream_flush (filtered);
-	g_object_unref (ciphertext);
-	g_object_unref (filtered);
+	parser = _g_mime_crypto_context_decrypt_content (ctx, flags, session_key, content, &res, err);
 	g_object_unref (ctx);
 	
-	g_mime_stream_reset (stream);
-	parser = g_mime_parser_new ();
-	g_mime_parser_init_with_stream (parser, stream);
-	g_object_unref (stream);
+	if (parser == NULL)
+		return NULL;
 	
 	decrypted = g_mime_parser_construct_part (parser, NULL);
 	g_object_unref (parser);
@@ -44,6 +44,7 @@
 #include "gmime-table-private.h"
 #include "gmime-charset.h"
 #include "gmime-iconv.h"
+#include "gmime-internal.h"
 
 #ifdef HAVE_ICONV_DETECT_H
 #include "iconv-detect.h"
@@ -137,6 +138,18 @@ static struct {
 	{ NULL,              NULL         }
 };
 
+/* charset names whose iconv names follow from the rules in
+ * charset_iconv_name_new(); these are resolved once at init so that
+ * the most common lookups are served from the immutable table */
+static const char *rule_based_charsets[] = {
+	"iso-8859-1", "iso-8859-2", "iso-8859-3", "iso-8859-4", "iso-8859-5",
+	"iso-8859-6", "iso-8859-7", "iso-8859-8", "iso-8859-9", "iso-8859-10",
+	"iso-8859-11", "iso-8859-13", "iso-8859-14", "iso-8859-15", "iso-8859-16",
+	"iso-2022-jp", "iso-2022-kr", "windows-1250", "windows-1251", "windows-1252",
+	"windows-1253", "windows-1254", "windows-1255", "windows-1256", "windows-1257",
+	"windows-1258", "shift-jis", "shift_jis", "sjis", NULL
+};
+
 static const char *shiftjis_aliases[] = {
 	"shift-jis", "shift_jis", "sjis", "shift_jis-2004", "shift_jisx0213",
 	"jisx0208.1983-0", "jisx0212.1990-0", "pck", NULL
@@ -166,19 +179,36 @@ static struct {
 	{ "koi8-u",        "uk" }
 };
 
-static GHashTable *iconv_charsets = NULL;
+typedef struct _CharsetAlias {
+	struct _CharsetAlias *next;
+	char *iconv_name;
+	char *name;
+} CharsetAlias;
+
+/* Charset name -> iconv name lookups never take a lock:
+ *
+ * All of the known aliases live in an open-addressed table that is
+ * built by g_mime_charset_map_init() and never modified afterwards.
+ * The hash seed is chosen so that no two known names share a slot,
+ * so a lookup costs one hash and at most one strcmp().
+ *
+ * Names that are not in that table are resolved on first use and
+ * pushed onto one of the overflow buckets with an atomic
+ * compare-and-swap. Entries are never unlinked or freed before
+ * g_mime_charset_map_shutdown(), so readers can walk a bucket without
+ * any synchronization beyond an atomic load of its head. */
+#define KNOWN_CHARSETS_SIZE 512
+#define OVERFLOW_BUCKETS 256
+
+static CharsetAlias known_charsets[KNOWN_CHARSETS_SIZE];
+static guint32 known_charsets_seed = 0;
+static CharsetAlias *overflow_charsets[OVERFLOW_BUCKETS];
+
 static char *locale_charset = NULL;
 static char *locale_lang = NULL;
 static int initialized = 0;
 
-#ifdef G_THREADS_ENABLED
-static GMutex lock;
-#define CHARSET_UNLOCK() g_mutex_unlock (&lock);
-#define CHARSET_LOCK() g_mutex_lock (&lock);
-#else
-#define CHARSET_UNLOCK()
-#define CHARSET_LOCK()
-#endif /* G_THREADS_ENABLED */
+static char *charset_iconv_name_new (const char *name, const char *charset);
 
 
 /**
@@ -189,22 +219,32 @@ static GMutex lock;
 void
 g_mime_charset_map_shutdown (void)
 {
+	CharsetAlias *alias, *next;
+	guint i;
+	
 	if (--initialized)
 		return;
 	
-#ifdef G_THREADS_ENABLED
-	if (glib_check_version (2, 37, 4) == NULL) {
-		/* The implementation of g_mutex_clear() prior
-		 * to glib 2.37.4 did not properly reset the
-		 * internal mutex pointer to NULL, so re-initializing
-		 * GMime would not properly re-initialize the mutexes.
-		 **/
-		g_mutex_clear (&lock);
+	for (i = 0; i < KNOWN_CHARSETS_SIZE; i++) {
+		g_free (known_charsets[i].iconv_name);
+		g_free (known_charsets[i].name);
 	}
-#endif
 	
-	g_hash_table_destroy (iconv_charsets);
-	iconv_charsets = NULL;
+	memset (known_charsets, 0, sizeof (known_charsets));
+	
+	for (i = 0; i < OVERFLOW_BUCKETS; i++) {
+		alias = overflow_charsets[i];
+		
+		while (alias != NULL) {
+			next = alias->next;
+			g_free (alias->iconv_name);
+			g_free (alias->name);
+			g_free (alias);
+			alias = next;
+		}
+		
+		overflow_charsets[i] = NULL;
+	}
 	
 	g_free (locale_charset);
 	locale_charset = NULL;
@@ -255,6 +295,97 @@ locale_parse_lang (const char *locale)
 }
 
 
+static guint32
+charset_hash (guint32 seed, const char *name)
+{
+	register const unsigned char *s = (const unsigned char *) name;
+	guint32 h = 2166136261u ^ seed;
+	
+	/* FNV-1a */
+	while (*s) {
+		h ^= *s++;
+		h *= 16777619u;
+	}
+	
+	/* fold the high bits into the bits used to pick a slot */
+	return h ^ (h >> 15);
+}
+
+static gboolean
+known_charsets_try_seed (guint32 seed, char **names, guint n)
+{
+	guint i, slot;
+	
+	memset (known_charsets, 0, sizeof (known_charsets));
+	
+	for (i = 0; i < n; i++) {
+		slot = charset_hash (seed, names[i]) & (KNOWN_CHARSETS_SIZE - 1);
+		
+		if (known_charsets[slot].name != NULL) {
+			if (strcmp (known_charsets[slot].name, names[i]) != 0)
+				return FALSE;
+			
+			/* a duplicate alias: the first one wins */
+			continue;
+		}
+		
+		known_charsets[slot].name = names[i];
+	}
+	
+	return TRUE;
+}
+
+static void
+known_charsets_init (void)
+{
+	GPtrArray *names, *iconv_names;
+	char *name, *iconv_name;
+	guint32 seed = 0;
+	guint i, slot;
+	
+	names = g_ptr_array_new ();
+	iconv_names = g_ptr_array_new ();
+	
+	for (i = 0; known_iconv_charsets[i].charset != NULL; i++) {
+		/* entries without an iconv name get resolved at runtime */
+		if (known_iconv_charsets[i].iconv_name == NULL)
+			continue;
+		
+		g_ptr_array_add (names, g_ascii_strdown (known_iconv_charsets[i].charset, -1));
+		g_ptr_array_add (iconv_names, g_strdup (known_iconv_charsets[i].iconv_name));
+	}
+	
+	for (i = 0; rule_based_charsets[i] != NULL; i++) {
+		name = (char *) rule_based_charsets[i];
+		g_ptr_array_add (names, g_strdup (name));
+		g_ptr_array_add (iconv_names, charset_iconv_name_new (name, name));
+	}
+	
+	/* find a seed that maps every known name to its own slot */
+	while (!known_charsets_try_seed (seed, (char **) names->pdata, names->len))
+		seed++;
+	
+	known_charsets_seed = seed;
+	
+	for (i = 0; i < names->len; i++) {
+		name = names->pdata[i];
+		iconv_name = iconv_names->pdata[i];
+		
+		slot = charset_hash (seed, name) & (KNOWN_CHARSETS_SIZE - 1);
+		if (known_charsets[slot].name != name) {
+			g_free (iconv_name);
+			g_free (name);
+			continue;
+		}
+		
+		known_charsets[slot].iconv_name = iconv_name;
+	}
+	
+	g_ptr_array_free (iconv_names, TRUE);
+	g_ptr_array_free (names, TRUE);
+}
+
+
 /**
  * g_mime_charset_map_init:
  *
@@ -265,8 +396,6 @@ locale_parse_lang (const char *locale)
 void
 g_mime_charset_map_init (void)
 {
-	char *charset, *iconv_name;
-	int i;
 #ifndef WIN32
 	char *locale;
 #endif
@@ -276,17 +405,7 @@ g_mime_charset_map_init (void)
 	if (initialized++)
 		return;
 	
-#ifdef G_THREADS_ENABLED
-	g_mutex_init (&lock);
-#endif
-	
-	iconv_charsets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
-	
-	for (i = 0; known_iconv_charsets[i].charset != NULL; i++) {
-		charset = g_ascii_strdown (known_iconv_charsets[i].charset, -1);
-		iconv_name = g_strdup (known_iconv_charsets[i].iconv_name);
-		g_hash_table_insert (iconv_charsets, charset, iconv_name);
-	}
+	known_charsets_init ();
 	
 #ifndef WIN32
 #ifdef HAVE_CODESET
@@ -438,33 +557,12 @@ strdown (char *str)
 	return str;
 }
 
-/**
- * g_mime_charset_iconv_name:
- * @charset: charset name
- *
- * Attempts to find an iconv-friendly charset name for @charset.
- *
- * Returns: an iconv-friendly charset name for @charset.
- **/
-const char *
-g_mime_charset_iconv_name (const char *charset)
+/* computes the iconv name for @name, the lowercased form of @charset */
+static char *
+charset_iconv_name_new (const char *name, const char *charset)
 {
-	char *name, *iconv_name, *buf;
-	
-	if (charset == NULL)
-		return NULL;
-	
-	name = g_alloca (strlen (charset) + 1);
-	strcpy (name, charset);
-	strdown (name);
-	
-	CHARSET_LOCK ();
-	
-	iconv_name = g_hash_table_lookup (iconv_charsets, name);
-	if (iconv_name) {
-		CHARSET_UNLOCK ();
-		return iconv_name;
-	}
+	const char *buf;
+	char *iconv_name;
 	
 	if (!strncmp (name, "iso", 3)) {
 		int iso, codepage;
@@ -523,9 +621,86 @@ g_mime_charset_iconv_name (const char *charset)
 		iconv_name = g_strdup (charset);
 	}
 	
-	g_hash_table_insert (iconv_charsets, g_strdup (name), iconv_name);
+	return iconv_name;
+}
+
+static const char *
+known_charsets_lookup (const char *name)
+{
+	guint slot = charset_hash (known_charsets_seed, name) & (KNOWN_CHARSETS_SIZE - 1);
+	
+	if (known_charsets[slot].name && !strcmp (known_charsets[slot].name, name))
+		return known_charsets[slot].iconv_name;
+	
+	return NULL;
+}
+
+static const char *
+overflow_charsets_lookup (CharsetAlias *alias, CharsetAlias *end, const char *name)
+{
+	while (alias != end) {
+		if (!strcmp (alias->name, name))
+			return alias->iconv_name;
+		
+		alias = alias->next;
+	}
+	
+	return NULL;
+}
+
+/**
+ * g_mime_charset_iconv_name:
+ * @charset: charset name
+ *
+ * Attempts to find an iconv-friendly charset name for @charset.
+ *
+ * This function never blocks and is safe to call from any number of
+ * threads at once.
+ *
+ * Returns: an iconv-friendly charset name for @charset.
+ **/
+const char *
+g_mime_charset_iconv_name (const char *charset)
+{
+	CharsetAlias *alias, *head, **bucket;
+	const char *iconv_name;
+	char *name;
+	
+	if (charset == NULL)
+		return NULL;
+	
+	name = g_alloca (strlen (charset) + 1);
+	strcpy (name, charset);
+	strdown (name);
+	
+	if ((iconv_name = known_charsets_lookup (name)))
+		return iconv_name;
+	
+	bucket = &overflow_charsets[charset_hash (0, name) & (OVERFLOW_BUCKETS - 1)];
+	head = g_atomic_pointer_get (bucket);
+	
+	if ((iconv_name = overflow_charsets_lookup (head, NULL, name)))
+		return iconv_name;
+	
+	alias = g_new (CharsetAlias, 1);
+	alias->iconv_name = charset_iconv_name_new (name, charset);
+	alias->name = g_strdup (name);
+	
+	do {
+		alias->next = head;
+		
+		if (g_atomic_pointer_compare_and_exchange (bucket, head, alias))
+			return alias->iconv_name;
+		
+		/* another thread got there first; it may have added this very name */
+		alias->next = g_atomic_pointer_get (bucket);
+		iconv_name = overflow_charsets_lookup (alias->next, head, name);
+		head = alias->next;
+	} while (iconv_name == NULL);
 	
-	CHARSET_UNLOCK ();
+	g_free (alias->iconv_name);
+	g_free (alias->name);
+	g_free (alias);
 	
 	return iconv_name;
 }
@@ -863,7 +1038,7 @@ g_mime_charset_can_encode (GMimeCharset *mask, const char *charset, const char *
 	const char *inbuf = text;
 	char out[256], *outbuf;
 	const char *iconv_name;
-	iconv_t cd;
+	GMimeIconv *cd;
 	guint i;
 	
 	if (len == 0)
@@ -903,7 +1078,7 @@ g_mime_charset_can_encode (GMimeCharset *mask, const char *charset, const char *
 	}
 	
 	/* down to the nitty gritty slow and painful way... */
-	if ((cd = g_mime_iconv_open (charset, "UTF-8")) == (iconv_t) -1)
+	if ((cd = _g_mime_iconv_open (charset, "UTF-8")) == NULL)
 		return FALSE;
 	
 	inleft = len;
@@ -913,7 +1088,7 @@ g_mime_charset_can_encode (GMimeCharset *mask, const char *charset, const char *
 		outbuf = out;
 		errno = 0;
 		
-		rc = iconv (cd, (char **) &inbuf, &inleft, &outbuf, &outleft);
+		rc = _g_mime_iconv (cd, (char **) &inbuf, &inleft, &outbuf, &outleft);
 		if (rc == (size_t) -1 && errno != E2BIG)
 			break;
 	} while (inleft > 0);
@@ -923,10 +1098,10 @@ g_mime_charset_can_encode (GMimeCharset *mask, const char *charset, const char *
 		outbuf = out;
 		errno = 0;
 		
-		rc = iconv (cd, NULL, NULL, &outbuf, &outleft);
+		rc = _g_mime_iconv (cd, NULL, NULL, &outbuf, &outleft);
 	}
 	
-	g_mime_iconv_close (cd);
+	_g_mime_iconv_close (cd);
 	
 	return rc != (size_t) -1;
 }
@@ -29,21 +29,94 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
+#ifdef HAVE_SYS_RANDOM_H
+#include <sys/random.h>     /* for getrandom() */
+#endif
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_PTHREAD_ATFORK)
+#include <pthread.h>        /* for pthread_atfork() */
+#endif
 
 #include "gmime-table-private.h"
 #include "gmime-common.h"
 
-void
-g_mime_read_random_pool (unsigned char *buffer, size_t bytes)
-{
 #ifdef __unix__
+#define RANDOM_POOL_SIZE 512
+
+typedef struct {
+	guint generation;
+	size_t index;
+	size_t length;
+	unsigned char buffer[RANDOM_POOL_SIZE];
+} RandomPool;
+
+static void
+random_pool_free (gpointer data)
+{
+	RandomPool *pool = data;
+	
+	memset (pool, 0, sizeof (RandomPool));
+	g_free (pool);
+}
+
+static GPrivate random_pool = G_PRIVATE_INIT (random_pool_free);
+
+#if defined (HAVE_PTHREAD_H) && defined (HAVE_PTHREAD_ATFORK)
+/* bumped in the child after every fork() so that pools inherited from
+ * the parent get discarded instead of handing out the same bytes */
+static volatile guint fork_generation = 0;
+
+static void
+random_pool_atfork_child (void)
+{
+	fork_generation++;
+}
+
+static guint
+random_pool_generation (void)
+{
+	static gsize initialized = 0;
+	
+	if (g_once_init_enter (&initialized)) {
+		pthread_atfork (NULL, NULL, random_pool_atfork_child);
+		g_once_init_leave (&initialized, 1);
+	}
+	
+	return fork_generation;
+}
+#else
+static guint
+random_pool_generation (void)
+{
+	return (guint) getpid ();
+}
+#endif
+
+static size_t
+read_random_bytes (unsigned char *buffer, size_t bytes)
+{
 	size_t nread = 0;
 	ssize_t n;
 	int fd;
 	
+#ifdef HAVE_GETRANDOM
+	do {
+		do {
+			n = getrandom (buffer + nread, bytes - nread, 0);
+		} while (n == -1 && errno == EINTR);
+		
+		if (n <= 0)
+			break;
+		
+		nread += n;
+	} while (nread < bytes);
+	
+	if (nread == bytes)
+		return nread;
+#endif
+	
 	if ((fd = open ("/dev/urandom", O_RDONLY)) == -1) {
 		if ((fd = open ("/dev/random", O_RDONLY)) == -1)
-			return;
+			return nread;
 	}
 	
 	do {
@@ -58,6 +131,59 @@ g_mime_read_random_pool (unsigned char *buffer, size_t bytes)
 	} while (nread < bytes);
 	
 	close (fd);
+	
+	return nread;
+}
+#endif /* __unix__ */
+
+void
+g_mime_read_random_pool (unsigned char *buffer, size_t bytes)
+{
+#ifdef __unix__
+	RandomPool *pool;
+	guint generation;
+	size_t n;
+	
+	if (bytes >= RANDOM_POOL_SIZE / 2) {
+		read_random_bytes (buffer, bytes);
+		return;
+	}
+	
+	generation = random_pool_generation ();
+	
+	if (!(pool = g_private_get (&random_pool))) {
+		pool = g_new (RandomPool, 1);
+		pool->generation = generation;
+		pool->length = 0;
+		pool->index = 0;
+		
+		g_private_set (&random_pool, pool);
+	} else if (pool->generation != generation) {
+		/* never hand a forked child the same bytes as its parent */
+		memset (pool->buffer, 0, sizeof (pool->buffer));
+		pool->generation = generation;
+		pool->length = 0;
+		pool->index = 0;
+	}
+	
+	while (bytes > 0) {
+		if (pool->index == pool->length) {
+			pool->length = read_random_bytes (pool->buffer, RANDOM_POOL_SIZE);
+			pool->index = 0;
+			
+			if (pool->length == 0)
+				return;
+		}
+		
+		n = MIN (bytes, pool->length - pool->index);
+		memcpy (buffer, pool->buffer + pool->index, n);
+		
+		/* don't leave consumed bytes lying around */
+		memset (pool->buffer + pool->index, 0, n);
+		pool->index += n;
+		buffer += n;
+		bytes -= n;
+	}
 #else
 	size_t i;
 	
@@ -102,12 +102,12 @@ g_mime_content_type_class_init (GMimeContentTypeClass *klass)
 static void
 g_mime_content_type_init (GMimeContentType *content_type, GMimeContentTypeClass *klass)
 {
-	content_type->changed = g_mime_event_new ((GObject *) content_type);
+	content_type->changed = NULL;
 	content_type->params = g_mime_param_list_new ();
 	content_type->subtype = NULL;
 	content_type->type = NULL;
 	
-	g_mime_event_add (content_type->params->changed, (GMimeEventCallback) param_list_changed, content_type);
+	g_mime_event_add (&content_type->params->changed, content_type->params, (GMimeEventCallback) param_list_changed, content_type);
 }
 
 static void
@@ -130,6 +130,30 @@ param_list_changed (GMimeParamList *list, gpointer args, GMimeContentType *conte
 	g_mime_event_emit (content_type->changed, NULL);
 }
 
+/**
+ * _g_mime_content_type_copy:
+ * @content_type: a #GMimeContentType
+ *
+ * Creates a deep copy of @content_type.
+ *
+ * Returns: (transfer full): a new #GMimeContentType.
+ **/
+GMimeContentType *
+_g_mime_content_type_copy (GMimeContentType *content_type)
+{
+	GMimeContentType *copy;
+	
+	copy = g_object_new (GMIME_TYPE_CONTENT_TYPE, NULL);
+	copy->subtype = g_strdup (content_type->subtype);
+	copy->type = g_strdup (content_type->type);
+	
+	g_object_unref (copy->params);
+	copy->params = _g_mime_param_list_copy (content_type->params);
+	g_mime_event_add (&copy->params->changed, copy->params, (GMimeEventCallback) param_list_changed, copy);
+	
+	return copy;
+}
+
 
 /**
  * g_mime_content_type_new:
@@ -194,13 +218,20 @@ g_mime_content_type_parse (GMimeParserOptions *options, const char *str)
 GMimeContentType *
 _g_mime_content_type_parse (GMimeParserOptions *options, const char *str, gint64 offset)
 {
-	GMimeContentType *content_type;
+	GMimeContentType *content_type, *template;
 	const char *inptr = str;
 	GMimeParamList *params;
 	char *type, *subtype;
 	
 	g_return_val_if_fail (str != NULL, NULL);
 	
+	if ((template = (GMimeContentType *) _g_mime_parser_options_cache_lookup (options, GMIME_TYPE_CONTENT_TYPE, str))) {
+		content_type = _g_mime_content_type_copy (template);
+		g_object_unref (template);
+		
+		return content_type;
+	}
+	
 	if (!g_mime_parse_content_type (&inptr, &type, &subtype)) {
 		_g_mime_parser_options_warn (options, offset, GMIME_WARN_INVALID_CONTENT_TYPE, str);
 		return g_mime_content_type_new ("application", "octet-stream");
@@ -216,11 +247,17 @@ _g_mime_content_type_parse (GMimeParserOptions *options, const char *str, gint64
 		inptr++;
 	
 	if (*inptr++ == ';' && *inptr && (params = _g_mime_param_list_parse (options, inptr, offset))) {
-		g_mime_event_add (params->changed, (GMimeEventCallback) param_list_changed, content_type);
+		g_mime_event_add (&params->changed, params, (GMimeEventCallback) param_list_changed, content_type);
 		g_object_unref (content_type->params);
 		content_type->params = params;
 	}
 	
+	if (g_mime_parser_options_get_header_cache_size (options) > 0) {
+		template = _g_mime_content_type_copy (content_type);
+		_g_mime_parser_options_cache_insert (options, GMIME_TYPE_CONTENT_TYPE, str, (GObject *) template);
+		g_object_unref (template);
+	}
+	
 	return content_type;
 }
 
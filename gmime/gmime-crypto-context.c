@@ -23,12 +23,23 @@
 #include <config.h>
 #endif
 
+#include <glib/gstdio.h>
 #include <string.h>
 
 #include "gmime-crypto-context.h"
+#include "gmime-filter-dos2unix.h"
+#include "gmime-stream-filter.h"
+#include "gmime-stream-mem.h"
+#include "gmime-stream-fs.h"
+#include "gmime-internal.h"
 #include "gmime-common.h"
 #include "gmime-error.h"
 
+/* when GMIME_DECRYPT_SPILL_TO_DISK is set, content larger than this gets
+ * decrypted into an unlinked temporary file, and decrypted leaf parts
+ * larger than this are left there rather than loaded into memory */
+#define DECRYPT_SPILL_THRESHOLD (1024 * 1024)
+
 
 /**
  * SECTION: gmime-crypto-context
@@ -517,6 +528,122 @@ g_mime_crypto_context_decrypt (GMimeCryptoContext *ctx, GMimeDecryptFlags flags,
 	return GMIME_CRYPTO_CONTEXT_GET_CLASS (ctx)->decrypt (ctx, flags, session_key, istream, ostream, err);
 }
 
+static GMimeStream *
+decrypt_stream_new (GMimeDecryptFlags flags, gint64 size)
+{
+	GMimeStream *stream;
+	char *path;
+	int fd;
+	
+	if (!(flags & GMIME_DECRYPT_SPILL_TO_DISK) || (size != -1 && size <= DECRYPT_SPILL_THRESHOLD))
+		return g_mime_stream_mem_new ();
+	
+	if ((fd = g_file_open_tmp ("gmime-XXXXXX", &path, NULL)) == -1)
+		return g_mime_stream_mem_new ();
+	
+	stream = g_mime_stream_fs_new (fd);
+	
+	/* the file only needs to live as long as the stream does */
+	if (g_unlink (path) == -1) {
+		g_object_unref (stream);
+		stream = g_mime_stream_mem_new ();
+	}
+	
+	g_free (path);
+	
+	return stream;
+}
+
+
+/**
+ * _g_mime_crypto_context_decrypt_content:
+ * @ctx: a #GMimeCryptoContext
+ * @flags: a set of #GMimeDecryptFlags
+ * @session_key: (nullable): the session key to use or %NULL
+ * @content: the encrypted content
+ * @result: (out): the #GMimeDecryptResult
+ * @err: a #GError
+ *
+ * Decrypts @content into canonicalized (LF line endings) cleartext
+ * and returns a #GMimeParser that is ready to construct the decrypted
+ * part from it.
+ *
+ * Content that has no transfer encoding is read by the crypto context
+ * straight from its source stream instead of being copied first.
+ * Base64, quoted-printable and uuencoded content (which includes
+ * nearly all application/pkcs7-mime parts) has to be decoded into a
+ * buffer before it can be decrypted.
+ *
+ * If @flags includes %GMIME_DECRYPT_SPILL_TO_DISK and @content is
+ * larger than 1 MiB, that buffer and the cleartext are unlinked
+ * temporary files rather than memory. The decision to keep a decrypted
+ * leaf part on disk is then made for each part: the parser leaves the
+ * content of leaves above the same threshold in the temporary file and
+ * loads the smaller ones into memory.
+ *
+ * Returns: (transfer full): the parser on success or %NULL on error.
+ **/
+GMimeParser *
+_g_mime_crypto_context_decrypt_content (GMimeCryptoContext *ctx, GMimeDecryptFlags flags, const char *session_key,
+					GMimeDataWrapper *content, GMimeDecryptResult **result, GError **err)
+{
+	GMimeStream *ciphertext, *cleartext, *filtered;
+	GMimeDecryptResult *res;
+	GMimeParser *parser;
+	GMimeFilter *filter;
+	
+	switch (content->encoding) {
+	case GMIME_CONTENT_ENCODING_BASE64:
+	case GMIME_CONTENT_ENCODING_QUOTEDPRINTABLE:
+	case GMIME_CONTENT_ENCODING_UUENCODE:
+		ciphertext = decrypt_stream_new (flags, g_mime_stream_length (content->stream));
+		g_mime_data_wrapper_write_to_stream (content, ciphertext);
+		break;
+	default:
+		ciphertext = content->stream;
+		g_object_ref (ciphertext);
+		break;
+	}
+	
+	g_mime_stream_reset (ciphertext);
+	
+	cleartext = decrypt_stream_new (flags, g_mime_stream_length (ciphertext));
+	filtered = g_mime_stream_filter_new (cleartext);
+	filter = g_mime_filter_dos2unix_new (FALSE);
+	g_mime_stream_filter_add ((GMimeStreamFilter *) filtered, filter);
+	g_object_unref (filter);
+	
+	res = g_mime_crypto_context_decrypt (ctx, flags, session_key, ciphertext, filtered, err);
+	
+	if (ciphertext == content->stream)
+		g_mime_stream_reset (ciphertext);
+	g_object_unref (ciphertext);
+	
+	if (res == NULL) {
+		g_object_unref (filtered);
+		g_object_unref (cleartext);
+		
+		return NULL;
+	}
+	
+	g_mime_stream_flush (filtered);
+	g_object_unref (filtered);
+	
+	g_mime_stream_reset (cleartext);
+	
+	parser = g_mime_parser_new ();
+	g_mime_parser_init_with_stream (parser, cleartext);
+	
+	if (!GMIME_IS_STREAM_MEM (cleartext))
+		_g_mime_parser_set_persist_threshold (parser, DECRYPT_SPILL_THRESHOLD);
+	
+	g_object_unref (cleartext);
+	
+	*result = res;
+	
+	return parser;
+}
+
 
 static int
 crypto_import_keys (GMimeCryptoContext *ctx, GMimeStream *istream, GError **err)
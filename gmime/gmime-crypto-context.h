@@ -81,6 +81,7 @@ typedef GMimeCryptoContext * (* GMimeCryptoContextNewFunc) (void);
  * @GMIME_DECRYPT_NONE: No flags specified.
  * @GMIME_DECRYPT_EXPORT_SESSION_KEY: Export the decryption session-key.
  * @GMIME_DECRYPT_NO_VERIFY: Disable signature verification.
+ * @GMIME_DECRYPT_SPILL_TO_DISK: Allow encrypted content larger than 1 MiB to be decrypted into an unlinked temporary file, leaving decrypted leaf parts above that size on disk instead of in memory.
  * @GMIME_DECRYPT_ENABLE_KEYSERVER_LOOKUPS: Enable OpenPGP keyserver lookups.
  * @GMIME_DECRYPT_ENABLE_ONLINE_CERTIFICATE_CHECKS: Enable CRL and OCSP checks that require network lookups.
  *
@@ -90,6 +91,7 @@ typedef enum {
 	GMIME_DECRYPT_NONE                             = 0,
 	GMIME_DECRYPT_EXPORT_SESSION_KEY               = 1 << 0,
 	GMIME_DECRYPT_NO_VERIFY                        = 1 << 1,
+	GMIME_DECRYPT_SPILL_TO_DISK                    = 1 << 2,
 
 	/* Note: these values must stay in sync with GMimeVerifyFlags */
 	GMIME_DECRYPT_ENABLE_KEYSERVER_LOOKUPS         = 1 << 15,
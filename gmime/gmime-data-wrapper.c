@@ -26,6 +26,7 @@
 #include "gmime-data-wrapper.h"
 #include "gmime-stream-filter.h"
 #include "gmime-filter-basic.h"
+#include "gmime-internal.h"
 
 
 /**
@@ -41,6 +42,13 @@
  **/
 
 
+typedef struct {
+	/* bumped whenever the stream or encoding is replaced */
+	guint generation;
+} GMimeDataWrapperPrivate;
+
+#define GMIME_DATA_WRAPPER_GET_PRIVATE(wrapper) ((GMimeDataWrapperPrivate *) G_STRUCT_MEMBER_P (wrapper, wrapper_private_offset))
+
 static void g_mime_data_wrapper_class_init (GMimeDataWrapperClass *klass);
 static void g_mime_data_wrapper_init (GMimeDataWrapper *wrapper, GMimeDataWrapperClass *klass);
 static void g_mime_data_wrapper_finalize (GObject *object);
@@ -49,6 +57,7 @@ static ssize_t write_to_stream (GMimeDataWrapper *wrapper, GMimeStream *stream);
 
 
 static GObject *parent_class = NULL;
+static gint wrapper_private_offset = 0;
 
 
 GType
@@ -70,6 +79,7 @@ g_mime_data_wrapper_get_type (void)
 		};
 		
 		type = g_type_register_static (G_TYPE_OBJECT, "GMimeDataWrapper", &info, 0);
+		wrapper_private_offset = g_type_add_instance_private (type, sizeof (GMimeDataWrapperPrivate));
 	}
 	
 	return type;
@@ -82,6 +92,7 @@ g_mime_data_wrapper_class_init (GMimeDataWrapperClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	
 	parent_class = g_type_class_ref (G_TYPE_OBJECT);
+	g_type_class_adjust_private_offset (klass, &wrapper_private_offset);
 	
 	object_class->finalize = g_mime_data_wrapper_finalize;
 	
@@ -174,6 +185,7 @@ g_mime_data_wrapper_set_stream (GMimeDataWrapper *wrapper, GMimeStream *stream)
 	if (wrapper->stream)
 		g_object_unref (wrapper->stream);
 	
+	GMIME_DATA_WRAPPER_GET_PRIVATE (wrapper)->generation++;
 	wrapper->stream = stream;
 }
 
@@ -207,6 +219,7 @@ g_mime_data_wrapper_set_encoding (GMimeDataWrapper *wrapper, GMimeContentEncodin
 {
 	g_return_if_fail (GMIME_IS_DATA_WRAPPER (wrapper));
 	
+	GMIME_DATA_WRAPPER_GET_PRIVATE (wrapper)->generation++;
 	wrapper->encoding = encoding;
 }
 
@@ -228,6 +241,23 @@ g_mime_data_wrapper_get_encoding (GMimeDataWrapper *wrapper)
 }
 
 
+/**
+ * _g_mime_data_wrapper_get_generation:
+ * @wrapper: a #GMimeDataWrapper
+ *
+ * Gets a counter that changes every time the stream or the encoding
+ * of @wrapper is replaced, allowing owners to tell whether the
+ * content is still the same as when they last looked at it.
+ *
+ * Returns: the current generation of @wrapper.
+ **/
+guint
+_g_mime_data_wrapper_get_generation (GMimeDataWrapper *wrapper)
+{
+	return GMIME_DATA_WRAPPER_GET_PRIVATE (wrapper)->generation;
+}
+
+
 static ssize_t
 write_to_stream (GMimeDataWrapper *wrapper, GMimeStream *stream)
 {
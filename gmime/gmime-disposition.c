@@ -91,11 +91,11 @@ g_mime_content_disposition_class_init (GMimeContentDispositionClass *klass)
 static void
 g_mime_content_disposition_init (GMimeContentDisposition *disposition, GMimeContentDispositionClass *klass)
 {
-	disposition->changed = g_mime_event_new ((GObject *) disposition);
+	disposition->changed = NULL;
 	disposition->params = g_mime_param_list_new ();
 	disposition->disposition = NULL;
 	
-	g_mime_event_add (disposition->params->changed, (GMimeEventCallback) param_list_changed, disposition);
+	g_mime_event_add (&disposition->params->changed, disposition->params, (GMimeEventCallback) param_list_changed, disposition);
 }
 
 static void
@@ -117,6 +117,29 @@ param_list_changed (GMimeParamList *list, gpointer args, GMimeContentDisposition
 	g_mime_event_emit (disposition->changed, NULL);
 }
 
+/**
+ * _g_mime_content_disposition_copy:
+ * @disposition: a #GMimeContentDisposition
+ *
+ * Creates a deep copy of @disposition.
+ *
+ * Returns: (transfer full): a new #GMimeContentDisposition.
+ **/
+GMimeContentDisposition *
+_g_mime_content_disposition_copy (GMimeContentDisposition *disposition)
+{
+	GMimeContentDisposition *copy;
+	
+	copy = g_object_new (GMIME_TYPE_CONTENT_DISPOSITION, NULL);
+	copy->disposition = g_strdup (disposition->disposition);
+	
+	g_object_unref (copy->params);
+	copy->params = _g_mime_param_list_copy (disposition->params);
+	g_mime_event_add (&copy->params->changed, copy->params, (GMimeEventCallback) param_list_changed, copy);
+	
+	return copy;
+}
+
 
 /**
  * g_mime_content_disposition_new:
@@ -155,7 +178,7 @@ g_mime_content_disposition_parse (GMimeParserOptions *options, const char *str)
 GMimeContentDisposition *
 _g_mime_content_disposition_parse (GMimeParserOptions *options, const char *str, gint64 offset)
 {
-	GMimeContentDisposition *disposition;
+	GMimeContentDisposition *disposition, *template;
 	const char *inptr = str;
 	GMimeParamList *params;
 	char *value;
@@ -163,6 +186,13 @@ _g_mime_content_disposition_parse (GMimeParserOptions *options, const char *str,
 	if (str == NULL)
 		return g_mime_content_disposition_new ();
 	
+	if ((template = (GMimeContentDisposition *) _g_mime_parser_options_cache_lookup (options, GMIME_TYPE_CONTENT_DISPOSITION, str))) {
+		disposition = _g_mime_content_disposition_copy (template);
+		g_object_unref (template);
+		
+		return disposition;
+	}
+	
 	disposition = g_object_new (GMIME_TYPE_CONTENT_DISPOSITION, NULL);
 	
 	/* get content disposition part */
@@ -176,11 +206,17 @@ _g_mime_content_disposition_parse (GMimeParserOptions *options, const char *str,
 	
 	/* parse the parameters, if any */
 	if (*inptr++ == ';' && *inptr && (params = _g_mime_param_list_parse (options, inptr, offset))) {
-		g_mime_event_add (params->changed, (GMimeEventCallback) param_list_changed, disposition);
+		g_mime_event_add (&params->changed, params, (GMimeEventCallback) param_list_changed, disposition);
 		g_object_unref (disposition->params);
 		disposition->params = params;
 	}
 	
+	if (g_mime_parser_options_get_header_cache_size (options) > 0) {
+		template = _g_mime_content_disposition_copy (disposition);
+		_g_mime_parser_options_cache_insert (options, GMIME_TYPE_CONTENT_DISPOSITION, str, (GObject *) template);
+		g_object_unref (template);
+	}
+	
 	return disposition;
 }
 
@@ -29,6 +29,7 @@
 
 #include "gmime-table-private.h"
 #include "gmime-encodings.h"
+#include "gmime-internal.h"
 
 
 #ifdef ENABLE_WARNINGS
@@ -584,6 +585,106 @@ g_mime_encoding_base64_decode_step (const unsigned char *inbuf, size_t inlen, un
 }
 
 
+/* feeds decoded octets through the same CRLF -> LF conversion as GMimeFilterDos2Unix */
+static inline unsigned char *
+dos2unix_put (unsigned char *outptr, const unsigned char *data, size_t len, char *pc)
+{
+	const unsigned char *dend = data + len;
+
+	while (data < dend) {
+		if (*data != '\n') {
+			if (*pc == '\r')
+				*outptr++ = '\r';
+
+			if (*data != '\r')
+				*outptr++ = *data;
+		} else {
+			*outptr++ = '\n';
+		}
+
+		*pc = (char) *data++;
+	}
+
+	return outptr;
+}
+
+/* Decodes base64 and converts CRLF to LF in a single pass. @pc holds
+ * the GMimeFilterDos2Unix state: the last decoded octet, where a
+ * trailing CR is held back until we know whether a LF follows it.
+ *
+ * The output never gets more than 1 byte ahead of the plain decoder,
+ * so @outbuf may overlap @inbuf as long as it starts at least 8 bytes
+ * before it. */
+size_t
+_g_mime_encoding_base64_decode_dos2unix_step (const unsigned char *inbuf, size_t inlen, unsigned char *outbuf,
+					      int *state, guint32 *save, char *pc)
+{
+	register const unsigned char *inptr = inbuf;
+	const unsigned char *inend = inptr + inlen;
+	unsigned char *outptr = outbuf;
+	unsigned int saved = *save;
+	unsigned char triplet[3];
+	unsigned char c, rank;
+	int n, eq, eof = 0;
+
+	n = *state;
+
+	/* if n == -1, then it means we've encountered the end of the base64 stream */
+	if (n == -1)
+		return 0;
+
+	while (inptr < inend) {
+		rank = gmime_base64_rank[(c = *inptr++)];
+
+		if (rank != 0xFF) {
+			saved = (saved << 6) | rank;
+			n++;
+
+			if (n == 4) {
+				triplet[0] = saved >> 16;
+				triplet[1] = saved >> 8;
+				triplet[2] = saved;
+				saved = 0;
+				n = 0;
+
+				if (*pc != '\r' && triplet[0] != '\r' && triplet[1] != '\r' && triplet[2] != '\r') {
+					/* common case: nothing to convert */
+					*outptr++ = triplet[0];
+					*outptr++ = triplet[1];
+					*outptr++ = triplet[2];
+					*pc = (char) triplet[2];
+				} else {
+					outptr = dos2unix_put (outptr, triplet, 3, pc);
+				}
+			}
+		} else if (c == '=') {
+			eof = 1;
+			break;
+		}
+	}
+
+	if (eof) {
+		if (n > 1) {
+			eq = 4 - n;
+			saved <<= (6 * eq);
+
+			triplet[0] = saved >> 16;
+			triplet[1] = saved >> 8;
+
+			outptr = dos2unix_put (outptr, triplet, n > 2 ? 2 : 1, pc);
+		}
+
+		n = -1;
+	}
+
+	/* save state */
+	*save = saved;
+	*state = n;
+
+	return (size_t) (outptr - outbuf);
+}
+
+
 /**
  * g_mime_encoding_uuencode_close:
  * @inbuf: input buffer
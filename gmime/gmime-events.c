@@ -17,12 +17,12 @@
  *  Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
  *  02110-1301, USA.
  */
-
-
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
 
+#include <string.h>
+
 #include "gmime-events.h"
 
 typedef struct _EventListener {
@@ -31,67 +31,35 @@ typedef struct _EventListener {
 	int blocked;
 } EventListener;
 
-static EventListener *
-event_listener_new (GMimeEventCallback callback, gpointer user_data)
-{
-	EventListener *listener;
-	
-	listener = g_slice_new (EventListener);
-	listener->user_data = user_data;
-	listener->callback = callback;
-	listener->blocked = 0;
-	
-	return listener;
-}
-
-static void
-event_listener_free (EventListener *listener)
-{
-	g_slice_free (EventListener, listener);
-}
-
 
+/* Note: events are only allocated once the first listener gets added
+ * and the first listener is stored inline, so an object that nobody
+ * listens to costs nothing and the common case of a single listener
+ * costs a single allocation. */
 struct _GMimeEvent {
-	GPtrArray *array;
+	EventListener *listeners;
 	gpointer owner;
-};
-
-
-/**
- * g_mime_event_new:
- * @owner: a pointer to the object owning this event
- *
- * Creates a new #GMimeEvent context.
- *
- * Returns: a newly allocated #GMimeEvent context.
- **/
-GMimeEvent *
-g_mime_event_new (gpointer owner)
-{
-	GMimeEvent *event;
-	
-	event = g_slice_new (GMimeEvent);
-	event->array = g_ptr_array_new ();
-	event->owner = owner;
+	guint length;
+	guint size;
 	
-	return event;
-}
+	EventListener first;
+};
 
 
 /**
  * g_mime_event_free:
- * @event: a #GMimeEvent
+ * @event: (nullable): a #GMimeEvent
  *
  * Frees an event context.
  **/
 void
 g_mime_event_free (GMimeEvent *event)
 {
-	guint i;
+	if (event == NULL)
+		return;
 	
-	for (i = 0; i < event->array->len; i++)
-		event_listener_free (event->array->pdata[i]);
-	g_ptr_array_free (event->array, TRUE);
+	if (event->listeners != &event->first)
+		g_free (event->listeners);
 	
 	g_slice_free (GMimeEvent, event);
 }
@@ -101,12 +69,15 @@ static int
 g_mime_event_index_of (GMimeEvent *event, GMimeEventCallback callback, gpointer user_data)
 {
 	EventListener *listener;
-	int i;
+	guint i;
+	
+	if (event == NULL)
+		return -1;
 	
-	for (i = 0; i < event->array->len; i++) {
-		listener = (EventListener *) event->array->pdata[i];
+	for (i = 0; i < event->length; i++) {
+		listener = &event->listeners[i];
 		if (listener->callback == callback && listener->user_data == user_data)
-			return i;
+			return (int) i;
 	}
 	
 	return -1;
@@ -115,7 +86,7 @@ g_mime_event_index_of (GMimeEvent *event, GMimeEventCallback callback, gpointer
 
 /**
  * g_mime_event_block:
- * @event: a #GMimeEvent
+ * @event: (nullable): a #GMimeEvent
  * @callback: a #GMimeEventCallback
  * @user_data: user context data
  *
@@ -124,20 +95,18 @@ g_mime_event_index_of (GMimeEvent *event, GMimeEventCallback callback, gpointer
 void
 g_mime_event_block (GMimeEvent *event, GMimeEventCallback callback, gpointer user_data)
 {
-	EventListener *listener;
 	int index;
 	
 	if ((index = g_mime_event_index_of (event, callback, user_data)) == -1)
 		return;
 	
-	listener = (EventListener *) event->array->pdata[index];
-	listener->blocked++;
+	event->listeners[index].blocked++;
 }
 
 
 /**
  * g_mime_event_unblock:
- * @event: a #GMimeEvent
+ * @event: (nullable): a #GMimeEvent
  * @callback: a #GMimeEventCallback
  * @user_data: user context data
  *
@@ -147,39 +116,62 @@ g_mime_event_block (GMimeEvent *event, GMimeEventCallback callback, gpointer use
 void
 g_mime_event_unblock (GMimeEvent *event, GMimeEventCallback callback, gpointer user_data)
 {
-	EventListener *listener;
 	int index;
 	
 	if ((index = g_mime_event_index_of (event, callback, user_data)) == -1)
 		return;
 	
-	listener = (EventListener *) event->array->pdata[index];
-	listener->blocked--;
+	event->listeners[index].blocked--;
 }
 
 
 /**
  * g_mime_event_add:
- * @event: a #GMimeEvent
+ * @event: a pointer to the (possibly %NULL) #GMimeEvent
+ * @owner: a pointer to the object owning the event
  * @callback: a #GMimeEventCallback
  * @user_data: user context data
  *
  * Adds a callback function that will get called with the specified
- * @user_data whenever @event is emitted.
+ * @user_data whenever the event is emitted. If the event has not
+ * been allocated yet, it will be allocated now.
  **/
 void
-g_mime_event_add (GMimeEvent *event, GMimeEventCallback callback, gpointer user_data)
+g_mime_event_add (gpointer *event, gpointer owner, GMimeEventCallback callback, gpointer user_data)
 {
+	GMimeEvent *evt = *event;
 	EventListener *listener;
 	
-	listener = event_listener_new (callback, user_data);
-	g_ptr_array_add (event->array, listener);
+	if (evt == NULL) {
+		evt = g_slice_new (GMimeEvent);
+		evt->listeners = &evt->first;
+		evt->owner = owner;
+		evt->length = 0;
+		evt->size = 1;
+		*event = evt;
+	}
+	
+	if (evt->length == evt->size) {
+		if (evt->listeners == &evt->first) {
+			evt->listeners = g_new (EventListener, 4);
+			evt->listeners[0] = evt->first;
+			evt->size = 4;
+		} else {
+			evt->size *= 2;
+			evt->listeners = g_renew (EventListener, evt->listeners, evt->size);
+		}
+	}
+	
+	listener = &evt->listeners[evt->length++];
+	listener->user_data = user_data;
+	listener->callback = callback;
+	listener->blocked = 0;
 }
 
 
 /**
  * g_mime_event_remove:
- * @event: a #GMimeEvent
+ * @event: (nullable): a #GMimeEvent
  * @callback: a #GMimeEventCallback
  * @user_data: user context data
  *
@@ -189,21 +181,21 @@ g_mime_event_add (GMimeEvent *event, GMimeEventCallback callback, gpointer user_
 void
 g_mime_event_remove (GMimeEvent *event, GMimeEventCallback callback, gpointer user_data)
 {
-	EventListener *listener;
 	int index;
 	
 	if ((index = g_mime_event_index_of (event, callback, user_data)) == -1)
 		return;
 	
-	listener = (EventListener *) event->array->pdata[index];
-	g_ptr_array_remove_index (event->array, index);
-	event_listener_free (listener);
+	event->length--;
+	
+	if ((guint) index < event->length)
+		memmove (&event->listeners[index], &event->listeners[index + 1], sizeof (EventListener) * (event->length - index));
 }
 
 
 /**
  * g_mime_event_emit:
- * @event: a #GMimeEvent
+ * @event: (nullable): a #GMimeEvent
  * @args: an argument pointer
  *
  * Calls each callback registered with this @event with the specified
@@ -212,12 +204,16 @@ g_mime_event_remove (GMimeEvent *event, GMimeEventCallback callback, gpointer us
 void
 g_mime_event_emit (GMimeEvent *event, gpointer args)
 {
-	EventListener *listener;
+	EventListener listener;
 	guint i;
 	
-	for (i = 0; i < event->array->len; i++) {
-		listener = (EventListener *) event->array->pdata[i];
-		if (listener->blocked <= 0)
-			listener->callback (event->owner, args, listener->user_data);
+	if (event == NULL)
+		return;
+	
+	for (i = 0; i < event->length; i++) {
+		/* Note: copy the listener since the callback may add more listeners */
+		listener = event->listeners[i];
+		if (listener.blocked <= 0)
+			listener.callback (event->owner, args, listener.user_data);
 	}
 }
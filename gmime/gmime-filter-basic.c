@@ -26,6 +26,8 @@
 #include <string.h>
 
 #include "gmime-filter-basic.h"
+#include "gmime-filter-dos2unix.h"
+#include "gmime-internal.h"
 #include "gmime-utils.h"
 
 
@@ -40,6 +42,10 @@
  **/
 
 
+/* how far ahead of the input a decoder's output may start when decoding in place */
+#define BASE64_HEADROOM (4)
+#define FUSED_HEADROOM  (8)
+
 static void g_mime_filter_basic_class_init (GMimeFilterBasicClass *klass);
 static void g_mime_filter_basic_init (GMimeFilterBasic *filter, GMimeFilterBasicClass *klass);
 static void g_mime_filter_basic_finalize (GObject *object);
@@ -126,6 +132,7 @@ filter_filter (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
 	GMimeFilterBasic *basic = (GMimeFilterBasic *) filter;
 	GMimeEncoding *encoder = &basic->encoder;
 	size_t nwritten = 0;
+	char *outptr;
 	size_t len;
 	
 	if (!encoder->encode && encoder->encoding == GMIME_CONTENT_ENCODING_UUENCODE) {
@@ -181,6 +188,15 @@ filter_filter (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
 		}
 	}
 	
+	if (!encoder->encode && encoder->encoding == GMIME_CONTENT_ENCODING_BASE64 &&
+	    (outptr = _g_mime_filter_get_in_place_buffer (filter, inbuf, prespace, BASE64_HEADROOM))) {
+		/* the decoder never writes past the input it has consumed, so decode in place */
+		*outlen = g_mime_encoding_step (encoder, inbuf, inlen, outptr);
+		*outprespace = prespace - BASE64_HEADROOM;
+		*outbuf = outptr;
+		return;
+	}
+	
 	len = g_mime_encoding_outlen (encoder, inlen);
 	g_mime_filter_set_size (filter, len, FALSE);
 	nwritten = g_mime_encoding_step (encoder, inbuf, inlen, filter->outbuf);
@@ -198,6 +214,7 @@ filter_complete (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace
 	GMimeFilterBasic *basic = (GMimeFilterBasic *) filter;
 	GMimeEncoding *encoder = &basic->encoder;
 	size_t nwritten = 0;
+	char *outptr;
 	size_t len;
 	
 	if (!encoder->encode && encoder->encoding == GMIME_CONTENT_ENCODING_UUENCODE) {
@@ -211,6 +228,14 @@ filter_complete (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace
 		}
 	}
 	
+	if (!encoder->encode && encoder->encoding == GMIME_CONTENT_ENCODING_BASE64 &&
+	    (outptr = _g_mime_filter_get_in_place_buffer (filter, inbuf, prespace, BASE64_HEADROOM))) {
+		*outlen = g_mime_encoding_flush (encoder, inbuf, inlen, outptr);
+		*outprespace = prespace - BASE64_HEADROOM;
+		*outbuf = outptr;
+		return;
+	}
+	
 	len = g_mime_encoding_outlen (encoder, inlen);
 	g_mime_filter_set_size (filter, len, FALSE);
 	nwritten = g_mime_encoding_flush (encoder, inbuf, inlen, filter->outbuf);
@@ -256,3 +281,56 @@ g_mime_filter_basic_new (GMimeContentEncoding encoding, gboolean encode)
 	
 	return (GMimeFilter *) basic;
 }
+
+
+/* Whether @filter followed by @next can be run as a single pass by
+ * _g_mime_filter_basic_fused(). Only exact instances qualify so that
+ * subclasses overriding the filter methods keep working. */
+gboolean
+_g_mime_filter_basic_can_fuse (GMimeFilter *filter, GMimeFilter *next)
+{
+	GMimeFilterBasic *basic = (GMimeFilterBasic *) filter;
+	
+	if (G_OBJECT_TYPE (filter) != GMIME_TYPE_FILTER_BASIC || G_OBJECT_TYPE (next) != GMIME_TYPE_FILTER_DOS2UNIX)
+		return FALSE;
+	
+	if (basic->encoder.encode || basic->encoder.encoding != GMIME_CONTENT_ENCODING_BASE64)
+		return FALSE;
+	
+	return filter->backlen == 0 && next->backlen == 0;
+}
+
+
+/* Runs a base64 decoder and the GMimeFilterDos2Unix that follows it
+ * as one filter, without staging the decoded data in between. The
+ * output is identical to running the two filters one after another. */
+void
+_g_mime_filter_basic_fused (GMimeFilter *filter, GMimeFilter *next, char *inbuf, size_t inlen,
+			    size_t prespace, char **outbuf, size_t *outlen, size_t *outprespace,
+			    gboolean writable, gboolean flush)
+{
+	GMimeFilterDos2Unix *dos2unix = (GMimeFilterDos2Unix *) next;
+	GMimeFilterBasic *basic = (GMimeFilterBasic *) filter;
+	GMimeEncoding *encoder = &basic->encoder;
+	unsigned char *outptr;
+	size_t nwritten;
+	
+	if (writable && prespace >= FUSED_HEADROOM) {
+		outptr = (unsigned char *) inbuf - FUSED_HEADROOM;
+		*outprespace = prespace - FUSED_HEADROOM;
+	} else {
+		/* room for a held back CR and a trailing newline */
+		g_mime_filter_set_size (filter, g_mime_encoding_outlen (encoder, inlen) + 2, FALSE);
+		outptr = (unsigned char *) filter->outbuf;
+		*outprespace = filter->outpre;
+	}
+	
+	nwritten = _g_mime_encoding_base64_decode_dos2unix_step ((const unsigned char *) inbuf, inlen, outptr,
+								 &encoder->state, &encoder->save, &dos2unix->pc);
+	
+	if (flush && dos2unix->ensure_newline && dos2unix->pc != '\n')
+		dos2unix->pc = outptr[nwritten++] = '\n';
+	
+	*outbuf = (char *) outptr;
+	*outlen = nwritten;
+}
@@ -28,6 +28,7 @@
 #include "gmime-filter-charset.h"
 #include "gmime-charset.h"
 #include "gmime-iconv.h"
+#include "gmime-internal.h"
 
 
 /**
@@ -41,6 +42,13 @@
  **/
 
 
+typedef struct {
+	/* does the actual conversion; may be a built-in converter */
+	GMimeIconv *converter;
+} GMimeFilterCharsetPrivate;
+
+#define GMIME_FILTER_CHARSET_GET_PRIVATE(filter) ((GMimeFilterCharsetPrivate *) G_STRUCT_MEMBER_P (filter, charset_private_offset))
+
 static void g_mime_filter_charset_class_init (GMimeFilterCharsetClass *klass);
 static void g_mime_filter_charset_init (GMimeFilterCharset *filter, GMimeFilterCharsetClass *klass);
 static void g_mime_filter_charset_finalize (GObject *object);
@@ -54,6 +62,7 @@ static void filter_reset (GMimeFilter *filter);
 
 
 static GMimeFilterClass *parent_class = NULL;
+static gint charset_private_offset = 0;
 
 
 GType
@@ -75,6 +84,7 @@ g_mime_filter_charset_get_type (void)
 		};
 		
 		type = g_type_register_static (GMIME_TYPE_FILTER, "GMimeFilterCharset", &info, 0);
+		charset_private_offset = g_type_add_instance_private (type, sizeof (GMimeFilterCharsetPrivate));
 	}
 	
 	return type;
@@ -88,6 +98,7 @@ g_mime_filter_charset_class_init (GMimeFilterCharsetClass *klass)
 	GMimeFilterClass *filter_class = GMIME_FILTER_CLASS (klass);
 	
 	parent_class = g_type_class_ref (GMIME_TYPE_FILTER);
+	g_type_class_adjust_private_offset (klass, &charset_private_offset);
 	
 	object_class->finalize = g_mime_filter_charset_finalize;
 	
@@ -108,12 +119,19 @@ g_mime_filter_charset_init (GMimeFilterCharset *filter, GMimeFilterCharsetClass
 static void
 g_mime_filter_charset_finalize (GObject *object)
 {
+	GMimeFilterCharsetPrivate *priv = GMIME_FILTER_CHARSET_GET_PRIVATE (object);
 	GMimeFilterCharset *filter = (GMimeFilterCharset *) object;
 	
 	g_free (filter->from_charset);
 	g_free (filter->to_charset);
-	if (filter->cd != (iconv_t) -1)
-		g_mime_iconv_close (filter->cd);
+	
+	if (priv->converter != NULL) {
+		/* a system converter owns the iconv descriptor */
+		if (filter->cd != (iconv_t) -1 && filter->cd != priv->converter->cd)
+			g_mime_iconv_close (filter->cd);
+		
+		_g_mime_iconv_close (priv->converter);
+	}
 	
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -131,12 +149,12 @@ static void
 filter_filter (GMimeFilter *filter, char *in, size_t len, size_t prespace,
 	       char **out, size_t *outlen, size_t *outprespace)
 {
-	GMimeFilterCharset *charset = (GMimeFilterCharset *) filter;
+	GMimeFilterCharsetPrivate *priv = GMIME_FILTER_CHARSET_GET_PRIVATE (filter);
 	size_t inleft, outleft, converted = 0;
 	char *inbuf;
 	char *outbuf;
 	
-	if (charset->cd == (iconv_t) -1)
+	if (priv->converter == NULL)
 		goto noop;
 	
 	g_mime_filter_set_size (filter, len * 5 + 16, FALSE);
@@ -147,7 +165,7 @@ filter_filter (GMimeFilter *filter, char *in, size_t len, size_t prespace,
 	inleft = len;
 	
 	do {
-		converted = iconv (charset->cd, &inbuf, &inleft, &outbuf, &outleft);
+		converted = _g_mime_iconv (priv->converter, &inbuf, &inleft, &outbuf, &outleft);
 		if (converted == (size_t) -1) {
 			if (errno == E2BIG || errno == EINVAL)
 				break;
@@ -198,12 +216,12 @@ static void
 filter_complete (GMimeFilter *filter, char *in, size_t len, size_t prespace,
 		 char **out, size_t *outlen, size_t *outprespace)
 {
-	GMimeFilterCharset *charset = (GMimeFilterCharset *) filter;
+	GMimeFilterCharsetPrivate *priv = GMIME_FILTER_CHARSET_GET_PRIVATE (filter);
 	size_t inleft, outleft, converted = 0;
 	char *inbuf;
 	char *outbuf;
 	
-	if (charset->cd == (iconv_t) -1)
+	if (priv->converter == NULL)
 		goto noop;
 	
 	g_mime_filter_set_size (filter, len * 5 + 16, FALSE);
@@ -215,7 +233,7 @@ filter_complete (GMimeFilter *filter, char *in, size_t len, size_t prespace,
 	
 	if (inleft > 0) {
 		do {
-			converted = iconv (charset->cd, &inbuf, &inleft, &outbuf, &outleft);
+			converted = _g_mime_iconv (priv->converter, &inbuf, &inleft, &outbuf, &outleft);
 			if (converted != (size_t) -1)
 				continue;
 			
@@ -258,7 +276,7 @@ filter_complete (GMimeFilter *filter, char *in, size_t len, size_t prespace,
 	}
 	
 	/* flush the iconv conversion */
-	while (iconv (charset->cd, NULL, NULL, &outbuf, &outleft) == (size_t) -1) {
+	while (_g_mime_iconv (priv->converter, NULL, NULL, &outbuf, &outleft) == (size_t) -1) {
 		if (errno != E2BIG)
 			break;
 		
@@ -284,10 +302,10 @@ filter_complete (GMimeFilter *filter, char *in, size_t len, size_t prespace,
 static void
 filter_reset (GMimeFilter *filter)
 {
-	GMimeFilterCharset *charset = (GMimeFilterCharset *) filter;
+	GMimeFilterCharsetPrivate *priv = GMIME_FILTER_CHARSET_GET_PRIVATE (filter);
 	
-	if (charset->cd != (iconv_t) -1)
-		iconv (charset->cd, NULL, NULL, NULL, NULL);
+	if (priv->converter != NULL)
+		_g_mime_iconv (priv->converter, NULL, NULL, NULL, NULL);
 }
 
 
@@ -304,17 +322,26 @@ filter_reset (GMimeFilter *filter)
 GMimeFilter *
 g_mime_filter_charset_new (const char *from_charset, const char *to_charset)
 {
+	GMimeFilterCharsetPrivate *priv;
 	GMimeFilterCharset *charset;
-	iconv_t cd;
+	GMimeIconv *cd;
 	
-	cd = g_mime_iconv_open (to_charset, from_charset);
-	if (cd == (iconv_t) -1)
+	cd = _g_mime_iconv_open (to_charset, from_charset);
+	if (cd == NULL)
 		return NULL;
 	
 	charset = g_object_new (GMIME_TYPE_FILTER_CHARSET, NULL);
+	priv = GMIME_FILTER_CHARSET_GET_PRIVATE (charset);
 	charset->from_charset = g_strdup (from_charset);
 	charset->to_charset = g_strdup (to_charset);
-	charset->cd = cd;
+	priv->converter = cd;
+	
+	/* the public descriptor always converts between the same charsets,
+	 * even when the filter itself uses a built-in converter */
+	if (cd->mode == GMIME_ICONV_MODE_SYSTEM)
+		charset->cd = cd->cd;
+	else
+		charset->cd = g_mime_iconv_open (to_charset, from_charset);
 	
 	return (GMimeFilter *) charset;
 }
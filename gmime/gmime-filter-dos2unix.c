@@ -23,7 +23,10 @@
 #include <config.h>
 #endif
 
+#include <string.h>
+
 #include "gmime-filter-dos2unix.h"
+#include "gmime-internal.h"
 
 
 /**
@@ -111,37 +114,63 @@ convert (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
 	register const char *inptr = inbuf;
 	const char *inend = inbuf + inlen;
 	size_t expected = inlen;
-	char *outptr;
-	
-	if (flush && dos2unix->ensure_newline)
-		expected++;
-	
-	if (dos2unix->pc == '\r')
-		expected++;
+	char *start, *outptr;
+	const char *cr;
+	size_t n;
 	
-	g_mime_filter_set_size (filter, expected, FALSE);
+	/* the output can only outgrow the input by a held back CR and a
+	 * trailing newline, so given 2 bytes of headroom we can convert
+	 * in place without ever overwriting input we have yet to read */
+	if ((start = _g_mime_filter_get_in_place_buffer (filter, inbuf, prespace, 2))) {
+		*outprespace = prespace - 2;
+	} else {
+		if (flush && dos2unix->ensure_newline)
+			expected++;
+		
+		if (dos2unix->pc == '\r')
+			expected++;
+		
+		g_mime_filter_set_size (filter, expected, FALSE);
+		*outprespace = filter->outpre;
+		start = filter->outbuf;
+	}
 	
-	outptr = filter->outbuf;
+	outptr = start;
 	while (inptr < inend) {
-		if (*inptr == '\n') {
-			*outptr++ = *inptr;
-		} else {
-			if (dos2unix->pc == '\r')
-				*outptr++ = dos2unix->pc;
+		if (dos2unix->pc == '\r') {
+			/* a CR is pending: drop it if it is followed by a LF */
+			if (*inptr != '\n')
+				*outptr++ = '\r';
 			
 			if (*inptr != '\r')
 				*outptr++ = *inptr;
+			
+			dos2unix->pc = *inptr++;
+			continue;
 		}
 		
-		dos2unix->pc = *inptr++;
+		/* everything up to the next CR is copied verbatim */
+		if (!(cr = memchr (inptr, '\r', inend - inptr)))
+			cr = inend;
+		
+		if ((n = cr - inptr) > 0) {
+			memmove (outptr, inptr, n);
+			dos2unix->pc = cr[-1];
+			outptr += n;
+			inptr = cr;
+		}
+		
+		if (inptr < inend) {
+			/* hold on to the CR until we see what follows it */
+			dos2unix->pc = *inptr++;
+		}
 	}
 	
 	if (flush && dos2unix->ensure_newline && dos2unix->pc != '\n')
 		dos2unix->pc = *outptr++ = '\n';
 	
-	*outlen = outptr - filter->outbuf;
-	*outprespace = filter->outpre;
-	*outbuf = filter->outbuf;
+	*outlen = outptr - start;
+	*outbuf = start;
 }
 
 static void
@@ -23,6 +23,8 @@
 #include <config.h>
 #endif
 
+#include <string.h>
+
 #include "gmime-filter-smtp-data.h"
 
 
@@ -105,37 +107,37 @@ filter_filter (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
 	GMimeFilterSmtpData *smtp = (GMimeFilterSmtpData *) filter;
 	register const char *inptr = inbuf;
 	const char *inend = inbuf + inlen;
-	gboolean escape = smtp->bol;
-	int ndots = 0;
+	const char *lf;
 	char *outptr;
+	size_t n;
 	
-	while (inptr < inend) {
-		if (*inptr == '.' && escape) {
-			escape = FALSE;
-			ndots++;
-		} else {
-			escape = *inptr == '\n';
-		}
-		
-		inptr++;
-	}
-	
-	g_mime_filter_set_size (filter, inlen + ndots, FALSE);
+	/* at most every other byte can be a '.' at the start of a line */
+	g_mime_filter_set_size (filter, inlen + (inlen / 2) + 1, FALSE);
 	
 	outptr = filter->outbuf;
-	inptr = inbuf;
+	
+	if (inptr < inend && smtp->bol && *inptr == '.')
+		*outptr++ = '.';
 	
 	while (inptr < inend) {
-		if (*inptr == '.' && smtp->bol) {
-			smtp->bol = FALSE;
-			*outptr++ = '.';
-		} else {
-			smtp->bol = *inptr == '\n';
-		}
+		/* copy everything up to and including the next LF verbatim */
+		if ((lf = memchr (inptr, '\n', inend - inptr)))
+			n = (lf + 1) - inptr;
+		else
+			n = inend - inptr;
+		
+		memcpy (outptr, inptr, n);
+		outptr += n;
+		inptr += n;
 		
-		*outptr++ = *inptr++;
+		/* byte-stuff a '.' at the start of the next line */
+		if (lf != NULL && inptr < inend && *inptr == '.')
+			*outptr++ = '.';
 	}
 	
+	if (inlen > 0)
+		smtp->bol = inend[-1] == '\n';
+	
 	*outlen = outptr - filter->outbuf;
 	*outprespace = filter->outpre;
 	*outbuf = filter->outbuf;
@@ -383,7 +383,7 @@ g_mime_filter_yenc_get_crc (GMimeFilterYenc *yenc)
 }
 
 
-static const int yenc_crc_table[256] = {
+static const guint32 yenc_crc_table[256] = {
 	0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f, 0xe963a535, 0x9e6495a3,
 	0x0edb8832, 0x79dcb8a4, 0xe0d5e91e, 0x97d2d988, 0x09b64c2b, 0x7eb17cbd, 0xe7b82d07, 0x90bf1d91,
 	0x1db71064, 0x6ab020f2, 0xf3b97148, 0x84be41de, 0x1adad47d, 0x6ddde4eb, 0xf4d4b551, 0x83d385c7,
@@ -418,7 +418,77 @@ static const int yenc_crc_table[256] = {
 	0xb3667a2e, 0xc4614ab8, 0x5d681b02, 0x2a6f2b94, 0xb40bbe37, 0xc30c8ea1, 0x5a05df1b, 0x2d02ef8d
 };
 
-#define yenc_crc_add(crc, c) (yenc_crc_table[(((int) (crc)) ^ ((unsigned char) (c))) & 0xff] ^ ((((int) (crc)) >> 8) & 0x00ffffff))
+#define yenc_crc_add(crc, c) (yenc_crc_table[((crc) ^ ((unsigned char) (c))) & 0xff] ^ ((crc) >> 8))
+
+/* slice-by-8 tables: yenc_crc_slice[k][i] is the crc of byte i followed by k zero bytes */
+static guint32 yenc_crc_slice[8][256];
+
+static void
+yenc_crc_slice_init (void)
+{
+	static gsize initialized = 0;
+	guint32 crc;
+	int i, k;
+	
+	if (!g_once_init_enter (&initialized))
+		return;
+	
+	for (i = 0; i < 256; i++) {
+		crc = yenc_crc_slice[0][i] = yenc_crc_table[i];
+		
+		for (k = 1; k < 8; k++) {
+			crc = yenc_crc_add (crc, 0);
+			yenc_crc_slice[k][i] = crc;
+		}
+	}
+	
+	g_once_init_leave (&initialized, 1);
+}
+
+static guint32
+yenc_crc_update (guint32 crc, const unsigned char *inbuf, size_t inlen)
+{
+	register const unsigned char *inptr = inbuf;
+	const unsigned char *inend = inbuf + inlen;
+	
+	if (inlen >= 16) {
+		yenc_crc_slice_init ();
+		
+		/* process 8 bytes per iteration; the byte-wise loads keep this endian-neutral */
+		while (inend - inptr >= 8) {
+			crc ^= ((guint32) inptr[0]) | ((guint32) inptr[1] << 8) |
+				((guint32) inptr[2] << 16) | ((guint32) inptr[3] << 24);
+			
+			crc = yenc_crc_slice[7][crc & 0xff] ^ yenc_crc_slice[6][(crc >> 8) & 0xff] ^
+				yenc_crc_slice[5][(crc >> 16) & 0xff] ^ yenc_crc_slice[4][crc >> 24] ^
+				yenc_crc_slice[3][inptr[4]] ^ yenc_crc_slice[2][inptr[5]] ^
+				yenc_crc_slice[1][inptr[6]] ^ yenc_crc_slice[0][inptr[7]];
+			
+			inptr += 8;
+		}
+	}
+	
+	while (inptr < inend)
+		crc = yenc_crc_add (crc, *inptr++);
+	
+	return crc;
+}
+
+
+/* word-at-a-time helpers used to skip over runs of bytes that need no escaping */
+#define YENC_ONES  G_GUINT64_CONSTANT (0x0101010101010101)
+#define YENC_HIGHS G_GUINT64_CONSTANT (0x8080808080808080)
+#define YENC_42    (YENC_ONES * 42)
+
+/* non-zero if any byte in @x is zero */
+#define yenc_has_zero(x) (((x) - YENC_ONES) & ~(x) & YENC_HIGHS)
+
+/* non-zero if any byte in @x is equal to @c */
+#define yenc_has_byte(x, c) yenc_has_zero ((x) ^ (YENC_ONES * (unsigned char) (c)))
+
+/* add/subtract 42 from every byte in @x (modulo 256) */
+#define yenc_add_42(x) ((((x) & ~YENC_HIGHS) + YENC_42) ^ ((x) & YENC_HIGHS))
+#define yenc_sub_42(x) ((((x) | YENC_HIGHS) - YENC_42) ^ (~(x) & YENC_HIGHS))
 
 #define YENC_NEWLINE_ESCAPE (GMIME_YDECODE_STATE_EOLN | GMIME_YDECODE_STATE_ESCAPE)
 
@@ -452,6 +522,7 @@ g_mime_ydecode_step (const unsigned char *inbuf, size_t inlen, unsigned char *ou
 	register unsigned char *outptr;
 	const unsigned char *inend;
 	unsigned char c;
+	guint64 word;
 	int ystate;
 	
 	if (*state & GMIME_YDECODE_STATE_END)
@@ -464,6 +535,24 @@ g_mime_ydecode_step (const unsigned char *inbuf, size_t inlen, unsigned char *ou
 	
 	inptr = inbuf;
 	while (inptr < inend) {
+		if (!(ystate & YENC_NEWLINE_ESCAPE)) {
+			/* copy runs of 8 bytes that contain neither '=' nor '\n' */
+			while (inend - inptr >= 8) {
+				memcpy (&word, inptr, 8);
+				
+				if (yenc_has_byte (word, '=') || yenc_has_byte (word, '\n'))
+					break;
+				
+				word = yenc_sub_42 (word);
+				memcpy (outptr, &word, 8);
+				outptr += 8;
+				inptr += 8;
+			}
+			
+			if (inptr == inend)
+				break;
+		}
+		
 		c = *inptr++;
 		
 		if ((ystate & YENC_NEWLINE_ESCAPE) == YENC_NEWLINE_ESCAPE) {
@@ -491,12 +580,12 @@ g_mime_ydecode_step (const unsigned char *inbuf, size_t inlen, unsigned char *ou
 		
 		ystate &= ~GMIME_YDECODE_STATE_EOLN;
 		
-		*outptr++ = c -= 42;
-		
-		*pcrc = yenc_crc_add (*pcrc, c);
-		*crc = yenc_crc_add (*crc, c);
+		*outptr++ = c - 42;
 	}
 	
+	*pcrc = yenc_crc_update (*pcrc, outbuf, outptr - outbuf);
+	*crc = yenc_crc_update (*crc, outbuf, outptr - outbuf);
+	
 	*state = ystate;
 	
 	return outptr - outbuf;
@@ -533,6 +622,10 @@ g_mime_yencode_step (const unsigned char *inbuf, size_t inlen, unsigned char *ou
 	const unsigned char *inend;
 	register int already;
 	unsigned char c;
+	guint64 word;
+	
+	*pcrc = yenc_crc_update (*pcrc, inbuf, inlen);
+	*crc = yenc_crc_update (*crc, inbuf, inlen);
 	
 	inend = inbuf + inlen;
 	outptr = outbuf;
@@ -541,12 +634,25 @@ g_mime_yencode_step (const unsigned char *inbuf, size_t inlen, unsigned char *ou
 	
 	inptr = inbuf;
 	while (inptr < inend) {
-		c = *inptr++;
+		/* copy runs of 8 bytes that need no escaping and do not end the line */
+		while (inend - inptr >= 8 && already + 8 < 128) {
+			memcpy (&word, inptr, 8);
+			word = yenc_add_42 (word);
+			
+			if (yenc_has_zero (word) || yenc_has_byte (word, '\t') || yenc_has_byte (word, '\r') ||
+			    yenc_has_byte (word, '\n') || yenc_has_byte (word, '='))
+				break;
+			
+			memcpy (outptr, &word, 8);
+			already += 8;
+			outptr += 8;
+			inptr += 8;
+		}
 		
-		*pcrc = yenc_crc_add (*pcrc, c);
-		*crc = yenc_crc_add (*crc, c);
+		if (inptr == inend)
+			break;
 		
-		c += 42;
+		c = *inptr++ + 42;
 		
 		if (c == '\0' || c == '\t' || c == '\r' || c == '\n' || c == '=') {
 			*outptr++ = '=';
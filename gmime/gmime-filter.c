@@ -26,6 +26,7 @@
 #include <string.h> /* for memcpy */
 
 #include "gmime-filter.h"
+#include "gmime-internal.h"
 
 
 /**
@@ -42,6 +43,9 @@
 struct _GMimeFilterPrivate {
 	char *inbuf;
 	size_t inlen;
+	
+	/* TRUE while the input buffer may be overwritten by the filter */
+	gboolean writable;
 };
 
 #define PRE_HEAD (64)
@@ -158,15 +162,16 @@ g_mime_filter_copy (GMimeFilter *filter)
 
 static void
 filter_run (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
-	    char **outbuf, size_t *outlen, size_t *outprespace,
+	    char **outbuf, size_t *outlen, size_t *outprespace, gboolean writable,
 	    void (*filterfunc) (GMimeFilter *filter,
 				char *inbuf, size_t inlen, size_t prespace,
 				char **outbuf, size_t *outlen, size_t *outprespace))
 {
+	struct _GMimeFilterPrivate *p = _PRIVATE (filter);
+	
 	/* here we take a performance hit, if the input buffer doesn't
 	   have the pre-space required.  We make a buffer that does... */
 	if (prespace < filter->backlen) {
-		struct _GMimeFilterPrivate *p = _PRIVATE (filter);
 		size_t newlen = inlen + prespace + filter->backlen;
 		
 		if (p->inlen < newlen) {
@@ -180,6 +185,9 @@ filter_run (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
 		memcpy (p->inbuf + p->inlen - inlen, inbuf, inlen);
 		inbuf = p->inbuf + p->inlen - inlen;
 		prespace = p->inlen - inlen;
+		
+		/* the copy is ours to scribble on */
+		writable = TRUE;
 	}
 	
 	/* preload any backed up data */
@@ -191,7 +199,9 @@ filter_run (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
 		filter->backlen = 0;
 	}
 	
+	p->writable = writable;
 	filterfunc (filter, inbuf, inlen, prespace, outbuf, outlen, outprespace);
+	p->writable = FALSE;
 }
 
 
@@ -222,7 +232,7 @@ g_mime_filter_filter (GMimeFilter *filter, char *inbuf, size_t inlen, size_t pre
 {
 	g_return_if_fail (GMIME_IS_FILTER (filter));
 	
-	filter_run (filter, inbuf, inlen, prespace, outbuf, outlen, outprespace,
+	filter_run (filter, inbuf, inlen, prespace, outbuf, outlen, outprespace, FALSE,
 		    GMIME_FILTER_GET_CLASS (filter)->filter);
 }
 
@@ -255,11 +265,47 @@ g_mime_filter_complete (GMimeFilter *filter,
 {
 	g_return_if_fail (GMIME_IS_FILTER (filter));
 	
-	filter_run (filter, inbuf, inlen, prespace, outbuf, outlen, outprespace,
+	filter_run (filter, inbuf, inlen, prespace, outbuf, outlen, outprespace, FALSE,
+		    GMIME_FILTER_GET_CLASS (filter)->complete);
+}
+
+
+/* Like g_mime_filter_filter() and g_mime_filter_complete(), but
+ * @writable tells the filter that it may overwrite @inbuf (and its
+ * prespace) with its output instead of copying it into its own
+ * buffer. Used by GMimeStreamFilter when it owns the buffer. */
+void
+_g_mime_filter_filter (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
+		       char **outbuf, size_t *outlen, size_t *outprespace, gboolean writable)
+{
+	filter_run (filter, inbuf, inlen, prespace, outbuf, outlen, outprespace, writable,
+		    GMIME_FILTER_GET_CLASS (filter)->filter);
+}
+
+void
+_g_mime_filter_complete (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
+			 char **outbuf, size_t *outlen, size_t *outprespace, gboolean writable)
+{
+	filter_run (filter, inbuf, inlen, prespace, outbuf, outlen, outprespace, writable,
 		    GMIME_FILTER_GET_CLASS (filter)->complete);
 }
 
 
+/* Returns where a filter may start writing its output in place, or
+ * %NULL if @inbuf may not be overwritten or lacks @headroom bytes of
+ * prespace. The filter must never write past the input it has read. */
+char *
+_g_mime_filter_get_in_place_buffer (GMimeFilter *filter, char *inbuf, size_t prespace, size_t headroom)
+{
+	struct _GMimeFilterPrivate *p = _PRIVATE (filter);
+	
+	if (!p->writable || prespace < headroom)
+		return NULL;
+	
+	return inbuf - headroom;
+}
+
+
 static void
 filter_reset (GMimeFilter *filter)
 {
@@ -45,8 +45,10 @@ struct _GMimeFormatOptions {
 	GMimeNewLineFormat newline;
 	gboolean mixed_charsets;
 	gboolean international;
+	gboolean verbatim;
 	GPtrArray *hidden;
 	guint maxline;
+	guint max_threads;
 };
 
 static GMimeFormatOptions *default_options = NULL;
@@ -109,7 +111,9 @@ g_mime_format_options_new (void)
 	options->hidden = g_ptr_array_new ();
 	options->mixed_charsets = TRUE;
 	options->international = FALSE;
+	options->verbatim = FALSE;
 	options->maxline = 78;
+	options->max_threads = 1;
 	
 	return options;
 }
@@ -138,7 +142,9 @@ _g_mime_format_options_clone (GMimeFormatOptions *options, gboolean hidden)
 	clone->newline = options->newline;
 	clone->mixed_charsets = options->mixed_charsets;
 	clone->international = options->international;
+	clone->verbatim = options->verbatim;
 	clone->maxline = options->newline;
+	clone->max_threads = options->max_threads;
 	
 	clone->hidden = g_ptr_array_new ();
 	
@@ -301,6 +307,116 @@ g_mime_format_options_create_newline_filter (GMimeFormatOptions *options, gboole
 }
 
 
+/**
+ * g_mime_format_options_get_verbatim:
+ * @options: (nullable): a #GMimeFormatOptions or %NULL
+ *
+ * Gets whether or not unmodified parsed content should be written
+ * verbatim.
+ *
+ * Returns: %TRUE if unmodified parsed content should be written verbatim
+ * or %FALSE otherwise.
+ **/
+gboolean
+g_mime_format_options_get_verbatim (GMimeFormatOptions *options)
+{
+	return options ? options->verbatim : default_options->verbatim;
+}
+
+
+/**
+ * g_mime_format_options_set_verbatim:
+ * @options: a #GMimeFormatOptions
+ * @verbatim: %TRUE if unmodified parsed content should be written verbatim
+ *
+ * Sets whether or not the content of parts that have not been modified
+ * since they were parsed should be copied verbatim from the stream they
+ * were parsed from rather than being re-serialized.
+ *
+ * This only applies to objects parsed by a #GMimeParser with
+ * g_mime_parser_set_persist_stream() enabled and is ignored if any
+ * headers are hidden. Note that verbatim content is not subject to the
+ * newline format.
+ **/
+void
+g_mime_format_options_set_verbatim (GMimeFormatOptions *options, gboolean verbatim)
+{
+	g_return_if_fail (options != NULL);
+	
+	options->verbatim = verbatim;
+}
+
+
+/**
+ * _g_mime_format_options_can_write_verbatim:
+ * @options: (nullable): a #GMimeFormatOptions or %NULL
+ *
+ * Gets whether or not unmodified parsed content may be written verbatim
+ * when serializing with @options.
+ *
+ * Returns: %TRUE if unmodified parsed content may be written verbatim.
+ **/
+gboolean
+_g_mime_format_options_can_write_verbatim (GMimeFormatOptions *options)
+{
+	if (options == NULL)
+		options = default_options;
+	
+	return options->verbatim && options->hidden->len == 0;
+}
+
+
+/**
+ * g_mime_format_options_get_max_threads:
+ * @options: (nullable): a #GMimeFormatOptions or %NULL
+ *
+ * Gets the maximum number of threads used to encode the parts of a
+ * multipart.
+ *
+ * Returns: the maximum number of threads, where 1 means that parts are
+ * encoded one after the other.
+ **/
+guint
+g_mime_format_options_get_max_threads (GMimeFormatOptions *options)
+{
+	return options ? options->max_threads : default_options->max_threads;
+}
+
+
+/**
+ * g_mime_format_options_set_max_threads:
+ * @options: a #GMimeFormatOptions
+ * @max_threads: the maximum number of threads or 0 for one per processor
+ *
+ * Sets the maximum number of threads used to encode the parts of a
+ * multipart. When greater than 1, the leaf parts of a multipart whose
+ * content needs to be encoded (e.g. into base64) are serialized
+ * concurrently into temporary memory buffers which are then written
+ * out in order, so the output is identical to that of a serial write.
+ *
+ * Parts are only encoded concurrently if their content streams can be
+ * read independently of each other: content that is a substream of a
+ * shared file stream (as produced by a #GMimeParser with
+ * g_mime_parser_set_persist_stream() enabled) is always encoded
+ * serially. Small parts are also encoded serially.
+ *
+ * g_mime_object_encode() takes no format options, so it uses the
+ * value set on the default options (see
+ * g_mime_format_options_get_default()) to scan the content of such
+ * parts concurrently when picking their Content-Transfer-Encoding.
+ **/
+void
+g_mime_format_options_set_max_threads (GMimeFormatOptions *options, guint max_threads)
+{
+	g_return_if_fail (options != NULL);
+	
+	if (max_threads == 0)
+		max_threads = g_get_num_processors ();
+	
+	options->max_threads = max_threads;
+}
+
+
 #ifdef NOT_YET_IMPLEMENTED
 /**
  * g_mime_format_options_get_allow_mixed_charsets:
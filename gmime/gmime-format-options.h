@@ -89,6 +89,12 @@ void g_mime_format_options_set_newline_format (GMimeFormatOptions *options, GMim
 const char *g_mime_format_options_get_newline (GMimeFormatOptions *options);
 GMimeFilter *g_mime_format_options_create_newline_filter (GMimeFormatOptions *options, gboolean ensure_newline);
 
+gboolean g_mime_format_options_get_verbatim (GMimeFormatOptions *options);
+void g_mime_format_options_set_verbatim (GMimeFormatOptions *options, gboolean verbatim);
+
+guint g_mime_format_options_get_max_threads (GMimeFormatOptions *options);
+void g_mime_format_options_set_max_threads (GMimeFormatOptions *options, guint max_threads);
+
 /*gboolean g_mime_format_options_get_allow_mixed_charsets (GMimeFormatOptions *options);*/
 /*void g_mime_format_options_set_allow_mixed_charsets (GMimeFormatOptions *options, gboolean allow);*/
 
@@ -0,0 +1,1405 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gmime-frozen-message.h"
+#include "gmime-message-part.h"
+#include "gmime-multipart.h"
+#include "gmime-internal.h"
+#include "gmime-error.h"
+#include "gmime-part.h"
+
+
+/**
+ * SECTION: gmime-frozen-message
+ * @title: GMimeFrozenMessage
+ * @short_description: Compact read-only messages
+ * @see_also: #GMimeMessage
+ *
+ * A #GMimeFrozenMessage is an immutable snapshot of a #GMimeMessage
+ * meant for applications that keep large numbers of parsed messages
+ * around for reading only, such as search indexers.
+ *
+ * Instead of a graph of objects, a frozen message is a single block of
+ * memory: every string (header names and values, media types,
+ * parameters, etc) is stored once in a shared string table and the
+ * MIME structure is an array of parts that refer to each other by
+ * index. Part 0 is always the message itself.
+ *
+ * Content is not copied: leaf parts keep a reference to the
+ * #GMimeDataWrapper of the original part, which usually refers to a
+ * range of the stream the message was parsed from.
+ *
+ * Since it is never modified, a #GMimeFrozenMessage may be used from
+ * multiple threads at once. g_mime_frozen_message_thaw() turns it back
+ * into a #GMimeMessage that can be modified.
+ *
+ * The block of memory contains no pointers, so for messages parsed
+ * with g_mime_parser_set_persist_stream() enabled it can also be saved
+ * using g_mime_frozen_message_save() and loaded again, for example
+ * from a memory-mapped cache file, using g_mime_frozen_message_load()
+ * together with the original stream. This avoids parsing the message
+ * again altogether.
+ **/
+
+
+#define NO_STRING G_MAXUINT32
+
+typedef struct {
+	guint32 name;
+	guint32 raw_name;
+	guint32 raw_value;
+	guint32 value;
+	gint64 offset;
+} FrozenHeader;
+
+typedef struct {
+	guint32 name;
+	guint32 value;
+} FrozenParam;
+
+typedef struct {
+	guint32 type;         /* GMimeFrozenPartType */
+	gint32 parent;
+	gint32 first_child;
+	gint32 next_sibling;
+	guint32 first_header;
+	guint32 n_headers;
+	guint32 media_type;
+	guint32 media_subtype;
+	guint32 first_param;
+	guint32 n_params;
+	guint32 disposition;
+	guint32 first_disposition_param;
+	guint32 n_disposition_params;
+	guint32 prologue;     /* mbox marker for messages */
+	guint32 epilogue;
+	gint32 content;
+} FrozenPart;
+
+/* the byte range of a leaf part's content within the source stream */
+typedef struct {
+	gint64 start;
+	gint64 end;
+	guint32 encoding;
+	guint32 reserved;
+} FrozenContent;
+
+/* The block of memory holding a frozen message starts with this header
+ * and is followed by the headers, contents, parts and params arrays
+ * and finally the string table, in that order. Each array starts out
+ * suitably aligned as long as the block itself is 8-byte aligned. The
+ * block contains no pointers, so it doubles as the serialized form. */
+#define FROZEN_MAGIC "GMimeFz"
+#define FROZEN_VERSION 1
+#define FROZEN_BYTE_ORDER 0x01020304
+
+typedef struct {
+	char magic[8];
+	guint32 version;
+	guint32 byte_order;
+	guint32 n_headers;
+	guint32 n_contents;
+	guint32 n_parts;
+	guint32 n_params;
+	guint32 strings_len;
+	guint32 message_id;
+	guint32 subject;
+	guint32 addresses[GMIME_ADDRESS_TYPE_BCC + 1];
+	guint32 reserved;
+} FrozenLayout;
+
+G_STATIC_ASSERT (sizeof (FrozenLayout) % 8 == 0);
+G_STATIC_ASSERT (sizeof (FrozenHeader) % 8 == 0);
+G_STATIC_ASSERT (sizeof (FrozenContent) % 8 == 0);
+G_STATIC_ASSERT (sizeof (FrozenPart) % 8 == 0);
+
+struct _GMimeFrozenMessage {
+	volatile gint ref_count;
+	
+	GBytes *bytes;
+	const FrozenLayout *layout;
+	const FrozenHeader *headers;
+	const FrozenContent *ranges;
+	const FrozenPart *parts;
+	const FrozenParam *params;
+	const char *strings;
+	
+	GMimeDataWrapper **contents;
+	GDateTime *date;
+};
+
+typedef struct {
+	GHashTable *string_hash;
+	GString *strings;
+	GArray *headers;
+	GArray *ranges;
+	GArray *params;
+	GArray *parts;
+	GPtrArray *contents;
+	GMimeStream *source;
+} FrozenBuilder;
+
+G_DEFINE_BOXED_TYPE (GMimeFrozenMessage, g_mime_frozen_message, g_mime_frozen_message_ref, g_mime_frozen_message_unref);
+
+
+static guint32
+builder_add_string (FrozenBuilder *builder, const char *str)
+{
+	gpointer offset;
+	guint32 n;
+	
+	if (str == NULL)
+		return NO_STRING;
+	
+	if (g_hash_table_lookup_extended (builder->string_hash, str, NULL, &offset))
+		return GPOINTER_TO_UINT (offset);
+	
+	n = (guint32) builder->strings->len;
+	g_string_append_len (builder->strings, str, strlen (str) + 1);
+	g_hash_table_insert (builder->string_hash, g_strdup (str), GUINT_TO_POINTER (n));
+	
+	return n;
+}
+
+static void
+builder_add_params (FrozenBuilder *builder, GMimeParamList *list, guint32 *first, guint32 *n)
+{
+	FrozenParam fparam;
+	GMimeParam *param;
+	int count, i;
+	
+	count = list ? g_mime_param_list_length (list) : 0;
+	*first = builder->params->len;
+	*n = (guint32) count;
+	
+	for (i = 0; i < count; i++) {
+		param = g_mime_param_list_get_parameter_at (list, i);
+		fparam.name = builder_add_string (builder, g_mime_param_get_name (param));
+		fparam.value = builder_add_string (builder, g_mime_param_get_value (param));
+		g_array_append_val (builder->params, fparam);
+	}
+}
+
+static void
+builder_add_range (FrozenBuilder *builder, GMimeDataWrapper *content)
+{
+	GMimeStream *stream = g_mime_data_wrapper_get_stream (content);
+	FrozenContent range;
+	
+	range.encoding = (guint32) g_mime_data_wrapper_get_encoding (content);
+	range.reserved = 0;
+	range.start = -1;
+	range.end = -1;
+	
+	/* content that the parser left in the source stream (see
+	 * g_mime_parser_set_persist_stream()) is a substream of it */
+	if (stream != NULL && stream->super_stream != NULL && stream->bound_end != -1) {
+		if (builder->source == NULL)
+			builder->source = stream->super_stream;
+		
+		if (stream->super_stream == builder->source) {
+			range.start = stream->bound_start;
+			range.end = stream->bound_end;
+		}
+	}
+	
+	g_array_append_val (builder->ranges, range);
+}
+
+static int
+builder_add_object (FrozenBuilder *builder, GMimeObject *object, int parent)
+{
+	GMimeContentDisposition *disposition;
+	GMimeContentType *content_type;
+	GMimeDataWrapper *content;
+	FrozenHeader fheader;
+	GMimeObject *child;
+	GMimeHeader *header;
+	FrozenPart fpart;
+	int index, prev, c;
+	int count, i;
+	
+	memset (&fpart, 0, sizeof (fpart));
+	fpart.parent = parent;
+	fpart.first_child = -1;
+	fpart.next_sibling = -1;
+	fpart.prologue = NO_STRING;
+	fpart.epilogue = NO_STRING;
+	fpart.content = -1;
+	
+	count = g_mime_header_list_get_count (object->headers);
+	fpart.first_header = builder->headers->len;
+	fpart.n_headers = (guint32) count;
+	
+	for (i = 0; i < count; i++) {
+		header = g_mime_header_list_get_header_at (object->headers, i);
+		fheader.name = builder_add_string (builder, g_mime_header_get_name (header));
+		fheader.raw_name = builder_add_string (builder, g_mime_header_get_raw_name (header));
+		fheader.raw_value = builder_add_string (builder, g_mime_header_get_raw_value (header));
+		fheader.value = builder_add_string (builder, g_mime_header_get_value (header));
+		fheader.offset = g_mime_header_get_offset (header);
+		g_array_append_val (builder->headers, fheader);
+	}
+	
+	if ((content_type = g_mime_object_get_content_type (object))) {
+		fpart.media_type = builder_add_string (builder, g_mime_content_type_get_media_type (content_type));
+		fpart.media_subtype = builder_add_string (builder, g_mime_content_type_get_media_subtype (content_type));
+		builder_add_params (builder, g_mime_content_type_get_parameters (content_type), &fpart.first_param, &fpart.n_params);
+	} else {
+		fpart.media_type = NO_STRING;
+		fpart.media_subtype = NO_STRING;
+		builder_add_params (builder, NULL, &fpart.first_param, &fpart.n_params);
+	}
+	
+	if ((disposition = g_mime_object_get_content_disposition (object))) {
+		fpart.disposition = builder_add_string (builder, g_mime_content_disposition_get_disposition (disposition));
+		builder_add_params (builder, g_mime_content_disposition_get_parameters (disposition),
+				    &fpart.first_disposition_param, &fpart.n_disposition_params);
+	} else {
+		fpart.disposition = NO_STRING;
+		builder_add_params (builder, NULL, &fpart.first_disposition_param, &fpart.n_disposition_params);
+	}
+	
+	if (GMIME_IS_MESSAGE (object)) {
+		fpart.type = GMIME_FROZEN_PART_MESSAGE;
+		fpart.prologue = builder_add_string (builder, ((GMimeMessage *) object)->marker);
+	} else if (GMIME_IS_MESSAGE_PART (object)) {
+		fpart.type = GMIME_FROZEN_PART_MESSAGE_PART;
+	} else if (GMIME_IS_MULTIPART (object)) {
+		fpart.type = GMIME_FROZEN_PART_MULTIPART;
+		fpart.prologue = builder_add_string (builder, g_mime_multipart_get_prologue ((GMimeMultipart *) object));
+		fpart.epilogue = builder_add_string (builder, g_mime_multipart_get_epilogue ((GMimeMultipart *) object));
+	} else {
+		fpart.type = GMIME_FROZEN_PART_LEAF;
+		
+		if (GMIME_IS_PART (object) && (content = g_mime_part_get_content ((GMimePart *) object))) {
+			fpart.content = builder->contents->len;
+			g_ptr_array_add (builder->contents, g_object_ref (content));
+			builder_add_range (builder, content);
+		}
+	}
+	
+	index = builder->parts->len;
+	g_array_append_val (builder->parts, fpart);
+	
+	/* the parts array may get reallocated while adding the children,
+	 * so the links are always set through g_array_index() */
+	if (GMIME_IS_MESSAGE (object)) {
+		if ((child = g_mime_message_get_mime_part ((GMimeMessage *) object)))
+			g_array_index (builder->parts, FrozenPart, index).first_child = builder_add_object (builder, child, index);
+	} else if (GMIME_IS_MESSAGE_PART (object)) {
+		if ((child = (GMimeObject *) g_mime_message_part_get_message ((GMimeMessagePart *) object)))
+			g_array_index (builder->parts, FrozenPart, index).first_child = builder_add_object (builder, child, index);
+	} else if (GMIME_IS_MULTIPART (object)) {
+		count = g_mime_multipart_get_count ((GMimeMultipart *) object);
+		prev = -1;
+		
+		for (i = 0; i < count; i++) {
+			child = g_mime_multipart_get_part ((GMimeMultipart *) object, i);
+			c = builder_add_object (builder, child, index);
+			
+			if (prev == -1)
+				g_array_index (builder->parts, FrozenPart, index).first_child = c;
+			else
+				g_array_index (builder->parts, FrozenPart, prev).next_sibling = c;
+			
+			prev = c;
+		}
+	}
+	
+	return index;
+}
+
+
+#define STRING(frozen, offset) ((offset) != NO_STRING ? (frozen)->strings + (offset) : NULL)
+
+/* points the arrays of @frozen into its block, which must already have
+ * been validated */
+static void
+frozen_message_attach (GMimeFrozenMessage *frozen, GBytes *bytes)
+{
+	const FrozenLayout *layout;
+	const char *block;
+	
+	block = g_bytes_get_data (bytes, NULL);
+	layout = (const FrozenLayout *) block;
+	block += sizeof (FrozenLayout);
+	
+	frozen->headers = (const FrozenHeader *) block;
+	block += layout->n_headers * sizeof (FrozenHeader);
+	
+	frozen->ranges = (const FrozenContent *) block;
+	block += layout->n_contents * sizeof (FrozenContent);
+	
+	frozen->parts = (const FrozenPart *) block;
+	block += layout->n_parts * sizeof (FrozenPart);
+	
+	frozen->params = (const FrozenParam *) block;
+	block += layout->n_params * sizeof (FrozenParam);
+	
+	frozen->strings = block;
+	frozen->layout = layout;
+	frozen->bytes = bytes;
+}
+
+static void
+frozen_message_init_date (GMimeFrozenMessage *frozen)
+{
+	const FrozenHeader *header = frozen->headers + frozen->parts[0].first_header;
+	guint32 i;
+	
+	frozen->date = NULL;
+	
+	for (i = 0; i < frozen->parts[0].n_headers; i++, header++) {
+		if (!g_ascii_strcasecmp (frozen->strings + header->name, "Date")) {
+			frozen->date = g_mime_utils_header_decode_date (STRING (frozen, header->raw_value));
+			break;
+		}
+	}
+}
+
+static void
+block_append (char **block, GArray *array)
+{
+	size_t n = array->len * g_array_get_element_size (array);
+	
+	memcpy (*block, array->data, n);
+	*block += n;
+}
+
+
+/**
+ * g_mime_message_freeze:
+ * @message: a #GMimeMessage
+ *
+ * Creates a compact, read-only snapshot of @message and all of its
+ * MIME parts. Later changes to @message do not affect the snapshot.
+ *
+ * Returns: (transfer full): a new #GMimeFrozenMessage.
+ **/
+GMimeFrozenMessage *
+g_mime_message_freeze (GMimeMessage *message)
+{
+	InternetAddressList *list;
+	GMimeFrozenMessage *frozen;
+	FrozenBuilder builder;
+	FrozenLayout layout;
+	char *block, *buf;
+	size_t size;
+	char *str;
+	guint i;
+	
+	g_return_val_if_fail (GMIME_IS_MESSAGE (message), NULL);
+	
+	builder.string_hash = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	builder.strings = g_string_new ("");
+	builder.headers = g_array_new (FALSE, FALSE, sizeof (FrozenHeader));
+	builder.ranges = g_array_new (FALSE, FALSE, sizeof (FrozenContent));
+	builder.params = g_array_new (FALSE, FALSE, sizeof (FrozenParam));
+	builder.parts = g_array_new (FALSE, FALSE, sizeof (FrozenPart));
+	builder.contents = g_ptr_array_new ();
+	builder.source = NULL;
+	
+	builder_add_object (&builder, (GMimeObject *) message, -1);
+	
+	memset (&layout, 0, sizeof (layout));
+	memcpy (layout.magic, FROZEN_MAGIC, sizeof (FROZEN_MAGIC));
+	layout.version = FROZEN_VERSION;
+	layout.byte_order = FROZEN_BYTE_ORDER;
+	
+	for (i = 0; i < G_N_ELEMENTS (layout.addresses); i++) {
+		list = g_mime_message_get_addresses (message, (GMimeAddressType) i);
+		
+		if (list != NULL && internet_address_list_length (list) > 0) {
+			str = internet_address_list_to_string (list, NULL, FALSE);
+			layout.addresses[i] = builder_add_string (&builder, str);
+			g_free (str);
+		} else {
+			layout.addresses[i] = NO_STRING;
+		}
+	}
+	
+	layout.message_id = builder_add_string (&builder, g_mime_message_get_message_id (message));
+	layout.subject = builder_add_string (&builder, g_mime_message_get_subject (message));
+	
+	layout.n_headers = builder.headers->len;
+	layout.n_contents = builder.ranges->len;
+	layout.n_parts = builder.parts->len;
+	layout.n_params = builder.params->len;
+	layout.strings_len = builder.strings->len;
+	
+	size = sizeof (FrozenLayout);
+	size += layout.n_headers * sizeof (FrozenHeader);
+	size += layout.n_contents * sizeof (FrozenContent);
+	size += layout.n_parts * sizeof (FrozenPart);
+	size += layout.n_params * sizeof (FrozenParam);
+	size += layout.strings_len;
+	
+	buf = block = g_malloc (size);
+	memcpy (block, &layout, sizeof (FrozenLayout));
+	block += sizeof (FrozenLayout);
+	block_append (&block, builder.headers);
+	block_append (&block, builder.ranges);
+	block_append (&block, builder.parts);
+	block_append (&block, builder.params);
+	memcpy (block, builder.strings->str, builder.strings->len);
+	
+	frozen = g_slice_new (GMimeFrozenMessage);
+	frozen->ref_count = 1;
+	
+	frozen_message_attach (frozen, g_bytes_new_take (buf, size));
+	frozen_message_init_date (frozen);
+	
+	frozen->contents = g_new (GMimeDataWrapper *, builder.contents->len + 1);
+	memcpy (frozen->contents, builder.contents->pdata, builder.contents->len * sizeof (GMimeDataWrapper *));
+	
+	g_hash_table_destroy (builder.string_hash);
+	g_string_free (builder.strings, TRUE);
+	g_array_free (builder.headers, TRUE);
+	g_array_free (builder.ranges, TRUE);
+	g_array_free (builder.params, TRUE);
+	g_array_free (builder.parts, TRUE);
+	g_ptr_array_free (builder.contents, TRUE);
+	
+	return frozen;
+}
+
+
+/**
+ * g_mime_frozen_message_save:
+ * @frozen: a #GMimeFrozenMessage
+ * @err: a #GError
+ *
+ * Gets the serialized form of @frozen: a compact, versioned binary
+ * description of the message structure (the headers with their raw
+ * values and offsets, the Content-Type and Content-Disposition
+ * parameters and the byte range of each part's content within the
+ * source stream) that can be written to disk and later passed to
+ * g_mime_frozen_message_load() along with the source stream to
+ * rebuild the message without parsing it again.
+ *
+ * This is only possible if the message was parsed with
+ * g_mime_parser_set_persist_stream() enabled on a seekable stream,
+ * since otherwise the content of the parts is not a range of the
+ * source stream.
+ *
+ * The data uses the byte order of the host and may be mapped into
+ * memory directly when loading it.
+ *
+ * Returns: (transfer full): the serialized structure or %NULL on error.
+ **/
+GBytes *
+g_mime_frozen_message_save (GMimeFrozenMessage *frozen, GError **err)
+{
+	guint32 i;
+	
+	g_return_val_if_fail (frozen != NULL, NULL);
+	
+	for (i = 0; i < frozen->layout->n_contents; i++) {
+		if (frozen->ranges[i].start == -1) {
+			g_set_error_literal (err, GMIME_ERROR, GMIME_ERROR_NOT_SUPPORTED,
+					     "The content of the message is not a range of the stream it was parsed from.");
+			return NULL;
+		}
+	}
+	
+	return g_bytes_ref (frozen->bytes);
+}
+
+static gboolean
+valid_string (const FrozenLayout *layout, guint32 offset, gboolean nullable)
+{
+	if (offset == NO_STRING)
+		return nullable;
+	
+	return offset < layout->strings_len;
+}
+
+static gboolean
+valid_range (guint32 first, guint32 n, guint32 len)
+{
+	return first <= len && n <= len - first;
+}
+
+static gboolean
+frozen_message_validate (const char *data, size_t size)
+{
+	const FrozenLayout *layout = (const FrozenLayout *) data;
+	const FrozenContent *range;
+	const FrozenPart *parts, *part;
+	const FrozenHeader *header;
+	const FrozenParam *param;
+	gboolean valid = TRUE;
+	const char *strings;
+	guint64 expected;
+	guint8 *linked;
+	guint32 i;
+	
+	if (size < sizeof (FrozenLayout) || memcmp (layout->magic, FROZEN_MAGIC, sizeof (FROZEN_MAGIC)) != 0)
+		return FALSE;
+	
+	if (layout->version != FROZEN_VERSION || layout->byte_order != FROZEN_BYTE_ORDER)
+		return FALSE;
+	
+	expected = sizeof (FrozenLayout);
+	expected += (guint64) layout->n_headers * sizeof (FrozenHeader);
+	expected += (guint64) layout->n_contents * sizeof (FrozenContent);
+	expected += (guint64) layout->n_parts * sizeof (FrozenPart);
+	expected += (guint64) layout->n_params * sizeof (FrozenParam);
+	expected += layout->strings_len;
+	
+	if (expected != size || layout->n_parts == 0 || layout->strings_len == 0)
+		return FALSE;
+	
+	strings = data + size - layout->strings_len;
+	if (strings[layout->strings_len - 1] != '\0')
+		return FALSE;
+	
+	if (!valid_string (layout, layout->message_id, TRUE) ||
+	    !valid_string (layout, layout->subject, TRUE))
+		return FALSE;
+	
+	for (i = 0; i < G_N_ELEMENTS (layout->addresses); i++) {
+		if (!valid_string (layout, layout->addresses[i], TRUE))
+			return FALSE;
+	}
+	
+	header = (const FrozenHeader *) (data + sizeof (FrozenLayout));
+	for (i = 0; i < layout->n_headers; i++, header++) {
+		if (!valid_string (layout, header->name, FALSE) ||
+		    !valid_string (layout, header->raw_name, FALSE) ||
+		    !valid_string (layout, header->raw_value, FALSE) ||
+		    !valid_string (layout, header->value, TRUE))
+			return FALSE;
+	}
+	
+	range = (const FrozenContent *) header;
+	for (i = 0; i < layout->n_contents; i++, range++) {
+		if (range->start < 0 || range->end < range->start || range->encoding > GMIME_CONTENT_ENCODING_UUENCODE)
+			return FALSE;
+	}
+	
+	parts = (const FrozenPart *) range;
+	
+	/* every part but the root must be linked to exactly once, or
+	 * thawing would construct the parts it can reach more than once */
+	linked = g_new0 (guint8, layout->n_parts);
+	
+	for (i = 0; i < layout->n_parts && valid; i++) {
+		part = &parts[i];
+		
+		if (part->type > GMIME_FROZEN_PART_LEAF) {
+			valid = FALSE;
+			break;
+		}
+		
+		/* parts are stored in depth-first order, so links to the
+		 * parent always point backward and the others forward */
+		if ((i == 0 ? part->parent != -1 : (part->parent < 0 || part->parent >= (gint32) i)) ||
+		    (part->first_child != -1 && (part->first_child <= (gint32) i || (guint32) part->first_child >= layout->n_parts)) ||
+		    (part->next_sibling != -1 && (part->next_sibling <= (gint32) i || (guint32) part->next_sibling >= layout->n_parts))) {
+			valid = FALSE;
+			break;
+		}
+		
+		if (part->first_child != -1) {
+			if (linked[part->first_child]++ || parts[part->first_child].parent != (gint32) i)
+				valid = FALSE;
+		}
+		
+		if (part->next_sibling != -1) {
+			if (linked[part->next_sibling]++ || parts[part->next_sibling].parent != part->parent)
+				valid = FALSE;
+		}
+		
+		if (!valid_range (part->first_header, part->n_headers, layout->n_headers) ||
+		    !valid_range (part->first_param, part->n_params, layout->n_params) ||
+		    !valid_range (part->first_disposition_param, part->n_disposition_params, layout->n_params))
+			valid = FALSE;
+		
+		if (!valid_string (layout, part->media_type, TRUE) ||
+		    !valid_string (layout, part->media_subtype, TRUE) ||
+		    !valid_string (layout, part->disposition, TRUE) ||
+		    !valid_string (layout, part->prologue, TRUE) ||
+		    !valid_string (layout, part->epilogue, TRUE))
+			valid = FALSE;
+		
+		if (part->content != -1 && (part->content < 0 || (guint32) part->content >= layout->n_contents))
+			valid = FALSE;
+	}
+	
+	g_free (linked);
+	
+	if (!valid)
+		return FALSE;
+	
+	param = (const FrozenParam *) (parts + layout->n_parts);
+	for (i = 0; i < layout->n_params; i++, param++) {
+		if (!valid_string (layout, param->name, FALSE) || !valid_string (layout, param->value, FALSE))
+			return FALSE;
+	}
+	
+	return TRUE;
+}
+
+
+/**
+ * g_mime_frozen_message_load:
+ * @bytes: the serialized structure of a message
+ * @source: the stream the message was originally parsed from
+ * @err: a #GError
+ *
+ * Loads the structure of a message previously saved using
+ * g_mime_frozen_message_save(). The content of the leaf parts becomes
+ * substreams of @source, which must provide the same data as the
+ * stream that the message was originally parsed from. None of the
+ * content is read.
+ *
+ * When the data in @bytes is suitably aligned (as is the case for
+ * memory allocated with g_malloc() or a file mapped with
+ * g_mapped_file_new()), it is used in place rather than copied.
+ *
+ * Use g_mime_frozen_message_thaw() to turn the result into a
+ * #GMimeMessage.
+ *
+ * Returns: (transfer full): a new #GMimeFrozenMessage or %NULL if
+ * @bytes does not contain a valid message structure.
+ **/
+GMimeFrozenMessage *
+g_mime_frozen_message_load (GBytes *bytes, GMimeStream *source, GError **err)
+{
+	GMimeFrozenMessage *frozen;
+	const FrozenContent *range;
+	GMimeStream *stream;
+	gconstpointer data;
+	size_t size;
+	guint32 i;
+	
+	g_return_val_if_fail (bytes != NULL, NULL);
+	g_return_val_if_fail (GMIME_IS_STREAM (source), NULL);
+	
+	data = g_bytes_get_data (bytes, &size);
+	
+	if (((gsize) data % 8) == 0)
+		bytes = g_bytes_ref (bytes);
+	else
+		bytes = g_bytes_new (data, size);
+	
+	if (!frozen_message_validate (g_bytes_get_data (bytes, NULL), size)) {
+		g_set_error_literal (err, GMIME_ERROR, GMIME_ERROR_PARSE_ERROR,
+				     "Invalid or incompatible message structure.");
+		g_bytes_unref (bytes);
+		return NULL;
+	}
+	
+	frozen = g_slice_new (GMimeFrozenMessage);
+	frozen->ref_count = 1;
+	
+	frozen_message_attach (frozen, bytes);
+	frozen_message_init_date (frozen);
+	
+	frozen->contents = g_new (GMimeDataWrapper *, frozen->layout->n_contents + 1);
+	for (i = 0; i < frozen->layout->n_contents; i++) {
+		range = &frozen->ranges[i];
+		
+		stream = g_mime_stream_substream (source, range->start, range->end);
+		frozen->contents[i] = g_mime_data_wrapper_new_with_stream (stream, (GMimeContentEncoding) range->encoding);
+		g_object_unref (stream);
+	}
+	
+	return frozen;
+}
+
+
+/**
+ * g_mime_frozen_message_ref:
+ * @frozen: a #GMimeFrozenMessage
+ *
+ * Increments the reference count of @frozen.
+ *
+ * Returns: (transfer full): @frozen.
+ **/
+GMimeFrozenMessage *
+g_mime_frozen_message_ref (GMimeFrozenMessage *frozen)
+{
+	g_return_val_if_fail (frozen != NULL, NULL);
+	
+	g_atomic_int_inc (&frozen->ref_count);
+	
+	return frozen;
+}
+
+
+/**
+ * g_mime_frozen_message_unref:
+ * @frozen: a #GMimeFrozenMessage
+ *
+ * Decrements the reference count of @frozen, freeing it once the count
+ * drops to 0.
+ **/
+void
+g_mime_frozen_message_unref (GMimeFrozenMessage *frozen)
+{
+	guint32 i;
+	
+	g_return_if_fail (frozen != NULL);
+	
+	if (!g_atomic_int_dec_and_test (&frozen->ref_count))
+		return;
+	
+	for (i = 0; i < frozen->layout->n_contents; i++)
+		g_object_unref (frozen->contents[i]);
+	g_free (frozen->contents);
+	
+	if (frozen->date)
+		g_date_time_unref (frozen->date);
+	
+	g_bytes_unref (frozen->bytes);
+	g_slice_free (GMimeFrozenMessage, frozen);
+}
+
+
+static const char *
+find_param (GMimeFrozenMessage *frozen, guint32 first, guint32 n, const char *name)
+{
+	const FrozenParam *param = frozen->params + first;
+	guint32 i;
+	
+	for (i = 0; i < n; i++, param++) {
+		if (!g_ascii_strcasecmp (frozen->strings + param->name, name))
+			return STRING (frozen, param->value);
+	}
+	
+	return NULL;
+}
+
+static void
+thaw_headers (GMimeFrozenMessage *frozen, const FrozenPart *fpart, GMimeObject *object)
+{
+	const FrozenHeader *header = frozen->headers + fpart->first_header;
+	guint32 i;
+	
+	_g_mime_object_begin_construct (object);
+	
+	for (i = 0; i < fpart->n_headers; i++, header++) {
+		_g_mime_object_append_header (object, STRING (frozen, header->name), STRING (frozen, header->raw_name),
+					      STRING (frozen, header->raw_value), header->offset);
+	}
+	
+	_g_mime_object_end_construct (object);
+}
+
+static gboolean
+has_header (GMimeFrozenMessage *frozen, const FrozenPart *fpart, const char *name)
+{
+	const FrozenHeader *header = frozen->headers + fpart->first_header;
+	guint32 i;
+	
+	for (i = 0; i < fpart->n_headers; i++, header++) {
+		if (!g_ascii_strcasecmp (frozen->strings + header->name, name))
+			return TRUE;
+	}
+	
+	return FALSE;
+}
+
+static GMimeMessage *thaw_message (GMimeFrozenMessage *frozen, GMimeParserOptions *options, int index);
+
+static GMimeObject *
+thaw_object (GMimeFrozenMessage *frozen, GMimeParserOptions *options, int index)
+{
+	const FrozenPart *fpart = &frozen->parts[index];
+	const char *type = "application", *subtype = "octet-stream";
+	GMimeContentType *content_type;
+	GMimeMessage *message;
+	GMimeObject *object;
+	GMimeObject *child;
+	int i;
+	
+	if (fpart->media_type != NO_STRING && fpart->media_subtype != NO_STRING) {
+		subtype = frozen->strings + fpart->media_subtype;
+		type = frozen->strings + fpart->media_type;
+	}
+	
+	object = g_mime_object_new_type (options, type, subtype);
+	
+	if (!has_header (frozen, fpart, "Content-Type")) {
+		content_type = g_mime_content_type_new (type, subtype);
+		_g_mime_object_set_content_type (object, content_type);
+		g_object_unref (content_type);
+	}
+	
+	thaw_headers (frozen, fpart, object);
+	
+	switch (fpart->type) {
+	case GMIME_FROZEN_PART_MESSAGE_PART:
+		if (fpart->first_child != -1 && GMIME_IS_MESSAGE_PART (object)) {
+			message = thaw_message (frozen, options, fpart->first_child);
+			g_mime_message_part_set_message ((GMimeMessagePart *) object, message);
+			g_object_unref (message);
+		}
+		break;
+	case GMIME_FROZEN_PART_MULTIPART:
+		if (!GMIME_IS_MULTIPART (object))
+			break;
+		
+		g_mime_multipart_set_prologue ((GMimeMultipart *) object, STRING (frozen, fpart->prologue));
+		g_mime_multipart_set_epilogue ((GMimeMultipart *) object, STRING (frozen, fpart->epilogue));
+		
+		for (i = fpart->first_child; i != -1; i = frozen->parts[i].next_sibling) {
+			child = thaw_object (frozen, options, i);
+			g_mime_multipart_add ((GMimeMultipart *) object, child);
+			g_object_unref (child);
+		}
+		break;
+	default:
+		if (fpart->content != -1 && GMIME_IS_PART (object))
+			g_mime_part_set_content ((GMimePart *) object, frozen->contents[fpart->content]);
+		break;
+	}
+	
+	return object;
+}
+
+static GMimeMessage *
+thaw_message (GMimeFrozenMessage *frozen, GMimeParserOptions *options, int index)
+{
+	const FrozenPart *fpart = &frozen->parts[index];
+	GMimeMessage *message;
+	
+	message = g_mime_message_new (FALSE);
+	((GMimeObject *) message)->ensure_newline = FALSE;
+	_g_mime_header_list_set_options (((GMimeObject *) message)->headers, options);
+	message->marker = g_strdup (STRING (frozen, fpart->prologue));
+	
+	thaw_headers (frozen, fpart, (GMimeObject *) message);
+	
+	if (fpart->first_child != -1)
+		message->mime_part = thaw_object (frozen, options, fpart->first_child);
+	
+	return message;
+}
+
+
+/**
+ * g_mime_frozen_message_thaw:
+ * @frozen: a #GMimeFrozenMessage
+ * @options: (nullable): a #GMimeParserOptions or %NULL
+ *
+ * Rebuilds a mutable #GMimeMessage from @frozen. The headers are
+ * restored with their original raw values and offsets and the leaf
+ * parts share their content with the message @frozen was created from.
+ *
+ * Returns: (transfer full): a new #GMimeMessage.
+ **/
+GMimeMessage *
+g_mime_frozen_message_thaw (GMimeFrozenMessage *frozen, GMimeParserOptions *options)
+{
+	g_return_val_if_fail (frozen != NULL, NULL);
+	
+	return thaw_message (frozen, options, 0);
+}
+
+
+/**
+ * g_mime_frozen_message_get_subject:
+ * @frozen: a #GMimeFrozenMessage
+ *
+ * Gets the decoded subject of the message.
+ *
+ * Returns: (nullable): the subject or %NULL if the message has no subject.
+ **/
+const char *
+g_mime_frozen_message_get_subject (GMimeFrozenMessage *frozen)
+{
+	g_return_val_if_fail (frozen != NULL, NULL);
+	
+	return STRING (frozen, frozen->layout->subject);
+}
+
+
+/**
+ * g_mime_frozen_message_get_message_id:
+ * @frozen: a #GMimeFrozenMessage
+ *
+ * Gets the Message-Id of the message, without the angle brackets.
+ *
+ * Returns: (nullable): the Message-Id or %NULL if the message has none.
+ **/
+const char *
+g_mime_frozen_message_get_message_id (GMimeFrozenMessage *frozen)
+{
+	g_return_val_if_fail (frozen != NULL, NULL);
+	
+	return STRING (frozen, frozen->layout->message_id);
+}
+
+
+/**
+ * g_mime_frozen_message_get_date:
+ * @frozen: a #GMimeFrozenMessage
+ *
+ * Gets the parsed Date header of the message.
+ *
+ * Returns: (nullable) (transfer none): the date or %NULL if the message
+ * has no valid Date header.
+ **/
+GDateTime *
+g_mime_frozen_message_get_date (GMimeFrozenMessage *frozen)
+{
+	g_return_val_if_fail (frozen != NULL, NULL);
+	
+	return frozen->date;
+}
+
+
+/**
+ * g_mime_frozen_message_get_addresses:
+ * @frozen: a #GMimeFrozenMessage
+ * @type: a #GMimeAddressType
+ *
+ * Gets the addresses of the given @type as a single decoded string
+ * suitable for displaying or indexing, as returned by
+ * internet_address_list_to_string().
+ *
+ * Returns: (nullable): the addresses or %NULL if there are none.
+ **/
+const char *
+g_mime_frozen_message_get_addresses (GMimeFrozenMessage *frozen, GMimeAddressType type)
+{
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (type <= GMIME_ADDRESS_TYPE_BCC, NULL);
+	
+	return STRING (frozen, frozen->layout->addresses[type]);
+}
+
+
+/**
+ * g_mime_frozen_message_get_part_count:
+ * @frozen: a #GMimeFrozenMessage
+ *
+ * Gets the number of parts in @frozen, including the message itself
+ * which is always part 0.
+ *
+ * Returns: the number of parts.
+ **/
+int
+g_mime_frozen_message_get_part_count (GMimeFrozenMessage *frozen)
+{
+	g_return_val_if_fail (frozen != NULL, -1);
+	
+	return (int) frozen->layout->n_parts;
+}
+
+#define VALID_PART(frozen, part) ((part) >= 0 && (guint) (part) < (frozen)->layout->n_parts)
+
+
+/**
+ * g_mime_frozen_message_get_part_type:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the kind of object that @part was frozen from.
+ *
+ * Returns: the #GMimeFrozenPartType of @part.
+ **/
+GMimeFrozenPartType
+g_mime_frozen_message_get_part_type (GMimeFrozenMessage *frozen, int part)
+{
+	g_return_val_if_fail (frozen != NULL, GMIME_FROZEN_PART_LEAF);
+	g_return_val_if_fail (VALID_PART (frozen, part), GMIME_FROZEN_PART_LEAF);
+	
+	return (GMimeFrozenPartType) frozen->parts[part].type;
+}
+
+
+/**
+ * g_mime_frozen_message_get_parent:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the index of the part that contains @part.
+ *
+ * Returns: the index of the parent of @part or %-1 if @part is the
+ * message itself.
+ **/
+int
+g_mime_frozen_message_get_parent (GMimeFrozenMessage *frozen, int part)
+{
+	g_return_val_if_fail (frozen != NULL, -1);
+	g_return_val_if_fail (VALID_PART (frozen, part), -1);
+	
+	return frozen->parts[part].parent;
+}
+
+
+/**
+ * g_mime_frozen_message_get_first_child:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the index of the first child of @part: the top-level MIME part
+ * of a message, the message contained in a message/rfc822 part or the
+ * first subpart of a multipart.
+ *
+ * Returns: the index of the first child of @part or %-1 if it has none.
+ **/
+int
+g_mime_frozen_message_get_first_child (GMimeFrozenMessage *frozen, int part)
+{
+	g_return_val_if_fail (frozen != NULL, -1);
+	g_return_val_if_fail (VALID_PART (frozen, part), -1);
+	
+	return frozen->parts[part].first_child;
+}
+
+
+/**
+ * g_mime_frozen_message_get_next_sibling:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the index of the subpart that follows @part within the same
+ * multipart.
+ *
+ * Returns: the index of the next sibling of @part or %-1 if it has none.
+ **/
+int
+g_mime_frozen_message_get_next_sibling (GMimeFrozenMessage *frozen, int part)
+{
+	g_return_val_if_fail (frozen != NULL, -1);
+	g_return_val_if_fail (VALID_PART (frozen, part), -1);
+	
+	return frozen->parts[part].next_sibling;
+}
+
+
+/**
+ * g_mime_frozen_message_get_header_count:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the number of headers belonging to @part.
+ *
+ * Returns: the number of headers.
+ **/
+int
+g_mime_frozen_message_get_header_count (GMimeFrozenMessage *frozen, int part)
+{
+	g_return_val_if_fail (frozen != NULL, -1);
+	g_return_val_if_fail (VALID_PART (frozen, part), -1);
+	
+	return (int) frozen->parts[part].n_headers;
+}
+
+
+/**
+ * g_mime_frozen_message_get_header_name:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ * @index: the index of a header
+ *
+ * Gets the name of the header at @index.
+ *
+ * Returns: the header name.
+ **/
+const char *
+g_mime_frozen_message_get_header_name (GMimeFrozenMessage *frozen, int part, int index)
+{
+	const FrozenPart *fpart;
+	
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	
+	fpart = &frozen->parts[part];
+	
+	g_return_val_if_fail (index >= 0 && (guint32) index < fpart->n_headers, NULL);
+	
+	return STRING (frozen, frozen->headers[fpart->first_header + index].name);
+}
+
+
+/**
+ * g_mime_frozen_message_get_header_value:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ * @index: the index of a header
+ *
+ * Gets the unfolded and decoded value of the header at @index.
+ *
+ * Returns: the header value.
+ **/
+const char *
+g_mime_frozen_message_get_header_value (GMimeFrozenMessage *frozen, int part, int index)
+{
+	const FrozenPart *fpart;
+	
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	
+	fpart = &frozen->parts[part];
+	
+	g_return_val_if_fail (index >= 0 && (guint32) index < fpart->n_headers, NULL);
+	
+	return STRING (frozen, frozen->headers[fpart->first_header + index].value);
+}
+
+
+/**
+ * g_mime_frozen_message_get_header:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ * @name: a header name
+ *
+ * Gets the unfolded and decoded value of the first header of @part
+ * named @name.
+ *
+ * Returns: (nullable): the header value or %NULL if @part has no such
+ * header.
+ **/
+const char *
+g_mime_frozen_message_get_header (GMimeFrozenMessage *frozen, int part, const char *name)
+{
+	const FrozenHeader *header;
+	const FrozenPart *fpart;
+	guint32 i;
+	
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+	
+	fpart = &frozen->parts[part];
+	header = frozen->headers + fpart->first_header;
+	
+	for (i = 0; i < fpart->n_headers; i++, header++) {
+		if (!g_ascii_strcasecmp (frozen->strings + header->name, name))
+			return STRING (frozen, header->value);
+	}
+	
+	return NULL;
+}
+
+
+/**
+ * g_mime_frozen_message_get_media_type:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the media type of @part's Content-Type.
+ *
+ * Returns: (nullable): the media type.
+ **/
+const char *
+g_mime_frozen_message_get_media_type (GMimeFrozenMessage *frozen, int part)
+{
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	
+	return STRING (frozen, frozen->parts[part].media_type);
+}
+
+
+/**
+ * g_mime_frozen_message_get_media_subtype:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the media subtype of @part's Content-Type.
+ *
+ * Returns: (nullable): the media subtype.
+ **/
+const char *
+g_mime_frozen_message_get_media_subtype (GMimeFrozenMessage *frozen, int part)
+{
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	
+	return STRING (frozen, frozen->parts[part].media_subtype);
+}
+
+
+/**
+ * g_mime_frozen_message_is_type:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ * @type: MIME type to compare against
+ * @subtype: MIME subtype to compare against
+ *
+ * Compares the Content-Type of @part with the given type and subtype,
+ * the same way as g_mime_content_type_is_type().
+ *
+ * Returns: %TRUE if the Content-Type of @part matches or %FALSE otherwise.
+ **/
+gboolean
+g_mime_frozen_message_is_type (GMimeFrozenMessage *frozen, int part, const char *type, const char *subtype)
+{
+	const FrozenPart *fpart;
+	
+	g_return_val_if_fail (frozen != NULL, FALSE);
+	g_return_val_if_fail (VALID_PART (frozen, part), FALSE);
+	g_return_val_if_fail (type != NULL, FALSE);
+	g_return_val_if_fail (subtype != NULL, FALSE);
+	
+	fpart = &frozen->parts[part];
+	
+	if (fpart->media_type == NO_STRING || fpart->media_subtype == NO_STRING)
+		return FALSE;
+	
+	if (!strcmp (type, "*") || !g_ascii_strcasecmp (frozen->strings + fpart->media_type, type)) {
+		if (!strcmp (subtype, "*"))
+			return TRUE;
+		
+		if (!g_ascii_strcasecmp (frozen->strings + fpart->media_subtype, subtype))
+			return TRUE;
+	}
+	
+	return FALSE;
+}
+
+
+/**
+ * g_mime_frozen_message_get_content_type_parameter:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ * @name: parameter name
+ *
+ * Gets the decoded value of the Content-Type parameter @name of @part.
+ *
+ * Returns: (nullable): the parameter value or %NULL if it is not set.
+ **/
+const char *
+g_mime_frozen_message_get_content_type_parameter (GMimeFrozenMessage *frozen, int part, const char *name)
+{
+	const FrozenPart *fpart;
+	
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+	
+	fpart = &frozen->parts[part];
+	
+	return find_param (frozen, fpart->first_param, fpart->n_params, name);
+}
+
+
+/**
+ * g_mime_frozen_message_get_disposition:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the disposition of @part, such as "inline" or "attachment".
+ *
+ * Returns: (nullable): the disposition or %NULL if @part has no
+ * Content-Disposition.
+ **/
+const char *
+g_mime_frozen_message_get_disposition (GMimeFrozenMessage *frozen, int part)
+{
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	
+	return STRING (frozen, frozen->parts[part].disposition);
+}
+
+
+/**
+ * g_mime_frozen_message_get_disposition_parameter:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ * @name: parameter name
+ *
+ * Gets the decoded value of the Content-Disposition parameter @name of
+ * @part.
+ *
+ * Returns: (nullable): the parameter value or %NULL if it is not set.
+ **/
+const char *
+g_mime_frozen_message_get_disposition_parameter (GMimeFrozenMessage *frozen, int part, const char *name)
+{
+	const FrozenPart *fpart;
+	
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	g_return_val_if_fail (name != NULL, NULL);
+	
+	fpart = &frozen->parts[part];
+	
+	return find_param (frozen, fpart->first_disposition_param, fpart->n_disposition_params, name);
+}
+
+
+/**
+ * g_mime_frozen_message_get_filename:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the filename of @part, the same way as g_mime_part_get_filename():
+ * the "filename" parameter of the Content-Disposition or, failing that,
+ * the "name" parameter of the Content-Type.
+ *
+ * Returns: (nullable): the filename or %NULL if @part has none.
+ **/
+const char *
+g_mime_frozen_message_get_filename (GMimeFrozenMessage *frozen, int part)
+{
+	const char *filename;
+	const FrozenPart *fpart;
+	
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	
+	fpart = &frozen->parts[part];
+	
+	if ((filename = find_param (frozen, fpart->first_disposition_param, fpart->n_disposition_params, "filename")))
+		return filename;
+	
+	return find_param (frozen, fpart->first_param, fpart->n_params, "name");
+}
+
+
+/**
+ * g_mime_frozen_message_get_content:
+ * @frozen: a #GMimeFrozenMessage
+ * @part: the index of a part
+ *
+ * Gets the content of a leaf part.
+ *
+ * Returns: (nullable) (transfer none): the #GMimeDataWrapper of @part
+ * or %NULL if @part has no content.
+ **/
+GMimeDataWrapper *
+g_mime_frozen_message_get_content (GMimeFrozenMessage *frozen, int part)
+{
+	const FrozenPart *fpart;
+	
+	g_return_val_if_fail (frozen != NULL, NULL);
+	g_return_val_if_fail (VALID_PART (frozen, part), NULL);
+	
+	fpart = &frozen->parts[part];
+	
+	return fpart->content != -1 ? frozen->contents[fpart->content] : NULL;
+}
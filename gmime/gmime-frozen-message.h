@@ -0,0 +1,96 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+
+#ifndef __GMIME_FROZEN_MESSAGE_H__
+#define __GMIME_FROZEN_MESSAGE_H__
+
+#include <gmime/gmime-parser-options.h>
+#include <gmime/gmime-data-wrapper.h>
+#include <gmime/gmime-message.h>
+
+G_BEGIN_DECLS
+
+#define GMIME_TYPE_FROZEN_MESSAGE (g_mime_frozen_message_get_type ())
+
+/**
+ * GMimeFrozenPartType:
+ * @GMIME_FROZEN_PART_MESSAGE: A message (the root or the content of a message/rfc822 part).
+ * @GMIME_FROZEN_PART_MESSAGE_PART: A message/rfc822 part. Its only child, if any, is the message it contains.
+ * @GMIME_FROZEN_PART_MULTIPART: A multipart. Its children are the subparts.
+ * @GMIME_FROZEN_PART_LEAF: A leaf part with content.
+ *
+ * The kind of object a part of a #GMimeFrozenMessage was frozen from.
+ **/
+typedef enum {
+	GMIME_FROZEN_PART_MESSAGE,
+	GMIME_FROZEN_PART_MESSAGE_PART,
+	GMIME_FROZEN_PART_MULTIPART,
+	GMIME_FROZEN_PART_LEAF
+} GMimeFrozenPartType;
+
+/**
+ * GMimeFrozenMessage:
+ *
+ * A compact, immutable snapshot of a #GMimeMessage.
+ **/
+typedef struct _GMimeFrozenMessage GMimeFrozenMessage;
+
+GType g_mime_frozen_message_get_type (void) G_GNUC_CONST;
+
+GMimeFrozenMessage *g_mime_message_freeze (GMimeMessage *message);
+GMimeMessage *g_mime_frozen_message_thaw (GMimeFrozenMessage *frozen, GMimeParserOptions *options);
+
+GMimeFrozenMessage *g_mime_frozen_message_ref (GMimeFrozenMessage *frozen);
+void g_mime_frozen_message_unref (GMimeFrozenMessage *frozen);
+
+GBytes *g_mime_frozen_message_save (GMimeFrozenMessage *frozen, GError **err);
+GMimeFrozenMessage *g_mime_frozen_message_load (GBytes *bytes, GMimeStream *source, GError **err);
+
+const char *g_mime_frozen_message_get_subject (GMimeFrozenMessage *frozen);
+const char *g_mime_frozen_message_get_message_id (GMimeFrozenMessage *frozen);
+GDateTime *g_mime_frozen_message_get_date (GMimeFrozenMessage *frozen);
+const char *g_mime_frozen_message_get_addresses (GMimeFrozenMessage *frozen, GMimeAddressType type);
+
+int g_mime_frozen_message_get_part_count (GMimeFrozenMessage *frozen);
+GMimeFrozenPartType g_mime_frozen_message_get_part_type (GMimeFrozenMessage *frozen, int part);
+int g_mime_frozen_message_get_parent (GMimeFrozenMessage *frozen, int part);
+int g_mime_frozen_message_get_first_child (GMimeFrozenMessage *frozen, int part);
+int g_mime_frozen_message_get_next_sibling (GMimeFrozenMessage *frozen, int part);
+
+int g_mime_frozen_message_get_header_count (GMimeFrozenMessage *frozen, int part);
+const char *g_mime_frozen_message_get_header_name (GMimeFrozenMessage *frozen, int part, int index);
+const char *g_mime_frozen_message_get_header_value (GMimeFrozenMessage *frozen, int part, int index);
+const char *g_mime_frozen_message_get_header (GMimeFrozenMessage *frozen, int part, const char *name);
+
+const char *g_mime_frozen_message_get_media_type (GMimeFrozenMessage *frozen, int part);
+const char *g_mime_frozen_message_get_media_subtype (GMimeFrozenMessage *frozen, int part);
+gboolean g_mime_frozen_message_is_type (GMimeFrozenMessage *frozen, int part, const char *type, const char *subtype);
+const char *g_mime_frozen_message_get_content_type_parameter (GMimeFrozenMessage *frozen, int part, const char *name);
+
+const char *g_mime_frozen_message_get_disposition (GMimeFrozenMessage *frozen, int part);
+const char *g_mime_frozen_message_get_disposition_parameter (GMimeFrozenMessage *frozen, int part, const char *name);
+const char *g_mime_frozen_message_get_filename (GMimeFrozenMessage *frozen, int part);
+
+GMimeDataWrapper *g_mime_frozen_message_get_content (GMimeFrozenMessage *frozen, int part);
+
+G_END_DECLS
+
+#endif /* __GMIME_FROZEN_MESSAGE_H__ */
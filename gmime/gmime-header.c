@@ -29,7 +29,6 @@
 #include "gmime-stream-filter.h"
 #include "gmime-table-private.h"
 #include "gmime-parse-utils.h"
-#include "gmime-stream-mem.h"
 #include "internet-address.h"
 #include "gmime-references.h"
 #include "gmime-internal.h"
@@ -78,11 +77,20 @@ static struct {
 };
 
 
+typedef struct {
+	/* the parsed value, cached until the value changes */
+	GMimeHeaderParsedType parsed_type;
+	gpointer parsed;
+} GMimeHeaderPrivate;
+
+#define GMIME_HEADER_GET_PRIVATE(header) ((GMimeHeaderPrivate *) G_STRUCT_MEMBER_P (header, header_private_offset))
+
 static void g_mime_header_class_init (GMimeHeaderClass *klass);
 static void g_mime_header_init (GMimeHeader *header, GMimeHeaderClass *klass);
 static void g_mime_header_finalize (GObject *object);
 
 static GObjectClass *parent_class = NULL;
+static gint header_private_offset = 0;
 
 
 GType
@@ -104,6 +112,7 @@ g_mime_header_get_type (void)
 		};
 		
 		type = g_type_register_static (G_TYPE_OBJECT, "GMimeHeader", &info, 0);
+		header_private_offset = g_type_add_instance_private (type, sizeof (GMimeHeaderPrivate));
 	}
 	
 	return type;
@@ -115,6 +124,7 @@ g_mime_header_class_init (GMimeHeaderClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	
 	parent_class = g_type_class_ref (G_TYPE_OBJECT);
+	g_type_class_adjust_private_offset (klass, &header_private_offset);
 	
 	object_class->finalize = g_mime_header_finalize;
 }
@@ -122,7 +132,7 @@ g_mime_header_class_init (GMimeHeaderClass *klass)
 static void
 g_mime_header_init (GMimeHeader *header, GMimeHeaderClass *klass)
 {
-	header->changed = g_mime_event_new (header);
+	header->changed = NULL;
 	header->formatter = NULL;
 	header->options = NULL;
 	header->reformat = FALSE;
@@ -134,11 +144,37 @@ g_mime_header_init (GMimeHeader *header, GMimeHeaderClass *klass)
 	header->offset = -1;
 }
 
+static void
+header_clear_parsed (GMimeHeader *header)
+{
+	GMimeHeaderPrivate *priv = GMIME_HEADER_GET_PRIVATE (header);
+	
+	switch (priv->parsed_type) {
+	case GMIME_HEADER_PARSED_CONTENT_TYPE:
+	case GMIME_HEADER_PARSED_CONTENT_DISPOSITION:
+	case GMIME_HEADER_PARSED_ADDRESSES:
+		if (priv->parsed)
+			g_object_unref (priv->parsed);
+		break;
+	case GMIME_HEADER_PARSED_DATE:
+		if (priv->parsed)
+			g_date_time_unref (priv->parsed);
+		break;
+	case GMIME_HEADER_PARSED_MESSAGE_ID:
+		g_free (priv->parsed);
+		break;
+	}
+	
+	priv->parsed_type = GMIME_HEADER_PARSED_NONE;
+	priv->parsed = NULL;
+}
+
 static void
 g_mime_header_finalize (GObject *object)
 {
 	GMimeHeader *header = (GMimeHeader *) object;
 	
+	header_clear_parsed (header);
 	g_mime_event_free (header->changed);
 	g_free (header->raw_value);
 	g_free (header->raw_name);
@@ -193,6 +229,11 @@ g_mime_header_new (GMimeParserOptions *options, const char *name, const char *va
 	if (!raw_value && value)
 		header->raw_value = formatter (header, NULL, header->value, charset);
 	
+	GMIME_STATS (_g_mime_stats_record_alloc (GMIME_STATS_SUBSYSTEM_HEADERS, sizeof (GMimeHeader) +
+						 strlen (header->name) + strlen (header->raw_name) + 2 +
+						 (header->raw_value ? strlen (header->raw_value) + 1 : 0) +
+						 (header->value ? strlen (header->value) + 1 : 0)));
+	
 	return header;
 }
 
@@ -231,8 +272,14 @@ g_mime_header_get_value (GMimeHeader *header)
 	
 	if (!header->value && header->raw_value) {
 		buf = g_mime_utils_header_unfold (header->raw_value);
-		header->value = _g_mime_utils_header_decode_text (header->options, buf, NULL, header->offset);
-		g_free (buf);
+		
+		if (!_g_mime_utils_header_is_plain_text (buf)) {
+			header->value = _g_mime_utils_header_decode_text (header->options, buf, NULL, header->offset);
+			g_free (buf);
+		} else {
+			/* the unfolded value is already the decoded value */
+			header->value = buf;
+		}
 	}
 	
 	return header->value;
@@ -267,6 +314,7 @@ g_mime_header_set_value (GMimeHeader *header, GMimeFormatOptions *options, const
 	header->charset = charset ? g_strdup (charset) : NULL;
 	header->reformat = TRUE;
 	header->value = buf;
+	header_clear_parsed (header);
 	
 	g_mime_event_emit (header->changed, NULL);
 }
@@ -347,6 +395,7 @@ g_mime_header_set_raw_value (GMimeHeader *header, const char *raw_value)
 	header->reformat = FALSE;
 	header->raw_value = buf;
 	header->value = NULL;
+	header_clear_parsed (header);
 	
 	g_mime_event_emit (header->changed, NULL);
 }
@@ -376,6 +425,130 @@ _g_mime_header_set_offset (GMimeHeader *header, gint64 offset)
 }
 
 
+/* The following functions parse the header's value into a structured
+ * representation the first time they are called and cache the result
+ * until the header's value is changed. A header's value can only be
+ * parsed as a single type.
+ *
+ * The cache is the single owner of the parsed value: mutable values
+ * (content types, dispositions and address lists) are handed out as
+ * copies so that modifying them can never make the cache disagree
+ * with the header's value. */
+
+static gboolean
+header_get_parsed (GMimeHeader *header, GMimeHeaderParsedType type, gpointer *parsed)
+{
+	GMimeHeaderPrivate *priv = GMIME_HEADER_GET_PRIVATE (header);
+	
+	if (priv->parsed_type != type)
+		return FALSE;
+	
+	*parsed = priv->parsed;
+	
+	return TRUE;
+}
+
+static gpointer
+header_set_parsed (GMimeHeader *header, GMimeHeaderParsedType type, gpointer parsed)
+{
+	GMimeHeaderPrivate *priv = GMIME_HEADER_GET_PRIVATE (header);
+	
+	priv->parsed_type = type;
+	priv->parsed = parsed;
+	
+	return parsed;
+}
+
+#define HEADER_CAN_PARSE_AS(header, type) (GMIME_HEADER_GET_PRIVATE (header)->parsed_type == GMIME_HEADER_PARSED_NONE || \
+					   GMIME_HEADER_GET_PRIVATE (header)->parsed_type == (type))
+
+GMimeContentType *
+_g_mime_header_dup_content_type (GMimeHeader *header)
+{
+	GMimeContentType *content_type;
+	const char *value;
+	
+	g_return_val_if_fail (HEADER_CAN_PARSE_AS (header, GMIME_HEADER_PARSED_CONTENT_TYPE), NULL);
+	
+	if (!header_get_parsed (header, GMIME_HEADER_PARSED_CONTENT_TYPE, (gpointer *) &content_type)) {
+		value = g_mime_header_get_value (header);
+		content_type = _g_mime_content_type_parse (header->options, value, header->offset);
+		header_set_parsed (header, GMIME_HEADER_PARSED_CONTENT_TYPE, content_type);
+	}
+	
+	return _g_mime_content_type_copy (content_type);
+}
+
+GMimeContentDisposition *
+_g_mime_header_dup_content_disposition (GMimeHeader *header)
+{
+	GMimeContentDisposition *disposition;
+	const char *value;
+	
+	g_return_val_if_fail (HEADER_CAN_PARSE_AS (header, GMIME_HEADER_PARSED_CONTENT_DISPOSITION), NULL);
+	
+	if (!header_get_parsed (header, GMIME_HEADER_PARSED_CONTENT_DISPOSITION, (gpointer *) &disposition)) {
+		value = g_mime_header_get_value (header);
+		disposition = _g_mime_content_disposition_parse (header->options, value, header->offset);
+		header_set_parsed (header, GMIME_HEADER_PARSED_CONTENT_DISPOSITION, disposition);
+	}
+	
+	return _g_mime_content_disposition_copy (disposition);
+}
+
+void
+_g_mime_header_copy_addresses (GMimeHeader *header, InternetAddressList *list)
+{
+	InternetAddressList *addresses = NULL;
+	
+	g_return_if_fail (HEADER_CAN_PARSE_AS (header, GMIME_HEADER_PARSED_ADDRESSES));
+	
+	if (!header_get_parsed (header, GMIME_HEADER_PARSED_ADDRESSES, (gpointer *) &addresses)) {
+		if (header->raw_value)
+			addresses = _internet_address_list_parse (header->options, header->raw_value, header->offset);
+		
+		header_set_parsed (header, GMIME_HEADER_PARSED_ADDRESSES, addresses);
+	}
+	
+	if (addresses != NULL)
+		_internet_address_list_append_copy (list, addresses);
+}
+
+GDateTime *
+_g_mime_header_get_date (GMimeHeader *header)
+{
+	GDateTime *date = NULL;
+	const char *value;
+	
+	g_return_val_if_fail (HEADER_CAN_PARSE_AS (header, GMIME_HEADER_PARSED_DATE), NULL);
+	
+	if (header_get_parsed (header, GMIME_HEADER_PARSED_DATE, (gpointer *) &date))
+		return date;
+	
+	if ((value = g_mime_header_get_value (header)))
+		date = g_mime_utils_header_decode_date (value);
+	
+	return header_set_parsed (header, GMIME_HEADER_PARSED_DATE, date);
+}
+
+const char *
+_g_mime_header_get_message_id (GMimeHeader *header)
+{
+	const char *value;
+	char *msgid = NULL;
+	
+	g_return_val_if_fail (HEADER_CAN_PARSE_AS (header, GMIME_HEADER_PARSED_MESSAGE_ID), NULL);
+	
+	if (header_get_parsed (header, GMIME_HEADER_PARSED_MESSAGE_ID, (gpointer *) &msgid))
+		return msgid;
+	
+	if ((value = g_mime_header_get_value (header)))
+		msgid = g_mime_utils_decode_message_id (value);
+	
+	return header_set_parsed (header, GMIME_HEADER_PARSED_MESSAGE_ID, msgid);
+}
+
+
 /**
  * g_mime_header_write_to_stream:
  * @header: a #GMimeHeader
@@ -930,6 +1103,15 @@ g_mime_header_format_default (GMimeHeader *header, GMimeFormatOptions *options,
 }
 
 
+typedef struct {
+	/* set whenever the list is modified after being parsed */
+	gboolean dirty;
+} GMimeHeaderListPrivate;
+
+#define GMIME_HEADER_LIST_GET_PRIVATE(list) ((GMimeHeaderListPrivate *) G_STRUCT_MEMBER_P (list, list_private_offset))
+
+static gint list_private_offset = 0;
+
 static void
 header_changed (GMimeHeader *header, gpointer user_args, GMimeHeaderList *list)
 {
@@ -937,6 +1119,7 @@ header_changed (GMimeHeader *header, gpointer user_args, GMimeHeaderList *list)
 	
 	args.action = GMIME_HEADER_LIST_CHANGED_ACTION_CHANGED;
 	args.header = header;
+	GMIME_HEADER_LIST_GET_PRIVATE (list)->dirty = TRUE;
 	
 	g_mime_event_emit (list->changed, &args);
 }
@@ -969,6 +1152,7 @@ g_mime_header_list_get_type (void)
 		};
 		
 		type = g_type_register_static (G_TYPE_OBJECT, "GMimeHeaderList", &info, 0);
+		list_private_offset = g_type_add_instance_private (type, sizeof (GMimeHeaderListPrivate));
 	}
 	
 	return type;
@@ -981,6 +1165,7 @@ g_mime_header_list_class_init (GMimeHeaderListClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	
 	list_parent_class = g_type_class_ref (G_TYPE_OBJECT);
+	g_type_class_adjust_private_offset (klass, &list_private_offset);
 	
 	object_class->finalize = g_mime_header_list_finalize;
 }
@@ -990,7 +1175,7 @@ g_mime_header_list_init (GMimeHeaderList *list, GMimeHeaderListClass *klass)
 {
 	list->hash = g_hash_table_new (g_mime_strcase_hash,
 				       g_mime_strcase_equal);
-	list->changed = g_mime_event_new (list);
+	list->changed = NULL;
 	list->array = g_ptr_array_new ();
 }
 
@@ -1064,6 +1249,7 @@ g_mime_header_list_clear (GMimeHeaderList *headers)
 	
 	args.action = GMIME_HEADER_LIST_CHANGED_ACTION_CLEARED;
 	args.header = NULL;
+	GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty = TRUE;
 	
 	g_mime_event_emit (headers->changed, &args);
 }
@@ -1082,6 +1268,18 @@ _g_mime_header_list_set_options (GMimeHeaderList *headers, GMimeParserOptions *o
 	headers->options = g_mime_parser_options_clone (options);
 }
 
+gboolean
+_g_mime_header_list_is_dirty (GMimeHeaderList *headers)
+{
+	return GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty;
+}
+
+void
+_g_mime_header_list_set_dirty (GMimeHeaderList *headers, gboolean dirty)
+{
+	GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty = dirty;
+}
+
 
 /**
  * g_mime_header_list_get_count:
@@ -1147,7 +1345,7 @@ g_mime_header_list_prepend (GMimeHeaderList *headers, const char *name, const ch
 	g_return_if_fail (name != NULL);
 	
 	header = g_mime_header_new (headers->options, name, value, name, NULL, charset, -1);
-	g_mime_event_add (header->changed, (GMimeEventCallback) header_changed, headers);
+	g_mime_event_add (&header->changed, header, (GMimeEventCallback) header_changed, headers);
 	g_hash_table_replace (headers->hash, header->name, header);
 	
 	if (headers->array->len > 0) {
@@ -1165,6 +1363,7 @@ g_mime_header_list_prepend (GMimeHeaderList *headers, const char *name, const ch
 	
 	args.action = GMIME_HEADER_LIST_CHANGED_ACTION_ADDED;
 	args.header = header;
+	GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty = TRUE;
 	
 	g_mime_event_emit (headers->changed, &args);
 }
@@ -1178,7 +1377,7 @@ _g_mime_header_list_append (GMimeHeaderList *headers, const char *name, const ch
 	GMimeHeader *header;
 	
 	header = g_mime_header_new (headers->options, name, NULL, raw_name, raw_value, NULL, offset);
-	g_mime_event_add (header->changed, (GMimeEventCallback) header_changed, headers);
+	g_mime_event_add (&header->changed, header, (GMimeEventCallback) header_changed, headers);
 	g_ptr_array_add (headers->array, header);
 	
 	if (!g_hash_table_lookup (headers->hash, name))
@@ -1186,6 +1385,7 @@ _g_mime_header_list_append (GMimeHeaderList *headers, const char *name, const ch
 	
 	args.action = GMIME_HEADER_LIST_CHANGED_ACTION_ADDED;
 	args.header = header;
+	GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty = TRUE;
 	
 	g_mime_event_emit (headers->changed, &args);
 }
@@ -1212,7 +1412,7 @@ g_mime_header_list_append (GMimeHeaderList *headers, const char *name, const cha
 	g_return_if_fail (name != NULL);
 	
 	header = g_mime_header_new (headers->options, name, value, name, NULL, charset, -1);
-	g_mime_event_add (header->changed, (GMimeEventCallback) header_changed, headers);
+	g_mime_event_add (&header->changed, header, (GMimeEventCallback) header_changed, headers);
 	g_ptr_array_add (headers->array, header);
 	
 	if (!g_hash_table_lookup (headers->hash, name))
@@ -1220,6 +1420,7 @@ g_mime_header_list_append (GMimeHeaderList *headers, const char *name, const cha
 	
 	args.action = GMIME_HEADER_LIST_CHANGED_ACTION_ADDED;
 	args.header = header;
+	GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty = TRUE;
 	
 	g_mime_event_emit (headers->changed, &args);
 }
@@ -1273,6 +1474,7 @@ _g_mime_header_list_set (GMimeHeaderList *headers, const char *name, const char
 		
 		args.action = GMIME_HEADER_LIST_CHANGED_ACTION_CHANGED;
 		args.header = header;
+		GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty = TRUE;
 		
 		g_mime_event_emit (headers->changed, &args);
 	} else {
@@ -1326,6 +1528,7 @@ g_mime_header_list_set (GMimeHeaderList *headers, const char *name, const char *
 		
 		args.action = GMIME_HEADER_LIST_CHANGED_ACTION_CHANGED;
 		args.header = header;
+		GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty = TRUE;
 		
 		g_mime_event_emit (headers->changed, &args);
 	} else {
@@ -1404,6 +1607,7 @@ g_mime_header_list_remove (GMimeHeaderList *headers, const char *name)
 	
 	args.action = GMIME_HEADER_LIST_CHANGED_ACTION_REMOVED;
 	args.header = header;
+	GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty = TRUE;
 	
 	g_mime_event_emit (headers->changed, &args);
 	g_object_unref (header);
@@ -1453,6 +1657,7 @@ g_mime_header_list_remove_at (GMimeHeaderList *headers, int index)
 	
 	args.action = GMIME_HEADER_LIST_CHANGED_ACTION_REMOVED;
 	args.header = header;
+	GMIME_HEADER_LIST_GET_PRIVATE (headers)->dirty = TRUE;
 	
 	g_mime_event_emit (headers->changed, &args);
 	g_object_unref (header);
@@ -1517,21 +1722,7 @@ g_mime_header_list_write_to_stream (GMimeHeaderList *headers, GMimeFormatOptions
 char *
 g_mime_header_list_to_string (GMimeHeaderList *headers, GMimeFormatOptions *options)
 {
-	GMimeStream *stream;
-	GByteArray *array;
-	char *str;
-	
 	g_return_val_if_fail (GMIME_IS_HEADER_LIST (headers), NULL);
 	
-	array = g_byte_array_new ();
-	stream = g_mime_stream_mem_new ();
-	g_mime_stream_mem_set_byte_array ((GMimeStreamMem *) stream, array);
-	g_mime_header_list_write_to_stream (headers, options, stream);
-	g_object_unref (stream);
-	
-	g_byte_array_append (array, (unsigned char *) "", 1);
-	str = (char *) array->data;
-	g_byte_array_free (array, FALSE);
-	
-	return str;
+	return _g_mime_serialize_to_string ((GMimeWriteFunc) g_mime_header_list_write_to_stream, headers, options);
 }
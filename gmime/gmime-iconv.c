@@ -24,10 +24,13 @@
 #endif
 
 #include <glib.h>
+#include <string.h>
 #include <errno.h>
 
 #include "gmime-charset.h"
 #include "gmime-iconv.h"
+#include "gmime-internal.h"
+#include "gmime-sbcs-map-private.h"
 
 
 /**
@@ -42,6 +45,11 @@
  **/
 
 
+/* size of the hashed unicode -> byte map used when encoding; twice
+ * the number of non-ASCII characters a single-byte charset can have */
+#define SBCS_REVERSE_SIZE 256
+
+
 /**
  * g_mime_iconv_open: (skip)
  * @to: charset to convert to
@@ -92,3 +100,356 @@ g_mime_iconv_close (iconv_t cd)
 {
 	return iconv_close (cd);
 }
+
+
+static gboolean
+is_utf8 (const char *charset)
+{
+	charset = g_mime_charset_iconv_name (charset);
+	
+	return !g_ascii_strcasecmp (charset, "UTF-8") || !g_ascii_strcasecmp (charset, "utf8");
+}
+
+static const unsigned short *
+sbcs_table (const char *charset)
+{
+	guint i;
+	
+	charset = g_mime_charset_canon_name (charset);
+	
+	for (i = 0; i < G_N_ELEMENTS (sbcs_charsets); i++) {
+		if (!g_ascii_strcasecmp (sbcs_charsets[i].name, charset))
+			return sbcs_charsets[i].table;
+	}
+	
+	return NULL;
+}
+
+static inline guint
+sbcs_reverse_hash (gunichar c)
+{
+	return (c * 2654435761u) >> 24;
+}
+
+static guint32 *
+sbcs_reverse_new (const unsigned short *table)
+{
+	guint32 *reverse;
+	guint i, slot;
+	
+	reverse = g_new0 (guint32, SBCS_REVERSE_SIZE);
+	
+	for (i = 0; i < 128; i++) {
+		if (table[i] == SBCS_INVALID)
+			continue;
+		
+		slot = sbcs_reverse_hash (table[i]) & (SBCS_REVERSE_SIZE - 1);
+		while (reverse[slot] != 0)
+			slot = (slot + 1) & (SBCS_REVERSE_SIZE - 1);
+		
+		reverse[slot] = (table[i] << 8) | (i + 128);
+	}
+	
+	return reverse;
+}
+
+static inline int
+sbcs_reverse_lookup (const guint32 *reverse, gunichar c)
+{
+	guint slot = sbcs_reverse_hash (c) & (SBCS_REVERSE_SIZE - 1);
+	
+	while (reverse[slot] != 0) {
+		if ((reverse[slot] >> 8) == c)
+			return reverse[slot] & 0xff;
+		
+		slot = (slot + 1) & (SBCS_REVERSE_SIZE - 1);
+	}
+	
+	return -1;
+}
+
+
+/**
+ * _g_mime_iconv_open:
+ * @to: charset to convert to
+ * @from: charset to convert from
+ *
+ * Like g_mime_iconv_open(), except that conversions between UTF-8 and
+ * the common single-byte charsets, as well as UTF-8 to UTF-8, are done
+ * by built-in table-driven converters instead of iconv(3).
+ *
+ * Returns: a new #GMimeIconv for use with _g_mime_iconv() on success
+ * or %NULL on fail as well as setting an appropriate errno value.
+ **/
+GMimeIconv *
+_g_mime_iconv_open (const char *to, const char *from)
+{
+	const unsigned short *table = NULL;
+	GMimeIconvMode mode;
+	GMimeIconv *cd;
+	iconv_t ic;
+	
+	if (from == NULL || to == NULL) {
+		errno = EINVAL;
+		return NULL;
+	}
+	
+	if (!g_ascii_strcasecmp (from, "x-unknown"))
+		from = g_mime_locale_charset ();
+	
+	if (is_utf8 (to)) {
+		if (is_utf8 (from))
+			mode = GMIME_ICONV_MODE_UTF8;
+		else if ((table = sbcs_table (from)))
+			mode = GMIME_ICONV_MODE_SBCS_TO_UTF8;
+		else
+			mode = GMIME_ICONV_MODE_SYSTEM;
+	} else if (is_utf8 (from) && (table = sbcs_table (to))) {
+		mode = GMIME_ICONV_MODE_UTF8_TO_SBCS;
+	} else {
+		mode = GMIME_ICONV_MODE_SYSTEM;
+	}
+	
+	if (mode == GMIME_ICONV_MODE_SYSTEM) {
+		if ((ic = g_mime_iconv_open (to, from)) == (iconv_t) -1)
+			return NULL;
+	} else {
+		ic = (iconv_t) -1;
+	}
+	
+	cd = g_new (GMimeIconv, 1);
+	cd->mode = mode;
+	cd->cd = ic;
+	cd->table = table;
+	cd->reverse = mode == GMIME_ICONV_MODE_UTF8_TO_SBCS ? sbcs_reverse_new (table) : NULL;
+	
+	return cd;
+}
+
+static size_t
+utf8_to_utf8 (char **inbuf, size_t *inleft, char **outbuf, size_t *outleft)
+{
+	register const char *inptr = *inbuf;
+	const char *inend = inptr + *inleft;
+	register char *outptr = *outbuf;
+	char *outend = outptr + *outleft;
+	size_t rv = 0, n;
+	const char *end;
+	gunichar c;
+	
+	while (inptr < inend) {
+		/* copy everything up to the first nul, invalid sequence or
+		 * character that doesn't fit entirely in either buffer */
+		n = MIN (inend - inptr, outend - outptr);
+		g_utf8_validate (inptr, n, &end);
+		memcpy (outptr, inptr, end - inptr);
+		outptr += end - inptr;
+		inptr = end;
+		
+		if (inptr == inend)
+			break;
+		
+		if (*inptr == '\0') {
+			/* g_utf8_validate() stops at nul bytes, iconv does not */
+			if (outptr == outend) {
+				errno = E2BIG;
+				rv = (size_t) -1;
+				break;
+			}
+			
+			*outptr++ = *inptr++;
+			continue;
+		}
+		
+		n = g_utf8_skip[*((const unsigned char *) inptr)];
+		c = g_utf8_get_char_validated (inptr, inend - inptr);
+		
+		if (c == (gunichar) -2 && n > (size_t) (inend - inptr)) {
+			errno = EINVAL;
+			rv = (size_t) -1;
+			break;
+		}
+		
+		if (c == (gunichar) -1 || c == (gunichar) -2) {
+			errno = EILSEQ;
+			rv = (size_t) -1;
+			break;
+		}
+		
+		/* a valid character that didn't fit in the output buffer */
+		if (n > (size_t) (outend - outptr)) {
+			errno = E2BIG;
+			rv = (size_t) -1;
+			break;
+		}
+		
+		memcpy (outptr, inptr, n);
+		outptr += n;
+		inptr += n;
+	}
+	
+	*inleft -= inptr - *inbuf;
+	*outleft -= outptr - *outbuf;
+	*inbuf = (char *) inptr;
+	*outbuf = outptr;
+	
+	return rv;
+}
+
+static size_t
+sbcs_to_utf8 (const unsigned short *table, char **inbuf, size_t *inleft, char **outbuf, size_t *outleft)
+{
+	register const unsigned char *inptr = (const unsigned char *) *inbuf;
+	const unsigned char *inend = inptr + *inleft;
+	register unsigned char *outptr = (unsigned char *) *outbuf;
+	unsigned char *outend = outptr + *outleft;
+	size_t rv = 0, n;
+	gunichar c;
+	
+	while (inptr < inend) {
+		if (*inptr < 128) {
+			c = *inptr;
+			n = 1;
+		} else if ((c = table[*inptr - 128]) == SBCS_INVALID) {
+			errno = EILSEQ;
+			rv = (size_t) -1;
+			break;
+		} else {
+			n = c < 0x800 ? 2 : 3;
+		}
+		
+		if (n > (size_t) (outend - outptr)) {
+			errno = E2BIG;
+			rv = (size_t) -1;
+			break;
+		}
+		
+		switch (n) {
+		case 1:
+			*outptr++ = c;
+			break;
+		case 2:
+			*outptr++ = 0xc0 | (c >> 6);
+			*outptr++ = 0x80 | (c & 0x3f);
+			break;
+		default:
+			*outptr++ = 0xe0 | (c >> 12);
+			*outptr++ = 0x80 | ((c >> 6) & 0x3f);
+			*outptr++ = 0x80 | (c & 0x3f);
+			break;
+		}
+		
+		inptr++;
+	}
+	
+	*inleft -= inptr - (const unsigned char *) *inbuf;
+	*outleft -= outptr - (unsigned char *) *outbuf;
+	*inbuf = (char *) inptr;
+	*outbuf = (char *) outptr;
+	
+	return rv;
+}
+
+static size_t
+utf8_to_sbcs (const guint32 *reverse, char **inbuf, size_t *inleft, char **outbuf, size_t *outleft)
+{
+	register const unsigned char *inptr = (const unsigned char *) *inbuf;
+	const unsigned char *inend = inptr + *inleft;
+	register unsigned char *outptr = (unsigned char *) *outbuf;
+	unsigned char *outend = outptr + *outleft;
+	size_t rv = 0, n;
+	gunichar c;
+	int byte;
+	
+	while (inptr < inend) {
+		if (outptr == outend) {
+			errno = E2BIG;
+			rv = (size_t) -1;
+			break;
+		}
+		
+		if (*inptr < 128) {
+			*outptr++ = *inptr++;
+			continue;
+		}
+		
+		n = g_utf8_skip[*inptr];
+		c = g_utf8_get_char_validated ((const char *) inptr, inend - inptr);
+		
+		if (c == (gunichar) -2 && n > (size_t) (inend - inptr)) {
+			errno = EINVAL;
+			rv = (size_t) -1;
+			break;
+		}
+		
+		/* invalid UTF-8 or a character that the charset doesn't have */
+		if (c == (gunichar) -1 || c == (gunichar) -2 || (byte = sbcs_reverse_lookup (reverse, c)) == -1) {
+			errno = EILSEQ;
+			rv = (size_t) -1;
+			break;
+		}
+		
+		*outptr++ = (unsigned char) byte;
+		inptr += n;
+	}
+	
+	*inleft -= inptr - (const unsigned char *) *inbuf;
+	*outleft -= outptr - (unsigned char *) *outbuf;
+	*inbuf = (char *) inptr;
+	*outbuf = (char *) outptr;
+	
+	return rv;
+}
+
+
+/**
+ * _g_mime_iconv:
+ * @cd: a #GMimeIconv
+ * @inbuf: input buffer
+ * @inleft: number of bytes left in @inbuf
+ * @outbuf: output buffer
+ * @outleft: number of bytes left in @outbuf
+ *
+ * Converts text exactly like iconv(3) would, including the way errors
+ * are reported through errno and how %NULL @inbuf flushes or resets
+ * the conversion state.
+ *
+ * Returns: the number of irreversible conversions or (size_t) %-1 on
+ * error.
+ **/
+size_t
+_g_mime_iconv (GMimeIconv *cd, char **inbuf, size_t *inleft, char **outbuf, size_t *outleft)
+{
+	if (cd->mode == GMIME_ICONV_MODE_SYSTEM)
+		return iconv (cd->cd, inbuf, inleft, outbuf, outleft);
+	
+	/* the built-in converters are stateless, so there is nothing to flush or reset */
+	if (inbuf == NULL || *inbuf == NULL)
+		return 0;
+	
+	switch (cd->mode) {
+	case GMIME_ICONV_MODE_UTF8:
+		return utf8_to_utf8 (inbuf, inleft, outbuf, outleft);
+	case GMIME_ICONV_MODE_SBCS_TO_UTF8:
+		return sbcs_to_utf8 (cd->table, inbuf, inleft, outbuf, outleft);
+	default:
+		return utf8_to_sbcs (cd->reverse, inbuf, inleft, outbuf, outleft);
+	}
+}
+
+
+/**
+ * _g_mime_iconv_close:
+ * @cd: a #GMimeIconv
+ *
+ * Closes @cd.
+ **/
+void
+_g_mime_iconv_close (GMimeIconv *cd)
+{
+	if (cd->cd != (iconv_t) -1)
+		iconv_close (cd->cd);
+	
+	g_free (cd->reverse);
+	g_free (cd);
+}
@@ -24,8 +24,16 @@
 
 #include <gmime/gmime-format-options.h>
 #include <gmime/gmime-parser-options.h>
+#include <gmime/gmime-parser.h>
+#include <gmime/gmime-crypto-context.h>
+#include <gmime/gmime-data-wrapper.h>
 #include <gmime/gmime-object.h>
+#include <gmime/gmime-message.h>
+#include <gmime/gmime-part.h>
 #include <gmime/gmime-events.h>
+#include <gmime/gmime-filter.h>
+#include <gmime/gmime-iconv.h>
+#include <gmime/gmime-stats.h>
 #include <gmime/gmime-utils.h>
 
 G_BEGIN_DECLS
@@ -42,57 +50,174 @@ typedef struct {
 	GMimeHeader *header;
 } GMimeHeaderListChangedEventArgs;
 
+/* statistics: GMIME_STATS(x) compiles to nothing unless configured with --enable-stats */
+#ifdef ENABLE_STATS
+#define GMIME_STATS(x) x
+G_GNUC_INTERNAL void _g_mime_stats_record_alloc (GMimeStatsSubsystem subsystem, size_t size);
+#else
+#define GMIME_STATS(x)
+#endif /* ENABLE_STATS */
+
 /* GMimeFormatOptions */
 G_GNUC_INTERNAL void g_mime_format_options_init (void);
 G_GNUC_INTERNAL void g_mime_format_options_shutdown (void);
 G_GNUC_INTERNAL GMimeFormatOptions *_g_mime_format_options_clone (GMimeFormatOptions *options, gboolean hidden);
+G_GNUC_INTERNAL gboolean _g_mime_format_options_can_write_verbatim (GMimeFormatOptions *options);
 
 /* GMimeParserOptions */
 G_GNUC_INTERNAL void g_mime_parser_options_init (void);
 G_GNUC_INTERNAL void g_mime_parser_options_shutdown (void);
 G_GNUC_INTERNAL void _g_mime_parser_options_warn (GMimeParserOptions *options, gint64 offset, GMimeParserWarning errcode,
 						  const gchar *item);
+G_GNUC_INTERNAL GObject *_g_mime_parser_options_cache_lookup (GMimeParserOptions *options, GType type, const char *value);
+G_GNUC_INTERNAL void _g_mime_parser_options_cache_insert (GMimeParserOptions *options, GType type, const char *value,
+							  GObject *object);
 
 /* GMimeHeader */
+typedef enum {
+	GMIME_HEADER_PARSED_NONE,
+	GMIME_HEADER_PARSED_CONTENT_TYPE,
+	GMIME_HEADER_PARSED_CONTENT_DISPOSITION,
+	GMIME_HEADER_PARSED_ADDRESSES,
+	GMIME_HEADER_PARSED_DATE,
+	GMIME_HEADER_PARSED_MESSAGE_ID
+} GMimeHeaderParsedType;
+
 //G_GNUC_INTERNAL void _g_mime_header_set_raw_value (GMimeHeader *header, const char *raw_value);
 G_GNUC_INTERNAL void _g_mime_header_set_offset (GMimeHeader *header, gint64 offset);
+G_GNUC_INTERNAL GMimeContentType *_g_mime_header_dup_content_type (GMimeHeader *header);
+G_GNUC_INTERNAL GMimeContentDisposition *_g_mime_header_dup_content_disposition (GMimeHeader *header);
+G_GNUC_INTERNAL void _g_mime_header_copy_addresses (GMimeHeader *header, InternetAddressList *list);
+G_GNUC_INTERNAL GDateTime *_g_mime_header_get_date (GMimeHeader *header);
+G_GNUC_INTERNAL const char *_g_mime_header_get_message_id (GMimeHeader *header);
 
 /* GMimeHeaderList */
 G_GNUC_INTERNAL GMimeParserOptions *_g_mime_header_list_get_options (GMimeHeaderList *headers);
 G_GNUC_INTERNAL void _g_mime_header_list_set_options (GMimeHeaderList *headers, GMimeParserOptions *options);
+G_GNUC_INTERNAL gboolean _g_mime_header_list_is_dirty (GMimeHeaderList *headers);
+G_GNUC_INTERNAL void _g_mime_header_list_set_dirty (GMimeHeaderList *headers, gboolean dirty);
 G_GNUC_INTERNAL void _g_mime_header_list_append (GMimeHeaderList *headers, const char *name, const char *raw_name,
 						 const char *raw_value, gint64 offset);
 G_GNUC_INTERNAL void _g_mime_header_list_set (GMimeHeaderList *headers, const char *name, const char *raw_value);
 
+/* GMimeDataWrapper */
+G_GNUC_INTERNAL guint _g_mime_data_wrapper_get_generation (GMimeDataWrapper *wrapper);
+
 /* GMimeObject */
 G_GNUC_INTERNAL void _g_mime_object_block_header_list_changed (GMimeObject *object);
 G_GNUC_INTERNAL void _g_mime_object_unblock_header_list_changed (GMimeObject *object);
 G_GNUC_INTERNAL void _g_mime_object_set_content_type (GMimeObject *object, GMimeContentType *content_type);
 G_GNUC_INTERNAL void _g_mime_object_append_header (GMimeObject *object, const char *name, const char *raw_name,
 						   const char *raw_value, gint64 offset);
+G_GNUC_INTERNAL void _g_mime_object_begin_construct (GMimeObject *object);
+G_GNUC_INTERNAL void _g_mime_object_end_construct (GMimeObject *object);
+G_GNUC_INTERNAL void _g_mime_object_set_source (GMimeObject *object, GMimeStream *source);
+G_GNUC_INTERNAL void _g_mime_object_clear_source (GMimeObject *object);
+G_GNUC_INTERNAL gboolean _g_mime_object_can_write_source (GMimeObject *object, GMimeFormatOptions *options);
+G_GNUC_INTERNAL ssize_t _g_mime_object_write_source (GMimeObject *object, GMimeStream *stream);
+G_GNUC_INTERNAL void _g_mime_object_set_content_size (GMimeObject *object, gint64 octets, gint64 lines);
+
+/* serialization into memory */
+typedef ssize_t (* GMimeWriteFunc) (gpointer object, GMimeFormatOptions *options, GMimeStream *stream);
+
+G_GNUC_INTERNAL ssize_t _g_mime_serialized_length (GMimeWriteFunc write, gpointer object, GMimeFormatOptions *options);
+G_GNUC_INTERNAL ssize_t _g_mime_serialize_to_buffer (GMimeWriteFunc write, gpointer object, GMimeFormatOptions *options,
+						     char *buffer, size_t buflen);
+G_GNUC_INTERNAL char *_g_mime_serialize_to_string (GMimeWriteFunc write, gpointer object, GMimeFormatOptions *options);
+
+/* GMimePart */
+G_GNUC_INTERNAL gboolean _g_mime_part_encode_needs_scan (GMimePart *part, GMimeEncodingConstraint constraint);
+G_GNUC_INTERNAL GMimeFilter *_g_mime_part_encode_scan (GMimePart *part);
+G_GNUC_INTERNAL void _g_mime_part_encode_apply (GMimePart *part, GMimeEncodingConstraint constraint, GMimeFilter *filter);
+G_GNUC_INTERNAL void _g_mime_part_set_fingerprint (GMimePart *mime_part, GMimeFingerprintFlags flags, guint64 hash,
+						   gint64 length, const unsigned char *sha256);
+
+/* GMimeMessage */
+G_GNUC_INTERNAL void _g_mime_message_append_envelope (GMimeMessage *message, GString *envelope);
+
+/* GMimeStreamCallback */
+typedef ssize_t (* GMimeStreamCallbackFunc) (const char *buf, size_t len, gpointer user_data);
+
+G_GNUC_INTERNAL GMimeStream *_g_mime_stream_callback_new (GMimeStreamCallbackFunc write, gpointer user_data);
+
+/* GMimeParser */
+G_GNUC_INTERNAL void _g_mime_parser_set_persist_threshold (GMimeParser *parser, gint64 threshold);
+
+/* GMimeCryptoContext */
+G_GNUC_INTERNAL GMimeParser *_g_mime_crypto_context_decrypt_content (GMimeCryptoContext *ctx, GMimeDecryptFlags flags,
+								     const char *session_key, GMimeDataWrapper *content,
+								     GMimeDecryptResult **result, GError **err);
 
 /* GMimeContentType */
 G_GNUC_INTERNAL GMimeContentType *_g_mime_content_type_parse (GMimeParserOptions *options, const char *str, gint64 offset);
+G_GNUC_INTERNAL GMimeContentType *_g_mime_content_type_copy (GMimeContentType *content_type);
 
 /* GMimeParamList */
+G_GNUC_INTERNAL char *_g_mime_param_encode_value (GMimeParam *param, gboolean *rfc2231);
 G_GNUC_INTERNAL GMimeParamList *_g_mime_param_list_parse (GMimeParserOptions *options, const char *str, gint64 offset);
+G_GNUC_INTERNAL GMimeParamList *_g_mime_param_list_copy (GMimeParamList *list);
 
 /* GMimeContentDisposition */
 G_GNUC_INTERNAL GMimeContentDisposition *_g_mime_content_disposition_parse (GMimeParserOptions *options, const char *str,
 									    gint64 offset);
+G_GNUC_INTERNAL GMimeContentDisposition *_g_mime_content_disposition_copy (GMimeContentDisposition *disposition);
 
 /* utils */
+G_GNUC_INTERNAL void g_mime_utils_shutdown (void);
 G_GNUC_INTERNAL char *_g_mime_utils_unstructured_header_fold (GMimeParserOptions *options, GMimeFormatOptions *format,
 							      const char *field, const char *value);
 G_GNUC_INTERNAL char *_g_mime_utils_structured_header_fold (GMimeParserOptions *options, GMimeFormatOptions *format,
 							    const char *field, const char *value);
+G_GNUC_INTERNAL gboolean _g_mime_utils_header_is_plain_text (const char *text);
 G_GNUC_INTERNAL char *_g_mime_utils_header_decode_text (GMimeParserOptions *options, const char *text, const char **charset,
 							gint64 offset);
 G_GNUC_INTERNAL char *_g_mime_utils_header_decode_phrase (GMimeParserOptions *options, const char *text, const char **charset,
 							  gint64 offset);
+G_GNUC_INTERNAL void _g_mime_utils_append_imap_nstring (GString *str, const char *value);
+G_GNUC_INTERNAL void _g_mime_utils_append_imap_header (GString *str, GMimeHeaderList *headers, const char *name);
+
+/* GMimeFilter */
+G_GNUC_INTERNAL void _g_mime_filter_filter (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
+					    char **outbuf, size_t *outlen, size_t *outprespace, gboolean writable);
+G_GNUC_INTERNAL void _g_mime_filter_complete (GMimeFilter *filter, char *inbuf, size_t inlen, size_t prespace,
+					      char **outbuf, size_t *outlen, size_t *outprespace, gboolean writable);
+G_GNUC_INTERNAL char *_g_mime_filter_get_in_place_buffer (GMimeFilter *filter, char *inbuf, size_t prespace,
+							  size_t headroom);
+
+/* GMimeFilterBasic */
+G_GNUC_INTERNAL gboolean _g_mime_filter_basic_can_fuse (GMimeFilter *filter, GMimeFilter *next);
+G_GNUC_INTERNAL void _g_mime_filter_basic_fused (GMimeFilter *filter, GMimeFilter *next, char *inbuf, size_t inlen,
+						 size_t prespace, char **outbuf, size_t *outlen, size_t *outprespace,
+						 gboolean writable, gboolean flush);
+
+/* encodings */
+G_GNUC_INTERNAL size_t _g_mime_encoding_base64_decode_dos2unix_step (const unsigned char *inbuf, size_t inlen,
+								     unsigned char *outbuf, int *state, guint32 *save,
+								     char *pc);
+
+/* GMimeIconv: iconv(3) with built-in converters for UTF-8 and the common single-byte charsets */
+typedef enum {
+	GMIME_ICONV_MODE_SYSTEM,
+	GMIME_ICONV_MODE_UTF8,
+	GMIME_ICONV_MODE_SBCS_TO_UTF8,
+	GMIME_ICONV_MODE_UTF8_TO_SBCS
+} GMimeIconvMode;
+
+typedef struct {
+	GMimeIconvMode mode;
+	iconv_t cd;
+	const unsigned short *table;
+	guint32 *reverse;
+} GMimeIconv;
+
+G_GNUC_INTERNAL GMimeIconv *_g_mime_iconv_open (const char *to, const char *from);
+G_GNUC_INTERNAL size_t _g_mime_iconv (GMimeIconv *cd, char **inbuf, size_t *inleft, char **outbuf, size_t *outleft);
+G_GNUC_INTERNAL void _g_mime_iconv_close (GMimeIconv *cd);
+G_GNUC_INTERNAL char *_g_mime_iconv_strndup (GMimeIconv *cd, const char *str, size_t n);
 
 /* InternetAddressList */
 G_GNUC_INTERNAL InternetAddressList *_internet_address_list_parse (GMimeParserOptions *options, const char *str, gint64 offset);
+G_GNUC_INTERNAL void _internet_address_list_append_copy (InternetAddressList *list, InternetAddressList *append);
 
 G_END_DECLS
 
@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "gmime-message-part.h"
+#include "gmime-internal.h"
 
 #define d(x)
 
@@ -135,6 +136,14 @@ message_part_write_to_stream (GMimeObject *object, GMimeFormatOptions *options,
 		total += nwritten;
 	}
 	
+	/* copy unmodified content straight from the stream it was parsed from */
+	if (message && _g_mime_object_can_write_source (object, options)) {
+		if ((nwritten = _g_mime_object_write_source (object, stream)) == -1)
+			return -1;
+		
+		return total + nwritten;
+	}
+	
 	/* write the message */
 	if (message) {
 		if (message->marker && (len = strlen (message->marker)) > 0) {
@@ -242,6 +251,7 @@ g_mime_message_part_set_message (GMimeMessagePart *part, GMimeMessage *message)
 	if (part->message)
 		g_object_unref (part->message);
 	
+	_g_mime_object_clear_source ((GMimeObject *) part);
 	part->message = message;
 }
 
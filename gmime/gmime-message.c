@@ -34,7 +34,6 @@
 #include "gmime-part.h"
 #include "gmime-utils.h"
 #include "gmime-common.h"
-#include "gmime-stream-mem.h"
 #include "gmime-stream-filter.h"
 #include "gmime-parse-utils.h"
 #include "gmime-internal.h"
@@ -152,7 +151,7 @@ connect_changed_event (GMimeMessage *message, GMimeAddressType type)
 	
 	addrlist = message->addrlists[type];
 	
-	g_mime_event_add (addrlist->changed, address_types[type].changed_cb, message);
+	g_mime_event_add (&addrlist->changed, addrlist, address_types[type].changed_cb, message);
 }
 
 static void
@@ -263,8 +262,8 @@ static void
 message_update_addresses (GMimeMessage *message, GMimeParserOptions *options, GMimeAddressType type)
 {
 	GMimeHeaderList *headers = ((GMimeObject *) message)->headers;
-	InternetAddressList *addrlist, *list;
-	const char *name, *value;
+	InternetAddressList *addrlist;
+	const char *name;
 	GMimeHeader *header;
 	int count, i;
 	
@@ -282,12 +281,7 @@ message_update_addresses (GMimeMessage *message, GMimeParserOptions *options, GM
 		if (g_ascii_strcasecmp (address_types[type].name, name) != 0)
 			continue;
 		
-		if ((value = g_mime_header_get_raw_value (header))) {
-			if ((list = _internet_address_list_parse (options, value, header->offset))) {
-				internet_address_list_append (addrlist, list);
-				g_object_unref (list);
-			}
-		}
+		_g_mime_header_copy_addresses (header, addrlist);
 	}
 	
 	unblock_changed_event (message, type);
@@ -336,20 +330,17 @@ process_header (GMimeObject *object, GMimeHeader *header)
 			message->subject = NULL;
 		break;
 	case HEADER_DATE:
-		if ((value = g_mime_header_get_value (header))) {
+		if (g_mime_header_get_raw_value (header)) {
 			if (message->date)
 				g_date_time_unref (message->date);
 			
-			message->date = g_mime_utils_header_decode_date (value);
+			if ((message->date = _g_mime_header_get_date (header)))
+				g_date_time_ref (message->date);
 		}
 		break;
 	case HEADER_MESSAGE_ID:
 		g_free (message->message_id);
-		
-		if ((value = g_mime_header_get_value (header)))
-			message->message_id = g_mime_utils_decode_message_id (value);
-		else
-			message->message_id = NULL;
+		message->message_id = g_strdup (_g_mime_header_get_message_id (header));
 		break;
 	}
 }
@@ -546,20 +537,7 @@ write_headers_to_stream (GMimeObject *object, GMimeFormatOptions *options, GMime
 static char *
 message_get_headers (GMimeObject *object, GMimeFormatOptions *options)
 {
-	GMimeStream *stream;
-	GByteArray *ba;
-	char *str;
-	
-	ba = g_byte_array_new ();
-	stream = g_mime_stream_mem_new ();
-	g_mime_stream_mem_set_byte_array ((GMimeStreamMem *) stream, ba);
-	write_headers_to_stream (object, options, stream);
-	g_object_unref (stream);
-	g_byte_array_append (ba, (unsigned char *) "", 1);
-	str = (char *) ba->data;
-	g_byte_array_free (ba, FALSE);
-	
-	return str;
+	return _g_mime_serialize_to_string ((GMimeWriteFunc) write_headers_to_stream, object, options);
 }
 
 static ssize_t
@@ -570,6 +548,10 @@ message_write_to_stream (GMimeObject *object, GMimeFormatOptions *options, gbool
 	ssize_t nwritten, total = 0;
 	const char *newline;
 	
+	/* copy the unmodified message straight from the stream it was parsed from */
+	if (!content_only && _g_mime_object_can_write_source (object, options))
+		return _g_mime_object_write_source (object, stream);
+	
 	if (!content_only) {
 		if ((nwritten = write_headers_to_stream (object, options, stream)) == -1)
 			return -1;
@@ -1047,6 +1029,8 @@ g_mime_message_set_mime_part (GMimeMessage *message, GMimeObject *mime_part)
 	if (message->mime_part == mime_part)
 		return;
 	
+	_g_mime_object_clear_source ((GMimeObject *) message);
+	
 	if (message->mime_part)
 		g_object_unref (message->mime_part);
 	
@@ -1177,6 +1161,142 @@ g_mime_message_get_body (GMimeMessage *message)
 	return NULL;
 }
 
+static void
+envelope_append_address_list (GString *envelope, InternetAddressList *list)
+{
+	InternetAddressMailbox *mailbox;
+	InternetAddress *address;
+	char *name, *addr;
+	int count, i;
+	
+	count = internet_address_list_length (list);
+	
+	for (i = 0; i < count; i++) {
+		address = internet_address_list_get_address (list, i);
+		
+		if (address->name && g_mime_utils_text_is_8bit ((const unsigned char *) address->name, strlen (address->name)))
+			name = g_mime_utils_header_encode_phrase (NULL, address->name, address->charset);
+		else
+			name = g_strdup (address->name);
+		
+		if (INTERNET_ADDRESS_IS_GROUP (address)) {
+			/* rfc3501: a group is bracketed by a start marker (with the group
+			 * name as the mailbox) and an end marker, both with a NIL host */
+			g_string_append (envelope, "(NIL NIL ");
+			_g_mime_utils_append_imap_nstring (envelope, name ? name : "");
+			g_string_append (envelope, " NIL)");
+			
+			envelope_append_address_list (envelope, ((InternetAddressGroup *) address)->members);
+			
+			g_string_append (envelope, "(NIL NIL NIL NIL)");
+		} else {
+			mailbox = (InternetAddressMailbox *) address;
+			
+			g_string_append_c (envelope, '(');
+			_g_mime_utils_append_imap_nstring (envelope, name);
+			g_string_append (envelope, " NIL ");
+			
+			if (mailbox->at > 0) {
+				addr = g_strndup (mailbox->addr, mailbox->at);
+				_g_mime_utils_append_imap_nstring (envelope, addr);
+				g_string_append_c (envelope, ' ');
+				_g_mime_utils_append_imap_nstring (envelope, mailbox->addr + mailbox->at + 1);
+				g_free (addr);
+			} else {
+				_g_mime_utils_append_imap_nstring (envelope, mailbox->addr);
+				g_string_append (envelope, " NIL");
+			}
+			
+			g_string_append_c (envelope, ')');
+		}
+		
+		g_free (name);
+	}
+}
+
+static void
+envelope_append_addresses (GString *envelope, InternetAddressList *list)
+{
+	if (internet_address_list_length (list) == 0) {
+		g_string_append (envelope, "NIL");
+		return;
+	}
+	
+	g_string_append_c (envelope, '(');
+	envelope_append_address_list (envelope, list);
+	g_string_append_c (envelope, ')');
+}
+
+
+/**
+ * _g_mime_message_append_envelope:
+ * @message: A #GMimeMessage
+ * @envelope: a #GString
+ *
+ * Appends the IMAP ENVELOPE of @message to @envelope.
+ **/
+void
+_g_mime_message_append_envelope (GMimeMessage *message, GString *envelope)
+{
+	GMimeHeaderList *headers = ((GMimeObject *) message)->headers;
+	InternetAddressList *from, *list;
+	
+	from = g_mime_message_get_addresses (message, GMIME_ADDRESS_TYPE_FROM);
+	
+	g_string_append_c (envelope, '(');
+	_g_mime_utils_append_imap_header (envelope, headers, "Date");
+	g_string_append_c (envelope, ' ');
+	_g_mime_utils_append_imap_header (envelope, headers, "Subject");
+	g_string_append_c (envelope, ' ');
+	envelope_append_addresses (envelope, from);
+	g_string_append_c (envelope, ' ');
+	
+	/* rfc3501: the Sender and Reply-To fields default to the From field */
+	list = g_mime_message_get_addresses (message, GMIME_ADDRESS_TYPE_SENDER);
+	envelope_append_addresses (envelope, internet_address_list_length (list) > 0 ? list : from);
+	g_string_append_c (envelope, ' ');
+	list = g_mime_message_get_addresses (message, GMIME_ADDRESS_TYPE_REPLY_TO);
+	envelope_append_addresses (envelope, internet_address_list_length (list) > 0 ? list : from);
+	g_string_append_c (envelope, ' ');
+	
+	envelope_append_addresses (envelope, g_mime_message_get_addresses (message, GMIME_ADDRESS_TYPE_TO));
+	g_string_append_c (envelope, ' ');
+	envelope_append_addresses (envelope, g_mime_message_get_addresses (message, GMIME_ADDRESS_TYPE_CC));
+	g_string_append_c (envelope, ' ');
+	envelope_append_addresses (envelope, g_mime_message_get_addresses (message, GMIME_ADDRESS_TYPE_BCC));
+	g_string_append_c (envelope, ' ');
+	_g_mime_utils_append_imap_header (envelope, headers, "In-Reply-To");
+	g_string_append_c (envelope, ' ');
+	_g_mime_utils_append_imap_header (envelope, headers, "Message-Id");
+	g_string_append_c (envelope, ')');
+}
+
+
+/**
+ * g_mime_message_get_envelope:
+ * @message: A #GMimeMessage
+ *
+ * Formats the IMAP ENVELOPE (as defined by rfc3501) of @message. The
+ * header values are taken in their raw (encoded) form and the
+ * addresses from the already-parsed address lists, so the content of
+ * @message is never touched.
+ *
+ * Returns: (transfer full): a newly allocated string containing the
+ * parenthesized ENVELOPE list.
+ **/
+char *
+g_mime_message_get_envelope (GMimeMessage *message)
+{
+	GString *envelope;
+	
+	g_return_val_if_fail (GMIME_IS_MESSAGE (message), NULL);
+	
+	envelope = g_string_new ("");
+	_g_mime_message_append_envelope (message, envelope);
+	
+	return g_string_free (envelope, FALSE);
+}
+
 
 /**
  * g_mime_message_get_autocrypt_header:
@@ -135,6 +135,8 @@ void g_mime_message_foreach (GMimeMessage *message, GMimeObjectForeachFunc callb
 
 GMimeObject *g_mime_message_get_body (GMimeMessage *message);
 
+char *g_mime_message_get_envelope (GMimeMessage *message);
+
 G_END_DECLS
 
 #endif /* __GMIME_MESSAGE_H__ */
@@ -263,13 +263,11 @@ g_mime_multipart_encrypted_decrypt (GMimeMultipartEncrypted *encrypted, GMimeDec
 				    GError **err)
 {
 	GMimeObject *decrypted, *version_part, *encrypted_part;
-	GMimeStream *filtered, *stream, *ciphertext;
 	const char *protocol, *supported;
 	GMimeContentType *content_type;
 	GMimeDataWrapper *content;
 	GMimeDecryptResult *res;
 	GMimeCryptoContext *ctx;
-	GMimeFilter *filter;
 	GMimeParser *parser;
 	char *mime_type;
 	
@@ -331,37 +329,13 @@ g_mime_multipart_encrypted_decrypt (GMimeMultipartEncrypted *encrypted, GMimeDec
 		return NULL;
 	}
 	
-	/* get the ciphertext stream */
-	content = g_mime_part_get_content ((GMimePart *) encrypted_part);
-	ciphertext = g_mime_stream_mem_new ();
-	g_mime_data_wrapper_write_to_stream (content, ciphertext);
-	g_mime_stream_reset (ciphertext);
-	
-	stream = g_mime_stream_mem_new ();
-	filtered = g_mime_stream_filter_new (stream);
-	filter = g_mime_filter_dos2unix_new (FALSE);
-	g_mime_stream_filter_add ((GMimeStreamFilter *) filtered, filter);
-	g_object_unref (filter);
-	
 	/* get the cleartext */
-	if (!(res = g_mime_crypto_context_decrypt (ctx, flags, session_key, ciphertext, filtered, err))) {
-		g_object_unref (ciphertext);
-		g_object_unref (filtered);
-		g_object_unref (stream);
-		g_object_unref (ctx);
-		
-		return NULL;
-	}
-	
-	g_mime_stream_flush (filtered);
-	g_object_unref (ciphertext);
-	g_object_unref (filtered);
+	content = g_mime_part_get_content ((GMimePart *) encrypted_part);
+	parser = _g_mime_crypto_context_decrypt_content (ctx, flags, session_key, content, &res, err);
 	g_object_unref (ctx);
 	
-	g_mime_stream_reset (stream);
-	parser = g_mime_parser_new ();
-	g_mime_parser_init_with_stream (parser, stream);
-	g_object_unref (stream);
+	if (parser == NULL)
+		return NULL;
 	
 	decrypted = g_mime_parser_construct_part (parser, NULL);
 	g_object_unref (parser);
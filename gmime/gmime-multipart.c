@@ -25,8 +25,13 @@
 
 #include <string.h>
 
+#include "gmime-stream-chunked.h"
+#include "gmime-stream-file.h"
+#include "gmime-stream-mem.h"
+#include "gmime-stream-fs.h"
 #include "gmime-multipart.h"
 #include "gmime-internal.h"
+#include "gmime-part.h"
 #include "gmime-common.h"
 #include "gmime-utils.h"
 
@@ -147,6 +152,133 @@ g_mime_multipart_finalize (GObject *object)
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
+/* parts smaller than this aren't worth handing off to another thread */
+#define PARALLEL_ENCODE_MIN_SIZE (64 * 1024)
+
+typedef struct {
+	GMimeObject *part;
+	GMimeFormatOptions *options;
+	GMimeStream *stream;
+	ssize_t nwritten;
+} EncodeJob;
+
+static void
+encode_job_run (gpointer data, gpointer user_data)
+{
+	EncodeJob *job = data;
+	
+	job->nwritten = g_mime_object_write_to_stream (job->part, job->options, job->stream);
+}
+
+static gboolean
+can_read_in_parallel (GMimeStream *stream, GHashTable *streams)
+{
+	gint64 len;
+	
+	if (stream == NULL || g_hash_table_contains (streams, stream))
+		return FALSE;
+	
+	/* only streams known to be readable independently of any other
+	 * stream qualify: memory-backed ones, and files that are not
+	 * substreams sharing a file descriptor (and its seek position) */
+	if (!GMIME_IS_STREAM_MEM (stream) && !GMIME_IS_STREAM_CHUNKED (stream) &&
+	    !((GMIME_IS_STREAM_FS (stream) || GMIME_IS_STREAM_FILE (stream)) && stream->super_stream == NULL))
+		return FALSE;
+	
+	if ((len = g_mime_stream_length (stream)) != -1 && len < PARALLEL_ENCODE_MIN_SIZE)
+		return FALSE;
+	
+	g_hash_table_add (streams, stream);
+	
+	return TRUE;
+}
+
+static gboolean
+can_encode_in_parallel (GMimeObject *part, GMimeFormatOptions *options, GHashTable *streams)
+{
+	GMimeDataWrapper *content;
+	
+	if (!GMIME_IS_PART (part) || _g_mime_object_can_write_source (part, options))
+		return FALSE;
+	
+	/* only content that actually has to be encoded or decoded is worth it */
+	content = g_mime_part_get_content ((GMimePart *) part);
+	if (content == NULL || g_mime_part_get_content_encoding ((GMimePart *) part) == g_mime_data_wrapper_get_encoding (content))
+		return FALSE;
+	
+	return can_read_in_parallel (g_mime_data_wrapper_get_stream (content), streams);
+}
+
+/* serializes the leaf parts of @multipart that need encoding into
+ * temporary buffers using a pool of threads, returning the buffers
+ * indexed by child or %NULL if there was nothing to do in parallel */
+static GMimeStream **
+multipart_encode_parallel (GMimeMultipart *multipart, GMimeFormatOptions *options)
+{
+	guint max_threads = g_mime_format_options_get_max_threads (options);
+	GMimeStream **encoded = NULL;
+	GHashTable *streams;
+	GThreadPool *pool;
+	EncodeJob *jobs;
+	guint i, n = 0;
+	
+	if (max_threads < 2 || multipart->children->len < 2)
+		return NULL;
+	
+	streams = g_hash_table_new (g_direct_hash, g_direct_equal);
+	jobs = g_new (EncodeJob, multipart->children->len);
+	
+	for (i = 0; i < multipart->children->len; i++) {
+		jobs[i].part = multipart->children->pdata[i];
+		jobs[i].options = options;
+		jobs[i].stream = NULL;
+		jobs[i].nwritten = -1;
+		
+		if (can_encode_in_parallel (jobs[i].part, options, streams)) {
+			jobs[i].stream = g_mime_stream_chunked_new ();
+			n++;
+		}
+	}
+	
+	g_hash_table_destroy (streams);
+	
+	if (n > 1) {
+		pool = g_thread_pool_new (encode_job_run, NULL, (gint) MIN (max_threads, n), FALSE, NULL);
+		
+		for (i = 0; i < multipart->children->len; i++) {
+			if (jobs[i].stream != NULL)
+				g_thread_pool_push (pool, &jobs[i], NULL);
+		}
+		
+		/* wait for all of the jobs to complete */
+		g_thread_pool_free (pool, FALSE, TRUE);
+		
+		encoded = g_new0 (GMimeStream *, multipart->children->len);
+		
+		for (i = 0; i < multipart->children->len; i++) {
+			if (jobs[i].stream == NULL)
+				continue;
+			
+			/* parts that failed get written (and fail) again serially */
+			if (jobs[i].nwritten != -1) {
+				g_mime_stream_reset (jobs[i].stream);
+				encoded[i] = jobs[i].stream;
+			} else {
+				g_object_unref (jobs[i].stream);
+			}
+		}
+	} else {
+		for (i = 0; i < multipart->children->len; i++) {
+			if (jobs[i].stream != NULL)
+				g_object_unref (jobs[i].stream);
+		}
+	}
+	
+	g_free (jobs);
+	
+	return encoded;
+}
+
 static ssize_t
 multipart_write_to_stream (GMimeObject *object, GMimeFormatOptions *options, gboolean content_only, GMimeStream *stream)
 {
@@ -154,6 +286,7 @@ multipart_write_to_stream (GMimeObject *object, GMimeFormatOptions *options, gbo
 	const char *boundary, *newline;
 	ssize_t nwritten, total = 0;
 	GMimeFormatOptions *format;
+	GMimeStream **encoded;
 	gboolean is_signed;
 	GMimeObject *part;
 	guint i;
@@ -175,6 +308,14 @@ multipart_write_to_stream (GMimeObject *object, GMimeFormatOptions *options, gbo
 		total += nwritten;
 	}
 	
+	/* copy unmodified content straight from the stream it was parsed from */
+	if (_g_mime_object_can_write_source (object, options)) {
+		if ((nwritten = _g_mime_object_write_source (object, stream)) == -1)
+			return -1;
+		
+		return total + nwritten;
+	}
+	
 	/* write the prologue */
 	if (multipart->prologue) {
 		if ((nwritten = g_mime_stream_write_string (stream, multipart->prologue)) == -1)
@@ -196,41 +337,52 @@ multipart_write_to_stream (GMimeObject *object, GMimeFormatOptions *options, gbo
 		format = options;
 	}
 	
+	encoded = multipart_encode_parallel (multipart, format);
+	nwritten = 0;
+	
 	for (i = 0; i < multipart->children->len; i++) {
 		part = multipart->children->pdata[i];
 		
 		/* write the boundary */
-		if ((nwritten = g_mime_stream_printf (stream, "--%s%s", boundary, newline)) == -1) {
-			if (is_signed)
-				g_mime_format_options_free (format);
-			return -1;
-		}
+		if ((nwritten = g_mime_stream_printf (stream, "--%s%s", boundary, newline)) == -1)
+			break;
 		
 		total += nwritten;
 		
 		/* write this part out */
-		if ((nwritten = g_mime_object_write_to_stream (part, format, stream)) == -1) {
-			if (is_signed)
-				g_mime_format_options_free (format);
-			return -1;
-		}
+		if (encoded && encoded[i])
+			nwritten = g_mime_stream_write_to_stream (encoded[i], stream);
+		else
+			nwritten = g_mime_object_write_to_stream (part, format, stream);
+		
+		if (nwritten == -1)
+			break;
 		
 		total += nwritten;
 		
 		if (!GMIME_IS_MULTIPART (part) || ((GMimeMultipart *) part)->write_end_boundary) {
-			if ((nwritten = g_mime_stream_write_string (stream, newline)) == -1) {
-				if (is_signed)
-					g_mime_format_options_free (format);
-				return -1;
-			}
+			if ((nwritten = g_mime_stream_write_string (stream, newline)) == -1)
+				break;
 			
 			total += nwritten;
 		}
 	}
 	
+	if (encoded) {
+		for (i = 0; i < multipart->children->len; i++) {
+			if (encoded[i])
+				g_object_unref (encoded[i]);
+		}
+		
+		g_free (encoded);
+	}
+	
 	if (is_signed)
 		g_mime_format_options_free (format);
 	
+	if (nwritten == -1)
+		return -1;
+	
 	/* write the end-boundary (but only if a boundary is set) */
 	if (multipart->write_end_boundary && boundary) {
 		if ((nwritten = g_mime_stream_printf (stream, "--%s--%s", boundary, newline)) == -1)
@@ -250,17 +402,119 @@ multipart_write_to_stream (GMimeObject *object, GMimeFormatOptions *options, gbo
 	return total;
 }
 
+typedef struct {
+	GMimePart *part;
+	GMimeFilter *filter;
+} ScanJob;
+
+static void
+scan_job_run (gpointer data, gpointer user_data)
+{
+	ScanJob *job = data;
+	
+	job->filter = _g_mime_part_encode_scan (job->part);
+}
+
+static gboolean
+can_scan_in_parallel (GMimeObject *part, GMimeEncodingConstraint constraint, GHashTable *streams)
+{
+	GMimeObjectClass *part_class;
+	GMimeDataWrapper *content;
+	
+	if (!GMIME_IS_PART (part))
+		return FALSE;
+	
+	/* a subclass that overrides encode() may not scan the content */
+	part_class = g_type_class_peek (GMIME_TYPE_PART);
+	if (GMIME_OBJECT_GET_CLASS (part)->encode != part_class->encode)
+		return FALSE;
+	
+	if (!_g_mime_part_encode_needs_scan ((GMimePart *) part, constraint))
+		return FALSE;
+	
+	if (!(content = g_mime_part_get_content ((GMimePart *) part)))
+		return FALSE;
+	
+	return can_read_in_parallel (g_mime_data_wrapper_get_stream (content), streams);
+}
+
+/* scans the content of the leaf parts of @multipart that need it using
+ * a pool of threads, returning the resulting #GMimeFilterBest filters
+ * indexed by child or %NULL if there was nothing to do in parallel */
+static GMimeFilter **
+multipart_scan_parallel (GMimeMultipart *multipart, GMimeEncodingConstraint constraint)
+{
+	guint max_threads = g_mime_format_options_get_max_threads (NULL);
+	GMimeFilter **scanned = NULL;
+	GHashTable *streams;
+	GThreadPool *pool;
+	ScanJob *jobs;
+	guint i, n = 0;
+	
+	if (max_threads < 2 || multipart->children->len < 2)
+		return NULL;
+	
+	streams = g_hash_table_new (g_direct_hash, g_direct_equal);
+	jobs = g_new (ScanJob, multipart->children->len);
+	
+	for (i = 0; i < multipart->children->len; i++) {
+		jobs[i].part = NULL;
+		jobs[i].filter = NULL;
+		
+		if (can_scan_in_parallel (multipart->children->pdata[i], constraint, streams)) {
+			jobs[i].part = multipart->children->pdata[i];
+			n++;
+		}
+	}
+	
+	g_hash_table_destroy (streams);
+	
+	if (n > 1) {
+		pool = g_thread_pool_new (scan_job_run, NULL, (gint) MIN (max_threads, n), FALSE, NULL);
+		
+		for (i = 0; i < multipart->children->len; i++) {
+			if (jobs[i].part != NULL)
+				g_thread_pool_push (pool, &jobs[i], NULL);
+		}
+		
+		/* wait for all of the jobs to complete */
+		g_thread_pool_free (pool, FALSE, TRUE);
+		
+		scanned = g_new (GMimeFilter *, multipart->children->len);
+		
+		for (i = 0; i < multipart->children->len; i++)
+			scanned[i] = jobs[i].filter;
+	}
+	
+	g_free (jobs);
+	
+	return scanned;
+}
+
 static void
 multipart_encode (GMimeObject *object, GMimeEncodingConstraint constraint)
 {
 	GMimeMultipart *multipart = (GMimeMultipart *) object;
 	GMimeObject *subpart;
+	GMimeFilter **scanned;
 	int i;
 	
+	/* the content of large leaf parts is scanned concurrently first;
+	 * the encodings are then set here, in order, as before */
+	scanned = multipart_scan_parallel (multipart, constraint);
+	
 	for (i = 0; i < g_mime_multipart_get_count (multipart); i++) {
 		subpart = g_mime_multipart_get_part (multipart, i);
-		g_mime_object_encode (subpart, constraint);
+		
+		if (scanned != NULL && scanned[i] != NULL) {
+			_g_mime_part_encode_apply ((GMimePart *) subpart, constraint, scanned[i]);
+			g_object_unref (scanned[i]);
+		} else {
+			g_mime_object_encode (subpart, constraint);
+		}
 	}
+	
+	g_free (scanned);
 }
 
 
@@ -322,6 +576,7 @@ g_mime_multipart_set_prologue (GMimeMultipart *multipart, const char *prologue)
 	
 	g_free (multipart->prologue);
 	multipart->prologue = g_strdup (prologue);
+	_g_mime_object_clear_source ((GMimeObject *) multipart);
 }
 
 
@@ -356,6 +611,7 @@ g_mime_multipart_set_epilogue (GMimeMultipart *multipart, const char *epilogue)
 	
 	g_free (multipart->epilogue);
 	multipart->epilogue = g_strdup (epilogue);
+	_g_mime_object_clear_source ((GMimeObject *) multipart);
 }
 
 
@@ -399,6 +655,8 @@ g_mime_multipart_clear (GMimeMultipart *multipart)
 {
 	g_return_if_fail (GMIME_IS_MULTIPART (multipart));
 	
+	_g_mime_object_clear_source ((GMimeObject *) multipart);
+	
 	GMIME_MULTIPART_GET_CLASS (multipart)->clear (multipart);
 }
 
@@ -424,6 +682,8 @@ g_mime_multipart_add (GMimeMultipart *multipart, GMimeObject *part)
 	g_return_if_fail (GMIME_IS_MULTIPART (multipart));
 	g_return_if_fail (GMIME_IS_OBJECT (part));
 	
+	_g_mime_object_clear_source ((GMimeObject *) multipart);
+	
 	GMIME_MULTIPART_GET_CLASS (multipart)->add (multipart, part);
 }
 
@@ -473,6 +733,8 @@ g_mime_multipart_insert (GMimeMultipart *multipart, int index, GMimeObject *part
 	g_return_if_fail (GMIME_IS_OBJECT (part));
 	g_return_if_fail (index >= 0);
 	
+	_g_mime_object_clear_source ((GMimeObject *) multipart);
+	
 	GMIME_MULTIPART_GET_CLASS (multipart)->insert (multipart, index, part);
 }
 
@@ -504,7 +766,12 @@ g_mime_multipart_remove (GMimeMultipart *multipart, GMimeObject *part)
 	g_return_val_if_fail (GMIME_IS_MULTIPART (multipart), FALSE);
 	g_return_val_if_fail (GMIME_IS_OBJECT (part), FALSE);
 	
-	return GMIME_MULTIPART_GET_CLASS (multipart)->remove (multipart, part);
+	if (!GMIME_MULTIPART_GET_CLASS (multipart)->remove (multipart, part))
+		return FALSE;
+	
+	_g_mime_object_clear_source ((GMimeObject *) multipart);
+	
+	return TRUE;
 }
 
 
@@ -537,10 +804,17 @@ multipart_remove_at (GMimeMultipart *multipart, int index)
 GMimeObject *
 g_mime_multipart_remove_at (GMimeMultipart *multipart, int index)
 {
+	GMimeObject *part;
+	
 	g_return_val_if_fail (GMIME_IS_MULTIPART (multipart), NULL);
 	g_return_val_if_fail (index >= 0, NULL);
 	
-	return GMIME_MULTIPART_GET_CLASS (multipart)->remove_at (multipart, index);
+	if (!(part = GMIME_MULTIPART_GET_CLASS (multipart)->remove_at (multipart, index)))
+		return NULL;
+	
+	_g_mime_object_clear_source ((GMimeObject *) multipart);
+	
+	return part;
 }
 
 
@@ -572,6 +846,8 @@ g_mime_multipart_replace (GMimeMultipart *multipart, int index, GMimeObject *rep
 	multipart->children->pdata[index] = replacement;
 	g_object_ref (replacement);
 	
+	_g_mime_object_clear_source ((GMimeObject *) multipart);
+	
 	return replaced;
 }
 
@@ -703,21 +979,11 @@ g_mime_multipart_get_count (GMimeMultipart *multipart)
 static void
 multipart_set_boundary (GMimeMultipart *multipart, const char *boundary)
 {
-	char bbuf[35];
+	char bbuf[GMIME_ID_GENERATOR_BOUNDARY_LEN + 1];
 	
 	if (!boundary) {
 		/* Generate a fairly random boundary string. */
-		unsigned char digest[16], *p;
-		guint32 save = 0;
-		int state = 0;
-		
-		g_mime_read_random_pool (digest, 16);
-		
-		strcpy (bbuf, "=-");
-		p = (unsigned char *) bbuf + 2;
-		p += g_mime_encoding_base64_encode_step (digest, 16, p, &state, &save);
-		*p = '\0';
-		
+		g_mime_id_generator_format_boundary (g_mime_id_generator_get_default (), bbuf, sizeof (bbuf));
 		boundary = bbuf;
 	}
 	
@@ -25,13 +25,20 @@
 
 #include <ctype.h>
 #include <string.h>
+#include <errno.h>
 
 #include "gmime-common.h"
 #include "gmime-object.h"
+#include "gmime-multipart.h"
+#include "gmime-message.h"
+#include "gmime-message-part.h"
 #include "gmime-stream-mem.h"
+#include "gmime-stream-null.h"
+#include "gmime-part.h"
 #include "gmime-internal.h"
 #include "gmime-events.h"
 #include "gmime-utils.h"
+#include "gmime-error.h"
 
 
 /**
@@ -55,6 +62,20 @@ struct _subtype_bucket {
 	GType object_type;
 };
 
+typedef struct {
+	/* the raw content the object was parsed from */
+	GMimeStream *source;
+	
+	/* the generation of a GMimePart's content when the source was recorded */
+	guint content_generation;
+	
+	/* the size of the raw content as recorded by the parser */
+	gint64 content_octets;
+	gint64 content_lines;
+} GMimeObjectPrivate;
+
+#define GMIME_OBJECT_GET_PRIVATE(object) ((GMimeObjectPrivate *) G_STRUCT_MEMBER_P (object, object_private_offset))
+
 static void _g_mime_object_set_content_disposition (GMimeObject *object, GMimeContentDisposition *disposition);
 void _g_mime_object_set_content_type (GMimeObject *object, GMimeContentType *content_type);
 
@@ -80,6 +101,7 @@ static void content_disposition_changed (GMimeContentDisposition *disposition, g
 static GHashTable *type_hash = NULL;
 
 static GObjectClass *parent_class = NULL;
+static gint object_private_offset = 0;
 
 
 GType
@@ -102,6 +124,7 @@ g_mime_object_get_type (void)
 		
 		type = g_type_register_static (G_TYPE_OBJECT, "GMimeObject",
 					       &info, G_TYPE_FLAG_ABSTRACT);
+		object_private_offset = g_type_add_instance_private (type, sizeof (GMimeObjectPrivate));
 	}
 	
 	return type;
@@ -114,6 +137,7 @@ g_mime_object_class_init (GMimeObjectClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	
 	parent_class = g_type_class_ref (G_TYPE_OBJECT);
+	g_type_class_adjust_private_offset (klass, &object_private_offset);
 	
 	object_class->finalize = g_mime_object_finalize;
 	
@@ -130,22 +154,27 @@ g_mime_object_class_init (GMimeObjectClass *klass)
 static void
 g_mime_object_init (GMimeObject *object, GMimeObjectClass *klass)
 {
+	GMimeObjectPrivate *priv = GMIME_OBJECT_GET_PRIVATE (object);
 	GMimeHeaderList *headers;
 	
 	headers = g_mime_header_list_new (g_mime_parser_options_get_default ());
-	g_mime_event_add (headers->changed, (GMimeEventCallback) header_list_changed, object);
+	g_mime_event_add (&headers->changed, headers, (GMimeEventCallback) header_list_changed, object);
 	object->headers = headers;
 	
 	object->ensure_newline = FALSE;
 	object->content_type = NULL;
 	object->disposition = NULL;
 	object->content_id = NULL;
+	
+	priv->content_octets = -1;
+	priv->content_lines = -1;
 }
 
 
 static void
 g_mime_object_finalize (GObject *object)
 {
+	GMimeObjectPrivate *priv = GMIME_OBJECT_GET_PRIVATE (object);
 	GMimeObject *mime = (GMimeObject *) object;
 	GMimeEvent *event;
 	
@@ -167,6 +196,9 @@ g_mime_object_finalize (GObject *object)
 		g_object_unref (mime->headers);
 	}
 	
+	if (priv->source)
+		g_object_unref (priv->source);
+	
 	g_free (mime->content_id);
 	
 	G_OBJECT_CLASS (parent_class)->finalize (object);
@@ -198,7 +230,7 @@ object_header_changed (GMimeObject *object, GMimeHeader *header)
 	gboolean can_warn = g_mime_parser_options_get_warning_callback (options) != NULL;
 	GMimeContentDisposition *disposition;
 	GMimeContentType *content_type;
-	const char *name, *value;
+	const char *name;
 	guint i;
 	
 	name = g_mime_header_get_name (header);
@@ -217,21 +249,20 @@ object_header_changed (GMimeObject *object, GMimeHeader *header)
 	
 	switch (i) {
 	case HEADER_CONTENT_DISPOSITION:
-		value = g_mime_header_get_value (header);
-		disposition = _g_mime_content_disposition_parse (options, value, header->offset);
-		_g_mime_object_set_content_disposition (object, disposition);
-		g_object_unref (disposition);
+		if ((disposition = _g_mime_header_dup_content_disposition (header))) {
+			_g_mime_object_set_content_disposition (object, disposition);
+			g_object_unref (disposition);
+		}
 		break;
 	case HEADER_CONTENT_TYPE:
-		value = g_mime_header_get_value (header);
-		content_type = _g_mime_content_type_parse (options, value, header->offset);
-		_g_mime_object_set_content_type (object, content_type);
-		g_object_unref (content_type);
+		if ((content_type = _g_mime_header_dup_content_type (header))) {
+			_g_mime_object_set_content_type (object, content_type);
+			g_object_unref (content_type);
+		}
 		break;
 	case HEADER_CONTENT_ID:
-		value = g_mime_header_get_value (header);
 		g_free (object->content_id);
-		object->content_id = g_mime_utils_decode_message_id (value);
+		object->content_id = g_strdup (_g_mime_header_get_message_id (header));
 		break;
 	}
 }
@@ -326,6 +357,9 @@ content_type_changed (GMimeContentType *content_type, gpointer args, GMimeObject
 	
 	raw_value = g_mime_content_type_encode (content_type, NULL);
 	
+	/* the boundary may have changed */
+	_g_mime_object_clear_source (object);
+	
 	_g_mime_object_block_header_list_changed (object);
 	_g_mime_header_list_set (object->headers, "Content-Type", raw_value);
 	_g_mime_object_unblock_header_list_changed (object);
@@ -506,9 +540,11 @@ object_set_content_type (GMimeObject *object, GMimeContentType *content_type)
 		g_object_unref (object->content_type);
 	}
 	
-	g_mime_event_add (content_type->changed, (GMimeEventCallback) content_type_changed, object);
+	g_mime_event_add (&content_type->changed, content_type, (GMimeEventCallback) content_type_changed, object);
 	object->content_type = content_type;
 	g_object_ref (content_type);
+	
+	_g_mime_object_clear_source (object);
 }
 
 
@@ -650,7 +686,7 @@ _g_mime_object_set_content_disposition (GMimeObject *object, GMimeContentDisposi
 		g_object_unref (object->disposition);
 	}
 	
-	g_mime_event_add (disposition->changed, (GMimeEventCallback) content_disposition_changed, object);
+	g_mime_event_add (&disposition->changed, disposition, (GMimeEventCallback) content_disposition_changed, object);
 	object->disposition = disposition;
 	g_object_ref (disposition);
 }
@@ -853,6 +889,237 @@ _g_mime_object_append_header (GMimeObject *object, const char *header, const cha
 }
 
 
+/**
+ * _g_mime_object_begin_construct:
+ * @object: a #GMimeObject
+ *
+ * Stops changes to the header list of @object from propagating to
+ * @object until _g_mime_object_end_construct() is called, so that a
+ * block of headers can be appended without deriving the state of
+ * @object (content type, disposition, addresses, ...) after each one.
+ *
+ * Note: This method is meant for use by #GMimeParser.
+ **/
+void
+_g_mime_object_begin_construct (GMimeObject *object)
+{
+	_g_mime_object_block_header_list_changed (object);
+}
+
+
+/**
+ * _g_mime_object_end_construct:
+ * @object: a #GMimeObject
+ *
+ * Resumes the propagation of header list changes to @object and
+ * derives the state of @object from the headers that were appended
+ * since _g_mime_object_begin_construct() was called.
+ *
+ * Note: This method is meant for use by #GMimeParser.
+ **/
+void
+_g_mime_object_end_construct (GMimeObject *object)
+{
+	GMimeObjectClass *klass = GMIME_OBJECT_GET_CLASS (object);
+	GMimeHeaderList *headers = object->headers;
+	guint i;
+	
+	_g_mime_object_unblock_header_list_changed (object);
+	
+	for (i = 0; i < headers->array->len; i++)
+		klass->header_added (object, (GMimeHeader *) headers->array->pdata[i]);
+}
+
+
+static void
+object_save_content_generation (GMimeObject *object)
+{
+	GMimeObjectPrivate *priv = GMIME_OBJECT_GET_PRIVATE (object);
+	GMimeDataWrapper *content;
+	
+	if (GMIME_IS_PART (object) && (content = ((GMimePart *) object)->content))
+		priv->content_generation = _g_mime_data_wrapper_get_generation (content);
+}
+
+static gboolean
+object_content_was_replaced (GMimeObject *object)
+{
+	GMimeObjectPrivate *priv = GMIME_OBJECT_GET_PRIVATE (object);
+	GMimeDataWrapper *content;
+	
+	/* g_mime_part_set_content() clears the source, but the stream
+	 * or encoding of the existing content may have been changed */
+	if (!GMIME_IS_PART (object) || !(content = ((GMimePart *) object)->content))
+		return FALSE;
+	
+	return _g_mime_data_wrapper_get_generation (content) != priv->content_generation;
+}
+
+
+/**
+ * _g_mime_object_set_source:
+ * @object: a #GMimeObject
+ * @source: (nullable): the stream the content of @object was parsed from
+ *
+ * Records the raw content that @object was parsed from and marks its
+ * headers as unmodified. For a #GMimeMessage, @source also includes the
+ * message headers.
+ *
+ * Note: This method is meant for use by #GMimeParser.
+ **/
+void
+_g_mime_object_set_source (GMimeObject *object, GMimeStream *source)
+{
+	GMimeObjectPrivate *priv = GMIME_OBJECT_GET_PRIVATE (object);
+	
+	if (source)
+		g_object_ref (source);
+	
+	if (priv->source)
+		g_object_unref (priv->source);
+	
+	object_save_content_generation (object);
+	_g_mime_header_list_set_dirty (object->headers, FALSE);
+	priv->source = source;
+}
+
+
+/**
+ * _g_mime_object_clear_source:
+ * @object: a #GMimeObject
+ *
+ * Forgets the raw content that @object was parsed from as well as its
+ * recorded size. This must be called whenever the content of @object
+ * is modified.
+ **/
+void
+_g_mime_object_clear_source (GMimeObject *object)
+{
+	GMimeObjectPrivate *priv = GMIME_OBJECT_GET_PRIVATE (object);
+	
+	if (priv->source) {
+		g_object_unref (priv->source);
+		priv->source = NULL;
+	}
+	
+	priv->content_octets = -1;
+	priv->content_lines = -1;
+}
+
+
+/**
+ * _g_mime_object_set_content_size:
+ * @object: a #GMimeObject
+ * @octets: the number of octets in the raw content
+ * @lines: the number of lines in the raw content
+ *
+ * Records the size of the raw content that @object was parsed from and
+ * marks its headers as unmodified. For a #GMimeMessage, the size also
+ * includes the message headers.
+ *
+ * Note: This method is meant for use by #GMimeParser.
+ **/
+void
+_g_mime_object_set_content_size (GMimeObject *object, gint64 octets, gint64 lines)
+{
+	GMimeObjectPrivate *priv = GMIME_OBJECT_GET_PRIVATE (object);
+	
+	object_save_content_generation (object);
+	_g_mime_header_list_set_dirty (object->headers, FALSE);
+	priv->content_octets = octets;
+	priv->content_lines = lines;
+}
+
+static gboolean object_is_pristine (GMimeObject *object);
+
+static gboolean
+object_content_is_pristine (GMimeObject *object)
+{
+	GMimeMultipart *multipart;
+	GMimeMessage *message;
+	guint i;
+	
+	if (GMIME_OBJECT_GET_PRIVATE (object)->source == NULL)
+		return FALSE;
+	
+	if (GMIME_IS_PART (object)) {
+		if (object_content_was_replaced (object))
+			return FALSE;
+	} else if (GMIME_IS_MULTIPART (object)) {
+		multipart = (GMimeMultipart *) object;
+		
+		for (i = 0; i < multipart->children->len; i++) {
+			if (!object_is_pristine (multipart->children->pdata[i]))
+				return FALSE;
+		}
+	} else if (GMIME_IS_MESSAGE_PART (object)) {
+		message = ((GMimeMessagePart *) object)->message;
+		
+		if (message == NULL || !object_is_pristine ((GMimeObject *) message))
+			return FALSE;
+	} else if (GMIME_IS_MESSAGE (object)) {
+		message = (GMimeMessage *) object;
+		
+		/* the message's source includes the headers of its toplevel part */
+		if (message->mime_part == NULL || !object_is_pristine (message->mime_part))
+			return FALSE;
+	}
+	
+	return TRUE;
+}
+
+static gboolean
+object_is_pristine (GMimeObject *object)
+{
+	return !_g_mime_header_list_is_dirty (object->headers) && object_content_is_pristine (object);
+}
+
+
+/**
+ * _g_mime_object_can_write_source:
+ * @object: a #GMimeObject
+ * @options: (nullable): a #GMimeFormatOptions or %NULL
+ *
+ * Checks whether the content of @object can be copied verbatim from
+ * the stream it was parsed from. For a #GMimeMessage, this also checks
+ * the message headers.
+ *
+ * Returns: %TRUE if _g_mime_object_write_source() may be used.
+ **/
+gboolean
+_g_mime_object_can_write_source (GMimeObject *object, GMimeFormatOptions *options)
+{
+	if (!_g_mime_format_options_can_write_verbatim (options))
+		return FALSE;
+	
+	if (GMIME_IS_MESSAGE (object))
+		return object_is_pristine (object);
+	
+	return object_content_is_pristine (object);
+}
+
+
+/**
+ * _g_mime_object_write_source:
+ * @object: a #GMimeObject
+ * @stream: output stream
+ *
+ * Copies the raw content that @object was parsed from to @stream.
+ *
+ * Returns: the number of bytes written or %-1 on fail.
+ **/
+ssize_t
+_g_mime_object_write_source (GMimeObject *object, GMimeStream *stream)
+{
+	GMimeObjectPrivate *priv = GMIME_OBJECT_GET_PRIVATE (object);
+	
+	if (g_mime_stream_reset (priv->source) == -1)
+		return -1;
+	
+	return g_mime_stream_write_to_stream (priv->source, stream);
+}
+
+
 /**
  * g_mime_object_append_header:
  * @object: a #GMimeObject
@@ -989,6 +1256,330 @@ g_mime_object_write_to_stream (GMimeObject *object, GMimeFormatOptions *options,
 }
 
 
+/* the serialized output of an asynchronous write is handed to the
+ * main loop in chunks of this size */
+#define WRITE_ASYNC_CHUNK_SIZE (64 * 1024)
+
+typedef struct {
+	GMimeFormatOptions *options;
+	GCancellable *cancellable;
+	GOutputStream *ostream;
+	int io_priority;
+	GTask *task;
+	
+	/* chunks of serialized output waiting to be written (GBytes),
+	 * filled by the worker thread and drained by the main loop */
+	GMutex lock;
+	GQueue chunks;
+	gboolean scheduled;
+	gint failed;
+	
+	/* the chunk being filled, only accessed by the worker thread */
+	GByteArray *buffer;
+	
+	/* only accessed from the task's main context */
+	gboolean serialized;
+	gboolean returned;
+	GBytes *writing;
+	gsize nwritten;
+	GError *error;
+} ObjectWriteAsyncData;
+
+static void object_write_next (GTask *task);
+
+static void
+object_write_clear_chunks (ObjectWriteAsyncData *data)
+{
+	GBytes *bytes;
+	
+	g_mutex_lock (&data->lock);
+	while ((bytes = g_queue_pop_head (&data->chunks)))
+		g_bytes_unref (bytes);
+	g_mutex_unlock (&data->lock);
+}
+
+static void
+object_write_async_data_free (ObjectWriteAsyncData *data)
+{
+	object_write_clear_chunks (data);
+	g_mutex_clear (&data->lock);
+	
+	if (data->options)
+		g_mime_format_options_free (data->options);
+	if (data->error)
+		g_error_free (data->error);
+	g_object_unref (data->ostream);
+	g_free (data);
+}
+
+static gboolean
+object_write_next_idle (gpointer user_data)
+{
+	object_write_next (user_data);
+	
+	return G_SOURCE_REMOVE;
+}
+
+/* called on the worker thread to hand the current chunk to the main loop */
+static void
+object_write_queue_chunk (ObjectWriteAsyncData *data)
+{
+	gboolean schedule;
+	GSource *source;
+	GBytes *bytes;
+	
+	if (data->buffer->len == 0)
+		return;
+	
+	bytes = g_byte_array_free_to_bytes (data->buffer);
+	data->buffer = g_byte_array_sized_new (WRITE_ASYNC_CHUNK_SIZE);
+	
+	g_mutex_lock (&data->lock);
+	g_queue_push_tail (&data->chunks, bytes);
+	schedule = !data->scheduled;
+	data->scheduled = TRUE;
+	g_mutex_unlock (&data->lock);
+	
+	if (!schedule)
+		return;
+	
+	/* an idle source rather than g_main_context_invoke(), which could
+	 * run the callback right here if the context happens to be free */
+	source = g_idle_source_new ();
+	g_source_set_priority (source, data->io_priority);
+	g_source_set_callback (source, object_write_next_idle, g_object_ref (data->task), g_object_unref);
+	g_source_attach (source, g_task_get_context (data->task));
+	g_source_unref (source);
+}
+
+/* called on the worker thread with the output of the serializer */
+static ssize_t
+object_write_sink (const char *buf, size_t len, gpointer user_data)
+{
+	ObjectWriteAsyncData *data = user_data;
+	
+	/* stop serializing once the output has failed or been cancelled */
+	if (g_atomic_int_get (&data->failed) || g_cancellable_is_cancelled (data->cancellable)) {
+		errno = ECANCELED;
+		return -1;
+	}
+	
+	g_byte_array_append (data->buffer, (const guint8 *) buf, len);
+	
+	if (data->buffer->len >= WRITE_ASYNC_CHUNK_SIZE)
+		object_write_queue_chunk (data);
+	
+	return len;
+}
+
+static void
+object_write_serialize (GTask *serializer, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	ObjectWriteAsyncData *data = task_data;
+	GMimeObject *object = source_object;
+	GMimeStream *sink;
+	ssize_t nwritten;
+	int errnosav;
+	
+	if (g_task_return_error_if_cancelled (serializer))
+		return;
+	
+	data->buffer = g_byte_array_sized_new (WRITE_ASYNC_CHUNK_SIZE);
+	sink = _g_mime_stream_callback_new (object_write_sink, data);
+	nwritten = g_mime_object_write_to_stream (object, data->options, sink);
+	errnosav = errno;
+	g_object_unref (sink);
+	
+	if (nwritten != -1)
+		object_write_queue_chunk (data);
+	
+	g_byte_array_free (data->buffer, TRUE);
+	data->buffer = NULL;
+	
+	if (nwritten != -1)
+		g_task_return_boolean (serializer, TRUE);
+	else if (!g_task_return_error_if_cancelled (serializer))
+		g_task_return_new_error (serializer, GMIME_ERROR, errnosav, "Failed to write message: %s", g_strerror (errnosav));
+}
+
+static void
+object_write_fail (ObjectWriteAsyncData *data, GError *err)
+{
+	if (data->error == NULL)
+		data->error = err;
+	else
+		g_error_free (err);
+	
+	/* tell the serializer to stop and drop what it has produced */
+	g_atomic_int_set (&data->failed, 1);
+	object_write_clear_chunks (data);
+}
+
+static void
+object_write_chunk_done (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GTask *task = user_data;
+	ObjectWriteAsyncData *data = g_task_get_task_data (task);
+	GError *err = NULL;
+	gsize nwritten;
+	
+	g_bytes_unref (data->writing);
+	data->writing = NULL;
+	
+	if (g_output_stream_write_all_finish ((GOutputStream *) source, result, &nwritten, &err))
+		data->nwritten += nwritten;
+	else
+		object_write_fail (data, err);
+	
+	object_write_next (task);
+	g_object_unref (task);
+}
+
+/* writes the next queued chunk, or completes the task once the
+ * serializer is done and everything it produced has been written */
+static void
+object_write_next (GTask *task)
+{
+	ObjectWriteAsyncData *data = g_task_get_task_data (task);
+	gconstpointer buf;
+	GBytes *bytes;
+	gsize len;
+	
+	if (data->writing != NULL || data->returned)
+		return;
+	
+	/* anything the serializer queued after a failure is dropped */
+	if (data->error != NULL)
+		object_write_clear_chunks (data);
+	
+	g_mutex_lock (&data->lock);
+	bytes = g_queue_pop_head (&data->chunks);
+	data->scheduled = FALSE;
+	g_mutex_unlock (&data->lock);
+	
+	if (bytes != NULL) {
+		data->writing = bytes;
+		buf = g_bytes_get_data (bytes, &len);
+		
+		g_output_stream_write_all_async (data->ostream, buf, len, data->io_priority, data->cancellable,
+						 object_write_chunk_done, g_object_ref (task));
+		return;
+	}
+	
+	if (!data->serialized)
+		return;
+	
+	data->returned = TRUE;
+	
+	if (data->error != NULL) {
+		g_task_return_error (task, data->error);
+		data->error = NULL;
+	} else {
+		g_task_return_int (task, (gssize) data->nwritten);
+	}
+}
+
+static void
+object_write_serialized (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GTask *task = user_data;
+	ObjectWriteAsyncData *data = g_task_get_task_data (task);
+	GError *err = NULL;
+	
+	if (!g_task_propagate_boolean ((GTask *) result, &err))
+		object_write_fail (data, err);
+	
+	data->serialized = TRUE;
+	object_write_next (task);
+	g_object_unref (task);
+}
+
+
+/**
+ * g_mime_object_write_to_stream_async:
+ * @object: a #GMimeObject
+ * @options: (nullable): a #GMimeFormatOptions or %NULL
+ * @stream: a #GOutputStream
+ * @io_priority: the I/O priority of the write requests
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the object has been written
+ * @user_data: (closure): user data for @callback
+ *
+ * Asynchronously writes the headers and content of the MIME object
+ * to @stream.
+ *
+ * The object is serialized on a worker thread, which hands the output
+ * over in chunks as it is produced. The chunks are written to @stream
+ * with g_output_stream_write_all_async() at @io_priority, so no thread
+ * is ever blocked on the output. The serializer does not wait for the
+ * output stream either, so a slow stream means more of the output is
+ * held in memory at once.
+ *
+ * @object must not be modified until @callback has been invoked. Call
+ * g_mime_object_write_to_stream_finish() from @callback to get the
+ * result.
+ **/
+void
+g_mime_object_write_to_stream_async (GMimeObject *object, GMimeFormatOptions *options, GOutputStream *stream,
+				     int io_priority, GCancellable *cancellable,
+				     GAsyncReadyCallback callback, gpointer user_data)
+{
+	ObjectWriteAsyncData *data;
+	GTask *task, *serializer;
+	
+	g_return_if_fail (GMIME_IS_OBJECT (object));
+	g_return_if_fail (G_IS_OUTPUT_STREAM (stream));
+	
+	task = g_task_new (object, cancellable, callback, user_data);
+	g_task_set_source_tag (task, g_mime_object_write_to_stream_async);
+	g_task_set_priority (task, io_priority);
+	
+	data = g_new0 (ObjectWriteAsyncData, 1);
+	data->options = options ? g_mime_format_options_clone (options) : NULL;
+	data->cancellable = cancellable;
+	data->io_priority = io_priority;
+	data->ostream = stream;
+	data->task = task;
+	g_object_ref (stream);
+	
+	g_mutex_init (&data->lock);
+	g_queue_init (&data->chunks);
+	
+	g_task_set_task_data (task, data, (GDestroyNotify) object_write_async_data_free);
+	
+	/* the serializer's callback holds a reference on @task (and so on
+	 * @data) until the worker thread is done with it */
+	serializer = g_task_new (object, cancellable, object_write_serialized, g_object_ref (task));
+	g_task_set_task_data (serializer, data, NULL);
+	g_task_set_priority (serializer, io_priority);
+	
+	g_task_run_in_thread (serializer, object_write_serialize);
+	g_object_unref (serializer);
+	g_object_unref (task);
+}
+
+
+/**
+ * g_mime_object_write_to_stream_finish:
+ * @object: a #GMimeObject
+ * @result: a #GAsyncResult
+ * @err: a #GError
+ *
+ * Finishes an operation started with g_mime_object_write_to_stream_async().
+ *
+ * Returns: the number of bytes written or %-1 on fail, in which case
+ * @err will be set.
+ **/
+ssize_t
+g_mime_object_write_to_stream_finish (GMimeObject *object, GAsyncResult *result, GError **err)
+{
+	g_return_val_if_fail (GMIME_IS_OBJECT (object), -1);
+	g_return_val_if_fail (g_task_is_valid (result, object), -1);
+	
+	return g_task_propagate_int ((GTask *) result, err);
+}
+
+
 /**
  * g_mime_object_write_content_to_stream:
  * @object: a #GMimeObject
@@ -1033,32 +1624,95 @@ g_mime_object_encode (GMimeObject *object, GMimeEncodingConstraint constraint)
 }
 
 
-/**
- * g_mime_object_to_string:
- * @object: a #GMimeObject
- * @options: (nullable): a #GMimeFormatOptions or %NULL
- *
- * Allocates a string buffer containing the contents of @object.
- *
- * Returns: an allocated string containing the contents of the mime
- * object.
- **/
+/* Serializing into memory is done in two passes: the first one writes
+ * to a null stream to measure the output and the second one writes it
+ * straight into a buffer allocated at exactly that size, so that the
+ * result is allocated once instead of being grown (and copied) as it
+ * is written. */
+ssize_t
+_g_mime_serialized_length (GMimeWriteFunc write, gpointer object, GMimeFormatOptions *options)
+{
+	GMimeStream *stream;
+	ssize_t nwritten;
+	size_t len;
+	
+	stream = g_mime_stream_null_new ();
+	nwritten = write (object, options, stream);
+	len = ((GMimeStreamNull *) stream)->written;
+	g_object_unref (stream);
+	
+	return nwritten == -1 ? -1 : (ssize_t) len;
+}
+
+typedef struct {
+	char *buffer;
+	size_t buflen;
+	size_t total;
+} SerializeBuffer;
+
+static ssize_t
+serialize_buffer_write (const char *buf, size_t len, gpointer user_data)
+{
+	SerializeBuffer *sb = (SerializeBuffer *) user_data;
+	
+	/* copy as much as fits and keep counting the rest */
+	if (sb->total < sb->buflen)
+		memcpy (sb->buffer + sb->total, buf, MIN (len, sb->buflen - sb->total));
+	
+	sb->total += len;
+	
+	return (ssize_t) len;
+}
+
+/* Writes up to @buflen bytes of the output straight into @buffer and
+ * returns the full length of the output, or -1 if the write failed. */
+ssize_t
+_g_mime_serialize_to_buffer (GMimeWriteFunc write, gpointer object, GMimeFormatOptions *options, char *buffer, size_t buflen)
+{
+	GMimeStream *stream;
+	SerializeBuffer sb;
+	ssize_t nwritten;
+	
+	sb.buffer = buffer;
+	sb.buflen = buflen;
+	sb.total = 0;
+	
+	stream = _g_mime_stream_callback_new (serialize_buffer_write, &sb);
+	nwritten = write (object, options, stream);
+	g_object_unref (stream);
+	
+	return nwritten == -1 ? -1 : (ssize_t) sb.total;
+}
+
 char *
-g_mime_object_to_string (GMimeObject *object, GMimeFormatOptions *options)
+_g_mime_serialize_to_string (GMimeWriteFunc write, gpointer object, GMimeFormatOptions *options)
 {
 	GMimeStream *stream;
 	GByteArray *array;
+	ssize_t length;
 	char *str;
 	
-	g_return_val_if_fail (GMIME_IS_OBJECT (object), NULL);
+	if ((length = _g_mime_serialized_length (write, object, options)) != -1) {
+		str = g_malloc ((size_t) length + 1);
+		
+		if (_g_mime_serialize_to_buffer (write, object, options, str, (size_t) length) == length) {
+			str[length] = '\0';
+			return str;
+		}
+		
+		g_free (str);
+	}
 	
+	/* the write failed or the second pass did not match the first one;
+	 * fall back to growing an array, which still leaves whatever was
+	 * written in the string */
 	array = g_byte_array_new ();
 	stream = g_mime_stream_mem_new ();
-	g_mime_stream_mem_set_byte_array (GMIME_STREAM_MEM (stream), array);
-	
-	g_mime_object_write_to_stream (object, options, stream);
+	g_mime_stream_mem_set_byte_array ((GMimeStreamMem *) stream, array);
 	
+	write (object, options, stream);
 	g_object_unref (stream);
+	
 	g_byte_array_append (array, (unsigned char *) "", 1);
 	str = (char *) array->data;
 	g_byte_array_free (array, FALSE);
@@ -1067,6 +1721,52 @@ g_mime_object_to_string (GMimeObject *object, GMimeFormatOptions *options)
 }
 
 
+/**
+ * g_mime_object_to_string:
+ * @object: a #GMimeObject
+ * @options: (nullable): a #GMimeFormatOptions or %NULL
+ *
+ * Allocates a string buffer containing the contents of @object.
+ *
+ * Returns: an allocated string containing the contents of the mime
+ * object.
+ **/
+char *
+g_mime_object_to_string (GMimeObject *object, GMimeFormatOptions *options)
+{
+	g_return_val_if_fail (GMIME_IS_OBJECT (object), NULL);
+	
+	return _g_mime_serialize_to_string ((GMimeWriteFunc) g_mime_object_write_to_stream, object, options);
+}
+
+
+/**
+ * g_mime_object_write_to_buffer:
+ * @object: a #GMimeObject
+ * @options: (nullable): a #GMimeFormatOptions or %NULL
+ * @buffer: (array length=buflen) (element-type guint8) (nullable): a buffer to write to
+ * @buflen: the size of @buffer
+ *
+ * Writes the headers and content of @object into @buffer, which is
+ * not nul-terminated. If @buffer is too small, only the first @buflen
+ * bytes are written, and the return value can be used to allocate a
+ * buffer of the right size (a @buflen of 0 can be used to only get
+ * the size). The output is copied straight into @buffer rather than
+ * going through an intermediate buffer.
+ *
+ * Returns: the length of the serialized object, which is larger than
+ * @buflen if @buffer was too small, or %-1 on error.
+ **/
+ssize_t
+g_mime_object_write_to_buffer (GMimeObject *object, GMimeFormatOptions *options, char *buffer, size_t buflen)
+{
+	g_return_val_if_fail (GMIME_IS_OBJECT (object), -1);
+	g_return_val_if_fail (buffer != NULL || buflen == 0, -1);
+	
+	return _g_mime_serialize_to_buffer ((GMimeWriteFunc) g_mime_object_write_to_stream, object, options, buffer, buflen);
+}
+
+
 /**
  * g_mime_object_get_header_list:
  * @object: a #GMimeObject
@@ -1084,6 +1784,281 @@ g_mime_object_get_header_list (GMimeObject *object)
 	return object->headers;
 }
 
+static gboolean
+object_content_size_is_known (GMimeObject *object)
+{
+	GMimeMultipart *multipart;
+	GMimeObject *child;
+	guint i;
+	
+	if (GMIME_OBJECT_GET_PRIVATE (object)->content_octets < 0 || object_content_was_replaced (object))
+		return FALSE;
+	
+	/* the size of a container also covers the headers of its children */
+	if (GMIME_IS_MULTIPART (object)) {
+		multipart = (GMimeMultipart *) object;
+		
+		for (i = 0; i < multipart->children->len; i++) {
+			child = multipart->children->pdata[i];
+			
+			if (_g_mime_header_list_is_dirty (child->headers) || !object_content_size_is_known (child))
+				return FALSE;
+		}
+	} else if (GMIME_IS_MESSAGE_PART (object)) {
+		child = (GMimeObject *) ((GMimeMessagePart *) object)->message;
+		
+		if (child == NULL || _g_mime_header_list_is_dirty (child->headers) || !object_content_size_is_known (child))
+			return FALSE;
+	} else if (GMIME_IS_MESSAGE (object)) {
+		child = ((GMimeMessage *) object)->mime_part;
+		
+		if (child == NULL || _g_mime_header_list_is_dirty (child->headers) || !object_content_size_is_known (child))
+			return FALSE;
+	}
+	
+	return TRUE;
+}
+
+
+/**
+ * g_mime_object_get_content_size:
+ * @object: a #GMimeObject
+ * @octets: (out) (optional): return location for the number of octets
+ * @lines: (out) (optional): return location for the number of lines
+ *
+ * Gets the size of the raw (encoded) content of @object as recorded by
+ * the #GMimeParser while it was scanning the content. For a
+ * #GMimeMessage, the size also includes the message headers.
+ *
+ * The line count follows the IMAP convention: the newline preceding a
+ * multipart boundary terminates the last line of content (even though
+ * it is not part of the content itself) and a final line lacking a
+ * newline is counted as well.
+ *
+ * Returns: %TRUE if the size is known or %FALSE if @object was not
+ * constructed by the parser or has been modified since.
+ **/
+gboolean
+g_mime_object_get_content_size (GMimeObject *object, gint64 *octets, gint64 *lines)
+{
+	g_return_val_if_fail (GMIME_IS_OBJECT (object), FALSE);
+	
+	if (GMIME_IS_MESSAGE (object) && _g_mime_header_list_is_dirty (object->headers))
+		return FALSE;
+	
+	if (!object_content_size_is_known (object))
+		return FALSE;
+	
+	if (octets)
+		*octets = GMIME_OBJECT_GET_PRIVATE (object)->content_octets;
+	
+	if (lines)
+		*lines = GMIME_OBJECT_GET_PRIVATE (object)->content_lines;
+	
+	return TRUE;
+}
+
+static void
+bodystructure_get_size (GMimeObject *object, gint64 *octets, gint64 *lines)
+{
+	GMimeStreamNull *null;
+	
+	if (object_content_size_is_known (object)) {
+		*octets = GMIME_OBJECT_GET_PRIVATE (object)->content_octets;
+		*lines = GMIME_OBJECT_GET_PRIVATE (object)->content_lines;
+		return;
+	}
+	
+	/* the content was not parsed or has been modified since, so we have to measure it */
+	null = (GMimeStreamNull *) g_mime_stream_null_new ();
+	g_mime_stream_null_set_count_newlines (null, TRUE);
+	g_mime_object_write_content_to_stream (object, NULL, (GMimeStream *) null);
+	*octets = (gint64) null->written;
+	*lines = (gint64) null->newlines;
+	g_object_unref (null);
+}
+
+static void
+bodystructure_append_params (GString *str, GMimeParamList *list)
+{
+	GMimeParam *param;
+	char *name, *value;
+	gboolean rfc2231;
+	int count, i;
+	
+	if (list == NULL || (count = g_mime_param_list_length (list)) == 0) {
+		g_string_append (str, "NIL");
+		return;
+	}
+	
+	g_string_append_c (str, '(');
+	
+	for (i = 0; i < count; i++) {
+		param = g_mime_param_list_get_parameter_at (list, i);
+		
+		if (i > 0)
+			g_string_append_c (str, ' ');
+		
+		/* IMAP wants the values as they appear in the header, not decoded */
+		value = _g_mime_param_encode_value (param, &rfc2231);
+		
+		if (rfc2231) {
+			name = g_strdup_printf ("%s*", g_mime_param_get_name (param));
+			_g_mime_utils_append_imap_nstring (str, name);
+			g_free (name);
+		} else {
+			_g_mime_utils_append_imap_nstring (str, g_mime_param_get_name (param));
+		}
+		
+		g_string_append_c (str, ' ');
+		_g_mime_utils_append_imap_nstring (str, value);
+		g_free (value);
+	}
+	
+	g_string_append_c (str, ')');
+}
+
+static void
+bodystructure_append_extensions (GString *str, GMimeObject *object)
+{
+	GMimeContentDisposition *disposition = object->disposition;
+	
+	g_string_append_c (str, ' ');
+	
+	if (disposition != NULL) {
+		g_string_append_c (str, '(');
+		_g_mime_utils_append_imap_nstring (str, g_mime_content_disposition_get_disposition (disposition));
+		g_string_append_c (str, ' ');
+		bodystructure_append_params (str, g_mime_content_disposition_get_parameters (disposition));
+		g_string_append_c (str, ')');
+	} else {
+		g_string_append (str, "NIL");
+	}
+	
+	g_string_append_c (str, ' ');
+	_g_mime_utils_append_imap_header (str, object->headers, "Content-Language");
+	g_string_append_c (str, ' ');
+	_g_mime_utils_append_imap_header (str, object->headers, "Content-Location");
+}
+
+static void
+bodystructure_append (GString *str, GMimeObject *object, gboolean extensions)
+{
+	GMimeContentType *content_type = object->content_type;
+	GMimeContentEncoding encoding;
+	GMimeMultipart *multipart;
+	GMimeMessage *message;
+	gint64 octets, lines;
+	const char *cte;
+	char *value;
+	guint i;
+	
+	g_string_append_c (str, '(');
+	
+	if (GMIME_IS_MULTIPART (object)) {
+		multipart = (GMimeMultipart *) object;
+		
+		for (i = 0; i < multipart->children->len; i++)
+			bodystructure_append (str, multipart->children->pdata[i], extensions);
+		
+		g_string_append_c (str, ' ');
+		_g_mime_utils_append_imap_nstring (str, content_type->subtype);
+		
+		if (extensions) {
+			g_string_append_c (str, ' ');
+			bodystructure_append_params (str, content_type->params);
+			bodystructure_append_extensions (str, object);
+		}
+		
+		g_string_append_c (str, ')');
+		return;
+	}
+	
+	_g_mime_utils_append_imap_nstring (str, content_type->type);
+	g_string_append_c (str, ' ');
+	_g_mime_utils_append_imap_nstring (str, content_type->subtype);
+	g_string_append_c (str, ' ');
+	bodystructure_append_params (str, content_type->params);
+	g_string_append_c (str, ' ');
+	_g_mime_utils_append_imap_header (str, object->headers, "Content-Id");
+	g_string_append_c (str, ' ');
+	_g_mime_utils_append_imap_header (str, object->headers, "Content-Description");
+	g_string_append_c (str, ' ');
+	
+	if (GMIME_IS_PART (object))
+		encoding = g_mime_part_get_content_encoding ((GMimePart *) object);
+	else if ((cte = g_mime_object_get_header (object, "Content-Transfer-Encoding")))
+		encoding = g_mime_content_encoding_from_string (cte);
+	else
+		encoding = GMIME_CONTENT_ENCODING_DEFAULT;
+	
+	if (encoding != GMIME_CONTENT_ENCODING_DEFAULT) {
+		value = g_ascii_strup (g_mime_content_encoding_to_string (encoding), -1);
+		_g_mime_utils_append_imap_nstring (str, value);
+		g_free (value);
+	} else {
+		g_string_append (str, "\"7BIT\"");
+	}
+	
+	bodystructure_get_size (object, &octets, &lines);
+	g_string_append_printf (str, " %" G_GINT64_FORMAT, octets);
+	
+	if (GMIME_IS_MESSAGE_PART (object) && (message = ((GMimeMessagePart *) object)->message) && message->mime_part) {
+		g_string_append_c (str, ' ');
+		_g_mime_message_append_envelope (message, str);
+		g_string_append_c (str, ' ');
+		bodystructure_append (str, message->mime_part, extensions);
+		g_string_append_printf (str, " %" G_GINT64_FORMAT, lines);
+	} else if (g_mime_content_type_is_type (content_type, "text", "*")) {
+		g_string_append_printf (str, " %" G_GINT64_FORMAT, lines);
+	}
+	
+	if (extensions) {
+		g_string_append_c (str, ' ');
+		_g_mime_utils_append_imap_header (str, object->headers, "Content-Md5");
+		bodystructure_append_extensions (str, object);
+	}
+	
+	g_string_append_c (str, ')');
+}
+
+
+/**
+ * g_mime_object_get_bodystructure:
+ * @object: a #GMimeObject
+ * @extensions: %TRUE if the extension data should be included
+ *
+ * Formats the IMAP BODYSTRUCTURE (as defined by rfc3501) of @object. If
+ * @extensions is %FALSE, the extension data is omitted, which produces
+ * the IMAP BODY form instead.
+ *
+ * The octet and line counts are taken from the sizes recorded by the
+ * #GMimeParser (see g_mime_object_get_content_size()), so the content
+ * streams of a parsed object are never read. Only objects that were
+ * constructed or modified by the caller need to be measured.
+ *
+ * Returns: (nullable) (transfer full): a newly allocated string containing
+ * the parenthesized BODYSTRUCTURE list or %NULL if @object is a
+ * #GMimeMessage without a MIME part.
+ **/
+char *
+g_mime_object_get_bodystructure (GMimeObject *object, gboolean extensions)
+{
+	GString *str;
+	
+	g_return_val_if_fail (GMIME_IS_OBJECT (object), NULL);
+	
+	if (GMIME_IS_MESSAGE (object)) {
+		if (!(object = ((GMimeMessage *) object)->mime_part))
+			return NULL;
+	}
+	
+	str = g_string_new ("");
+	bodystructure_append (str, object, extensions);
+	
+	return g_string_free (str, FALSE);
+}
+
 
 static void
 subtype_bucket_foreach (gpointer key, gpointer value, gpointer user_data)
@@ -24,6 +24,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <gio/gio.h>
 
 #include <gmime/gmime-format-options.h>
 #include <gmime/gmime-parser-options.h>
@@ -134,8 +135,16 @@ GMimeHeaderList *g_mime_object_get_header_list (GMimeObject *object);
 char *g_mime_object_get_headers (GMimeObject *object, GMimeFormatOptions *options);
 
 ssize_t g_mime_object_write_to_stream (GMimeObject *object, GMimeFormatOptions *options, GMimeStream *stream);
+void g_mime_object_write_to_stream_async (GMimeObject *object, GMimeFormatOptions *options, GOutputStream *stream,
+					  int io_priority, GCancellable *cancellable,
+					  GAsyncReadyCallback callback, gpointer user_data);
+ssize_t g_mime_object_write_to_stream_finish (GMimeObject *object, GAsyncResult *result, GError **err);
 ssize_t g_mime_object_write_content_to_stream (GMimeObject *object, GMimeFormatOptions *options, GMimeStream *stream);
 char *g_mime_object_to_string (GMimeObject *object, GMimeFormatOptions *options);
+ssize_t g_mime_object_write_to_buffer (GMimeObject *object, GMimeFormatOptions *options, char *buffer, size_t buflen);
+
+gboolean g_mime_object_get_content_size (GMimeObject *object, gint64 *octets, gint64 *lines);
+char *g_mime_object_get_bodystructure (GMimeObject *object, gboolean extensions);
 
 void g_mime_object_encode (GMimeObject *object, GMimeEncodingConstraint constraint);
 
@@ -65,6 +65,56 @@ static unsigned char tohex[16] = {
 };
 
 
+/* Parameter names that are looked up often get a small non-zero atom
+ * so that a #GMimeParamList can find them by scanning a byte vector
+ * instead of doing a g_ascii_strcasecmp() per parameter. Any other
+ * name has atom 0 and is matched by name. */
+static const struct {
+	const char *name;
+	size_t len;
+} param_atoms[] = {
+	{ NULL,                 0 },
+	{ "boundary",           8 },
+	{ "charset",            7 },
+	{ "name",               4 },
+	{ "filename",           8 },
+	{ "format",             6 },
+	{ "delsp",              5 },
+	{ "protocol",           8 },
+	{ "micalg",             6 },
+	{ "type",               4 },
+	{ "start",              5 },
+	{ "start-info",        10 },
+	{ "smime-type",        10 },
+	{ "report-type",       11 },
+	{ "size",               4 },
+	{ "creation-date",     13 },
+	{ "modification-date", 17 },
+	{ "read-date",          9 },
+	{ "id",                 2 },
+	{ "number",             6 },
+	{ "total",              5 },
+	{ "access-type",       11 },
+	{ "method",             6 },
+	{ "reply-type",        10 },
+};
+
+static guint8
+param_atom (const char *name)
+{
+	size_t len = strlen (name);
+	char c = g_ascii_tolower (*name);
+	guint8 i;
+	
+	for (i = 1; i < G_N_ELEMENTS (param_atoms); i++) {
+		if (param_atoms[i].len == len && param_atoms[i].name[0] == c &&
+		    !g_ascii_strcasecmp (param_atoms[i].name, name))
+			return i;
+	}
+	
+	return 0;
+}
+
 static void g_mime_param_class_init (GMimeParamClass *klass);
 static void g_mime_param_init (GMimeParam *cert, GMimeParamClass *klass);
 static void g_mime_param_finalize (GObject *object);
@@ -110,7 +160,7 @@ static void
 g_mime_param_init (GMimeParam *param, GMimeParamClass *klass)
 {
 	param->method = GMIME_PARAM_ENCODING_METHOD_DEFAULT;
-	param->changed = g_mime_event_new (param);
+	param->changed = NULL;
 	param->charset = NULL;
 	param->value = NULL;
 	param->name = NULL;
@@ -142,6 +192,8 @@ g_mime_param_finalize (GObject *object)
 static GMimeParam *
 g_mime_param_new (void)
 {
+	GMIME_STATS (_g_mime_stats_record_alloc (GMIME_STATS_SUBSYSTEM_PARAMS, sizeof (GMimeParam)));
+	
 	return g_object_new (GMIME_TYPE_PARAM, NULL);
 }
 
@@ -314,12 +366,20 @@ param_changed (GMimeParam *param, gpointer args, GMimeParamList *list)
 }
 
 
+typedef struct {
+	/* the name atom of each parameter, parallel to list->array */
+	GByteArray *atoms;
+} GMimeParamListPrivate;
+
+#define GMIME_PARAM_LIST_GET_PRIVATE(list) ((GMimeParamListPrivate *) G_STRUCT_MEMBER_P (list, list_private_offset))
+
 static void g_mime_param_list_class_init (GMimeParamListClass *klass);
 static void g_mime_param_list_init (GMimeParamList *list, GMimeParamListClass *klass);
 static void g_mime_param_list_finalize (GObject *object);
 
 
 static GObjectClass *list_parent_class = NULL;
+static gint list_private_offset = 0;
 
 
 GType
@@ -341,6 +401,7 @@ g_mime_param_list_get_type (void)
 		};
 		
 		type = g_type_register_static (G_TYPE_OBJECT, "GMimeParamList", &info, 0);
+		list_private_offset = g_type_add_instance_private (type, sizeof (GMimeParamListPrivate));
 	}
 	
 	return type;
@@ -353,6 +414,7 @@ g_mime_param_list_class_init (GMimeParamListClass *klass)
 	GObjectClass *object_class = G_OBJECT_CLASS (klass);
 	
 	list_parent_class = g_type_class_ref (G_TYPE_OBJECT);
+	g_type_class_adjust_private_offset (klass, &list_private_offset);
 	
 	object_class->finalize = g_mime_param_list_finalize;
 }
@@ -360,8 +422,11 @@ g_mime_param_list_class_init (GMimeParamListClass *klass)
 static void
 g_mime_param_list_init (GMimeParamList *list, GMimeParamListClass *klass)
 {
-	list->changed = g_mime_event_new (list);
+	GMimeParamListPrivate *priv = GMIME_PARAM_LIST_GET_PRIVATE (list);
+	
+	list->changed = NULL;
 	list->array = g_ptr_array_new ();
+	priv->atoms = g_byte_array_new ();
 }
 
 static void
@@ -378,6 +443,7 @@ g_mime_param_list_finalize (GObject *object)
 	}
 	
 	g_ptr_array_free (list->array, TRUE);
+	g_byte_array_free (GMIME_PARAM_LIST_GET_PRIVATE (list)->atoms, TRUE);
 	g_mime_event_free (list->changed);
 	
 	G_OBJECT_CLASS (list_parent_class)->finalize (object);
@@ -436,6 +502,7 @@ g_mime_param_list_clear (GMimeParamList *list)
 	}
 	
 	g_ptr_array_set_size (list->array, 0);
+	g_byte_array_set_size (GMIME_PARAM_LIST_GET_PRIVATE (list)->atoms, 0);
 	
 	g_mime_event_emit (list->changed, NULL);
 }
@@ -453,10 +520,57 @@ g_mime_param_list_clear (GMimeParamList *list)
 static void
 g_mime_param_list_add (GMimeParamList *list, GMimeParam *param)
 {
-	g_mime_event_add (param->changed, (GMimeEventCallback) param_changed, list);
+	guint8 atom = param_atom (param->name);
+	
+	g_mime_event_add (&param->changed, param, (GMimeEventCallback) param_changed, list);
+	g_byte_array_append (GMIME_PARAM_LIST_GET_PRIVATE (list)->atoms, &atom, 1);
 	g_ptr_array_add (list->array, param);
 }
 
+static GByteArray *
+param_list_get_atoms (GMimeParamList *list)
+{
+	GByteArray *atoms = GMIME_PARAM_LIST_GET_PRIVATE (list)->atoms;
+	GMimeParam *param;
+	guint i;
+	
+	/* list->array is visible in the public struct, so rebuild the
+	 * atoms if something added or removed entries behind our back */
+	if (atoms->len != list->array->len) {
+		g_byte_array_set_size (atoms, list->array->len);
+		
+		for (i = 0; i < list->array->len; i++) {
+			param = list->array->pdata[i];
+			atoms->data[i] = param_atom (param->name);
+		}
+	}
+	
+	return atoms;
+}
+
+static int
+param_list_index_of (GMimeParamList *list, const char *name)
+{
+	GByteArray *atoms = param_list_get_atoms (list);
+	guint8 atom = param_atom (name);
+	GMimeParam *param;
+	guint i;
+	
+	for (i = 0; i < atoms->len; i++) {
+		if (atoms->data[i] != atom)
+			continue;
+		
+		if (atom != 0)
+			return i;
+		
+		param = list->array->pdata[i];
+		if (!g_ascii_strcasecmp (param->name, name))
+			return i;
+	}
+	
+	return -1;
+}
+
 
 /**
  * g_mime_param_list_set_parameter:
@@ -470,19 +584,15 @@ void
 g_mime_param_list_set_parameter (GMimeParamList *list, const char *name, const char *value)
 {
 	GMimeParam *param;
-	guint i;
+	int index;
 	
 	g_return_if_fail (GMIME_IS_PARAM_LIST (list));
 	g_return_if_fail (name != NULL);
 	g_return_if_fail (value != NULL);
 	
-	for (i = 0; i < list->array->len; i++) {
-		param = list->array->pdata[i];
-		
-		if (!g_ascii_strcasecmp (param->name, name)) {
-			g_mime_param_set_value (param, value);
-			return;
-		}
+	if ((index = param_list_index_of (list, name)) != -1) {
+		g_mime_param_set_value (list->array->pdata[index], value);
+		return;
 	}
 	
 	param = g_mime_param_new ();
@@ -507,20 +617,15 @@ g_mime_param_list_set_parameter (GMimeParamList *list, const char *name, const c
 GMimeParam *
 g_mime_param_list_get_parameter (GMimeParamList *list, const char *name)
 {
-	GMimeParam *param;
-	guint i;
+	int index;
 	
 	g_return_val_if_fail (GMIME_IS_PARAM_LIST (list), NULL);
 	g_return_val_if_fail (name != NULL, NULL);
 	
-	for (i = 0; i < list->array->len; i++) {
-		param = list->array->pdata[i];
-		
-		if (!g_ascii_strcasecmp (param->name, name))
-			return param;
-	}
+	if ((index = param_list_index_of (list, name)) == -1)
+		return NULL;
 	
-	return NULL;
+	return list->array->pdata[index];
 }
 
 
@@ -558,24 +663,15 @@ g_mime_param_list_get_parameter_at (GMimeParamList *list, int index)
 gboolean
 g_mime_param_list_remove (GMimeParamList *list, const char *name)
 {
-	GMimeParam *param;
-	guint i;
+	int index;
 	
 	g_return_val_if_fail (GMIME_IS_PARAM_LIST (list), FALSE);
 	g_return_val_if_fail (name != NULL, FALSE);
 	
-	for (i = 0; i < list->array->len; i++) {
-		param = list->array->pdata[i];
-		
-		if (!g_ascii_strcasecmp (param->name, name)) {
-			g_mime_event_remove (param->changed, (GMimeEventCallback) param_changed, list);
-			g_ptr_array_remove_index (list->array, i);
-			g_object_unref (param);
-			return TRUE;
-		}
-	}
+	if ((index = param_list_index_of (list, name)) == -1)
+		return FALSE;
 	
-	return FALSE;
+	return g_mime_param_list_remove_at (list, index);
 }
 
 
@@ -601,6 +697,7 @@ g_mime_param_list_remove_at (GMimeParamList *list, int index)
 	
 	param = list->array->pdata[index];
 	g_mime_event_remove (param->changed, (GMimeEventCallback) param_changed, list);
+	g_byte_array_remove_index (param_list_get_atoms (list), index);
 	g_ptr_array_remove_index (list->array, index);
 	g_object_unref (param);
 	
@@ -616,7 +713,7 @@ encode_param (GMimeParam *param, GMimeFormatOptions *options, GMimeParamEncoding
 	GMimeParamEncodingMethod requested;
 	const unsigned char *start = inptr;
 	const char *charset = NULL;
-	iconv_t cd = (iconv_t) -1;
+	GMimeIconv *cd = NULL;
 	char *outbuf = NULL;
 	unsigned char c;
 	char *outstr;
@@ -658,11 +755,11 @@ encode_param (GMimeParam *param, GMimeFormatOptions *options, GMimeParamEncoding
 	}
 	
 	if (g_ascii_strcasecmp (charset, "UTF-8") != 0)
-		cd = g_mime_iconv_open (charset, "UTF-8");
+		cd = _g_mime_iconv_open (charset, "UTF-8");
 	
-	if (cd != (iconv_t) -1) {
-		outbuf = g_mime_iconv_strdup (cd, param->value);
-		g_mime_iconv_close (cd);
+	if (cd != NULL) {
+		outbuf = _g_mime_iconv_strndup (cd, param->value, strlen (param->value));
+		_g_mime_iconv_close (cd);
 		if (outbuf == NULL) {
 			charset = "UTF-8";
 			inptr = start;
@@ -694,6 +791,28 @@ encode_param (GMimeParam *param, GMimeFormatOptions *options, GMimeParamEncoding
 	return outstr;
 }
 
+/**
+ * _g_mime_param_encode_value:
+ * @param: a #GMimeParam
+ * @rfc2231: (out): return location for whether the value uses rfc2231 encoding
+ *
+ * Encodes the value of @param the way it would be written in a header,
+ * without quoting or folding it.
+ *
+ * Returns: (transfer full): the encoded value.
+ **/
+char *
+_g_mime_param_encode_value (GMimeParam *param, gboolean *rfc2231)
+{
+	GMimeParamEncodingMethod method;
+	char *value;
+	
+	value = encode_param (param, NULL, &method);
+	*rfc2231 = method == GMIME_PARAM_ENCODING_METHOD_RFC2231;
+	
+	return value;
+}
+
 static void
 g_string_append_len_quoted (GString *str, const char *text, size_t len)
 {
@@ -1211,7 +1330,7 @@ charset_convert (const char *charset, char *in, size_t inlen)
 {
 	gboolean locale = FALSE;
 	char *result = NULL;
-	iconv_t cd;
+	GMimeIconv *cd;
 	
 	if (!charset || !g_ascii_strcasecmp (charset, "UTF-8") || !g_ascii_strcasecmp (charset, "us-ascii")) {
 		/* we shouldn't need any charset conversion here... */
@@ -1223,15 +1342,15 @@ charset_convert (const char *charset, char *in, size_t inlen)
 	}
 	
 	/* need charset conversion */
-	cd = g_mime_iconv_open ("UTF-8", charset);
-	if (cd == (iconv_t) -1 && !locale) {
+	cd = _g_mime_iconv_open ("UTF-8", charset);
+	if (cd == NULL && !locale) {
 		charset = g_mime_locale_charset ();
-		cd = g_mime_iconv_open ("UTF-8", charset);
+		cd = _g_mime_iconv_open ("UTF-8", charset);
 	}
 	
-	if (cd != (iconv_t) -1) {
-		result = g_mime_iconv_strndup (cd, in, inlen);
-		g_mime_iconv_close (cd);
+	if (cd != NULL) {
+		result = _g_mime_iconv_strndup (cd, in, inlen);
+		_g_mime_iconv_close (cd);
 	}
 	
 	if (result == NULL)
@@ -1423,7 +1542,7 @@ decode_param_list (GMimeParserOptions *options, const char *in, gint64 offset)
 		
 		for (i = 0; i < params->array->len; i++) {
 			param = params->array->pdata[i];
-		
+			
 			for (j = i + 1; j < params->array->len; j++) {
 				p = params->array->pdata[j];
 				
@@ -1466,3 +1585,39 @@ _g_mime_param_list_parse (GMimeParserOptions *options, const char *str, gint64 o
 	
 	return decode_param_list (options, str, offset);
 }
+
+/**
+ * _g_mime_param_list_copy:
+ * @list: a #GMimeParamList
+ *
+ * Creates a deep copy of @list.
+ *
+ * Returns: (transfer full): a new #GMimeParamList.
+ **/
+GMimeParamList *
+_g_mime_param_list_copy (GMimeParamList *list)
+{
+	GMimeParamList *copy;
+	GMimeParam *param, *p;
+	guint i;
+	
+	copy = g_mime_param_list_new ();
+	g_ptr_array_set_size (copy->array, list->array->len);
+	g_byte_array_append (GMIME_PARAM_LIST_GET_PRIVATE (copy)->atoms, param_list_get_atoms (list)->data, list->array->len);
+	
+	for (i = 0; i < list->array->len; i++) {
+		p = list->array->pdata[i];
+		
+		param = g_mime_param_new ();
+		param->charset = g_strdup (p->charset);
+		param->value = g_strdup (p->value);
+		param->name = g_strdup (p->name);
+		param->lang = g_strdup (p->lang);
+		param->method = p->method;
+		
+		g_mime_event_add (&param->changed, param, (GMimeEventCallback) param_changed, copy);
+		copy->array->pdata[i] = param;
+	}
+	
+	return copy;
+}
@@ -26,7 +26,10 @@
 #include <string.h>
 
 #include "gmime-parser-options.h"
+#include "gmime-internal.h"
 
+/* values longer than this are unlikely to repeat and are never cached */
+#define HEADER_CACHE_MAX_VALUE 1024
 
 static char *default_charsets[3] = { "utf-8", "iso-8859-1", NULL };
 
@@ -50,8 +53,106 @@ struct _GMimeParserOptions {
 	char **charsets;
 	GMimeParserWarningFunc warning_cb;
 	gpointer warning_user_data;
+	
+	/* parsed header value cache, shared with clones */
+	struct _HeaderCache *cache;
 };
 
+typedef struct {
+	GType type;
+	char *value;
+	GObject *object;
+} HeaderCacheEntry;
+
+typedef struct _HeaderCache {
+	volatile gint ref_count;
+	GHashTable *table;
+	GQueue order;
+	GMutex lock;
+	guint size;
+	guint hits;
+} HeaderCache;
+
+static guint
+header_cache_entry_hash (gconstpointer key)
+{
+	const HeaderCacheEntry *entry = key;
+	
+	return g_str_hash (entry->value) ^ (guint) entry->type;
+}
+
+static gboolean
+header_cache_entry_equal (gconstpointer a, gconstpointer b)
+{
+	const HeaderCacheEntry *entry0 = a;
+	const HeaderCacheEntry *entry1 = b;
+	
+	return entry0->type == entry1->type && !strcmp (entry0->value, entry1->value);
+}
+
+static void
+header_cache_entry_free (gpointer data)
+{
+	HeaderCacheEntry *entry = data;
+	
+	g_object_unref (entry->object);
+	g_free (entry->value);
+	g_slice_free (HeaderCacheEntry, entry);
+}
+
+static HeaderCache *
+header_cache_new (guint size)
+{
+	HeaderCache *cache;
+	
+	if (size == 0)
+		return NULL;
+	
+	cache = g_slice_new (HeaderCache);
+	cache->table = g_hash_table_new_full (header_cache_entry_hash, header_cache_entry_equal,
+					      header_cache_entry_free, NULL);
+	g_queue_init (&cache->order);
+	g_mutex_init (&cache->lock);
+	cache->ref_count = 1;
+	cache->size = size;
+	cache->hits = 0;
+	
+	return cache;
+}
+
+static HeaderCache *
+header_cache_ref (HeaderCache *cache)
+{
+	if (cache != NULL)
+		g_atomic_int_inc (&cache->ref_count);
+	
+	return cache;
+}
+
+static void
+header_cache_unref (HeaderCache *cache)
+{
+	if (cache == NULL || !g_atomic_int_dec_and_test (&cache->ref_count))
+		return;
+	
+	g_queue_clear (&cache->order);
+	g_hash_table_destroy (cache->table);
+	g_mutex_clear (&cache->lock);
+	g_slice_free (HeaderCache, cache);
+}
+
+/* Clones of a set of options share its cache, which is how the
+ * per-part header lists created by the parser end up sharing the
+ * cache of the options that were passed to the parser. Any change
+ * that affects how values get parsed gives the options a private
+ * cache of their own so that the other users aren't affected. */
+static void
+header_cache_reset (GMimeParserOptions *options, guint size)
+{
+	header_cache_unref (options->cache);
+	options->cache = header_cache_new (size);
+}
+
 static GMimeParserOptions *default_options = NULL;
 
 G_DEFINE_BOXED_TYPE (GMimeParserOptions, g_mime_parser_options, g_mime_parser_options_clone, g_mime_parser_options_free);
@@ -69,6 +170,7 @@ g_mime_parser_options_shutdown (void)
 	if (default_options == NULL)
 		return;
 	
+	header_cache_unref (default_options->cache);
 	g_strfreev (default_options->charsets);
 	g_slice_free (GMimeParserOptions, default_options);
 	default_options = NULL;
@@ -92,6 +194,94 @@ _g_mime_parser_options_warn (GMimeParserOptions *options, gint64 offset, guint e
 		warn (offset, errcode, item, user_data);
 }
 
+/**
+ * _g_mime_parser_options_cache_lookup:
+ * @options: (nullable): a #GMimeParserOptions or %NULL
+ * @type: the #GType of the parsed object
+ * @value: the raw header value
+ *
+ * Looks up a previously parsed header value in the header cache.
+ *
+ * The returned object is a shared template: the caller must not modify
+ * it, only copy it.
+ *
+ * Returns: (transfer full): the cached object or %NULL if @value has not
+ * been cached (or if the cache is disabled).
+ **/
+GObject *
+_g_mime_parser_options_cache_lookup (GMimeParserOptions *options, GType type, const char *value)
+{
+	HeaderCacheEntry key, *entry;
+	GObject *object = NULL;
+	HeaderCache *cache;
+	
+	if (options == NULL)
+		options = default_options;
+	
+	/* cache hits would suppress the warnings a fresh parse emits */
+	if ((cache = options->cache) == NULL || options->warning_cb != NULL)
+		return NULL;
+	
+	key.type = type;
+	key.value = (char *) value;
+	
+	g_mutex_lock (&cache->lock);
+	if ((entry = g_hash_table_lookup (cache->table, &key))) {
+		object = g_object_ref (entry->object);
+		cache->hits++;
+	}
+	g_mutex_unlock (&cache->lock);
+	
+	return object;
+}
+
+/**
+ * _g_mime_parser_options_cache_insert:
+ * @options: (nullable): a #GMimeParserOptions or %NULL
+ * @type: the #GType of the parsed object
+ * @value: the raw header value
+ * @object: the parsed object
+ *
+ * Adds @object to the header cache as the parsed form of @value,
+ * evicting the oldest entries if the cache is full. The cache takes a
+ * reference on @object which must never be modified afterward.
+ **/
+void
+_g_mime_parser_options_cache_insert (GMimeParserOptions *options, GType type, const char *value, GObject *object)
+{
+	HeaderCacheEntry *entry, *oldest;
+	HeaderCache *cache;
+	
+	if (options == NULL)
+		options = default_options;
+	
+	if ((cache = options->cache) == NULL || options->warning_cb != NULL || strlen (value) > HEADER_CACHE_MAX_VALUE)
+		return;
+	
+	entry = g_slice_new (HeaderCacheEntry);
+	entry->value = g_strdup (value);
+	entry->object = g_object_ref (object);
+	entry->type = type;
+	
+	g_mutex_lock (&cache->lock);
+	
+	if (!g_hash_table_contains (cache->table, entry)) {
+		if (cache->order.length >= cache->size) {
+			oldest = g_queue_pop_head (&cache->order);
+			g_hash_table_remove (cache->table, oldest);
+		}
+		
+		g_queue_push_tail (&cache->order, entry);
+		g_hash_table_add (cache->table, entry);
+		entry = NULL;
+	}
+	
+	g_mutex_unlock (&cache->lock);
+	
+	if (entry != NULL)
+		header_cache_entry_free (entry);
+}
+
 /**
  * g_mime_parser_options_get_default:
  *
@@ -131,7 +321,9 @@ g_mime_parser_options_new (void)
 	
 	options->warning_cb = NULL;
 	options->warning_user_data = NULL;
-
+	
+	options->cache = NULL;
+	
 	return options;
 }
 
@@ -169,7 +361,9 @@ g_mime_parser_options_clone (GMimeParserOptions *options)
 	
 	clone->warning_cb = options->warning_cb;
 	clone->warning_user_data = options->warning_user_data;
-
+	
+	clone->cache = header_cache_ref (options->cache);
+	
 	return clone;
 }
 
@@ -186,6 +380,7 @@ g_mime_parser_options_free (GMimeParserOptions *options)
 	g_return_if_fail (options != NULL);
 	
 	if (options != default_options) {
+		header_cache_unref (options->cache);
 		g_strfreev (options->charsets);
 		g_slice_free (GMimeParserOptions, options);
 	}
@@ -326,6 +521,9 @@ g_mime_parser_options_set_parameter_compliance_mode (GMimeParserOptions *options
 	g_return_if_fail (options != NULL);
 	
 	options->parameters = mode;
+	
+	if (options->cache != NULL)
+		header_cache_reset (options, options->cache->size);
 }
 
 
@@ -369,6 +567,9 @@ g_mime_parser_options_set_rfc2047_compliance_mode (GMimeParserOptions *options,
 	g_return_if_fail (options != NULL);
 	
 	options->rfc2047 = mode;
+	
+	if (options->cache != NULL)
+		header_cache_reset (options, options->cache->size);
 }
 
 
@@ -417,6 +618,9 @@ g_mime_parser_options_set_fallback_charsets (GMimeParserOptions *options, const
 	for (i = 0; i < n; i++)
 		options->charsets[i] = g_strdup (charsets[i]);
 	options->charsets[n] = NULL;
+	
+	if (options->cache != NULL)
+		header_cache_reset (options, options->cache->size);
 }
 
 
@@ -451,3 +655,84 @@ g_mime_parser_options_set_warning_callback (GMimeParserOptions *options, GMimePa
 	options->warning_cb = warning_cb;
 	options->warning_user_data = user_data;
 }
+
+
+/**
+ * g_mime_parser_options_get_header_cache_size:
+ * @options: (nullable): a #GMimeParserOptions or %NULL
+ *
+ * Gets the maximum number of parsed Content-Type and Content-Disposition
+ * header values that are cached.
+ *
+ * Returns: the maximum number of cached header values or %0 if the cache
+ * is disabled.
+ **/
+guint
+g_mime_parser_options_get_header_cache_size (GMimeParserOptions *options)
+{
+	if (options == NULL)
+		options = default_options;
+	
+	return options->cache ? options->cache->size : 0;
+}
+
+
+/**
+ * g_mime_parser_options_get_header_cache_hits:
+ * @options: (nullable): a #GMimeParserOptions or %NULL
+ *
+ * Gets the number of times a Content-Type or Content-Disposition value
+ * was copied from the header cache rather than parsed. The count
+ * includes the hits of any clones of @options and starts over whenever
+ * the cache is reset.
+ *
+ * Returns: the number of header cache hits.
+ **/
+guint
+g_mime_parser_options_get_header_cache_hits (GMimeParserOptions *options)
+{
+	HeaderCache *cache;
+	guint hits;
+	
+	if (options == NULL)
+		options = default_options;
+	
+	if ((cache = options->cache) == NULL)
+		return 0;
+	
+	g_mutex_lock (&cache->lock);
+	hits = cache->hits;
+	g_mutex_unlock (&cache->lock);
+	
+	return hits;
+}
+
+
+/**
+ * g_mime_parser_options_set_header_cache_size:
+ * @options: a #GMimeParserOptions
+ * @size: the maximum number of cached header values or %0 to disable the cache
+ *
+ * Sets the maximum number of parsed Content-Type and Content-Disposition
+ * header values to cache.
+ *
+ * Mailboxes tend to repeat the same handful of Content-Type and
+ * Content-Disposition values over and over. With the cache enabled,
+ * parsing a value that has been seen before copies the previous result
+ * instead of parsing the parameters again. Once the cache is full, the
+ * oldest values are discarded first.
+ *
+ * The cache is shared with any clones of @options (including the
+ * ones used internally by the parsed objects) and is safe to use from
+ * several threads at once. It is bypassed while a warning callback is
+ * set, since a cached value would not report its warnings again.
+ *
+ * By default, the cache is disabled.
+ **/
+void
+g_mime_parser_options_set_header_cache_size (GMimeParserOptions *options, guint size)
+{
+	g_return_if_fail (options != NULL);
+	
+	header_cache_reset (options, size);
+}
@@ -131,6 +131,10 @@ GMimeParserWarningFunc g_mime_parser_options_get_warning_callback (GMimeParserOp
 void g_mime_parser_options_set_warning_callback (GMimeParserOptions *options, GMimeParserWarningFunc warning_cb,
 						 gpointer user_data);
 
+guint g_mime_parser_options_get_header_cache_size (GMimeParserOptions *options);
+guint g_mime_parser_options_get_header_cache_hits (GMimeParserOptions *options);
+void g_mime_parser_options_set_header_cache_size (GMimeParserOptions *options, guint size);
+
 G_END_DECLS
 
 #endif /* __GMIME_PARSER_OPTIONS_H__ */
@@ -32,11 +32,14 @@
 #include "gmime-table-private.h"
 #include "gmime-message-part.h"
 #include "gmime-parse-utils.h"
+#include "gmime-filter-basic.h"
+#include "gmime-stream-chunked.h"
 #include "gmime-stream-null.h"
 #include "gmime-stream-mem.h"
 #include "gmime-multipart.h"
 #include "gmime-internal.h"
 #include "gmime-common.h"
+#include "gmime-error.h"
 #include "gmime-part.h"
 
 #ifdef ENABLE_WARNINGS
@@ -96,6 +99,7 @@ static void g_mime_parser_finalize (GObject *object);
 
 static void parser_init (GMimeParser *parser, GMimeStream *stream);
 static void parser_close (GMimeParser *parser);
+static void parser_feed_step (GMimeParser *parser, GMimeParserOptions *options);
 
 static GMimeObject *parser_construct_leaf_part (GMimeParser *parser, GMimeParserOptions *options, ContentType *content_type,
 						gboolean toplevel, int depth);
@@ -126,6 +130,15 @@ typedef enum {
 	GMIME_PARSER_STATE_COMPLETE,
 } GMimeParserState;
 
+struct _StepHeadersState {
+	gboolean scanning_field_name;
+	gboolean check_folded;
+	gboolean midline;
+	gboolean blank;
+	gboolean valid;
+	ssize_t left;
+};
+
 struct _GMimeParserPrivate {
 	GMimeStream *stream;
 	GMimeFormat format;
@@ -139,6 +152,10 @@ struct _GMimeParserPrivate {
 	char *inptr;
 	char *inend;
 	
+	/* number of newlines in the stream preceding 'newlines_ptr' */
+	gint64 newlines;
+	char *newlines_ptr;
+	
 	GMimeParserHeaderRegexFunc header_cb;
 	gpointer user_data;
 	GRegex *regex;
@@ -156,9 +173,16 @@ struct _GMimeParserPrivate {
 	gint64 headers_begin;
 	gint64 headers_end;
 	
+	/* line number of the current mime-part headerblock */
+	gint64 headers_lineno;
+	
 	/* current header field offset */
 	gint64 header_offset;
 	
+	/* end offset and line number of the most recently scanned content */
+	gint64 content_last;
+	gint64 content_lineno;
+	
 	GPtrArray *headers;
 	
 	/* header buffer */
@@ -169,6 +193,14 @@ struct _GMimeParserPrivate {
 	BoundaryStack *bounds;
 	BoundaryType boundary;
 	
+	/* the state of the message headers being parsed as they are fed */
+	struct _StepHeadersState feed_state;
+	
+	/* leaf content no larger than this is loaded into memory even
+	 * when the stream is persistent (0 means never) */
+	gint64 persist_threshold;
+	
+	GMimeFingerprintFlags fingerprint;
 	GMimeOpenPGPState openpgp;
 	short int state;
 	
@@ -177,7 +209,14 @@ struct _GMimeParserPrivate {
 	unsigned short int have_regex:1;
 	unsigned short int persist_stream:1;
 	unsigned short int respect_content_length:1;
-	unsigned short int unused:11;
+	unsigned short int feed:1;
+	unsigned short int feed_eof:1;
+	unsigned short int feed_headers:1;
+	unsigned short int unused:8;
+	
+#ifdef ENABLE_STATS
+	GMimeParserStats stats;
+#endif
 };
 
 static const char MBOX_BOUNDARY[6] = "From ";
@@ -318,8 +357,10 @@ g_mime_parser_init (GMimeParser *parser, GMimeParserClass *klass)
 {
 	parser->priv = g_new (struct _GMimeParserPrivate, 1);
 	parser->priv->respect_content_length = FALSE;
+	parser->priv->fingerprint = GMIME_FINGERPRINT_NONE;
 	parser->priv->format = GMIME_FORMAT_MESSAGE;
 	parser->priv->persist_stream = TRUE;
+	parser->priv->persist_threshold = 0;
 	parser->priv->have_regex = FALSE;
 	parser->priv->regex = NULL;
 	
@@ -364,6 +405,9 @@ parser_init (GMimeParser *parser, GMimeStream *stream)
 	priv->inptr = priv->inbuf;
 	priv->inend = priv->inbuf;
 	
+	priv->newlines = 0;
+	priv->newlines_ptr = priv->inptr;
+	
 	priv->marker = g_byte_array_new ();
 	priv->marker_offset = -1;
 	
@@ -380,16 +424,26 @@ parser_init (GMimeParser *parser, GMimeStream *stream)
 	
 	priv->headers_begin = -1;
 	priv->headers_end = -1;
+	priv->headers_lineno = -1;
 	
 	priv->header_offset = -1;
 	
+	priv->content_last = -1;
+	priv->content_lineno = -1;
+	
 	priv->openpgp = GMIME_OPENPGP_NONE;
 	priv->boundary = BOUNDARY_NONE;
 	
 	priv->toplevel = FALSE;
 	priv->seekable = offset != -1;
 	
+	priv->feed = FALSE;
+	priv->feed_eof = FALSE;
+	priv->feed_headers = FALSE;
+	
 	priv->bounds = NULL;
+	
+	GMIME_STATS (memset (&priv->stats, 0, sizeof (priv->stats)));
 }
 
 static void
@@ -478,6 +532,110 @@ g_mime_parser_init_with_stream (GMimeParser *parser, GMimeStream *stream)
 }
 
 
+static void
+parser_feed_begin (GMimeParser *parser)
+{
+	GMimeStream *stream;
+	
+	stream = g_mime_stream_chunked_new ();
+	parser_close (parser);
+	parser_init (parser, stream);
+	g_object_unref (stream);
+	
+	parser->priv->feed = TRUE;
+}
+
+
+/**
+ * g_mime_parser_feed:
+ * @parser: a #GMimeParser context
+ * @options: (nullable): a #GMimeParserOptions or %NULL
+ * @buffer: (array length=len) (element-type guint8): a chunk of the raw message
+ * @len: the length of @buffer
+ *
+ * Hands the next @len bytes of the message to @parser. This is an
+ * alternative to g_mime_parser_init_with_stream() for callers such as
+ * event-driven servers that receive the message a piece at a time and
+ * cannot block waiting for the rest of it.
+ *
+ * Chunks may be split anywhere, including in the middle of a header
+ * or a boundary line. The headers of the message are parsed as soon
+ * as they arrive, so a callback registered with
+ * g_mime_parser_set_header_regex() is invoked from within
+ * g_mime_parser_feed() and any warnings are reported to @options.
+ *
+ * The rest of the message is buffered by @parser (without being copied
+ * again when the part content is persisted) and is parsed by
+ * g_mime_parser_construct_message() or g_mime_parser_construct_part()
+ * once g_mime_parser_feed_eof() has been called. The result is the same
+ * as parsing a stream containing the concatenation of all the chunks.
+ *
+ * Note: @parser must not have been initialized with a stream. Messages
+ * in mbox or MMDF format are only parsed once all of them have been
+ * fed.
+ **/
+void
+g_mime_parser_feed (GMimeParser *parser, GMimeParserOptions *options, const char *buffer, size_t len)
+{
+	struct _GMimeParserPrivate *priv;
+	gint64 position;
+	
+	g_return_if_fail (GMIME_IS_PARSER (parser));
+	g_return_if_fail (buffer != NULL || len == 0);
+	
+	priv = parser->priv;
+	
+	g_return_if_fail (priv->feed || priv->stream == NULL);
+	g_return_if_fail (!priv->feed_eof);
+	
+	if (!priv->feed)
+		parser_feed_begin (parser);
+	
+	if (len > 0) {
+		/* append to the end without disturbing the read position */
+		position = g_mime_stream_tell (priv->stream);
+		g_mime_stream_seek (priv->stream, 0, GMIME_STREAM_SEEK_END);
+		g_mime_stream_write (priv->stream, buffer, len);
+		g_mime_stream_seek (priv->stream, position, GMIME_STREAM_SEEK_SET);
+	}
+	
+	parser_feed_step (parser, options);
+}
+
+
+/**
+ * g_mime_parser_feed_eof:
+ * @parser: a #GMimeParser context
+ * @options: (nullable): a #GMimeParserOptions or %NULL
+ *
+ * Tells @parser that everything has been handed to it using
+ * g_mime_parser_feed(), so that the message may now be constructed.
+ * If the input ended in the middle of the message headers, they are
+ * finished off here and any warnings are reported to @options.
+ **/
+void
+g_mime_parser_feed_eof (GMimeParser *parser, GMimeParserOptions *options)
+{
+	struct _GMimeParserPrivate *priv;
+	
+	g_return_if_fail (GMIME_IS_PARSER (parser));
+	
+	priv = parser->priv;
+	
+	g_return_if_fail (priv->feed || priv->stream == NULL);
+	
+	if (priv->feed_eof)
+		return;
+	
+	if (!priv->feed)
+		g_mime_parser_feed (parser, options, NULL, 0);
+	
+	priv->feed_eof = TRUE;
+	
+	parser_feed_step (parser, options);
+}
+
+
 /**
  * g_mime_parser_get_persist_stream:
  * @parser: a #GMimeParser context
@@ -525,6 +683,23 @@ g_mime_parser_set_persist_stream (GMimeParser *parser, gboolean persist)
 }
 
 
+/**
+ * _g_mime_parser_set_persist_threshold:
+ * @parser: a #GMimeParser context
+ * @threshold: the size in bytes or %0
+ *
+ * Makes a persistent @parser load the content of leaf parts that are
+ * no larger than @threshold into memory, leaving only the larger ones
+ * as substreams of the underlying stream. A @threshold of %0 restores
+ * the default of leaving all content on disk.
+ **/
+void
+_g_mime_parser_set_persist_threshold (GMimeParser *parser, gint64 threshold)
+{
+	parser->priv->persist_threshold = threshold;
+}
+
+
 /**
  * g_mime_parser_get_format:
  * @parser: a #GMimeParser context
@@ -600,6 +775,48 @@ g_mime_parser_set_respect_content_length (GMimeParser *parser, gboolean respect_
 }
 
 
+/**
+ * g_mime_parser_get_fingerprint:
+ * @parser: a #GMimeParser context
+ *
+ * Gets the fingerprints that @parser computes for the decoded content
+ * of each #GMimePart.
+ *
+ * Returns: the #GMimeFingerprintFlags.
+ **/
+GMimeFingerprintFlags
+g_mime_parser_get_fingerprint (GMimeParser *parser)
+{
+	g_return_val_if_fail (GMIME_IS_PARSER (parser), GMIME_FINGERPRINT_NONE);
+	
+	return parser->priv->fingerprint;
+}
+
+
+/**
+ * g_mime_parser_set_fingerprint:
+ * @parser: a #GMimeParser context
+ * @flags: the #GMimeFingerprintFlags to compute
+ *
+ * Sets the fingerprints that @parser should compute for the decoded
+ * content of each #GMimePart. The content is decoded (according to
+ * its Content-Transfer-Encoding) and hashed in the same pass that
+ * scans it for the next boundary, so the fingerprints are available
+ * via g_mime_part_get_content_hash() and
+ * g_mime_part_get_content_sha256() without reading the content a
+ * second time.
+ *
+ * By default, no fingerprints are computed.
+ **/
+void
+g_mime_parser_set_fingerprint (GMimeParser *parser, GMimeFingerprintFlags flags)
+{
+	g_return_if_fail (GMIME_IS_PARSER (parser));
+	
+	parser->priv->fingerprint = flags & (GMIME_FINGERPRINT_HASH | GMIME_FINGERPRINT_SHA256);
+}
+
+
 /**
  * g_mime_parser_set_header_regex: (skip)
  * @parser: a #GMimeParser context
@@ -639,6 +856,19 @@ g_mime_parser_set_header_regex (GMimeParser *parser, const char *regex,
 }
 
 
+static size_t
+count_newlines (const char *inptr, const char *inend)
+{
+	size_t n = 0;
+	
+	while (inptr < inend && (inptr = memchr (inptr, '\n', inend - inptr))) {
+		inptr++;
+		n++;
+	}
+	
+	return n;
+}
+
 static ssize_t
 parser_fill (GMimeParser *parser, size_t atleast)
 {
@@ -657,6 +887,9 @@ parser_fill (GMimeParser *parser, size_t atleast)
 	if (inlen > atleast)
 		return inlen;
 	
+	/* account for the newlines in the data we are about to discard */
+	priv->newlines += count_newlines (priv->newlines_ptr, inptr);
+	
 	/* attempt to align 'inend' with realbuf + SCAN_HEAD */
 	if (inptr >= inbuf) {
 		inbuf -= inlen < SCAN_HEAD ? inlen : SCAN_HEAD;
@@ -675,11 +908,15 @@ parser_fill (GMimeParser *parser, size_t atleast)
 		inbuf = inend;
 	}
 	
+	priv->newlines_ptr = inptr;
 	priv->inptr = inptr;
 	priv->inend = inbuf;
 	inend = priv->realbuf + SCAN_HEAD + SCAN_BUF;
 	
+	GMIME_STATS (priv->stats.fill_calls++);
+	
 	if ((nread = g_mime_stream_read (priv->stream, inbuf, inend - inbuf)) > 0) {
+		GMIME_STATS (priv->stats.bytes_read += nread);
 		priv->offset += nread;
 		priv->inend += nread;
 	}
@@ -700,6 +937,15 @@ parser_offset (struct _GMimeParserPrivate *priv, const char *inptr)
 	return (priv->offset - (priv->inend - inptr));
 }
 
+static gint64
+parser_lineno (struct _GMimeParserPrivate *priv, const char *inptr)
+{
+	if (!inptr)
+		inptr = priv->inptr;
+	
+	return priv->newlines + count_newlines (priv->newlines_ptr, inptr);
+}
+
 
 /**
  * g_mime_parser_tell:
@@ -881,6 +1127,8 @@ check_boundary (struct _GMimeParserPrivate *priv, const char *start, size_t len)
 	if (len > 0 && start[len - 1] == '\r')
 		len--;
 	
+	GMIME_STATS (priv->stats.boundary_checks++);
+	
 	if (!possible_boundary (marker, mlen, start, len))
 		return BOUNDARY_NONE;
 	
@@ -1018,6 +1266,7 @@ header_buffer_parse (GMimeParser *parser, GMimeParserOptions *options)
 	
 	header = g_slice_new (Header);
 	g_ptr_array_add (priv->headers, header);
+	GMIME_STATS (priv->stats.headers++);
 	
 	header->raw_name = g_strndup (priv->headerbuf, (size_t) (inptr - priv->headerbuf));
 	header->raw_value = g_strdup (inptr + 1);
@@ -1105,15 +1354,6 @@ warn_invalid_header (GMimeParser *parser, GMimeParserOptions *options, const cha
 	g_free (header);
 }
 
-struct _StepHeadersState {
-	gboolean scanning_field_name;
-	gboolean check_folded;
-	gboolean midline;
-	gboolean blank;
-	gboolean valid;
-	ssize_t left;
-};
-
 static gboolean
 step_headers (GMimeParser *parser, struct _StepHeadersState *state, GMimeParserOptions *options)
 {
@@ -1298,39 +1538,46 @@ step_headers (GMimeParser *parser, struct _StepHeadersState *state, GMimeParserO
 }
 
 static void
-parser_step_headers (GMimeParser *parser, GMimeParserOptions *options)
+parser_step_headers_begin (GMimeParser *parser, struct _StepHeadersState *state)
 {
-	gboolean can_warn = g_mime_parser_options_get_warning_callback (options) != NULL;
 	struct _GMimeParserPrivate *priv = parser->priv;
-	struct _StepHeadersState state;
-	ssize_t available;
 	
-	state.scanning_field_name = TRUE;
-	state.check_folded = FALSE;
-	state.midline = FALSE;
-	state.blank = FALSE;
-	state.valid = TRUE;
-	state.left = 0;
+	state->scanning_field_name = TRUE;
+	state->check_folded = FALSE;
+	state->midline = FALSE;
+	state->blank = FALSE;
+	state->valid = TRUE;
+	state->left = 0;
 	
 	parser_free_headers (priv);
 	priv->headers_begin = parser_offset (priv, NULL);
+	priv->headers_lineno = parser_lineno (priv, NULL);
 	priv->header_offset = priv->headers_begin;
 	priv->boundary = BOUNDARY_NONE;
-	
-	if (parser_fill (parser, SCAN_HEAD) <= 0) {
-		priv->state = GMIME_PARSER_STATE_ERROR;
-		return;
-	}
+}
+
+/* Note: when fed, running out of input before g_mime_parser_feed_eof()
+ * is not the end of the message, so we return %FALSE and leave @state
+ * such that scanning can resume once more input has been fed. */
+static gboolean
+parser_step_headers_continue (GMimeParser *parser, struct _StepHeadersState *state, GMimeParserOptions *options)
+{
+	gboolean can_warn = g_mime_parser_options_get_warning_callback (options) != NULL;
+	struct _GMimeParserPrivate *priv = parser->priv;
+	ssize_t available;
 	
 	do {
-		if (!step_headers (parser, &state, options))
-			return;
+		if (!step_headers (parser, state, options))
+			return TRUE;
 		
-		available = parser_fill (parser, state.left + 1);
+		available = parser_fill (parser, state->left + 1);
 		
-		if (available == state.left) {
+		if (available == state->left) {
+			if (priv->feed && !priv->feed_eof)
+				return FALSE;
+			
 			/* EOF reached before we reached the end of the headers... */
-			if (state.scanning_field_name && state.left > 0) {
+			if (state->scanning_field_name && state->left > 0) {
 				/* EOF reached right in the middle of a header field name. Throw an error.
 				 *
 				 * See private email from Feb 8, 2018 which contained a sample message w/o
@@ -1345,8 +1592,8 @@ parser_step_headers (GMimeParser *parser, GMimeParserOptions *options)
 				 *
 				 * For more details, see https://github.com/jstedfast/MimeKit/pull/51
 				 * and https://github.com/jstedfast/MimeKit/issues/348 */
-				if (state.left > 0) {
-					header_buffer_append (priv, priv->inptr, state.left);
+				if (state->left > 0) {
+					header_buffer_append (priv, priv->inptr, state->left);
 					priv->inptr = priv->inend;
 				}
 				
@@ -1358,11 +1605,27 @@ parser_step_headers (GMimeParser *parser, GMimeParserOptions *options)
 			if (can_warn)
 				_g_mime_parser_options_warn (options, -1, GMIME_WARN_TRUNCATED_MESSAGE, NULL);
 			
-			return;
+			return TRUE;
 		}
 	} while (TRUE);
 }
 
+static void
+parser_step_headers (GMimeParser *parser, GMimeParserOptions *options)
+{
+	struct _GMimeParserPrivate *priv = parser->priv;
+	struct _StepHeadersState state;
+	
+	parser_step_headers_begin (parser, &state);
+	
+	if (parser_fill (parser, SCAN_HEAD) <= 0) {
+		priv->state = GMIME_PARSER_STATE_ERROR;
+		return;
+	}
+	
+	parser_step_headers_continue (parser, &state, options);
+}
+
 static void
 content_type_destroy (ContentType *content_type)
 {
@@ -1504,6 +1767,47 @@ parser_step (GMimeParser *parser, GMimeParserOptions *options)
 }
 
 
+/* Parses as much of the message headers as has been fed so far. The
+ * content is scanned by the recursive construct functions, which can
+ * only run once everything has been fed. */
+static void
+parser_feed_step (GMimeParser *parser, GMimeParserOptions *options)
+{
+	struct _GMimeParserPrivate *priv = parser->priv;
+	
+	/* mbox and MMDF markers are scanned once everything has been fed */
+	if (priv->format != GMIME_FORMAT_MESSAGE)
+		return;
+	
+	if (priv->state == GMIME_PARSER_STATE_INIT)
+		parser_step (parser, options);
+	
+	if (priv->state != GMIME_PARSER_STATE_MESSAGE_HEADERS)
+		return;
+	
+	if (!priv->feed_headers) {
+		if (parser_fill (parser, SCAN_HEAD) <= 0) {
+			if (priv->feed_eof)
+				priv->state = GMIME_PARSER_STATE_ERROR;
+			return;
+		}
+		
+		parser_step_headers_begin (parser, &priv->feed_state);
+		priv->feed_headers = TRUE;
+	}
+	
+	priv->toplevel = TRUE;
+	
+	if (parser_step_headers_continue (parser, &priv->feed_state, options)) {
+		priv->message_headers_begin = priv->headers_begin;
+		priv->message_headers_end = priv->headers_end;
+		priv->feed_headers = FALSE;
+	}
+	
+	priv->toplevel = FALSE;
+}
+
+
 /* Optimization Notes:
  *
  * 1. By making the priv->realbuf char array 1 extra char longer, we
@@ -1515,19 +1819,157 @@ parser_step (GMimeParser *parser, GMimeParserOptions *options)
  **/
 
 
+#define FNV1A_64_OFFSET G_GUINT64_CONSTANT (14695981039346656037)
+#define FNV1A_64_PRIME  G_GUINT64_CONSTANT (1099511628211)
+
+typedef struct {
+	GMimeFingerprintFlags flags;
+	GMimeFilter *decoder;
+	GChecksum *sha256;
+	guint64 hash;
+	gint64 length;
+	
+	/* the newline preceding a boundary is not part of the content
+	 * but is only recognized as such once the boundary is found,
+	 * so the last 2 bytes are held back until then */
+	char pending[2];
+	size_t npending;
+} ParserFingerprint;
+
+static void
+parser_fingerprint_init (ParserFingerprint *fp, GMimeFingerprintFlags flags, GMimeContentEncoding encoding)
+{
+	switch (encoding) {
+	case GMIME_CONTENT_ENCODING_BASE64:
+	case GMIME_CONTENT_ENCODING_QUOTEDPRINTABLE:
+	case GMIME_CONTENT_ENCODING_UUENCODE:
+		fp->decoder = g_mime_filter_basic_new (encoding, FALSE);
+		break;
+	default:
+		fp->decoder = NULL;
+		break;
+	}
+	
+	if (flags & GMIME_FINGERPRINT_SHA256)
+		fp->sha256 = g_checksum_new (G_CHECKSUM_SHA256);
+	else
+		fp->sha256 = NULL;
+	
+	fp->flags = flags;
+	fp->hash = FNV1A_64_OFFSET;
+	fp->length = 0;
+	fp->npending = 0;
+}
+
+static void
+parser_fingerprint_digest (ParserFingerprint *fp, const char *buf, size_t len)
+{
+	register const unsigned char *inptr = (const unsigned char *) buf;
+	const unsigned char *inend = inptr + len;
+	register guint64 hash = fp->hash;
+	
+	if (fp->flags & GMIME_FINGERPRINT_HASH) {
+		while (inptr < inend) {
+			hash ^= *inptr++;
+			hash *= FNV1A_64_PRIME;
+		}
+		
+		fp->hash = hash;
+	}
+	
+	if (fp->sha256 != NULL)
+		g_checksum_update (fp->sha256, (const guchar *) buf, len);
+	
+	fp->length += len;
+}
+
+static void
+parser_fingerprint_decode (ParserFingerprint *fp, const char *inbuf, size_t inlen, gboolean flush)
+{
+	size_t outlen, outprespace;
+	char *outbuf;
+	
+	if (fp->decoder == NULL) {
+		parser_fingerprint_digest (fp, inbuf, inlen);
+		return;
+	}
+	
+	if (flush)
+		g_mime_filter_complete (fp->decoder, (char *) inbuf, inlen, 0, &outbuf, &outlen, &outprespace);
+	else
+		g_mime_filter_filter (fp->decoder, (char *) inbuf, inlen, 0, &outbuf, &outlen, &outprespace);
+	
+	parser_fingerprint_digest (fp, outbuf, outlen);
+}
+
+static void
+parser_fingerprint_write (ParserFingerprint *fp, const char *buf, size_t len)
+{
+	size_t n, m;
+	
+	if (fp->npending + len <= sizeof (fp->pending)) {
+		memcpy (fp->pending + fp->npending, buf, len);
+		fp->npending += len;
+		return;
+	}
+	
+	/* decode everything but the last 2 bytes */
+	n = fp->npending + len - sizeof (fp->pending);
+	
+	if (fp->npending > 0) {
+		m = MIN (n, fp->npending);
+		parser_fingerprint_decode (fp, fp->pending, m, FALSE);
+		memmove (fp->pending, fp->pending + m, fp->npending - m);
+		fp->npending -= m;
+		n -= m;
+	}
+	
+	parser_fingerprint_decode (fp, buf, n, FALSE);
+	memcpy (fp->pending + fp->npending, buf + n, len - n);
+	fp->npending += len - n;
+}
+
+static void
+parser_fingerprint_finish (ParserFingerprint *fp, size_t trim)
+{
+	trim = MIN (trim, fp->npending);
+	parser_fingerprint_decode (fp, fp->pending, fp->npending - trim, TRUE);
+	fp->npending = 0;
+}
+
+static void
+parser_fingerprint_apply (ParserFingerprint *fp, GMimePart *mime_part)
+{
+	guint8 digest[32];
+	gsize len = sizeof (digest);
+	
+	if (fp->sha256 != NULL) {
+		g_checksum_get_digest (fp->sha256, digest, &len);
+		g_checksum_free (fp->sha256);
+	}
+	
+	if (fp->decoder != NULL)
+		g_object_unref (fp->decoder);
+	
+	_g_mime_part_set_fingerprint (mime_part, fp->flags, fp->hash, fp->length,
+				      fp->sha256 != NULL ? digest : NULL);
+}
+
 /* we add 2 for \r\n */
 #define MAX_BOUNDARY_LEN(bounds) (bounds ? bounds->boundarylenmax + 2 : 0)
 
 static void
-parser_scan_content (GMimeParser *parser, GMimeStream *content, gboolean *empty)
+parser_scan_content (GMimeParser *parser, GMimeStream *content, ParserFingerprint *fp, gboolean *empty)
 {
 	struct _GMimeParserPrivate *priv = parser->priv;
 	char *aligned, *start, *inend;
 	register unsigned int *dword;
+	gboolean partial = FALSE;
 	gboolean midline = FALSE;
 	register char *inptr;
 	unsigned int mask;
 	size_t nleft, len;
+	size_t trim = 0;
 	size_t atleast;
 	gint64 pos;
 	char c;
@@ -1541,6 +1983,11 @@ parser_scan_content (GMimeParser *parser, GMimeStream *content, gboolean *empty)
 	
 	start = inptr = priv->inptr;
 	
+	/* the newlines in the content are counted as the lines are
+	 * scanned below, so parser_fill() never has to rescan them */
+	priv->newlines = parser_lineno (priv, NULL);
+	priv->newlines_ptr = inptr;
+	
 	/* figure out minimum amount of data we need */
 	atleast = MAX (SCAN_HEAD, MAX_BOUNDARY_LEN (priv->bounds));
 	
@@ -1596,14 +2043,18 @@ parser_scan_content (GMimeParser *parser, GMimeStream *content, gboolean *empty)
 				if ((priv->boundary = check_boundary (priv, start, len)) != BOUNDARY_NONE)
 					goto boundary;
 				
+				priv->newlines++;
 				inptr++;
 				len++;
+				
+				partial = FALSE;
 			} else {
 				/* didn't find an end-of-line */
 				midline = TRUE;
 				
 				if (priv->boundary == BOUNDARY_NONE) {
 					/* not enough to tell if we found a boundary */
+					priv->newlines_ptr = start;
 					priv->inptr = start;
 					inptr = start;
 					goto refill;
@@ -1612,29 +2063,110 @@ parser_scan_content (GMimeParser *parser, GMimeStream *content, gboolean *empty)
 				/* check for a boundary not ending in a \n (EOF) */
 				if ((priv->boundary = check_boundary (priv, start, len)) != BOUNDARY_NONE)
 					goto boundary;
+				
+				partial = TRUE;
 			}
 			
 			g_mime_stream_write (content, start, len);
+			
+			if (fp != NULL)
+				parser_fingerprint_write (fp, start, len);
 		}
 		
+		priv->newlines_ptr = inptr;
 		priv->inptr = inptr;
 	} while (priv->boundary == BOUNDARY_NONE);
 	
  boundary:
 	
 	/* don't chew up the boundary */
+	priv->newlines_ptr = start;
 	priv->inptr = start;
 	
 	pos = g_mime_stream_tell (content);
 	*empty = pos == 0;
 	
+	priv->content_last = parser_offset (priv, NULL);
+	
+	/* Note: the newline preceding a boundary terminates the last line
+	 * of content even though it belongs to the boundary, while a final
+	 * line without a newline (EOF) still counts as a line */
+	priv->content_lineno = parser_lineno (priv, NULL) + (partial ? 1 : 0);
+	
 	if (priv->boundary != BOUNDARY_EOS && pos > 0) {
 		/* the last \r\n belongs to the boundary */
-		if (inptr[-1] == '\r')
+		if (inptr[-1] == '\r') {
 			g_mime_stream_seek (content, -2, GMIME_STREAM_SEEK_CUR);
-		else
+			priv->content_last -= 2;
+			trim = 2;
+		} else {
 			g_mime_stream_seek (content, -1, GMIME_STREAM_SEEK_CUR);
+			priv->content_last--;
+			trim = 1;
+		}
 	}
+	
+	if (fp != NULL)
+		parser_fingerprint_finish (fp, trim);
+}
+
+#ifdef ENABLE_STATS
+static void
+parser_stats_add_part (struct _GMimeParserPrivate *priv, int depth)
+{
+	priv->stats.parts++;
+	
+	if ((guint) depth > priv->stats.max_depth)
+		priv->stats.max_depth = depth;
+}
+#endif
+
+static void
+parser_set_source (GMimeParser *parser, GMimeObject *object, gint64 start)
+{
+	struct _GMimeParserPrivate *priv = parser->priv;
+	GMimeStream *source;
+	
+	if (!priv->persist_stream || !priv->seekable || start < 0 || priv->content_last < start)
+		return;
+	
+	source = g_mime_stream_substream (priv->stream, start, priv->content_last);
+	_g_mime_object_set_source (object, source);
+	g_object_unref (source);
+}
+
+static void
+parser_set_content_size (GMimeParser *parser, GMimeObject *object, gint64 start, gint64 lineno)
+{
+	struct _GMimeParserPrivate *priv = parser->priv;
+	
+	if (start < 0 || lineno < 0 || priv->content_last < start)
+		return;
+	
+	_g_mime_object_set_content_size (object, priv->content_last - start, priv->content_lineno - lineno);
+}
+
+static GMimeStream *
+parser_load_content (GMimeParser *parser, gint64 start, gint64 end)
+{
+	struct _GMimeParserPrivate *priv = parser->priv;
+	GMimeStream *substream, *stream;
+	gint64 position;
+	
+	/* reading the substream moves the underlying stream */
+	position = g_mime_stream_tell (priv->stream);
+	
+	substream = g_mime_stream_substream (priv->stream, start, end);
+	stream = g_mime_stream_mem_new ();
+	g_mime_stream_write_to_stream (substream, stream);
+	g_mime_stream_reset (stream);
+	g_object_unref (substream);
+	
+	g_mime_stream_seek (priv->stream, position, GMIME_STREAM_SEEK_SET);
+	
+	GMIME_STATS (_g_mime_stats_record_alloc (GMIME_STATS_SUBSYSTEM_CONTENT, (size_t) (end - start)));
+	
+	return stream;
 }
 
 static void
@@ -1643,13 +2175,18 @@ parser_scan_mime_part_content (GMimeParser *parser, GMimePart *mime_part)
 	struct _GMimeParserPrivate *priv = parser->priv;
 	GMimeContentEncoding encoding;
 	GMimeDataWrapper *content;
+	ParserFingerprint fp;
 	GMimeStream *stream;
+	gint64 start, len, begin, lineno;
 	GByteArray *buffer;
-	gint64 start, len;
 	gboolean empty;
 	
 	g_assert (priv->state >= GMIME_PARSER_STATE_HEADERS_END);
 	
+	begin = parser_offset (priv, NULL);
+	lineno = parser_lineno (priv, NULL);
+	encoding = g_mime_part_get_content_encoding (mime_part);
+	
 	if (priv->persist_stream && priv->seekable) {
 		stream = g_mime_stream_null_new ();
 		start = parser_offset (priv, NULL);
@@ -1658,26 +2195,42 @@ parser_scan_mime_part_content (GMimeParser *parser, GMimePart *mime_part)
 		start = 0;
 	}
 	
-	parser_scan_content (parser, stream, &empty);
+	if (priv->fingerprint != GMIME_FINGERPRINT_NONE) {
+		parser_fingerprint_init (&fp, priv->fingerprint, encoding);
+		parser_scan_content (parser, stream, &fp, &empty);
+	} else {
+		parser_scan_content (parser, stream, NULL, &empty);
+	}
+	
 	len = g_mime_stream_tell (stream);
 	
 	if (priv->persist_stream && priv->seekable) {
 		g_object_unref (stream);
 		
-		stream = g_mime_stream_substream (priv->stream, start, start + len);
+		if (priv->persist_threshold > 0 && len <= priv->persist_threshold)
+			stream = parser_load_content (parser, start, start + len);
+		else
+			stream = g_mime_stream_substream (priv->stream, start, start + len);
 	} else {
 		buffer = g_mime_stream_mem_get_byte_array ((GMimeStreamMem *) stream);
 		g_byte_array_set_size (buffer, (guint) len);
 		g_mime_stream_reset (stream);
+		
+		GMIME_STATS (_g_mime_stats_record_alloc (GMIME_STATS_SUBSYSTEM_CONTENT, (size_t) len));
 	}
 	
-	encoding = g_mime_part_get_content_encoding (mime_part);
 	content = g_mime_data_wrapper_new_with_stream (stream, encoding);
 	g_object_unref (stream);
 	
 	g_mime_part_set_content (mime_part, content);
 	g_object_unref (content);
 	
+	if (priv->fingerprint != GMIME_FINGERPRINT_NONE)
+		parser_fingerprint_apply (&fp, mime_part);
+	
+	parser_set_content_size (parser, (GMimeObject *) mime_part, begin, lineno);
+	parser_set_source (parser, (GMimeObject *) mime_part, start);
+	
 	switch (priv->openpgp) {
 	case GMIME_OPENPGP_END_PGP_SIGNATURE:
 		g_mime_part_set_openpgp_data (mime_part, GMIME_OPENPGP_DATA_SIGNED);
@@ -1736,6 +2289,8 @@ static void
 parser_scan_message_part (GMimeParser *parser, GMimeParserOptions *options, GMimeMessagePart *mpart, int depth)
 {
 	struct _GMimeParserPrivate *priv = parser->priv;
+	gint64 content_begin, headers_begin;
+	gint64 content_lineno, headers_lineno;
 	ContentType *content_type;
 	GMimeMessage *message;
 	GMimeObject *object;
@@ -1745,6 +2300,9 @@ parser_scan_message_part (GMimeParser *parser, GMimeParserOptions *options, GMim
 	
 	g_assert (priv->state == GMIME_PARSER_STATE_CONTENT);
 	
+	content_begin = parser_offset (priv, NULL);
+	content_lineno = parser_lineno (priv, NULL);
+	
 	if (priv->bounds != NULL) {
 		/* Check for the possibility of an empty message/rfc822 part. */
 		register char *inptr;
@@ -1791,13 +2349,19 @@ parser_scan_message_part (GMimeParser *parser, GMimeParserOptions *options, GMim
 		return;
 	}
 	
+	headers_begin = priv->headers_begin;
+	headers_lineno = priv->headers_lineno;
+	
 	message = g_mime_message_new (FALSE);
 	((GMimeObject *) message)->ensure_newline = FALSE;
+	GMIME_STATS (parser_stats_add_part (priv, depth));
 	_g_mime_header_list_set_options (((GMimeObject *) message)->headers, options);
 	message->marker = priv->preheader;
 	priv->preheader = NULL;
 	
 	can_warn = g_mime_parser_options_get_warning_callback (options) != NULL;
+	_g_mime_object_begin_construct ((GMimeObject *) message);
+	
 	for (i = 0; i < priv->headers->len; i++) {
 		header = priv->headers->pdata[i];
 		
@@ -1809,6 +2373,8 @@ parser_scan_message_part (GMimeParser *parser, GMimeParserOptions *options, GMim
 		}
 	}
 	
+	_g_mime_object_end_construct ((GMimeObject *) message);
+	
 	content_type = parser_content_type (parser, NULL);
 	if (content_type_is_type (content_type, "multipart", "*"))
 		object = parser_construct_multipart (parser, options, content_type, TRUE, depth + 1);
@@ -1819,6 +2385,15 @@ parser_scan_message_part (GMimeParser *parser, GMimeParserOptions *options, GMim
 	message->mime_part = object;
 	
 	g_mime_message_part_set_message (mpart, message);
+	
+	parser_set_content_size (parser, (GMimeObject *) message, headers_begin, headers_lineno);
+	parser_set_content_size (parser, (GMimeObject *) mpart, content_begin, content_lineno);
+	
+	/* the message's own source must not include the marker */
+	if (message->marker == NULL)
+		parser_set_source (parser, (GMimeObject *) message, headers_begin);
+	parser_set_source (parser, (GMimeObject *) mpart, content_begin);
+	
 	g_object_unref (message);
 }
 
@@ -1886,6 +2461,7 @@ parser_construct_leaf_part (GMimeParser *parser, GMimeParserOptions *options, Co
 	}
 	
 	object = g_mime_object_new_type (options, type, subtype);
+	GMIME_STATS (parser_stats_add_part (priv, depth));
 	
 	if (!content_type->exists) {
 		GMimeContentType *mime_type;
@@ -1895,6 +2471,8 @@ parser_construct_leaf_part (GMimeParser *parser, GMimeParserOptions *options, Co
 		g_object_unref (mime_type);
 	}
 	
+	_g_mime_object_begin_construct (object);
+	
 	for (i = 0; i < priv->headers->len; i++) {
 		header = priv->headers->pdata[i];
 		
@@ -1905,6 +2483,7 @@ parser_construct_leaf_part (GMimeParser *parser, GMimeParserOptions *options, Co
 		}
 	}
 	
+	_g_mime_object_end_construct (object);
 	parser_free_headers (priv);
 	
 	if (priv->state == GMIME_PARSER_STATE_HEADERS_END) {
@@ -1960,7 +2539,7 @@ parser_scan_multipart_face (GMimeParser *parser, GMimeMultipart *multipart, gboo
 	char *face;
 	
 	stream = g_mime_stream_mem_new ();
-	parser_scan_content (parser, stream, &empty);
+	parser_scan_content (parser, stream, NULL, &empty);
 	
 	if (!empty) {
 		buffer = g_mime_stream_mem_get_byte_array ((GMimeStreamMem *) stream);
@@ -2038,6 +2617,7 @@ parser_construct_multipart (GMimeParser *parser, GMimeParserOptions *options, Co
 {
 	struct _GMimeParserPrivate *priv = parser->priv;
 	GMimeMultipart *multipart;
+	gint64 content_begin, content_lineno;
 	gint64 ctype_offset = -1;
 	const char *boundary;
 	GMimeObject *object;
@@ -2047,6 +2627,9 @@ parser_construct_multipart (GMimeParser *parser, GMimeParserOptions *options, Co
 	g_assert (priv->state >= GMIME_PARSER_STATE_HEADERS_END);
 	
 	object = g_mime_object_new_type (options, content_type->type, content_type->subtype);
+	GMIME_STATS (parser_stats_add_part (priv, depth));
+	
+	_g_mime_object_begin_construct (object);
 	
 	for (i = 0; i < priv->headers->len; i++) {
 		header = priv->headers->pdata[i];
@@ -2062,6 +2645,7 @@ parser_construct_multipart (GMimeParser *parser, GMimeParserOptions *options, Co
 		}
 	}
 	
+	_g_mime_object_end_construct (object);
 	parser_free_headers (priv);
 	
 	multipart = (GMimeMultipart *) object;
@@ -2074,6 +2658,9 @@ parser_construct_multipart (GMimeParser *parser, GMimeParserOptions *options, Co
 		}
 	}
 	
+	content_begin = parser_offset (priv, NULL);
+	content_lineno = parser_lineno (priv, NULL);
+	
 	if ((boundary = g_mime_object_get_content_type_parameter (object, "boundary")) && depth < MAX_LEVEL) {
 		parser_push_boundary (parser, boundary);
 		
@@ -2088,6 +2675,12 @@ parser_construct_multipart (GMimeParser *parser, GMimeParserOptions *options, Co
 			parser_skip_line (parser);
 			parser_pop_boundary (parser);
 			parser_scan_multipart_epilogue (parser, multipart);
+			
+			parser_set_content_size (parser, object, content_begin, content_lineno);
+			
+			/* only well-formed multiparts can be written back verbatim */
+			parser_set_source (parser, object, content_begin);
+			
 			return object;
 		}
 		
@@ -2117,6 +2710,8 @@ parser_construct_multipart (GMimeParser *parser, GMimeParserOptions *options, Co
 		parser_scan_multipart_prologue (parser, multipart);
 	}
 	
+	parser_set_content_size (parser, object, content_begin, content_lineno);
+	
 	return object;
 }
 
@@ -2127,13 +2722,15 @@ parser_construct_part (GMimeParser *parser, GMimeParserOptions *options)
 	ContentType *content_type;
 	GMimeObject *object;
 	
-	/* get the headers */
-	priv->state = GMIME_PARSER_STATE_HEADERS;
-	priv->toplevel = TRUE;
-	
-	while (priv->state < GMIME_PARSER_STATE_HEADERS_END) {
-		if (parser_step (parser, options) == GMIME_PARSER_STATE_ERROR)
-			return NULL;
+	/* get the headers, unless they were already parsed while being fed */
+	if (!priv->feed || priv->state < GMIME_PARSER_STATE_HEADERS_END) {
+		priv->state = GMIME_PARSER_STATE_HEADERS;
+		priv->toplevel = TRUE;
+		
+		while (priv->state < GMIME_PARSER_STATE_HEADERS_END) {
+			if (parser_step (parser, options) == GMIME_PARSER_STATE_ERROR)
+				return NULL;
+		}
 	}
 	
 	content_type = parser_content_type (parser, NULL);
@@ -2162,6 +2759,7 @@ GMimeObject *
 g_mime_parser_construct_part (GMimeParser *parser, GMimeParserOptions *options)
 {
 	g_return_val_if_fail (GMIME_IS_PARSER (parser), NULL);
+	g_return_val_if_fail (!parser->priv->feed || parser->priv->feed_eof, NULL);
 	
 	return parser_construct_part (parser, options);
 }
@@ -2174,6 +2772,7 @@ parser_construct_message (GMimeParser *parser, GMimeParserOptions *options)
 	unsigned long content_length = ULONG_MAX;
 	ContentType *content_type;
 	GMimeMessage *message;
+	gint64 headers_begin, headers_lineno;
 	GMimeObject *object;
 	const char *inptr;
 	gboolean can_warn;
@@ -2181,24 +2780,33 @@ parser_construct_message (GMimeParser *parser, GMimeParserOptions *options)
 	char *endptr;
 	guint i;
 	
-	/* scan the from-line if we are parsing an mbox */
-	while (priv->state != GMIME_PARSER_STATE_MESSAGE_HEADERS) {
-		if (parser_step (parser, options) == GMIME_PARSER_STATE_ERROR)
-			return NULL;
+	/* the headers may already have been parsed while they were fed */
+	if (!priv->feed || priv->state < GMIME_PARSER_STATE_HEADERS_END) {
+		/* scan the from-line if we are parsing an mbox */
+		while (priv->state != GMIME_PARSER_STATE_MESSAGE_HEADERS) {
+			if (parser_step (parser, options) == GMIME_PARSER_STATE_ERROR)
+				return NULL;
+		}
+		
+		/* parse the headers */
+		priv->toplevel = TRUE;
+		while (priv->state < GMIME_PARSER_STATE_HEADERS_END) {
+			if (parser_step (parser, options) == GMIME_PARSER_STATE_ERROR)
+				return NULL;
+		}
 	}
 	
-	/* parse the headers */
-	priv->toplevel = TRUE;
-	while (priv->state < GMIME_PARSER_STATE_HEADERS_END) {
-		if (parser_step (parser, options) == GMIME_PARSER_STATE_ERROR)
-			return NULL;
-	}
+	headers_begin = priv->headers_begin;
+	headers_lineno = priv->headers_lineno;
 	
 	message = g_mime_message_new (FALSE);
 	((GMimeObject *) message)->ensure_newline = FALSE;
+	GMIME_STATS (parser_stats_add_part (priv, 0));
 	_g_mime_header_list_set_options (((GMimeObject *) message)->headers, options);
 	
 	can_warn = g_mime_parser_options_get_warning_callback (options) != NULL;
+	_g_mime_object_begin_construct ((GMimeObject *) message);
+	
 	for (i = 0; i < priv->headers->len; i++) {
 		header = priv->headers->pdata[i];
 		
@@ -2220,6 +2828,8 @@ parser_construct_message (GMimeParser *parser, GMimeParserOptions *options)
 		}
 	}
 	
+	_g_mime_object_end_construct ((GMimeObject *) message);
+	
 	if (priv->format == GMIME_FORMAT_MBOX) {
 		parser_push_boundary (parser, MBOX_BOUNDARY);
 		priv->content_end = 0;
@@ -2239,6 +2849,9 @@ parser_construct_message (GMimeParser *parser, GMimeParserOptions *options)
 	content_type_destroy (content_type);
 	message->mime_part = object;
 	
+	parser_set_content_size (parser, (GMimeObject *) message, headers_begin, headers_lineno);
+	parser_set_source (parser, (GMimeObject *) message, headers_begin);
+	
 	if (priv->state == GMIME_PARSER_STATE_ERROR)
 		_g_mime_parser_options_warn (options, -1, GMIME_WARN_MALFORMED_MESSAGE, NULL);
 	
@@ -2264,11 +2877,158 @@ GMimeMessage *
 g_mime_parser_construct_message (GMimeParser *parser, GMimeParserOptions *options)
 {
 	g_return_val_if_fail (GMIME_IS_PARSER (parser), NULL);
+	g_return_val_if_fail (!parser->priv->feed || parser->priv->feed_eof, NULL);
 	
 	return parser_construct_message (parser, options);
 }
 
 
+#define ASYNC_READ_SIZE (64 * 1024)
+
+typedef struct {
+	GMimeParserOptions *options;
+	GInputStream *istream;
+	char *buffer;
+} ParserAsyncData;
+
+static void
+parser_async_data_free (ParserAsyncData *data)
+{
+	if (data->options)
+		g_mime_parser_options_free (data->options);
+	g_object_unref (data->istream);
+	g_free (data->buffer);
+	g_free (data);
+}
+
+static void parser_async_read_cb (GObject *source, GAsyncResult *result, gpointer user_data);
+
+static void
+parser_async_read (GTask *task)
+{
+	ParserAsyncData *data = g_task_get_task_data (task);
+	
+	g_input_stream_read_async (data->istream, data->buffer, ASYNC_READ_SIZE, g_task_get_priority (task),
+				   g_task_get_cancellable (task), parser_async_read_cb, task);
+}
+
+static void
+parser_async_construct (GTask *task, gpointer source_object, gpointer task_data, GCancellable *cancellable)
+{
+	ParserAsyncData *data = task_data;
+	GMimeParser *parser = source_object;
+	GMimeMessage *message;
+	
+	if (g_task_return_error_if_cancelled (task))
+		return;
+	
+	if ((message = parser_construct_message (parser, data->options)))
+		g_task_return_pointer (task, message, g_object_unref);
+	else
+		g_task_return_new_error (task, GMIME_ERROR, GMIME_ERROR_PARSE_ERROR, "Failed to parse message");
+}
+
+static void
+parser_async_read_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	GTask *task = (GTask *) user_data;
+	GMimeParser *parser = g_task_get_source_object (task);
+	ParserAsyncData *data = g_task_get_task_data (task);
+	GError *err = NULL;
+	gssize nread;
+	
+	if ((nread = g_input_stream_read_finish ((GInputStream *) source, result, &err)) == -1) {
+		g_task_return_error (task, err);
+		g_object_unref (task);
+		return;
+	}
+	
+	if (nread > 0) {
+		g_mime_parser_feed (parser, data->options, data->buffer, nread);
+		parser_async_read (task);
+		return;
+	}
+	
+	g_mime_parser_feed_eof (parser, data->options);
+	
+	/* the content is scanned in one go, so do it off the main loop */
+	g_task_run_in_thread (task, parser_async_construct);
+	g_object_unref (task);
+}
+
+
+/**
+ * g_mime_parser_construct_message_async:
+ * @parser: a #GMimeParser context
+ * @stream: a #GInputStream to read the message from
+ * @options: (nullable): a #GMimeParserOptions or %NULL
+ * @io_priority: the I/O priority of the read requests
+ * @cancellable: (nullable): a #GCancellable or %NULL
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the message has been parsed
+ * @user_data: (closure): user data for @callback
+ *
+ * Asynchronously reads a MIME message from @stream and constructs
+ * it. The message is read using g_input_stream_read_async() and handed
+ * to the parser using g_mime_parser_feed(), which parses the message
+ * headers as they arrive. Once the end of @stream has been reached, the
+ * rest of the message is parsed on a worker thread, so the thread
+ * running the main loop is never blocked.
+ *
+ * Any stream that @parser was previously initialized with is
+ * discarded, and @parser must not be used until @callback has been
+ * invoked. Call g_mime_parser_construct_message_finish() from
+ * @callback to get the result.
+ **/
+void
+g_mime_parser_construct_message_async (GMimeParser *parser, GInputStream *stream, GMimeParserOptions *options,
+				       int io_priority, GCancellable *cancellable,
+				       GAsyncReadyCallback callback, gpointer user_data)
+{
+	ParserAsyncData *data;
+	GTask *task;
+	
+	g_return_if_fail (GMIME_IS_PARSER (parser));
+	g_return_if_fail (G_IS_INPUT_STREAM (stream));
+	
+	data = g_new (ParserAsyncData, 1);
+	data->options = options ? g_mime_parser_options_clone (options) : NULL;
+	data->buffer = g_malloc (ASYNC_READ_SIZE);
+	data->istream = stream;
+	g_object_ref (stream);
+	
+	task = g_task_new (parser, cancellable, callback, user_data);
+	g_task_set_source_tag (task, g_mime_parser_construct_message_async);
+	g_task_set_task_data (task, data, (GDestroyNotify) parser_async_data_free);
+	g_task_set_priority (task, io_priority);
+	
+	parser_feed_begin (parser);
+	
+	parser_async_read (task);
+}
+
+
+/**
+ * g_mime_parser_construct_message_finish:
+ * @parser: a #GMimeParser context
+ * @result: a #GAsyncResult
+ * @err: a #GError
+ *
+ * Finishes an operation started with
+ * g_mime_parser_construct_message_async().
+ *
+ * Returns: (nullable) (transfer full): the MIME message or %NULL on
+ * fail, in which case @err will be set.
+ **/
+GMimeMessage *
+g_mime_parser_construct_message_finish (GMimeParser *parser, GAsyncResult *result, GError **err)
+{
+	g_return_val_if_fail (GMIME_IS_PARSER (parser), NULL);
+	g_return_val_if_fail (g_task_is_valid (result, parser), NULL);
+	
+	return g_task_propagate_pointer ((GTask *) result, err);
+}
+
+
 /**
  * g_mime_parser_get_mbox_marker:
  * @parser: a #GMimeParser context
@@ -2358,3 +3118,33 @@ g_mime_parser_get_headers_end (GMimeParser *parser)
 	
 	return parser->priv->message_headers_end;
 }
+
+
+/**
+ * g_mime_parser_get_stats:
+ * @parser: a #GMimeParser context
+ * @stats: (out): a #GMimeParserStats to fill in
+ *
+ * Gets the counters that @parser has collected since it was created
+ * or last initialized with g_mime_parser_init_with_stream().
+ *
+ * Returns: %TRUE if @stats was filled in or %FALSE if statistics are
+ * not enabled (see g_mime_stats_enabled()), in which case @stats is
+ * zeroed.
+ **/
+gboolean
+g_mime_parser_get_stats (GMimeParser *parser, GMimeParserStats *stats)
+{
+	g_return_val_if_fail (GMIME_IS_PARSER (parser), FALSE);
+	g_return_val_if_fail (stats != NULL, FALSE);
+	
+#ifdef ENABLE_STATS
+	memcpy (stats, &parser->priv->stats, sizeof (GMimeParserStats));
+	
+	return TRUE;
+#else
+	memset (stats, 0, sizeof (GMimeParserStats));
+	
+	return FALSE;
+#endif
+}
@@ -24,6 +24,7 @@
 
 #include <glib.h>
 #include <glib-object.h>
+#include <gio/gio.h>
 #include <errno.h>
 
 #include <gmime/gmime-object.h>
@@ -79,6 +80,27 @@ struct _GMimeParserClass {
 };
 
 
+/**
+ * GMimeParserStats:
+ * @bytes_read: the number of bytes read from the stream
+ * @fill_calls: the number of times the input buffer was refilled
+ * @headers: the number of header fields parsed
+ * @parts: the number of MIME parts and messages created
+ * @boundary_checks: the number of lines checked for a boundary marker
+ * @max_depth: the deepest level of nesting encountered
+ *
+ * Counters collected by a #GMimeParser. See g_mime_parser_get_stats().
+ **/
+typedef struct {
+	guint64 bytes_read;
+	guint64 fill_calls;
+	guint64 headers;
+	guint64 parts;
+	guint64 boundary_checks;
+	guint max_depth;
+} GMimeParserStats;
+
+
 /**
  * GMimeParserHeaderRegexFunc:
  * @parser: The #GMimeParser object.
@@ -102,6 +124,9 @@ GMimeParser *g_mime_parser_new_with_stream (GMimeStream *stream);
 
 void g_mime_parser_init_with_stream (GMimeParser *parser, GMimeStream *stream);
 
+void g_mime_parser_feed (GMimeParser *parser, GMimeParserOptions *options, const char *buffer, size_t len);
+void g_mime_parser_feed_eof (GMimeParser *parser, GMimeParserOptions *options);
+
 gboolean g_mime_parser_get_persist_stream (GMimeParser *parser);
 void g_mime_parser_set_persist_stream (GMimeParser *parser, gboolean persist);
 
@@ -111,6 +136,9 @@ void g_mime_parser_set_format (GMimeParser *parser, GMimeFormat format);
 gboolean g_mime_parser_get_respect_content_length (GMimeParser *parser);
 void g_mime_parser_set_respect_content_length (GMimeParser *parser, gboolean respect_content_length);
 
+GMimeFingerprintFlags g_mime_parser_get_fingerprint (GMimeParser *parser);
+void g_mime_parser_set_fingerprint (GMimeParser *parser, GMimeFingerprintFlags flags);
+
 void g_mime_parser_set_header_regex (GMimeParser *parser, const char *regex,
 				     GMimeParserHeaderRegexFunc header_cb,
 				     gpointer user_data);
@@ -118,6 +146,11 @@ void g_mime_parser_set_header_regex (GMimeParser *parser, const char *regex,
 GMimeObject *g_mime_parser_construct_part (GMimeParser *parser, GMimeParserOptions *options);
 GMimeMessage *g_mime_parser_construct_message (GMimeParser *parser, GMimeParserOptions *options);
 
+void g_mime_parser_construct_message_async (GMimeParser *parser, GInputStream *stream, GMimeParserOptions *options,
+					    int io_priority, GCancellable *cancellable,
+					    GAsyncReadyCallback callback, gpointer user_data);
+GMimeMessage *g_mime_parser_construct_message_finish (GMimeParser *parser, GAsyncResult *result, GError **err);
+
 gint64 g_mime_parser_tell (GMimeParser *parser);
 
 gboolean g_mime_parser_eos (GMimeParser *parser);
@@ -128,6 +161,8 @@ gint64 g_mime_parser_get_mbox_marker_offset (GMimeParser *parser);
 gint64 g_mime_parser_get_headers_begin (GMimeParser *parser);
 gint64 g_mime_parser_get_headers_end (GMimeParser *parser);
 
+gboolean g_mime_parser_get_stats (GMimeParser *parser, GMimeParserStats *stats);
+
 G_END_DECLS
 
 #endif /* __GMIME_PARSER_H__ */
@@ -55,6 +55,19 @@
  * sub-parts).
  **/
 
+typedef struct {
+	/* the fingerprints recorded by the parser */
+	GMimeFingerprintFlags fingerprint;
+	guint64 content_hash;
+	gint64 decoded_length;
+	unsigned char content_sha256[32];
+	
+	/* the generation of the content when the fingerprints were recorded */
+	guint content_generation;
+} GMimePartPrivate;
+
+#define GMIME_PART_GET_PRIVATE(part) ((GMimePartPrivate *) G_STRUCT_MEMBER_P (part, part_private_offset))
+
 /* GObject class methods */
 static void g_mime_part_class_init (GMimePartClass *klass);
 static void g_mime_part_init (GMimePart *mime_part, GMimePartClass *klass);
@@ -75,6 +88,7 @@ static void set_content (GMimePart *mime_part, GMimeDataWrapper *content);
 
 
 static GMimeObjectClass *parent_class = NULL;
+static gint part_private_offset = 0;
 
 
 GType
@@ -96,6 +110,7 @@ g_mime_part_get_type (void)
 		};
 		
 		type = g_type_register_static (GMIME_TYPE_OBJECT, "GMimePart", &info, 0);
+		part_private_offset = g_type_add_instance_private (type, sizeof (GMimePartPrivate));
 	}
 	
 	return type;
@@ -109,6 +124,7 @@ g_mime_part_class_init (GMimePartClass *klass)
 	GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 	
 	parent_class = g_type_class_ref (GMIME_TYPE_OBJECT);
+	g_type_class_adjust_private_offset (klass, &part_private_offset);
 	
 	gobject_class->finalize = g_mime_part_finalize;
 	
@@ -125,12 +141,19 @@ g_mime_part_class_init (GMimePartClass *klass)
 static void
 g_mime_part_init (GMimePart *mime_part, GMimePartClass *klass)
 {
+	GMimePartPrivate *priv = GMIME_PART_GET_PRIVATE (mime_part);
+	
 	mime_part->encoding = GMIME_CONTENT_ENCODING_DEFAULT;
 	mime_part->content_description = NULL;
 	mime_part->content_location = NULL;
 	mime_part->content_md5 = NULL;
 	mime_part->content = NULL;
 	mime_part->openpgp = (GMimeOpenPGPData) -1;
+	
+	priv->fingerprint = GMIME_FINGERPRINT_NONE;
+	priv->decoded_length = -1;
+	priv->content_hash = 0;
+	priv->content_generation = 0;
 }
 
 static void
@@ -186,6 +209,7 @@ process_header (GMimeObject *object, GMimeHeader *header)
 	case HEADER_CONTENT_TRANSFER_ENCODING:
 		value = g_mime_header_get_value (header);
 		mime_part->encoding = g_mime_content_encoding_from_string (value);
+		_g_mime_object_clear_source (object);
 		break;
 	case HEADER_CONTENT_DESCRIPTION:
 		value = g_mime_header_get_value (header);
@@ -245,6 +269,7 @@ mime_part_header_removed (GMimeObject *object, GMimeHeader *header)
 		switch (i) {
 		case HEADER_CONTENT_TRANSFER_ENCODING:
 			mime_part->encoding = GMIME_CONTENT_ENCODING_DEFAULT;
+			_g_mime_object_clear_source (object);
 			break;
 		case HEADER_CONTENT_DESCRIPTION:
 			g_free (mime_part->content_description);
@@ -274,6 +299,7 @@ mime_part_headers_cleared (GMimeObject *object)
 	mime_part->encoding = GMIME_CONTENT_ENCODING_DEFAULT;
 	g_free (mime_part->content_description);
 	mime_part->content_description = NULL;
+	_g_mime_object_clear_source (object);
 	g_free (mime_part->content_location);
 	mime_part->content_location = NULL;
 	g_free (mime_part->content_md5);
@@ -294,6 +320,10 @@ write_content (GMimePart *part, GMimeFormatOptions *options, GMimeStream *stream
 	if (!part->content)
 		return 0;
 	
+	/* copy unmodified content straight from the stream it was parsed from */
+	if (_g_mime_object_can_write_source (object, options))
+		return _g_mime_object_write_source (object, stream);
+	
 	/* Evil Genius's "slight" optimization: Since GMimeDataWrapper::write_to_stream()
 	 * decodes its content stream to the raw format, we can cheat by requesting its
 	 * content stream and not doing any encoding on the data if the source and
@@ -406,28 +436,52 @@ mime_part_write_to_stream (GMimeObject *object, GMimeFormatOptions *options, gbo
 	return total;
 }
 
-static void
-mime_part_encode (GMimeObject *object, GMimeEncodingConstraint constraint)
+/**
+ * _g_mime_part_encode_needs_scan:
+ * @part: a #GMimePart
+ * @constraint: a #GMimeEncodingConstraint
+ *
+ * Checks whether the content of @part has to be scanned to pick the
+ * best Content-Transfer-Encoding for @constraint.
+ *
+ * Returns: %TRUE if _g_mime_part_encode_scan() is needed or %FALSE if
+ * the current encoding is already safe.
+ **/
+gboolean
+_g_mime_part_encode_needs_scan (GMimePart *part, GMimeEncodingConstraint constraint)
 {
-	GMimePart *part = (GMimePart *) object;
-	GMimeContentEncoding encoding;
-	GMimeStream *stream, *null;
-	GMimeFilter *filter;
-	
 	switch (part->encoding) {
 	case GMIME_CONTENT_ENCODING_BINARY:
 		/* This encoding is only safe if the constraint is binary. */
-		if (constraint == GMIME_ENCODING_CONSTRAINT_BINARY)
-			return;
-		break;
+		return constraint != GMIME_ENCODING_CONSTRAINT_BINARY;
 	case GMIME_CONTENT_ENCODING_BASE64:
 	case GMIME_CONTENT_ENCODING_QUOTEDPRINTABLE:
 	case GMIME_CONTENT_ENCODING_UUENCODE:
 		/* These encodings are always safe. */
-		return;
+		return FALSE;
 	default:
-		break;
+		return TRUE;
 	}
+}
+
+
+/**
+ * _g_mime_part_encode_scan:
+ * @part: a #GMimePart
+ *
+ * Runs the content of @part through a #GMimeFilterBest. This only
+ * reads the content and does not modify @part, so it may be done on
+ * another thread as long as nothing else reads the content stream at
+ * the same time.
+ *
+ * Returns: (transfer full): the #GMimeFilterBest to pass to
+ * _g_mime_part_encode_apply().
+ **/
+GMimeFilter *
+_g_mime_part_encode_scan (GMimePart *part)
+{
+	GMimeStream *stream, *null;
+	GMimeFilter *filter;
 	
 	filter = g_mime_filter_best_new (GMIME_FILTER_BEST_ENCODING);
 	
@@ -439,6 +493,24 @@ mime_part_encode (GMimeObject *object, GMimeEncodingConstraint constraint)
 	g_mime_data_wrapper_write_to_stream (part->content, stream);
 	g_object_unref (stream);
 	
+	return filter;
+}
+
+
+/**
+ * _g_mime_part_encode_apply:
+ * @part: a #GMimePart
+ * @constraint: a #GMimeEncodingConstraint
+ * @filter: the #GMimeFilterBest returned by _g_mime_part_encode_scan()
+ *
+ * Sets the Content-Transfer-Encoding of @part based on the scan of its
+ * content.
+ **/
+void
+_g_mime_part_encode_apply (GMimePart *part, GMimeEncodingConstraint constraint, GMimeFilter *filter)
+{
+	GMimeContentEncoding encoding;
+	
 	encoding = g_mime_filter_best_encoding ((GMimeFilterBest *) filter, constraint);
 	
 	switch (part->encoding) {
@@ -459,7 +531,19 @@ mime_part_encode (GMimeObject *object, GMimeEncodingConstraint constraint)
 	default:
 		break;
 	}
+}
+
+static void
+mime_part_encode (GMimeObject *object, GMimeEncodingConstraint constraint)
+{
+	GMimePart *part = (GMimePart *) object;
+	GMimeFilter *filter;
+	
+	if (!_g_mime_part_encode_needs_scan (part, constraint))
+		return;
 	
+	filter = _g_mime_part_encode_scan (part);
+	_g_mime_part_encode_apply (part, constraint, filter);
 	g_object_unref (filter);
 }
 
@@ -779,6 +863,8 @@ g_mime_part_set_content_encoding (GMimePart *mime_part, GMimeContentEncoding enc
 	value = g_mime_content_encoding_to_string (encoding);
 	mime_part->encoding = encoding;
 	
+	_g_mime_object_clear_source (object);
+	
 	_g_mime_object_block_header_list_changed (object);
 	if (value != NULL)
 		g_mime_header_list_set (object->headers, "Content-Transfer-Encoding", value, NULL);
@@ -922,6 +1008,8 @@ set_content (GMimePart *mime_part, GMimeDataWrapper *content)
 		g_object_unref (mime_part->content);
 	
 	mime_part->openpgp = (GMimeOpenPGPData) -1;
+	GMIME_PART_GET_PRIVATE (mime_part)->fingerprint = GMIME_FINGERPRINT_NONE;
+	_g_mime_object_clear_source ((GMimeObject *) mime_part);
 	
 	mime_part->content = content;
 	g_object_ref (content);
@@ -966,6 +1054,125 @@ g_mime_part_get_content (GMimePart *mime_part)
 }
 
 
+/**
+ * _g_mime_part_set_fingerprint:
+ * @mime_part: a #GMimePart object
+ * @flags: the #GMimeFingerprintFlags that were computed
+ * @hash: the FNV-1a hash of the decoded content
+ * @length: the length of the decoded content
+ * @sha256: the SHA-256 digest of the decoded content or %NULL
+ *
+ * Records the fingerprints of the decoded content of @mime_part. They
+ * are discarded when the content is replaced, or when the stream or
+ * encoding of the content is changed.
+ *
+ * Note: This method is meant for use by #GMimeParser.
+ **/
+void
+_g_mime_part_set_fingerprint (GMimePart *mime_part, GMimeFingerprintFlags flags, guint64 hash,
+			      gint64 length, const unsigned char *sha256)
+{
+	GMimePartPrivate *priv = GMIME_PART_GET_PRIVATE (mime_part);
+	
+	priv->fingerprint = mime_part->content ? flags : GMIME_FINGERPRINT_NONE;
+	priv->content_hash = hash;
+	priv->decoded_length = length;
+	
+	if (mime_part->content)
+		priv->content_generation = _g_mime_data_wrapper_get_generation (mime_part->content);
+	
+	if (sha256 != NULL)
+		memcpy (priv->content_sha256, sha256, sizeof (priv->content_sha256));
+}
+
+/* checks that the @flag fingerprint was recorded for the current content */
+static gboolean
+part_has_fingerprint (GMimePart *mime_part, GMimeFingerprintFlags flag)
+{
+	GMimePartPrivate *priv = GMIME_PART_GET_PRIVATE (mime_part);
+	
+	if (!(priv->fingerprint & flag) || mime_part->content == NULL)
+		return FALSE;
+	
+	return _g_mime_data_wrapper_get_generation (mime_part->content) == priv->content_generation;
+}
+
+
+/**
+ * g_mime_part_get_content_hash:
+ * @mime_part: a #GMimePart object
+ * @hash: (out) (optional): return location for the hash
+ * @length: (out) (optional): return location for the length of the decoded content
+ *
+ * Gets the 64-bit FNV-1a hash of the decoded content of @mime_part as
+ * computed by the #GMimeParser while it was scanning the content (see
+ * g_mime_parser_set_fingerprint()).
+ *
+ * The hash is not cryptographically secure. It is meant for cheaply
+ * finding candidate duplicates, which should be confirmed by
+ * comparing lengths and content (or SHA-256 digests).
+ *
+ * Returns: %TRUE if the hash is known or %FALSE if the parser was not
+ * asked to compute it or the content has been replaced or modified since.
+ **/
+gboolean
+g_mime_part_get_content_hash (GMimePart *mime_part, guint64 *hash, gint64 *length)
+{
+	GMimePartPrivate *priv;
+	
+	g_return_val_if_fail (GMIME_IS_PART (mime_part), FALSE);
+	
+	if (!part_has_fingerprint (mime_part, GMIME_FINGERPRINT_HASH))
+		return FALSE;
+	
+	priv = GMIME_PART_GET_PRIVATE (mime_part);
+	
+	if (hash)
+		*hash = priv->content_hash;
+	
+	if (length)
+		*length = priv->decoded_length;
+	
+	return TRUE;
+}
+
+
+/**
+ * g_mime_part_get_content_sha256:
+ * @mime_part: a #GMimePart object
+ * @digest: (out caller-allocates) (optional): a 32 byte buffer for the digest
+ * @length: (out) (optional): return location for the length of the decoded content
+ *
+ * Gets the SHA-256 digest of the decoded content of @mime_part as
+ * computed by the #GMimeParser while it was scanning the content (see
+ * g_mime_parser_set_fingerprint()).
+ *
+ * Returns: %TRUE if the digest is known or %FALSE if the parser was
+ * not asked to compute it or the content has been replaced or modified
+ * since.
+ **/
+gboolean
+g_mime_part_get_content_sha256 (GMimePart *mime_part, unsigned char *digest, gint64 *length)
+{
+	GMimePartPrivate *priv;
+	
+	g_return_val_if_fail (GMIME_IS_PART (mime_part), FALSE);
+	
+	if (!part_has_fingerprint (mime_part, GMIME_FINGERPRINT_SHA256))
+		return FALSE;
+	
+	priv = GMIME_PART_GET_PRIVATE (mime_part);
+	
+	if (digest)
+		memcpy (digest, priv->content_sha256, sizeof (priv->content_sha256));
+	
+	if (length)
+		*length = priv->decoded_length;
+	
+	return TRUE;
+}
+
+
 /**
  * g_mime_part_set_openpgp_data:
  * @mime_part: a #GMimePart
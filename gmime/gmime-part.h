@@ -44,6 +44,21 @@ G_BEGIN_DECLS
 typedef struct _GMimePart GMimePart;
 typedef struct _GMimePartClass GMimePartClass;
 
+/**
+ * GMimeFingerprintFlags:
+ * @GMIME_FINGERPRINT_NONE: No fingerprint.
+ * @GMIME_FINGERPRINT_HASH: A 64-bit FNV-1a hash and the length of the decoded content.
+ * @GMIME_FINGERPRINT_SHA256: A SHA-256 digest and the length of the decoded content.
+ *
+ * The fingerprints that a #GMimeParser should compute for the decoded
+ * content of each #GMimePart while scanning it.
+ **/
+typedef enum {
+	GMIME_FINGERPRINT_NONE   = 0,
+	GMIME_FINGERPRINT_HASH   = 1 << 0,
+	GMIME_FINGERPRINT_SHA256 = 1 << 1
+} GMimeFingerprintFlags;
+
 /**
  * GMimePart:
  * @parent_object: parent #GMimeObject
@@ -108,6 +123,9 @@ const char *g_mime_part_get_filename (GMimePart *mime_part);
 void g_mime_part_set_content (GMimePart *mime_part, GMimeDataWrapper *content);
 GMimeDataWrapper *g_mime_part_get_content (GMimePart *mime_part);
 
+gboolean g_mime_part_get_content_hash (GMimePart *mime_part, guint64 *hash, gint64 *length);
+gboolean g_mime_part_get_content_sha256 (GMimePart *mime_part, unsigned char *digest, gint64 *length);
+
 void g_mime_part_set_openpgp_data (GMimePart *mime_part, GMimeOpenPGPData data);
 GMimeOpenPGPData g_mime_part_get_openpgp_data (GMimePart *mime_part);
 
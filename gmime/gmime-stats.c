@@ -0,0 +1,176 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+
+#include "gmime-stats.h"
+#include "gmime-internal.h"
+
+
+/**
+ * SECTION: gmime-stats
+ * @title: gmime-stats
+ * @short_description: Allocation statistics
+ * @see_also: g_mime_parser_get_stats(), g_mime_stream_get_stats()
+ *
+ * When GMime is configured with --enable-stats, it counts the
+ * allocations made by its header, parameter, address and content
+ * subsystems and keeps per-#GMimeParser and per-#GMimeStream
+ * counters. Without --enable-stats, none of this bookkeeping is
+ * compiled in and the query functions report that statistics are
+ * unavailable.
+ **/
+
+#define N_SUBSYSTEMS (GMIME_STATS_SUBSYSTEM_CONTENT + 1)
+
+#ifdef ENABLE_STATS
+typedef struct {
+	guint64 count;
+	guint64 bytes;
+} AllocStats;
+
+G_LOCK_DEFINE_STATIC (stats);
+static AllocStats allocations[N_SUBSYSTEMS];
+static GMimeStatsAllocFunc alloc_func = NULL;
+static gpointer alloc_data = NULL;
+
+
+void
+_g_mime_stats_record_alloc (GMimeStatsSubsystem subsystem, size_t size)
+{
+	GMimeStatsAllocFunc func;
+	gpointer user_data;
+	
+	G_LOCK (stats);
+	allocations[subsystem].count++;
+	allocations[subsystem].bytes += size;
+	user_data = alloc_data;
+	func = alloc_func;
+	G_UNLOCK (stats);
+	
+	if (func != NULL)
+		func (subsystem, size, user_data);
+}
+#endif /* ENABLE_STATS */
+
+
+/**
+ * g_mime_stats_enabled:
+ *
+ * Gets whether or not GMime was built with statistics support
+ * (i.e. configured with --enable-stats).
+ *
+ * Returns: %TRUE if statistics are collected or %FALSE otherwise.
+ **/
+gboolean
+g_mime_stats_enabled (void)
+{
+#ifdef ENABLE_STATS
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
+
+/**
+ * g_mime_stats_set_alloc_func:
+ * @func: (nullable) (scope notified): a #GMimeStatsAllocFunc or %NULL
+ * @user_data: user data to pass to @func
+ *
+ * Sets a function to be called for every allocation that GMime
+ * accounts to one of the #GMimeStatsSubsystem categories. This can be
+ * used to attribute allocations to the message being processed.
+ *
+ * The function may be called from any thread that uses GMime.
+ *
+ * Note: This has no effect unless statistics are enabled. See
+ * g_mime_stats_enabled().
+ **/
+void
+g_mime_stats_set_alloc_func (GMimeStatsAllocFunc func, gpointer user_data)
+{
+#ifdef ENABLE_STATS
+	G_LOCK (stats);
+	alloc_func = func;
+	alloc_data = user_data;
+	G_UNLOCK (stats);
+#endif
+}
+
+
+/**
+ * g_mime_stats_get_allocations:
+ * @subsystem: a #GMimeStatsSubsystem
+ * @count: (out) (optional): the number of allocations
+ * @bytes: (out) (optional): the number of bytes allocated
+ *
+ * Gets the number of allocations, and the total number of bytes
+ * allocated, by @subsystem since the program started or since the
+ * last call to g_mime_stats_reset().
+ *
+ * Returns: %TRUE if the statistics are available or %FALSE if
+ * statistics are not enabled, in which case @count and @bytes are set
+ * to %0.
+ **/
+gboolean
+g_mime_stats_get_allocations (GMimeStatsSubsystem subsystem, guint64 *count, guint64 *bytes)
+{
+	g_return_val_if_fail (subsystem < N_SUBSYSTEMS, FALSE);
+	
+#ifdef ENABLE_STATS
+	G_LOCK (stats);
+	if (count)
+		*count = allocations[subsystem].count;
+	if (bytes)
+		*bytes = allocations[subsystem].bytes;
+	G_UNLOCK (stats);
+	
+	return TRUE;
+#else
+	if (count)
+		*count = 0;
+	if (bytes)
+		*bytes = 0;
+	
+	return FALSE;
+#endif
+}
+
+
+/**
+ * g_mime_stats_reset:
+ *
+ * Resets the allocation counters for all subsystems.
+ **/
+void
+g_mime_stats_reset (void)
+{
+#ifdef ENABLE_STATS
+	G_LOCK (stats);
+	memset (allocations, 0, sizeof (allocations));
+	G_UNLOCK (stats);
+#endif
+}
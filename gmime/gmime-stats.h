@@ -0,0 +1,68 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+
+#ifndef __GMIME_STATS_H__
+#define __GMIME_STATS_H__
+
+#include <glib.h>
+#include <sys/types.h>
+
+G_BEGIN_DECLS
+
+/**
+ * GMimeStatsSubsystem:
+ * @GMIME_STATS_SUBSYSTEM_HEADERS: Allocations made for header fields.
+ * @GMIME_STATS_SUBSYSTEM_PARAMS: Allocations made for Content-Type and Content-Disposition parameters.
+ * @GMIME_STATS_SUBSYSTEM_ADDRESSES: Allocations made for parsed internet addresses.
+ * @GMIME_STATS_SUBSYSTEM_CONTENT: Allocations made for MIME part content.
+ *
+ * The subsystem that an allocation is accounted to.
+ **/
+typedef enum {
+	GMIME_STATS_SUBSYSTEM_HEADERS,
+	GMIME_STATS_SUBSYSTEM_PARAMS,
+	GMIME_STATS_SUBSYSTEM_ADDRESSES,
+	GMIME_STATS_SUBSYSTEM_CONTENT
+} GMimeStatsSubsystem;
+
+
+/**
+ * GMimeStatsAllocFunc:
+ * @subsystem: the subsystem that made the allocation
+ * @size: the number of bytes allocated
+ * @user_data: the user-supplied callback data
+ *
+ * A function that gets called every time GMime records an allocation.
+ **/
+typedef void (* GMimeStatsAllocFunc) (GMimeStatsSubsystem subsystem, size_t size, gpointer user_data);
+
+
+gboolean g_mime_stats_enabled (void);
+
+void g_mime_stats_set_alloc_func (GMimeStatsAllocFunc func, gpointer user_data);
+
+gboolean g_mime_stats_get_allocations (GMimeStatsSubsystem subsystem, guint64 *count, guint64 *bytes);
+
+void g_mime_stats_reset (void);
+
+G_END_DECLS
+
+#endif /* __GMIME_STATS_H__ */
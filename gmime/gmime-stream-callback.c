@@ -0,0 +1,140 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+
+#include "gmime-stream.h"
+#include "gmime-internal.h"
+
+
+/* A write-only stream that hands everything written to it to a
+ * callback. It is not part of the public API; it lets the library
+ * serialize objects straight into wherever the output is going
+ * without an intermediate buffer. */
+
+typedef struct {
+	GMimeStream parent_object;
+	
+	GMimeStreamCallbackFunc write;
+	gpointer user_data;
+} GMimeStreamCallback;
+
+typedef struct {
+	GMimeStreamClass parent_class;
+} GMimeStreamCallbackClass;
+
+static void g_mime_stream_callback_class_init (GMimeStreamCallbackClass *klass);
+
+static ssize_t stream_read (GMimeStream *stream, char *buf, size_t len);
+static ssize_t stream_write (GMimeStream *stream, const char *buf, size_t len);
+static gboolean stream_eos (GMimeStream *stream);
+
+
+static GType
+g_mime_stream_callback_get_type (void)
+{
+	static GType type = 0;
+	
+	if (!type) {
+		static const GTypeInfo info = {
+			sizeof (GMimeStreamCallbackClass),
+			NULL, /* base_class_init */
+			NULL, /* base_class_finalize */
+			(GClassInitFunc) g_mime_stream_callback_class_init,
+			NULL, /* class_finalize */
+			NULL, /* class_data */
+			sizeof (GMimeStreamCallback),
+			0,    /* n_preallocs */
+			NULL, /* instance_init */
+		};
+		
+		type = g_type_register_static (GMIME_TYPE_STREAM, "GMimeStreamCallback", &info, 0);
+	}
+	
+	return type;
+}
+
+
+static void
+g_mime_stream_callback_class_init (GMimeStreamCallbackClass *klass)
+{
+	GMimeStreamClass *stream_class = GMIME_STREAM_CLASS (klass);
+	
+	stream_class->read = stream_read;
+	stream_class->write = stream_write;
+	stream_class->eos = stream_eos;
+}
+
+
+static ssize_t
+stream_read (GMimeStream *stream, char *buf, size_t len)
+{
+	errno = EBADF;
+	
+	return -1;
+}
+
+static ssize_t
+stream_write (GMimeStream *stream, const char *buf, size_t len)
+{
+	GMimeStreamCallback *callback = (GMimeStreamCallback *) stream;
+	ssize_t nwritten;
+	
+	if ((nwritten = callback->write (buf, len, callback->user_data)) > 0)
+		stream->position += nwritten;
+	
+	return nwritten;
+}
+
+static gboolean
+stream_eos (GMimeStream *stream)
+{
+	return FALSE;
+}
+
+
+/**
+ * _g_mime_stream_callback_new:
+ * @write: the function to call with the data written to the stream
+ * @user_data: user data for @write
+ *
+ * Creates a new write-only stream that passes everything written to
+ * it on to @write, which returns the number of bytes it consumed or
+ * %-1 (with errno set) on error.
+ *
+ * Returns: a new stream.
+ **/
+GMimeStream *
+_g_mime_stream_callback_new (GMimeStreamCallbackFunc write, gpointer user_data)
+{
+	GMimeStreamCallback *callback;
+	
+	callback = g_object_new (g_mime_stream_callback_get_type (), NULL);
+	g_mime_stream_construct ((GMimeStream *) callback, 0, -1);
+	callback->write = write;
+	callback->user_data = user_data;
+	
+	return (GMimeStream *) callback;
+}
@@ -0,0 +1,547 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <string.h>
+#include <errno.h>
+
+#include "gmime-stream-chunked.h"
+
+
+/**
+ * SECTION: gmime-stream-chunked
+ * @title: GMimeStreamChunked
+ * @short_description: A memory-backed stream that grows without copying
+ * @see_also: #GMimeStream, #GMimeStreamMem
+ *
+ * A #GMimeStream implementation that, like #GMimeStreamMem, keeps its
+ * data in memory, but stores it as a list of fixed-size chunks rather
+ * than in a single contiguous buffer.
+ *
+ * Appending to the stream never moves data that has already been
+ * written, so building up a large stream does not repeatedly
+ * reallocate and copy it, and seeking to any offset is a simple
+ * index into the chunk list. Substreams share the chunks of the
+ * stream they were created from.
+ *
+ * Use g_mime_stream_chunked_get_bytes() when a contiguous copy of the
+ * data is needed.
+ **/
+
+
+/* all chunks except the last one are CHUNK_SIZE bytes; the last one
+ * starts out small and doubles in size until it reaches CHUNK_SIZE so
+ * that small streams don't waste memory */
+#define CHUNK_SIZE (64 * 1024)
+#define CHUNK_MIN_SIZE 256
+
+struct _GMimeChunkList {
+	volatile gint ref_count;
+	GPtrArray *chunks;
+	size_t last_size;
+	gint64 length;
+};
+
+typedef struct _GMimeChunkList ChunkList;
+
+
+static void g_mime_stream_chunked_class_init (GMimeStreamChunkedClass *klass);
+static void g_mime_stream_chunked_init (GMimeStreamChunked *stream, GMimeStreamChunkedClass *klass);
+static void g_mime_stream_chunked_finalize (GObject *object);
+
+static ssize_t stream_read (GMimeStream *stream, char *buf, size_t len);
+static ssize_t stream_write (GMimeStream *stream, const char *buf, size_t len);
+static int stream_flush (GMimeStream *stream);
+static int stream_close (GMimeStream *stream);
+static gboolean stream_eos (GMimeStream *stream);
+static int stream_reset (GMimeStream *stream);
+static gint64 stream_seek (GMimeStream *stream, gint64 offset, GMimeSeekWhence whence);
+static gint64 stream_tell (GMimeStream *stream);
+static gint64 stream_length (GMimeStream *stream);
+static GMimeStream *stream_substream (GMimeStream *stream, gint64 start, gint64 end);
+
+
+static GMimeStreamClass *parent_class = NULL;
+
+
+GType
+g_mime_stream_chunked_get_type (void)
+{
+	static GType type = 0;
+	
+	if (!type) {
+		static const GTypeInfo info = {
+			sizeof (GMimeStreamChunkedClass),
+			NULL, /* base_class_init */
+			NULL, /* base_class_finalize */
+			(GClassInitFunc) g_mime_stream_chunked_class_init,
+			NULL, /* class_finalize */
+			NULL, /* class_data */
+			sizeof (GMimeStreamChunked),
+			0,    /* n_preallocs */
+			(GInstanceInitFunc) g_mime_stream_chunked_init,
+		};
+		
+		type = g_type_register_static (GMIME_TYPE_STREAM, "GMimeStreamChunked", &info, 0);
+	}
+	
+	return type;
+}
+
+
+static void
+g_mime_stream_chunked_class_init (GMimeStreamChunkedClass *klass)
+{
+	GMimeStreamClass *stream_class = GMIME_STREAM_CLASS (klass);
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	
+	parent_class = g_type_class_ref (GMIME_TYPE_STREAM);
+	
+	object_class->finalize = g_mime_stream_chunked_finalize;
+	
+	stream_class->read = stream_read;
+	stream_class->write = stream_write;
+	stream_class->flush = stream_flush;
+	stream_class->close = stream_close;
+	stream_class->eos = stream_eos;
+	stream_class->reset = stream_reset;
+	stream_class->seek = stream_seek;
+	stream_class->tell = stream_tell;
+	stream_class->length = stream_length;
+	stream_class->substream = stream_substream;
+}
+
+static void
+g_mime_stream_chunked_init (GMimeStreamChunked *stream, GMimeStreamChunkedClass *klass)
+{
+	stream->chunks = NULL;
+}
+
+static void
+g_mime_stream_chunked_finalize (GObject *object)
+{
+	GMimeStream *stream = (GMimeStream *) object;
+	
+	stream_close (stream);
+	
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+
+static ChunkList *
+chunk_list_new (void)
+{
+	ChunkList *list;
+	
+	list = g_slice_new (ChunkList);
+	list->chunks = g_ptr_array_new_with_free_func (g_free);
+	list->ref_count = 1;
+	list->last_size = 0;
+	list->length = 0;
+	
+	return list;
+}
+
+static ChunkList *
+chunk_list_ref (ChunkList *list)
+{
+	g_atomic_int_inc (&list->ref_count);
+	
+	return list;
+}
+
+static void
+chunk_list_unref (ChunkList *list)
+{
+	if (!g_atomic_int_dec_and_test (&list->ref_count))
+		return;
+	
+	g_ptr_array_free (list->chunks, TRUE);
+	g_slice_free (ChunkList, list);
+}
+
+static size_t
+chunk_alloc_size (size_t needed)
+{
+	size_t size = CHUNK_MIN_SIZE;
+	
+	while (size < needed)
+		size <<= 1;
+	
+	return MIN (size, CHUNK_SIZE);
+}
+
+static void
+chunk_list_resize_last (ChunkList *list, size_t size)
+{
+	gpointer *last = &list->chunks->pdata[list->chunks->len - 1];
+	
+	*last = g_realloc (*last, size);
+	list->last_size = size;
+}
+
+/* makes room for @size bytes without touching the data already in
+ * the list; only the last chunk is ever reallocated, and at most until
+ * it reaches CHUNK_SIZE */
+static void
+chunk_list_reserve (ChunkList *list, gint64 size)
+{
+	guint n = list->chunks->len;
+	gint64 capacity, remaining;
+	size_t alloc;
+	
+	capacity = n > 0 ? (gint64) (n - 1) * CHUNK_SIZE + list->last_size : 0;
+	if (size <= capacity)
+		return;
+	
+	if (n > 0 && list->last_size < CHUNK_SIZE) {
+		if (size > (gint64) n * CHUNK_SIZE) {
+			chunk_list_resize_last (list, CHUNK_SIZE);
+		} else {
+			chunk_list_resize_last (list, chunk_alloc_size ((size_t) (size - (gint64) (n - 1) * CHUNK_SIZE)));
+			return;
+		}
+	}
+	
+	while ((gint64) list->chunks->len * CHUNK_SIZE < size) {
+		remaining = size - (gint64) list->chunks->len * CHUNK_SIZE;
+		alloc = remaining >= CHUNK_SIZE ? CHUNK_SIZE : chunk_alloc_size ((size_t) remaining);
+		g_ptr_array_add (list->chunks, g_malloc (alloc));
+		list->last_size = alloc;
+	}
+}
+
+static void
+chunk_list_read (ChunkList *list, gint64 offset, char *buf, size_t len)
+{
+	size_t index, n;
+	char *chunk;
+	
+	while (len > 0) {
+		index = (size_t) (offset % CHUNK_SIZE);
+		chunk = list->chunks->pdata[offset / CHUNK_SIZE];
+		n = MIN (len, CHUNK_SIZE - index);
+		
+		memcpy (buf, chunk + index, n);
+		offset += n;
+		buf += n;
+		len -= n;
+	}
+}
+
+/* writes @len bytes of @buf at @offset, or zeros if @buf is %NULL */
+static void
+chunk_list_write (ChunkList *list, gint64 offset, const char *buf, size_t len)
+{
+	size_t index, n;
+	char *chunk;
+	
+	while (len > 0) {
+		index = (size_t) (offset % CHUNK_SIZE);
+		chunk = list->chunks->pdata[offset / CHUNK_SIZE];
+		n = MIN (len, CHUNK_SIZE - index);
+		
+		if (buf != NULL) {
+			memcpy (chunk + index, buf, n);
+			buf += n;
+		} else {
+			memset (chunk + index, 0, n);
+		}
+		
+		offset += n;
+		len -= n;
+	}
+}
+
+
+static ssize_t
+stream_read (GMimeStream *stream, char *buf, size_t len)
+{
+	GMimeStreamChunked *chunked = (GMimeStreamChunked *) stream;
+	gint64 bound_end;
+	ssize_t n;
+	
+	if (chunked->chunks == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	
+	bound_end = stream->bound_end != -1 ? stream->bound_end : chunked->chunks->length;
+	bound_end = MIN (bound_end, chunked->chunks->length);
+	
+	n = (ssize_t) MIN (bound_end - stream->position, (gint64) len);
+	if (n > 0) {
+		chunk_list_read (chunked->chunks, stream->position, buf, n);
+		stream->position += n;
+	} else if (n < 0) {
+		errno = EINVAL;
+		n = -1;
+	}
+	
+	return n;
+}
+
+static ssize_t
+stream_write (GMimeStream *stream, const char *buf, size_t len)
+{
+	GMimeStreamChunked *chunked = (GMimeStreamChunked *) stream;
+	ChunkList *list = chunked->chunks;
+	gint64 bound_end;
+	ssize_t n;
+	
+	if (list == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	
+	if (stream->bound_end == -1) {
+		if (stream->position + (gint64) len > list->length) {
+			chunk_list_reserve (list, stream->position + len);
+			list->length = stream->position + len;
+		}
+		
+		bound_end = list->length;
+	} else
+		bound_end = MIN (stream->bound_end, list->length);
+	
+	n = (ssize_t) MIN (bound_end - stream->position, (gint64) len);
+	if (n > 0) {
+		chunk_list_write (list, stream->position, buf, n);
+		stream->position += n;
+	} else if (n < 0) {
+		errno = EINVAL;
+		n = -1;
+	}
+	
+	return n;
+}
+
+static int
+stream_flush (GMimeStream *stream)
+{
+	GMimeStreamChunked *chunked = (GMimeStreamChunked *) stream;
+	
+	if (chunked->chunks == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	
+	return 0;
+}
+
+static int
+stream_close (GMimeStream *stream)
+{
+	GMimeStreamChunked *chunked = (GMimeStreamChunked *) stream;
+	
+	if (chunked->chunks)
+		chunk_list_unref (chunked->chunks);
+	
+	chunked->chunks = NULL;
+	
+	return 0;
+}
+
+static gboolean
+stream_eos (GMimeStream *stream)
+{
+	GMimeStreamChunked *chunked = (GMimeStreamChunked *) stream;
+	gint64 bound_end;
+	
+	if (chunked->chunks == NULL)
+		return TRUE;
+	
+	bound_end = stream->bound_end != -1 ? stream->bound_end : chunked->chunks->length;
+	
+	return stream->position >= bound_end;
+}
+
+static int
+stream_reset (GMimeStream *stream)
+{
+	GMimeStreamChunked *chunked = (GMimeStreamChunked *) stream;
+	
+	if (chunked->chunks == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	
+	return 0;
+}
+
+static gint64
+stream_seek (GMimeStream *stream, gint64 offset, GMimeSeekWhence whence)
+{
+	GMimeStreamChunked *chunked = (GMimeStreamChunked *) stream;
+	gint64 bound_end, real = stream->position;
+	ChunkList *list = chunked->chunks;
+	
+	if (list == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	
+	bound_end = stream->bound_end != -1 ? stream->bound_end : list->length;
+	
+	switch (whence) {
+	case GMIME_STREAM_SEEK_SET:
+		real = offset;
+		break;
+	case GMIME_STREAM_SEEK_END:
+		real = offset + bound_end;
+		break;
+	case GMIME_STREAM_SEEK_CUR:
+		real = stream->position + offset;
+		break;
+	}
+	
+	if (real < stream->bound_start) {
+		errno = EINVAL;
+		return -1;
+	}
+	
+	if (stream->bound_end != -1 && real > bound_end) {
+		errno = EINVAL;
+		return -1;
+	}
+	
+	if (real > list->length) {
+		/* seeking past the end grows the stream, like GMimeStreamMem */
+		chunk_list_reserve (list, real);
+		chunk_list_write (list, list->length, NULL, (size_t) (real - list->length));
+		list->length = real;
+	}
+	
+	stream->position = real;
+	
+	return stream->position;
+}
+
+static gint64
+stream_tell (GMimeStream *stream)
+{
+	GMimeStreamChunked *chunked = (GMimeStreamChunked *) stream;
+	
+	if (chunked->chunks == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	
+	return stream->position;
+}
+
+static gint64
+stream_length (GMimeStream *stream)
+{
+	GMimeStreamChunked *chunked = (GMimeStreamChunked *) stream;
+	gint64 bound_end;
+	
+	if (chunked->chunks == NULL) {
+		errno = EBADF;
+		return -1;
+	}
+	
+	bound_end = stream->bound_end != -1 ? stream->bound_end : chunked->chunks->length;
+	
+	return bound_end - stream->bound_start;
+}
+
+static GMimeStream *
+stream_substream (GMimeStream *stream, gint64 start, gint64 end)
+{
+	GMimeStreamChunked *chunked;
+	
+	chunked = g_object_new (GMIME_TYPE_STREAM_CHUNKED, NULL);
+	g_mime_stream_construct ((GMimeStream *) chunked, start, end);
+	chunked->chunks = chunk_list_ref (((GMimeStreamChunked *) stream)->chunks);
+	
+	return (GMimeStream *) chunked;
+}
+
+
+/**
+ * g_mime_stream_chunked_new:
+ *
+ * Creates a new, empty #GMimeStreamChunked object.
+ *
+ * Returns: a new chunked memory stream.
+ **/
+GMimeStream *
+g_mime_stream_chunked_new (void)
+{
+	GMimeStreamChunked *chunked;
+	
+	chunked = g_object_new (GMIME_TYPE_STREAM_CHUNKED, NULL);
+	g_mime_stream_construct ((GMimeStream *) chunked, 0, -1);
+	chunked->chunks = chunk_list_new ();
+	
+	return (GMimeStream *) chunked;
+}
+
+
+/**
+ * g_mime_stream_chunked_get_bytes:
+ * @stream: a #GMimeStreamChunked
+ *
+ * Gets the data within the bounds of @stream as a single contiguous
+ * block of memory.
+ *
+ * The data is copied unless it lies within a single full chunk, in
+ * which case the returned #GBytes refers to the chunk directly. That
+ * range of @stream should therefore not be overwritten while the
+ * #GBytes is in use.
+ *
+ * Returns: (transfer full): the contents of @stream.
+ **/
+GBytes *
+g_mime_stream_chunked_get_bytes (GMimeStreamChunked *stream)
+{
+	GMimeStream *base = (GMimeStream *) stream;
+	gint64 start, end;
+	ChunkList *list;
+	size_t len;
+	char *buf;
+	
+	g_return_val_if_fail (GMIME_IS_STREAM_CHUNKED (stream), NULL);
+	
+	if ((list = stream->chunks) == NULL)
+		return g_bytes_new (NULL, 0);
+	
+	start = MIN (base->bound_start, list->length);
+	end = base->bound_end != -1 ? MIN (base->bound_end, list->length) : list->length;
+	len = (size_t) (end - start);
+	
+	if (len > 0 && start / CHUNK_SIZE == (end - 1) / CHUNK_SIZE &&
+	    ((guint) (start / CHUNK_SIZE) + 1 < list->chunks->len || list->last_size == CHUNK_SIZE)) {
+		/* full chunks are never reallocated, so it is safe to hand out a pointer into one */
+		buf = (char *) list->chunks->pdata[start / CHUNK_SIZE] + (start % CHUNK_SIZE);
+		
+		return g_bytes_new_with_free_func (buf, len, (GDestroyNotify) chunk_list_unref, chunk_list_ref (list));
+	}
+	
+	buf = g_malloc (len);
+	chunk_list_read (list, start, buf, len);
+	
+	return g_bytes_new_take (buf, len);
+}
@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "gmime-stream-filter.h"
+#include "gmime-internal.h"
 
 
 /**
@@ -41,11 +42,16 @@
  *
  * When data passes through a #GMimeStreamFilter, it will pass through
  * #GMimeFilter filters in the order they were added.
+ *
+ * Data is read from the source stream in blocks of
+ * g_mime_stream_filter_get_block_size() bytes. Filters that support it
+ * (such as base64 decoding and #GMimeFilterDos2Unix) transform the data
+ * in place rather than copying it into a buffer of their own.
  **/
 
 
 #define READ_PAD (64)		/* bytes padded before buffer */
-#define READ_SIZE (4096)
+#define DEFAULT_BLOCK_SIZE (64 * 1024)
 
 #define _PRIVATE(o) (((GMimeStreamFilter *)(o))->priv)
 
@@ -60,7 +66,9 @@ struct _GMimeStreamFilterPrivate {
 	int filterid;		/* next filter id */
 	
 	char *realbuffer;	/* buffer - READ_PAD */
-	char *buffer;		/* READ_SIZE bytes */
+	char *buffer;		/* buflen bytes */
+	size_t buflen;
+	size_t block_size;	/* size of the next buffer */
 	
 	char *filtered;		/* the filtered data */
 	size_t filteredlen;
@@ -143,8 +151,10 @@ g_mime_stream_filter_init (GMimeStreamFilter *stream, GMimeStreamFilterClass *kl
 	stream->priv = g_new (struct _GMimeStreamFilterPrivate, 1);
 	stream->priv->filters = NULL;
 	stream->priv->filterid = 0;
-	stream->priv->realbuffer = g_malloc (READ_SIZE + READ_PAD);
-	stream->priv->buffer = stream->priv->realbuffer + READ_PAD;
+	stream->priv->block_size = DEFAULT_BLOCK_SIZE;
+	stream->priv->realbuffer = NULL;
+	stream->priv->buffer = NULL;
+	stream->priv->buflen = 0;
 	stream->priv->last_was_read = TRUE;
 	stream->priv->filteredlen = 0;
 	stream->priv->flushed = FALSE;
@@ -175,33 +185,64 @@ g_mime_stream_filter_finalize (GObject *object)
 }
 
 
+/* Runs @inbuf through the filter chain. @writable says whether the
+ * filters may overwrite @inbuf, which is only the case when it is one
+ * of our own buffers. */
+static void
+filter_chain_run (struct _GMimeStreamFilterPrivate *priv, char *inbuf, size_t inlen, size_t presize,
+		  gboolean writable, gboolean flush, char **outbuf, size_t *outlen)
+{
+	char *start = inbuf, *end = inbuf + inlen;
+	struct _filter *f = priv->filters;
+	
+	*outbuf = inbuf;
+	*outlen = inlen;
+	
+	while (f != NULL) {
+		if (f->next && _g_mime_filter_basic_can_fuse (f->filter, f->next->filter)) {
+			_g_mime_filter_basic_fused (f->filter, f->next->filter, *outbuf, *outlen, presize,
+						    outbuf, outlen, &presize, writable, flush);
+			f = f->next;
+		} else if (flush) {
+			_g_mime_filter_complete (f->filter, *outbuf, *outlen, presize,
+						 outbuf, outlen, &presize, writable);
+		} else {
+			_g_mime_filter_filter (f->filter, *outbuf, *outlen, presize,
+					       outbuf, outlen, &presize, writable);
+		}
+		
+		/* once the data has been copied out of the caller's buffer, it's ours */
+		if (!writable)
+			writable = *outbuf < start || *outbuf > end;
+		
+		f = f->next;
+	}
+}
+
 static ssize_t
 stream_read (GMimeStream *stream, char *buf, size_t n)
 {
 	GMimeStreamFilter *filter = (GMimeStreamFilter *) stream;
 	struct _GMimeStreamFilterPrivate *priv = filter->priv;
-	struct _filter *f;
 	ssize_t nread;
 	
 	priv->last_was_read = TRUE;
 	
 	if (priv->filteredlen <= 0) {
-		size_t presize = READ_PAD;
+		if (priv->buflen != priv->block_size) {
+			/* nothing is pending, so it's safe to (re)allocate the buffer */
+			g_free (priv->realbuffer);
+			priv->realbuffer = g_malloc (priv->block_size + READ_PAD);
+			priv->buffer = priv->realbuffer + READ_PAD;
+			priv->buflen = priv->block_size;
+		}
 		
-		nread = g_mime_stream_read (filter->source, priv->buffer, READ_SIZE);
+		nread = g_mime_stream_read (filter->source, priv->buffer, priv->buflen);
 		if (nread <= 0) {
 			/* this is somewhat untested */
 			if (g_mime_stream_eos (filter->source) && !priv->flushed) {
-				priv->filtered = priv->buffer;
-				priv->filteredlen = 0;
-				f = priv->filters;
-				
-				while (f != NULL) {
-					g_mime_filter_complete (f->filter, priv->filtered, priv->filteredlen,
-								presize, &priv->filtered, &priv->filteredlen,
-								&presize);
-					f = f->next;
-				}
+				filter_chain_run (priv, priv->buffer, 0, READ_PAD, TRUE, TRUE,
+						  &priv->filtered, &priv->filteredlen);
 				
 				nread = priv->filteredlen;
 				priv->flushed = TRUE;
@@ -210,17 +251,10 @@ stream_read (GMimeStream *stream, char *buf, size_t n)
 			if (nread <= 0)
 				return nread;
 		} else {
-			priv->filtered = priv->buffer;
-			priv->filteredlen = nread;
 			priv->flushed = FALSE;
-			f = priv->filters;
 			
-			while (f != NULL) {
-				g_mime_filter_filter (f->filter, priv->filtered, priv->filteredlen, presize,
-						      &priv->filtered, &priv->filteredlen, &presize);
-				
-				f = f->next;
-			}
+			filter_chain_run (priv, priv->buffer, nread, READ_PAD, TRUE, FALSE,
+					  &priv->filtered, &priv->filteredlen);
 		}
 	}
 	
@@ -237,21 +271,14 @@ stream_write (GMimeStream *stream, const char *buf, size_t n)
 {
 	GMimeStreamFilter *filter = (GMimeStreamFilter *) stream;
 	struct _GMimeStreamFilterPrivate *priv = filter->priv;
-	char *buffer = (char *) buf;
 	ssize_t nwritten = n;
-	struct _filter *f;
-	size_t presize;
+	char *buffer;
 	
 	priv->last_was_read = FALSE;
 	priv->flushed = FALSE;
 	
-	f = priv->filters;
-	presize = 0;
-	while (f != NULL) {
-		g_mime_filter_filter (f->filter, buffer, n, presize, &buffer, &n, &presize);
-		
-		f = f->next;
-	}
+	/* the caller's buffer is const, so it must not be filtered in place */
+	filter_chain_run (priv, (char *) buf, n, 0, FALSE, FALSE, &buffer, &n);
 	
 	if (g_mime_stream_write (filter->source, buffer, n) == -1)
 		return -1;
@@ -265,25 +292,15 @@ stream_flush (GMimeStream *stream)
 {
 	GMimeStreamFilter *filter = (GMimeStreamFilter *) stream;
 	struct _GMimeStreamFilterPrivate *priv = filter->priv;
-	size_t presize, len;
-	struct _filter *f;
 	char *buffer;
+	size_t len;
 	
 	if (priv->last_was_read) {
 		/* no-op */
 		return 0;
 	}
 	
-	buffer = "";
-	len = 0;
-	presize = 0;
-	f = priv->filters;
-	
-	while (f != NULL) {
-		g_mime_filter_complete (f->filter, buffer, len, presize, &buffer, &len, &presize);
-		
-		f = f->next;
-	}
+	filter_chain_run (priv, "", 0, 0, FALSE, TRUE, &buffer, &len);
 	
 	if (len > 0 && g_mime_stream_write (filter->source, buffer, len) == -1)
 		return -1;
@@ -369,6 +386,7 @@ stream_substream (GMimeStream *stream, gint64 start, gint64 end)
 	GMimeStreamFilter *sub;
 	
 	sub = g_object_new (GMIME_TYPE_STREAM_FILTER, NULL);
+	sub->priv->block_size = filter->priv->block_size;
 	sub->source = filter->source;
 	g_object_ref (sub->source);
 	
@@ -538,3 +556,44 @@ g_mime_stream_filter_get_owner (GMimeStreamFilter *stream)
 	
 	return stream->owner;
 }
+
+
+/**
+ * g_mime_stream_filter_set_block_size:
+ * @stream: a #GMimeStreamFilter
+ * @block_size: the number of bytes to read from the source stream at a time
+ *
+ * Sets the number of bytes that @stream reads from its source stream
+ * and passes through its filters at a time. Larger blocks mean fewer
+ * calls into each filter at the cost of more memory per stream.
+ *
+ * The default block size is 64 KiB. If @stream still holds filtered
+ * data from a previous read, the new size takes effect once that data
+ * has been consumed.
+ **/
+void
+g_mime_stream_filter_set_block_size (GMimeStreamFilter *stream, size_t block_size)
+{
+	g_return_if_fail (GMIME_IS_STREAM_FILTER (stream));
+	g_return_if_fail (block_size > 0);
+	
+	stream->priv->block_size = block_size;
+}
+
+
+/**
+ * g_mime_stream_filter_get_block_size:
+ * @stream: a #GMimeStreamFilter
+ *
+ * Gets the number of bytes that @stream reads from its source stream
+ * at a time.
+ *
+ * Returns: the block size of @stream.
+ **/
+size_t
+g_mime_stream_filter_get_block_size (GMimeStreamFilter *stream)
+{
+	g_return_val_if_fail (GMIME_IS_STREAM_FILTER (stream), 0);
+	
+	return stream->priv->block_size;
+}
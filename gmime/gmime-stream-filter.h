@@ -70,6 +70,9 @@ void g_mime_stream_filter_remove (GMimeStreamFilter *stream, int id);
 void g_mime_stream_filter_set_owner (GMimeStreamFilter *stream, gboolean owner);
 gboolean g_mime_stream_filter_get_owner (GMimeStreamFilter *stream);
 
+void g_mime_stream_filter_set_block_size (GMimeStreamFilter *stream, size_t block_size);
+size_t g_mime_stream_filter_get_block_size (GMimeStreamFilter *stream);
+
 G_END_DECLS
 
 #endif /* __GMIME_STREAM_FILTER_H__ */
@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "gmime-stream.h"
+#include "gmime-internal.h"
 
 #define d(x)
 
@@ -61,6 +62,23 @@ static GMimeStream *stream_substream (GMimeStream *stream, gint64 start, gint64
 
 static GObjectClass *parent_class = NULL;
 
+#ifdef ENABLE_STATS
+static GQuark stats_quark = 0;
+
+static GMimeStreamStats *
+stream_get_stats (GMimeStream *stream)
+{
+	GMimeStreamStats *stats;
+	
+	if (!(stats = g_object_get_qdata ((GObject *) stream, stats_quark))) {
+		stats = g_new0 (GMimeStreamStats, 1);
+		g_object_set_qdata_full ((GObject *) stream, stats_quark, stats, g_free);
+	}
+	
+	return stats;
+}
+#endif /* ENABLE_STATS */
+
 
 GType
 g_mime_stream_get_type (void)
@@ -107,6 +125,8 @@ g_mime_stream_class_init (GMimeStreamClass *klass)
 	klass->tell = stream_tell;
 	klass->length = stream_length;
 	klass->substream = stream_substream;
+	
+	GMIME_STATS (stats_quark = g_quark_from_static_string ("gmime-stream-stats"));
 }
 
 static void
@@ -175,7 +195,22 @@ g_mime_stream_read (GMimeStream *stream, char *buf, size_t len)
 	if (len == 0)
 		return 0;
 	
+#ifdef ENABLE_STATS
+	{
+		GMimeStreamStats *stats = stream_get_stats (stream);
+		ssize_t nread;
+		
+		nread = GMIME_STREAM_GET_CLASS (stream)->read (stream, buf, len);
+		
+		stats->reads++;
+		if (nread > 0)
+			stats->bytes_read += nread;
+		
+		return nread;
+	}
+#else
 	return GMIME_STREAM_GET_CLASS (stream)->read (stream, buf, len);
+#endif
 }
 
 
@@ -206,7 +241,22 @@ g_mime_stream_write (GMimeStream *stream, const char *buf, size_t len)
 	if (len == 0)
 		return 0;
 	
+#ifdef ENABLE_STATS
+	{
+		GMimeStreamStats *stats = stream_get_stats (stream);
+		ssize_t nwritten;
+		
+		nwritten = GMIME_STREAM_GET_CLASS (stream)->write (stream, buf, len);
+		
+		stats->writes++;
+		if (nwritten > 0)
+			stats->bytes_written += nwritten;
+		
+		return nwritten;
+	}
+#else
 	return GMIME_STREAM_GET_CLASS (stream)->write (stream, buf, len);
+#endif
 }
 
 
@@ -352,6 +402,8 @@ g_mime_stream_seek (GMimeStream *stream, gint64 offset, GMimeSeekWhence whence)
 {
 	g_return_val_if_fail (GMIME_IS_STREAM (stream), -1);
 	
+	GMIME_STATS (stream_get_stats (stream)->seeks++);
+	
 	return GMIME_STREAM_GET_CLASS (stream)->seek (stream, offset, whence);
 }
 
@@ -606,3 +658,34 @@ g_mime_stream_writev (GMimeStream *stream, GMimeStreamIOVector *vector, size_t c
 	
 	return total;
 }
+
+
+/**
+ * g_mime_stream_get_stats:
+ * @stream: a #GMimeStream
+ * @stats: (out): a #GMimeStreamStats to fill in
+ *
+ * Gets the number of read, write and seek requests made on @stream
+ * through g_mime_stream_read(), g_mime_stream_write() and
+ * g_mime_stream_seek() along with the number of bytes transferred.
+ *
+ * Returns: %TRUE if @stats was filled in or %FALSE if statistics are
+ * not enabled (see g_mime_stats_enabled()), in which case @stats is
+ * zeroed.
+ **/
+gboolean
+g_mime_stream_get_stats (GMimeStream *stream, GMimeStreamStats *stats)
+{
+	g_return_val_if_fail (GMIME_IS_STREAM (stream), FALSE);
+	g_return_val_if_fail (stats != NULL, FALSE);
+	
+#ifdef ENABLE_STATS
+	memcpy (stats, stream_get_stats (stream), sizeof (GMimeStreamStats));
+	
+	return TRUE;
+#else
+	memset (stats, 0, sizeof (GMimeStreamStats));
+	
+	return FALSE;
+#endif
+}
@@ -70,6 +70,25 @@ typedef struct {
 } GMimeStreamIOVector;
 
 
+/**
+ * GMimeStreamStats:
+ * @reads: the number of read requests
+ * @writes: the number of write requests
+ * @seeks: the number of seek requests
+ * @bytes_read: the number of bytes read
+ * @bytes_written: the number of bytes written
+ *
+ * Counters collected by a #GMimeStream. See g_mime_stream_get_stats().
+ **/
+typedef struct {
+	guint64 reads;
+	guint64 writes;
+	guint64 seeks;
+	guint64 bytes_read;
+	guint64 bytes_written;
+} GMimeStreamStats;
+
+
 /**
  * GMimeStream:
  * @parent_object: parent #GObject
@@ -130,6 +149,8 @@ gint64    g_mime_stream_write_to_stream (GMimeStream *src, GMimeStream *dest);
 
 gint64    g_mime_stream_writev (GMimeStream *stream, GMimeStreamIOVector *vector, size_t count);
 
+gboolean  g_mime_stream_get_stats (GMimeStream *stream, GMimeStreamStats *stats);
+
 G_END_DECLS
 
 #endif /* __GMIME_STREAM_H__ */
@@ -112,6 +112,17 @@ static char base36[36] = {
 	'W', 'X', 'Y', 'Z'
 };
 
+struct _GMimeIdGenerator {
+	volatile int refcount;
+	size_t fqdn_len;
+	char *fqdn;
+};
+
+G_DEFINE_BOXED_TYPE (GMimeIdGenerator, g_mime_id_generator, g_mime_id_generator_ref, g_mime_id_generator_unref);
+
+G_LOCK_DEFINE_STATIC (default_generator);
+static GMimeIdGenerator *default_generator = NULL;
+
 static unsigned char tohex[16] = {
 	'0', '1', '2', '3', '4', '5', '6', '7',
 	'8', '9', 'A', 'B', 'C', 'D', 'E', 'F'
@@ -306,7 +317,6 @@ decode_int (const char *in, size_t inlen)
 	return val;
 }
 
-#if 0
 static int
 get_days_in_month (int month, int year)
 {
@@ -333,7 +343,6 @@ get_days_in_month (int month, int year)
 	        return 0;
 	}
 }
-#endif
 
 static int
 get_wday (const char *in, size_t inlen)
@@ -465,11 +474,73 @@ format_timezone_identifier (char *identifier, int len, int tz_offset)
 	return snprintf (identifier, len, "%c%02d:%02d:00", (sign > 0) ? '+' : '-', hours, minutes);
 }
 
+/* GTimeZone cache for every quarter-hour offset between -23:45 and +23:45 */
+#define TZONE_CACHE_SIZE ((24 * 4 * 2) - 1)
+static GTimeZone *tzone_cache[TZONE_CACHE_SIZE];
+
+static GTimeZone *
+tzone_new_offset (int tz_offset)
+{
+	char identifier[10];
+	GTimeZone *tz;
+	int minutes;
+	guint slot;
+	
+	if (format_timezone_identifier (identifier, sizeof (identifier), tz_offset) < 0)
+		return NULL;
+	
+	minutes = ((tz_offset / 100) * 60) + (tz_offset % 100);
+	
+	if ((minutes % 15) != 0 || (tz_offset % 100) >= 60 || (tz_offset % 100) <= -60)
+		return g_time_zone_new_identifier (identifier);
+	
+	slot = (guint) ((minutes / 15) + (TZONE_CACHE_SIZE / 2));
+	
+	if ((tz = g_atomic_pointer_get (&tzone_cache[slot])))
+		return g_time_zone_ref (tz);
+	
+	if (!(tz = g_time_zone_new_identifier (identifier)))
+		return NULL;
+	
+	if (!g_atomic_pointer_compare_and_exchange (&tzone_cache[slot], NULL, tz)) {
+		/* another thread beat us to it */
+		g_time_zone_unref (tz);
+		tz = g_atomic_pointer_get (&tzone_cache[slot]);
+	}
+	
+	return g_time_zone_ref (tz);
+}
+
+/**
+ * g_mime_utils_shutdown:
+ *
+ * Frees the cached timezones created by the date parser and the
+ * default #GMimeIdGenerator.
+ **/
+void
+g_mime_utils_shutdown (void)
+{
+	guint i;
+	
+	for (i = 0; i < TZONE_CACHE_SIZE; i++) {
+		if (tzone_cache[i] != NULL) {
+			g_time_zone_unref (tzone_cache[i]);
+			tzone_cache[i] = NULL;
+		}
+	}
+	
+	G_LOCK (default_generator);
+	if (default_generator != NULL) {
+		g_mime_id_generator_unref (default_generator);
+		default_generator = NULL;
+	}
+	G_UNLOCK (default_generator);
+}
+
 static GTimeZone *
 get_tzone (date_token **token)
 {
 	const char *inptr, *inend;
-	char identifier[10];
 	int tz_offset, i;
 	size_t len, n;
 	guint t;
@@ -488,11 +559,8 @@ get_tzone (date_token **token)
 
 			if (*inptr == '-')
 				tz_offset *= -1;
-
-			if (format_timezone_identifier (identifier, sizeof (identifier), tz_offset) < 0)
-				return NULL;
 			
-			return g_time_zone_new_identifier (identifier);
+			return tzone_new_offset (tz_offset);
 		}
 		
 		if (*inptr == '(') {
@@ -509,17 +577,212 @@ get_tzone (date_token **token)
 			if (n != len || strncmp (inptr, tz_offsets[t].name, n) != 0)
 				continue;
 			
-			// TODO: modify the struct to have an `identifier` field instead of `offset` that is a pre-formatted string?
-			if (format_timezone_identifier (identifier, sizeof (identifier), tz_offsets[t].offset) < 0)
-				return NULL;
-			
-			return g_time_zone_new_identifier (identifier);
+			return tzone_new_offset (tz_offsets[t].offset);
 		}
 	}
 	
 	return NULL;
 }
 
+/* The result of the strict rfc5322 date parser. The tz_offset is in
+ * the same +/-HHMM form used in the header. */
+typedef struct {
+	int year, month, day;
+	int hour, min, sec;
+	int tz_offset;
+} rfc5322_date;
+
+static gboolean
+decode_fixed_int (const char **in, size_t n, int *val)
+{
+	register const char *inptr = *in;
+	const char *inend = inptr + n;
+	
+	*val = 0;
+	
+	while (inptr < inend) {
+		if (!(*inptr >= '0' && *inptr <= '9'))
+			return FALSE;
+		
+		*val = (*val * 10) + (*inptr - '0');
+		inptr++;
+	}
+	
+	*in = inptr;
+	
+	return TRUE;
+}
+
+static gboolean
+skip_date_lwsp (const char **in)
+{
+	register const char *inptr = *in;
+	
+	while (*inptr == ' ' || *inptr == '\t')
+		inptr++;
+	
+	if (inptr == *in)
+		return FALSE;
+	
+	*in = inptr;
+	
+	return TRUE;
+}
+
+/* Parses dates in the strict rfc5322 form,
+ * `[ day-of-week "," ] day month year hh:mm[:ss] zone`, without
+ * allocating anything. Anything that deviates from the spec makes
+ * this return %FALSE so that the caller can fall back to the
+ * tokenizing parsers. */
+static gboolean
+parse_rfc5322_date (const char *str, rfc5322_date *date)
+{
+	register const char *inptr = str;
+	const char *start;
+	size_t n;
+	int sign;
+	guint t;
+	
+	while (*inptr == ' ' || *inptr == '\t')
+		inptr++;
+	
+	if (g_ascii_isalpha (*inptr)) {
+		/* day-of-week */
+		if (get_wday (inptr, 3) == -1 || inptr[3] != ',')
+			return FALSE;
+		
+		inptr += 4;
+		
+		while (*inptr == ' ' || *inptr == '\t')
+			inptr++;
+	}
+	
+	/* day */
+	n = (*inptr >= '0' && *inptr <= '9' && inptr[1] >= '0' && inptr[1] <= '9') ? 2 : 1;
+	if (!decode_fixed_int (&inptr, n, &date->day) || !skip_date_lwsp (&inptr))
+		return FALSE;
+	
+	/* month */
+	if ((date->month = get_month (inptr, 3)) == -1)
+		return FALSE;
+	
+	inptr += 3;
+	
+	if (!skip_date_lwsp (&inptr))
+		return FALSE;
+	
+	/* year */
+	start = inptr;
+	while (*inptr >= '0' && *inptr <= '9')
+		inptr++;
+	
+	n = (size_t) (inptr - start);
+	inptr = start;
+	
+	if (n != 2 && n != 4)
+		return FALSE;
+	
+	if (!decode_fixed_int (&inptr, n, &date->year) || !skip_date_lwsp (&inptr))
+		return FALSE;
+	
+	if (date->year < 100)
+		date->year += (date->year < 70) ? 2000 : 1900;
+	
+	if (date->year < 1969)
+		return FALSE;
+	
+	if (date->day < 1 || date->day > get_days_in_month (date->month, date->year))
+		return FALSE;
+	
+	/* time-of-day */
+	if (!decode_fixed_int (&inptr, 2, &date->hour) || *inptr++ != ':')
+		return FALSE;
+	
+	if (!decode_fixed_int (&inptr, 2, &date->min))
+		return FALSE;
+	
+	if (*inptr == ':') {
+		inptr++;
+		
+		if (!decode_fixed_int (&inptr, 2, &date->sec))
+			return FALSE;
+	} else {
+		date->sec = 0;
+	}
+	
+	if (date->hour > 23 || date->min > 59 || date->sec > 59)
+		return FALSE;
+	
+	if (!skip_date_lwsp (&inptr))
+		return FALSE;
+	
+	/* zone */
+	if (*inptr == '+' || *inptr == '-') {
+		sign = *inptr++ == '-' ? -1 : 1;
+		
+		if (!decode_fixed_int (&inptr, 4, &date->tz_offset))
+			return FALSE;
+		
+		if ((date->tz_offset / 100) >= 24 || (date->tz_offset % 100) >= 60)
+			return FALSE;
+		
+		date->tz_offset *= sign;
+	} else {
+		start = inptr;
+		while (g_ascii_isalpha (*inptr))
+			inptr++;
+		
+		n = (size_t) (inptr - start);
+		
+		for (t = 0; t < G_N_ELEMENTS (tz_offsets); t++) {
+			if (strlen (tz_offsets[t].name) == n && !strncmp (start, tz_offsets[t].name, n))
+				break;
+		}
+		
+		if (t == G_N_ELEMENTS (tz_offsets))
+			return FALSE;
+		
+		date->tz_offset = tz_offsets[t].offset;
+	}
+	
+	/* allow trailing comments such as "(PST)" */
+	return *inptr == '\0' || *inptr == ' ' || *inptr == '\t' || *inptr == '\r' || *inptr == '\n';
+}
+
+static GDateTime *
+rfc5322_date_to_date_time (rfc5322_date *date)
+{
+	GDateTime *dt;
+	GTimeZone *tz;
+	
+	if (!(tz = tzone_new_offset (date->tz_offset)))
+		return NULL;
+	
+	dt = g_date_time_new (tz, date->year, date->month, date->day, date->hour, date->min, (gdouble) date->sec);
+	g_time_zone_unref (tz);
+	
+	return dt;
+}
+
+static gint64
+rfc5322_date_to_unix (rfc5322_date *date)
+{
+	int year = date->year, month = date->month;
+	gint64 days, offset;
+	int era, yoe, doy;
+	
+	/* days since the epoch, see http://howardhinnant.github.io/date_algorithms.html#days_from_civil */
+	year -= month <= 2;
+	era = (year >= 0 ? year : year - 399) / 400;
+	yoe = year - era * 400;
+	doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + date->day - 1;
+	days = (gint64) era * 146097 + (yoe * 365 + yoe / 4 - yoe / 100 + doy) - 719468;
+	
+	offset = ((date->tz_offset / 100) * 3600) + ((date->tz_offset % 100) * 60);
+	
+	return (days * 86400) + (date->hour * 3600) + (date->min * 60) + date->sec - offset;
+}
+
 static GDateTime *
 parse_rfc822_date (date_token *tokens)
 {
@@ -761,8 +1024,12 @@ GDateTime *
 g_mime_utils_header_decode_date (const char *str)
 {
 	date_token *token, *tokens;
+	rfc5322_date parsed;
 	GDateTime *date;
 	
+	if (parse_rfc5322_date (str, &parsed) && (date = rfc5322_date_to_date_time (&parsed)))
+		return date;
+	
 	if (!(tokens = datetok (str)))
 		return NULL;
 	
@@ -781,123 +1048,392 @@ g_mime_utils_header_decode_date (const char *str)
 
 
 /**
- * g_mime_utils_generate_message_id:
- * @fqdn: Fully qualified domain name
+ * g_mime_utils_header_decode_date_unix:
+ * @str: input date string
+ * @date: (out): the number of seconds since the Unix epoch
+ * @tz_offset: (out) (optional): the timezone offset in the form +/-HHMM
  *
- * Generates a unique Message-Id.
+ * Parses the rfc822 date string like g_mime_utils_header_decode_date(),
+ * but without constructing a #GDateTime for well-formed dates.
  *
- * Returns: a unique string in an addr-spec format suitable for use as
- * a Message-Id.
+ * Returns: %TRUE if the date was successfully parsed or %FALSE otherwise.
  **/
-char *
-g_mime_utils_generate_message_id (const char *fqdn)
+gboolean
+g_mime_utils_header_decode_date_unix (const char *str, gint64 *date, int *tz_offset)
 {
-	const char *hostname = NULL;
-	unsigned char block[8];
-	unsigned long value;
-	char *name = NULL;
-	GString *msgid;
-	char *ascii;
-	int i;
+	rfc5322_date parsed;
+	GDateTime *dt;
+	GTimeSpan tz;
+	int sign;
 	
-	if (!fqdn) {
-#ifdef HAVE_UTSNAME_DOMAINNAME
-		struct utsname unam;
+	g_return_val_if_fail (str != NULL, FALSE);
+	g_return_val_if_fail (date != NULL, FALSE);
+	
+	if (parse_rfc5322_date (str, &parsed)) {
+		*date = rfc5322_date_to_unix (&parsed);
 		
-		uname (&unam);
+		if (tz_offset)
+			*tz_offset = parsed.tz_offset;
 		
-		hostname = unam.nodename;
+		return TRUE;
+	}
+	
+	if (!(dt = g_mime_utils_header_decode_date (str)))
+		return FALSE;
+	
+	*date = g_date_time_to_unix (dt);
+	
+	if (tz_offset) {
+		tz = g_date_time_get_utc_offset (dt);
+		sign = tz < 0 ? -1 : 1;
+		tz *= sign;
 		
-		if (unam.domainname[0])
-			name = g_strdup_printf ("%s.%s", hostname, unam.domainname);
+		*tz_offset = 100 * (tz / G_TIME_SPAN_HOUR);
+		*tz_offset += (tz % G_TIME_SPAN_HOUR) / G_TIME_SPAN_MINUTE;
+		*tz_offset *= sign;
+	}
+	
+	g_date_time_unref (dt);
+	
+	return TRUE;
+}
+
+
+static char *
+get_local_fqdn (void)
+{
+	const char *hostname = NULL;
+	char *name = NULL;
+	
+#ifdef HAVE_UTSNAME_DOMAINNAME
+	struct utsname unam;
+	
+	uname (&unam);
+	
+	hostname = unam.nodename;
+	
+	if (unam.domainname[0])
+		name = g_strdup_printf ("%s.%s", hostname, unam.domainname);
 #else /* ! HAVE_UTSNAME_DOMAINNAME */
-		char host[MAXHOSTNAMELEN + 1];
-		
+	char host[MAXHOSTNAMELEN + 1];
+	
 #ifdef HAVE_GETHOSTNAME
-		host[MAXHOSTNAMELEN] = '\0';
-		if (gethostname (host, MAXHOSTNAMELEN) == 0) {
+	host[MAXHOSTNAMELEN] = '\0';
+	if (gethostname (host, MAXHOSTNAMELEN) == 0) {
 #ifdef HAVE_GETDOMAINNAME
-			size_t domainlen = MAXHOSTNAMELEN;
-			char *domain;
-			int rv;
-			
-			domain = g_malloc (domainlen);
-			
-			while ((rv = getdomainname (domain, domainlen)) == -1 && errno == EINVAL) {
-				domainlen += MAXHOSTNAMELEN;
-				domain = g_realloc (domain, domainlen);
-			}
-			
-			if (rv == 0 && domain[0]) {
-				if (host[0]) {
-					name = g_strdup_printf ("%s.%s", host, domain);
-					g_free (domain);
-				} else {
-					name = domain;
-				}
+		size_t domainlen = MAXHOSTNAMELEN;
+		char *domain;
+		int rv;
+		
+		domain = g_malloc (domainlen);
+		
+		while ((rv = getdomainname (domain, domainlen)) == -1 && errno == EINVAL) {
+			domainlen += MAXHOSTNAMELEN;
+			domain = g_realloc (domain, domainlen);
+		}
+		
+		if (rv == 0 && domain[0]) {
+			if (host[0]) {
+				name = g_strdup_printf ("%s.%s", host, domain);
+				g_free (domain);
+			} else {
+				name = domain;
 			}
-#endif /* HAVE_GETDOMAINNAME */
-		} else {
-			host[0] = '\0';
 		}
+#endif /* HAVE_GETDOMAINNAME */
+	} else {
+		host[0] = '\0';
+	}
 #endif /* HAVE_GETHOSTNAME */
-		hostname = host;
+	hostname = host;
 #endif /* HAVE_UTSNAME_DOMAINNAME */
-		
+	
 #ifdef HAVE_GETADDRINFO
-		if (!name && hostname[0]) {
-			/* we weren't able to get a domain name */
-			struct addrinfo hints, *res;
-			
-			memset (&hints, 0, sizeof (hints));
-			hints.ai_flags = AI_CANONNAME;
-			
-			if (getaddrinfo (hostname, NULL, &hints, &res) == 0) {
-				name = g_strdup (res->ai_canonname);
-				freeaddrinfo (res);
-			}
+	if (!name && hostname[0]) {
+		/* we weren't able to get a domain name */
+		struct addrinfo hints, *res;
+		
+		memset (&hints, 0, sizeof (hints));
+		hints.ai_flags = AI_CANONNAME;
+		
+		if (getaddrinfo (hostname, NULL, &hints, &res) == 0) {
+			name = g_strdup (res->ai_canonname);
+			freeaddrinfo (res);
 		}
+	}
 #endif /* HAVE_GETADDRINFO */
-		
-		fqdn = name != NULL ? name : (hostname[0] ? hostname : "localhost.localdomain");
+	
+	if (name != NULL)
+		return name;
+	
+	return g_strdup (hostname[0] ? hostname : "localhost.localdomain");
+}
+
+
+/**
+ * g_mime_id_generator_new:
+ * @fqdn: (nullable): Fully qualified domain name or %NULL
+ *
+ * Creates a new Message-Id and multipart boundary generator. If @fqdn
+ * is %NULL, the fully qualified domain name of the local host is looked
+ * up once and used for all of the Message-Ids that the generator
+ * creates.
+ *
+ * Returns: (transfer full): a new #GMimeIdGenerator.
+ **/
+GMimeIdGenerator *
+g_mime_id_generator_new (const char *fqdn)
+{
+	GMimeIdGenerator *generator;
+	char *name = NULL;
+#ifdef LIBIDN
+	char *ascii;
+#endif
+	
+	if (!fqdn)
+		fqdn = name = get_local_fqdn ();
+	
+	generator = g_slice_new (GMimeIdGenerator);
+	generator->refcount = 1;
+	
+#ifdef LIBIDN
+	if (idn2_to_ascii_8z (fqdn, &ascii, 0) == IDN2_OK) {
+		generator->fqdn = g_strdup (ascii);
+		idn2_free (ascii);
+	} else {
+		generator->fqdn = g_strdup (fqdn);
 	}
+#else
+	generator->fqdn = g_strdup (fqdn);
+#endif
+	generator->fqdn_len = strlen (generator->fqdn);
 	
-	value = (unsigned long) time (NULL);
-	g_mime_read_random_pool (block, 8);
-	msgid = g_string_new ("");
+	g_free (name);
+	
+	return generator;
+}
+
+
+/**
+ * g_mime_id_generator_ref:
+ * @generator: a #GMimeIdGenerator
+ *
+ * Increments the reference count of @generator.
+ *
+ * Returns: (transfer full): @generator.
+ **/
+GMimeIdGenerator *
+g_mime_id_generator_ref (GMimeIdGenerator *generator)
+{
+	g_return_val_if_fail (generator != NULL, NULL);
+	
+	g_atomic_int_inc (&generator->refcount);
+	
+	return generator;
+}
+
+
+/**
+ * g_mime_id_generator_unref:
+ * @generator: a #GMimeIdGenerator
+ *
+ * Decrements the reference count of @generator, freeing it once the
+ * count reaches zero.
+ **/
+void
+g_mime_id_generator_unref (GMimeIdGenerator *generator)
+{
+	g_return_if_fail (generator != NULL);
+	
+	if (!g_atomic_int_dec_and_test (&generator->refcount))
+		return;
+	
+	g_free (generator->fqdn);
+	g_slice_free (GMimeIdGenerator, generator);
+}
+
+
+/**
+ * g_mime_id_generator_get_default:
+ *
+ * Gets the shared generator used by g_mime_utils_generate_message_id()
+ * and for auto-generated multipart boundaries. The local host's fully
+ * qualified domain name is looked up the first time this is called.
+ *
+ * Returns: (transfer none): the default #GMimeIdGenerator.
+ **/
+GMimeIdGenerator *
+g_mime_id_generator_get_default (void)
+{
+	GMimeIdGenerator *generator;
+	
+	if (G_LIKELY ((generator = g_atomic_pointer_get (&default_generator))))
+		return generator;
 	
+	G_LOCK (default_generator);
+	if (!(generator = default_generator)) {
+		generator = g_mime_id_generator_new (NULL);
+		g_atomic_pointer_set (&default_generator, generator);
+	}
+	G_UNLOCK (default_generator);
+	
+	return generator;
+}
+
+
+/**
+ * g_mime_id_generator_get_fqdn:
+ * @generator: a #GMimeIdGenerator
+ *
+ * Gets the (IDN-encoded) domain used for the Message-Ids created by
+ * @generator.
+ *
+ * Returns: the domain name.
+ **/
+const char *
+g_mime_id_generator_get_fqdn (GMimeIdGenerator *generator)
+{
+	g_return_val_if_fail (generator != NULL, NULL);
+	
+	return generator->fqdn;
+}
+
+
+static char *
+append_base36 (char *outptr, guint64 value)
+{
 	do {
-		g_string_append_c (msgid, base36[(int) (value % 36)]);
+		*outptr++ = base36[(int) (value % 36)];
 		value /= 36;
 	} while (value != 0);
 	
-	g_string_append_c (msgid, '.');
+	return outptr;
+}
+
+
+/**
+ * g_mime_id_generator_format_message_id:
+ * @generator: a #GMimeIdGenerator
+ * @buf: (array length=size): the output buffer
+ * @size: the size of @buf
+ *
+ * Writes a unique, nul-terminated Message-Id in addr-spec form into
+ * @buf. A buffer of #GMIME_ID_GENERATOR_LOCAL_PART_MAX_LEN bytes plus
+ * the length of the generator's domain name is always large enough.
+ *
+ * Returns: the length of the Message-Id, not including the nul
+ * terminator. If the return value is greater than or equal to @size,
+ * @buf was too small and has been set to an empty string.
+ **/
+size_t
+g_mime_id_generator_format_message_id (GMimeIdGenerator *generator, char *buf, size_t size)
+{
+	char local[GMIME_ID_GENERATOR_LOCAL_PART_MAX_LEN], *outptr;
+	unsigned char block[8];
+	guint64 value = 0;
+	size_t len;
+	int i;
+	
+	g_return_val_if_fail (generator != NULL, 0);
+	g_return_val_if_fail (buf != NULL || size == 0, 0);
 	
-	value = 0;
+	g_mime_read_random_pool (block, 8);
 	for (i = 0; i < 8; i++)
 		value = (value << 8) | block[i];
 	
-	do {
-		g_string_append_c (msgid, base36[(int) (value % 36)]);
-		value /= 36;
-	} while (value != 0);
+	outptr = append_base36 (local, (guint64) time (NULL));
+	*outptr++ = '.';
+	outptr = append_base36 (outptr, value);
+	*outptr++ = '@';
 	
-	g_string_append_c (msgid, '@');
+	len = outptr - local;
 	
-#ifdef LIBIDN
-	if (idn2_to_ascii_8z (fqdn, &ascii, 0) == IDN2_OK) {
-		g_string_append (msgid, ascii);
-		idn2_free (ascii);
-	} else {
-		g_string_append (msgid, fqdn);
+	if (len + generator->fqdn_len >= size) {
+		if (size > 0)
+			buf[0] = '\0';
+		
+		return len + generator->fqdn_len;
 	}
-#else
-	g_string_append (msgid, fqdn);
-#endif
 	
-	g_free (name);
+	memcpy (buf, local, len);
+	memcpy (buf + len, generator->fqdn, generator->fqdn_len + 1);
+	
+	return len + generator->fqdn_len;
+}
+
+
+/**
+ * g_mime_id_generator_format_boundary:
+ * @generator: a #GMimeIdGenerator
+ * @buf: (array length=size): the output buffer
+ * @size: the size of @buf
+ *
+ * Writes a random, nul-terminated multipart boundary into @buf. A
+ * buffer of #GMIME_ID_GENERATOR_BOUNDARY_LEN + 1 bytes is always large
+ * enough.
+ *
+ * Returns: the length of the boundary, not including the nul
+ * terminator. If the return value is greater than or equal to @size,
+ * @buf was too small and has been set to an empty string.
+ **/
+size_t
+g_mime_id_generator_format_boundary (GMimeIdGenerator *generator, char *buf, size_t size)
+{
+	unsigned char digest[16], *outptr;
+	guint32 save = 0;
+	int state = 0;
 	
-	return g_string_free (msgid, FALSE);
+	g_return_val_if_fail (generator != NULL, 0);
+	g_return_val_if_fail (buf != NULL || size == 0, 0);
+	
+	if (size <= GMIME_ID_GENERATOR_BOUNDARY_LEN) {
+		if (size > 0)
+			buf[0] = '\0';
+		
+		return GMIME_ID_GENERATOR_BOUNDARY_LEN;
+	}
+	
+	g_mime_read_random_pool (digest, 16);
+	
+	buf[0] = '=';
+	buf[1] = '-';
+	outptr = (unsigned char *) buf + 2;
+	outptr += g_mime_encoding_base64_encode_step (digest, 16, outptr, &state, &save);
+	*outptr = '\0';
+	
+	return GMIME_ID_GENERATOR_BOUNDARY_LEN;
+}
+
+
+/**
+ * g_mime_utils_generate_message_id:
+ * @fqdn: (nullable): Fully qualified domain name
+ *
+ * Generates a unique Message-Id. If @fqdn is %NULL, the default
+ * #GMimeIdGenerator is used.
+ *
+ * Returns: a unique string in an addr-spec format suitable for use as
+ * a Message-Id.
+ **/
+char *
+g_mime_utils_generate_message_id (const char *fqdn)
+{
+	GMimeIdGenerator *generator;
+	size_t size;
+	char *msgid;
+	
+	if (fqdn)
+		generator = g_mime_id_generator_new (fqdn);
+	else
+		generator = g_mime_id_generator_ref (g_mime_id_generator_get_default ());
+	
+	size = GMIME_ID_GENERATOR_LOCAL_PART_MAX_LEN + generator->fqdn_len;
+	msgid = g_malloc (size);
+	
+	g_mime_id_generator_format_message_id (generator, msgid, size);
+	g_mime_id_generator_unref (generator);
+	
+	return msgid;
 }
 
 
@@ -1107,7 +1643,7 @@ g_mime_utils_best_encoding (const unsigned char *text, size_t len)
  * Returns: the string length of the output buffer.
  **/
 static size_t
-charset_convert (iconv_t cd, const char *inbuf, size_t inleft, char **outp, size_t *outlenp, size_t *ninval)
+charset_convert (GMimeIconv *cd, const char *inbuf, size_t inleft, char **outp, size_t *outlenp, size_t *ninval)
 {
 	size_t outlen, outleft, rc, n = 0;
 	char *outbuf, *out;
@@ -1121,7 +1657,7 @@ charset_convert (iconv_t cd, const char *inbuf, size_t inleft, char **outp, size
 	}
 	
 	do {
-		rc = iconv (cd, (char **) &inbuf, &inleft, &outbuf, &outleft);
+		rc = _g_mime_iconv (cd, (char **) &inbuf, &inleft, &outbuf, &outleft);
 		if (rc == (size_t) -1) {
 			if (errno == EINVAL) {
 				/* incomplete sequence at the end of the input buffer */
@@ -1161,7 +1697,7 @@ charset_convert (iconv_t cd, const char *inbuf, size_t inleft, char **outp, size
 		}
 	} while (inleft > 0);
 	
-	while (iconv (cd, NULL, NULL, &outbuf, &outleft) == (size_t) -1) {
+	while (_g_mime_iconv (cd, NULL, NULL, &outbuf, &outleft) == (size_t) -1) {
 		if (errno != E2BIG)
 			break;
 		
@@ -1203,7 +1739,7 @@ g_mime_utils_decode_8bit (GMimeParserOptions *options, const char *text, size_t
 	size_t outleft, outlen, min, ninval;
 	const char **charsets;
 	const char *best;
-	iconv_t cd;
+	GMimeIconv *cd;
 	char *out;
 	int i;
 	
@@ -1217,12 +1753,12 @@ g_mime_utils_decode_8bit (GMimeParserOptions *options, const char *text, size_t
 	out = g_malloc (outleft + 1);
 	
 	for (i = 0; charsets[i]; i++) {
-		if ((cd = g_mime_iconv_open ("UTF-8", charsets[i])) == (iconv_t) -1)
+		if ((cd = _g_mime_iconv_open ("UTF-8", charsets[i])) == NULL)
 			continue;
 		
 		outlen = charset_convert (cd, text, len, &out, &outleft, &ninval);
 		
-		g_mime_iconv_close (cd);
+		_g_mime_iconv_close (cd);
 		
 		if (ninval == 0)
 			return g_realloc (out, outlen + 1);
@@ -1237,7 +1773,7 @@ g_mime_utils_decode_8bit (GMimeParserOptions *options, const char *text, size_t
 	 * try to find the one that fit the best and use that to convert what we can,
 	 * replacing any byte we can't convert with a '?' */
 	
-	if ((cd = g_mime_iconv_open ("UTF-8", best)) == (iconv_t) -1) {
+	if ((cd = _g_mime_iconv_open ("UTF-8", best)) == NULL) {
 		/* this shouldn't happen... but if we are here, then
 		 * it did...  the only thing we can do at this point
 		 * is replace the 8bit garbage and pray */
@@ -1261,7 +1797,7 @@ g_mime_utils_decode_8bit (GMimeParserOptions *options, const char *text, size_t
 	
 	outlen = charset_convert (cd, text, len, &out, &outleft, &ninval);
 	
-	g_mime_iconv_close (cd);
+	_g_mime_iconv_close (cd);
 	
 	return g_realloc (out, outlen + 1);
 }
@@ -1465,6 +2001,15 @@ rfc2047_token_new_encoded_word (const char *word, size_t len)
 	if ((lang = strchr (charset, '*')))
 		*lang = '\0';
 	
+	/* UTF-8 and US-ASCII get decoded without iconv, so don't bother
+	 * looking them up in the charset alias table */
+	if (!g_ascii_strcasecmp (charset, "utf-8") || !g_ascii_strcasecmp (charset, "utf8"))
+		charset = "UTF-8";
+	else if (!g_ascii_strcasecmp (charset, "us-ascii") || !g_ascii_strcasecmp (charset, "ascii"))
+		charset = "us-ascii";
+	else
+		charset = g_mime_charset_iconv_name (charset);
+	
 	/* skip over the '?' */
 	inptr++;
 	
@@ -1494,7 +2039,7 @@ rfc2047_token_new_encoded_word (const char *word, size_t len)
 		return NULL;
 	
 	token = rfc2047_token_new (payload, inptr - payload);
-	token->charset = g_mime_charset_iconv_name (charset);
+	token->charset = charset;
 	token->encoding = encoding;
 	
 	return token;
@@ -1806,7 +2351,7 @@ rfc2047_decode_tokens (GMimeParserOptions *options, rfc2047_token *tokens, size_
 	GString *decoded;
 	char encoding;
 	guint32 save;
-	iconv_t cd;
+	GMimeIconv *cd;
 	int state;
 	char *str;
 	
@@ -1862,8 +2407,9 @@ rfc2047_decode_tokens (GMimeParserOptions *options, rfc2047_token *tokens, size_
 			outptr = outbuf->data;
 			
 			/* convert the raw decoded text into UTF-8 */
-			if (!g_ascii_strcasecmp (charset, "UTF-8")) {
-				/* slight optimization over going through iconv */
+			if (!strcmp (charset, "UTF-8") || !strcmp (charset, "us-ascii")) {
+				/* US-ASCII is a subset of UTF-8, so both can be validated
+				 * in place without having to go through iconv */
 				str = (char *) outptr;
 				len = outlen;
 				
@@ -1873,7 +2419,7 @@ rfc2047_decode_tokens (GMimeParserOptions *options, rfc2047_token *tokens, size_
 				}
 				
 				g_string_append_len (decoded, (char *) outptr, outlen);
-			} else if ((cd = g_mime_iconv_open ("UTF-8", charset)) == (iconv_t) -1) {
+			} else if ((cd = _g_mime_iconv_open ("UTF-8", charset)) == NULL) {
 				w(g_warning ("Cannot convert from %s to UTF-8, header display may "
 					     "be corrupt: %s", charset[0] ? charset : "unspecified charset",
 					     g_strerror (errno)));
@@ -1886,7 +2432,7 @@ rfc2047_decode_tokens (GMimeParserOptions *options, rfc2047_token *tokens, size_
 				len = outlen;
 				
 				len = charset_convert (cd, (char *) outptr, outlen, &str, &len, &ninval);
-				g_mime_iconv_close (cd);
+				_g_mime_iconv_close (cd);
 				
 				g_string_append_len (decoded, str, len);
 				g_free (str);
@@ -1916,6 +2462,35 @@ rfc2047_decode_tokens (GMimeParserOptions *options, rfc2047_token *tokens, size_
 }
 
 
+/**
+ * _g_mime_utils_header_is_plain_text:
+ * @text: header text
+ *
+ * Checks whether @text can be used as its own decoded value, i.e. it
+ * contains no 8bit bytes and nothing that could start an rfc2047
+ * encoded-word.
+ *
+ * Returns: %TRUE if @text does not need to be decoded or %FALSE otherwise.
+ **/
+gboolean
+_g_mime_utils_header_is_plain_text (const char *text)
+{
+	register const char *inptr = text;
+	
+	while (*inptr) {
+		if (!is_ascii (*inptr))
+			return FALSE;
+		
+		if (*inptr == '=' && inptr[1] == '?')
+			return FALSE;
+		
+		inptr++;
+	}
+	
+	return TRUE;
+}
+
+
 /**
  * _g_mime_utils_header_decode_text:
  * @text: header text to decode
@@ -1942,6 +2517,14 @@ _g_mime_utils_header_decode_text (GMimeParserOptions *options, const char *text,
 		return g_strdup ("");
 	}
 	
+	if (_g_mime_utils_header_is_plain_text (text)) {
+		/* nothing to decode */
+		if (charset)
+			*charset = NULL;
+		
+		return g_strdup (text);
+	}
+	
 	tokens = tokenize_rfc2047_text (options, text, &len, offset);
 	decoded = rfc2047_decode_tokens (options, tokens, len, charset);
 	rfc2047_token_list_free (tokens);
@@ -1993,6 +2576,14 @@ _g_mime_utils_header_decode_phrase (GMimeParserOptions *options, const char *phr
 		return g_strdup ("");
 	}
 	
+	if (_g_mime_utils_header_is_plain_text (phrase)) {
+		/* nothing to decode */
+		if (charset)
+			*charset = NULL;
+		
+		return g_strdup (phrase);
+	}
+	
 	tokens = tokenize_rfc2047_phrase (options, phrase, &len, offset);
 	decoded = rfc2047_decode_tokens (options, tokens, len, charset);
 	rfc2047_token_list_free (tokens);
@@ -2048,7 +2639,7 @@ rfc2047_encode_word (GString *string, const char *word, size_t len,
 		     const char *charset, gushort safemask)
 {
 	register char *inptr, *outptr;
-	iconv_t cd = (iconv_t) -1;
+	GMimeIconv *cd = NULL;
 	unsigned char *encoded;
 	size_t enclen, pos;
 	char *uword = NULL;
@@ -2057,11 +2648,11 @@ rfc2047_encode_word (GString *string, const char *word, size_t len,
 	char encoding;
 	
 	if (g_ascii_strcasecmp (charset, "UTF-8") != 0)
-		cd = g_mime_iconv_open (charset, "UTF-8");
+		cd = _g_mime_iconv_open (charset, "UTF-8");
 	
-	if (cd != (iconv_t) -1) {
-		uword = g_mime_iconv_strndup (cd, (char *) word, len);
-		g_mime_iconv_close (cd);
+	if (cd != NULL) {
+		uword = _g_mime_iconv_strndup (cd, (char *) word, len);
+		_g_mime_iconv_close (cd);
 	}
 	
 	if (uword) {
@@ -2848,3 +3439,68 @@ g_mime_utils_header_unfold (const char *value)
 
 	return str;
 }
+
+
+/**
+ * _g_mime_utils_append_imap_nstring:
+ * @str: a #GString
+ * @value: (nullable): the value to append
+ *
+ * Appends @value to @str as an IMAP nstring (rfc3501): %NULL is
+ * written as NIL and values that cannot be represented as a quoted
+ * string are written as a literal.
+ **/
+void
+_g_mime_utils_append_imap_nstring (GString *str, const char *value)
+{
+	register const char *inptr;
+	
+	if (value == NULL) {
+		g_string_append (str, "NIL");
+		return;
+	}
+	
+	inptr = value;
+	while (*inptr && !((unsigned char) *inptr & 0x80) && *inptr != '\r' && *inptr != '\n')
+		inptr++;
+	
+	if (*inptr != '\0') {
+		g_string_append_printf (str, "{%lu}\r\n", (unsigned long) strlen (value));
+		g_string_append (str, value);
+		return;
+	}
+	
+	g_string_append_c (str, '"');
+	for (inptr = value; *inptr; inptr++) {
+		if (*inptr == '"' || *inptr == '\\')
+			g_string_append_c (str, '\\');
+		g_string_append_c (str, *inptr);
+	}
+	g_string_append_c (str, '"');
+}
+
+
+/**
+ * _g_mime_utils_append_imap_header:
+ * @str: a #GString
+ * @headers: a #GMimeHeaderList
+ * @name: header name
+ *
+ * Appends the unfolded raw value of the first @name header in
+ * @headers to @str as an IMAP nstring.
+ **/
+void
+_g_mime_utils_append_imap_header (GString *str, GMimeHeaderList *headers, const char *name)
+{
+	GMimeHeader *header;
+	char *value;
+	
+	if (!(header = g_mime_header_list_get_header (headers, name))) {
+		g_string_append (str, "NIL");
+		return;
+	}
+	
+	value = g_mime_utils_header_unfold (g_mime_header_get_raw_value (header));
+	_g_mime_utils_append_imap_nstring (str, value);
+	g_free (value);
+}
@@ -32,10 +32,50 @@
 G_BEGIN_DECLS
 
 GDateTime *g_mime_utils_header_decode_date (const char *str);
+gboolean g_mime_utils_header_decode_date_unix (const char *str, gint64 *date, int *tz_offset);
 char *g_mime_utils_header_format_date (GDateTime *date);
 
 char *g_mime_utils_generate_message_id (const char *fqdn);
 
+#define GMIME_TYPE_ID_GENERATOR (g_mime_id_generator_get_type ())
+
+/**
+ * GMIME_ID_GENERATOR_LOCAL_PART_MAX_LEN:
+ *
+ * The maximum number of bytes needed for the local-part and '@' of a
+ * generated Message-Id, including room for the nul terminator.
+ **/
+#define GMIME_ID_GENERATOR_LOCAL_PART_MAX_LEN 29
+
+/**
+ * GMIME_ID_GENERATOR_BOUNDARY_LEN:
+ *
+ * The length of a generated multipart boundary, not including the nul
+ * terminator.
+ **/
+#define GMIME_ID_GENERATOR_BOUNDARY_LEN 22
+
+/**
+ * GMimeIdGenerator:
+ *
+ * An opaque, thread-safe generator for Message-Ids and multipart
+ * boundaries.
+ **/
+typedef struct _GMimeIdGenerator GMimeIdGenerator;
+
+GType g_mime_id_generator_get_type (void) G_GNUC_CONST;
+
+GMimeIdGenerator *g_mime_id_generator_new (const char *fqdn);
+GMimeIdGenerator *g_mime_id_generator_ref (GMimeIdGenerator *generator);
+void g_mime_id_generator_unref (GMimeIdGenerator *generator);
+
+GMimeIdGenerator *g_mime_id_generator_get_default (void);
+
+const char *g_mime_id_generator_get_fqdn (GMimeIdGenerator *generator);
+
+size_t g_mime_id_generator_format_message_id (GMimeIdGenerator *generator, char *buf, size_t size);
+size_t g_mime_id_generator_format_boundary (GMimeIdGenerator *generator, char *buf, size_t size);
+
 /* decode a message-id */
 char *g_mime_utils_decode_message_id (const char *message_id);
 
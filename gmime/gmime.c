@@ -230,4 +230,5 @@ g_mime_shutdown (void)
 	g_mime_format_options_shutdown ();
 	g_mime_parser_options_shutdown ();
 	g_mime_charset_map_shutdown ();
+	g_mime_utils_shutdown ();
 }
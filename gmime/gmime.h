@@ -43,6 +43,7 @@
 #include <gmime/gmime-message.h>
 #include <gmime/gmime-message-part.h>
 #include <gmime/gmime-message-partial.h>
+#include <gmime/gmime-frozen-message.h>
 #include <gmime/internet-address.h>
 #include <gmime/gmime-encodings.h>
 #include <gmime/gmime-format-options.h>
@@ -50,9 +51,11 @@
 #include <gmime/gmime-parser.h>
 #include <gmime/gmime-utils.h>
 #include <gmime/gmime-references.h>
+#include <gmime/gmime-stats.h>
 #include <gmime/gmime-stream.h>
 #include <gmime/gmime-stream-buffer.h>
 #include <gmime/gmime-stream-cat.h>
+#include <gmime/gmime-stream-chunked.h>
 #include <gmime/gmime-stream-file.h>
 #include <gmime/gmime-stream-filter.h>
 #include <gmime/gmime-stream-fs.h>
@@ -149,7 +149,7 @@ internet_address_class_init (InternetAddressClass *klass)
 static void
 internet_address_init (InternetAddress *ia, InternetAddressClass *klass)
 {
-	ia->changed = g_mime_event_new ((GObject *) ia);
+	ia->changed = NULL;
 	ia->charset = NULL;
 	ia->name = NULL;
 }
@@ -364,6 +364,8 @@ _internet_address_mailbox_new (const char *name, const char *addr, int at)
 	mailbox->addr = g_strdup (addr);
 	mailbox->at = at;
 	
+	GMIME_STATS (_g_mime_stats_record_alloc (GMIME_STATS_SUBSYSTEM_ADDRESSES, sizeof (InternetAddressMailbox) + strlen (addr) + 1));
+	
 	_internet_address_set_name ((InternetAddress *) mailbox, name);
 	
 	return (InternetAddress *) mailbox;
@@ -395,6 +397,8 @@ internet_address_mailbox_new (const char *name, const char *addr)
 	if (!addrspec_parse (&inptr, "", &mailbox->addr, &mailbox->at))
 		mailbox->addr = g_strdup (addr);
 	
+	GMIME_STATS (_g_mime_stats_record_alloc (GMIME_STATS_SUBSYSTEM_ADDRESSES, sizeof (InternetAddressMailbox) + strlen (mailbox->addr) + 1));
+	
 	_internet_address_set_name ((InternetAddress *) mailbox, name);
 	
 	return (InternetAddress *) mailbox;
@@ -549,7 +553,7 @@ internet_address_group_init (InternetAddressGroup *group, InternetAddressGroupCl
 {
 	group->members = internet_address_list_new ();
 	
-	g_mime_event_add (group->members->changed, (GMimeEventCallback) members_changed, group);
+	g_mime_event_add (&group->members->changed, group->members, (GMimeEventCallback) members_changed, group);
 }
 
 static void
@@ -584,6 +588,8 @@ internet_address_group_new (const char *name)
 	group = g_object_new (INTERNET_ADDRESS_TYPE_GROUP, NULL);
 	_internet_address_set_name (group, name);
 	
+	GMIME_STATS (_g_mime_stats_record_alloc (GMIME_STATS_SUBSYSTEM_ADDRESSES, sizeof (InternetAddressGroup)));
+	
 	return group;
 }
 
@@ -610,7 +616,7 @@ internet_address_group_set_members (InternetAddressGroup *group, InternetAddress
 	}
 	
 	if (members) {
-		g_mime_event_add (members->changed, (GMimeEventCallback) members_changed, group);
+		g_mime_event_add (&members->changed, members, (GMimeEventCallback) members_changed, group);
 		g_object_ref (members);
 	}
 	
@@ -706,7 +712,7 @@ internet_address_list_class_init (InternetAddressListClass *klass)
 static void
 internet_address_list_init (InternetAddressList *list, InternetAddressListClass *klass)
 {
-	list->changed = g_mime_event_new ((GObject *) list);
+	list->changed = NULL;
 	list->array = g_ptr_array_new ();
 }
 
@@ -799,7 +805,7 @@ _internet_address_list_add (InternetAddressList *list, InternetAddress *ia)
 {
 	int index;
 	
-	g_mime_event_add (ia->changed, (GMimeEventCallback) address_changed, list);
+	g_mime_event_add (&ia->changed, ia, (GMimeEventCallback) address_changed, list);
 	
 	index = list->array->len;
 	g_ptr_array_add (list->array, ia);
@@ -864,7 +870,7 @@ internet_address_list_prepend (InternetAddressList *list, InternetAddressList *p
 	
 	for (i = 0; i < prepend->array->len; i++) {
 		ia = (InternetAddress *) prepend->array->pdata[i];
-		g_mime_event_add (ia->changed, (GMimeEventCallback) address_changed, list);
+		g_mime_event_add (&ia->changed, ia, (GMimeEventCallback) address_changed, list);
 		list->array->pdata[i] = ia;
 		g_object_ref (ia);
 	}
@@ -894,7 +900,7 @@ internet_address_list_append (InternetAddressList *list, InternetAddressList *ap
 	
 	for (i = 0; i < append->array->len; i++) {
 		ia = (InternetAddress *) append->array->pdata[i];
-		g_mime_event_add (ia->changed, (GMimeEventCallback) address_changed, list);
+		g_mime_event_add (&ia->changed, ia, (GMimeEventCallback) address_changed, list);
 		list->array->pdata[len + i] = ia;
 		g_object_ref (ia);
 	}
@@ -922,7 +928,7 @@ internet_address_list_insert (InternetAddressList *list, int index, InternetAddr
 	g_return_if_fail (IS_INTERNET_ADDRESS (ia));
 	g_return_if_fail (index >= 0);
 	
-	g_mime_event_add (ia->changed, (GMimeEventCallback) address_changed, list);
+	g_mime_event_add (&ia->changed, ia, (GMimeEventCallback) address_changed, list);
 	g_object_ref (ia);
 	
 	if ((guint) index < list->array->len) {
@@ -1105,7 +1111,7 @@ internet_address_list_set_address (InternetAddressList *list, int index, Interne
 	g_mime_event_remove (old->changed, (GMimeEventCallback) address_changed, list);
 	g_object_unref (old);
 	
-	g_mime_event_add (ia->changed, (GMimeEventCallback) address_changed, list);
+	g_mime_event_add (&ia->changed, ia, (GMimeEventCallback) address_changed, list);
 	list->array->pdata[index] = ia;
 	g_object_ref (ia);
 	
@@ -1678,9 +1684,133 @@ addrspec_parse (const char **in, const char *sentinels, char **addrspec, int *at
 	return FALSE;
 }
 
+#define FLAT_LIST_NONE G_MAXUINT32
+
+struct _InternetAddressFlatList {
+	volatile int ref_count;
+	
+	/* struct-of-arrays, one element per address */
+	guint32 *name;     /* offset of the name in the blob */
+	guint32 *addr;     /* offset of the addr-spec in the blob or FLAT_LIST_NONE for groups */
+	guint32 *charset;  /* offset of the charset in the blob or FLAT_LIST_NONE */
+	gint32 *at;        /* index of the '@' within the addr-spec */
+	gint32 *group;     /* index of the group containing the address or -1 */
+	guint length;
+	guint size;
+	
+	/* all of the strings, nul-terminated, back to back */
+	char *blob;
+	guint32 blob_len;
+	guint32 blob_size;
+};
+
+static guint32
+flat_list_append_string (InternetAddressFlatList *list, const char *str)
+{
+	guint32 offset = list->blob_len;
+	size_t n = strlen (str) + 1;
+	
+	if (list->blob_len + n > list->blob_size) {
+		while (list->blob_len + n > list->blob_size)
+			list->blob_size = list->blob_size ? list->blob_size * 2 : 256;
+		
+		list->blob = g_realloc (list->blob, list->blob_size);
+	}
+	
+	memcpy (list->blob + list->blob_len, str, n);
+	list->blob_len += n;
+	
+	return offset;
+}
+
+static int
+flat_list_append (InternetAddressFlatList *list, const char *name, const char *charset, const char *addr, int at, int group)
+{
+	guint index = list->length;
+	
+	if (list->length == list->size) {
+		list->size = list->size ? list->size * 2 : 8;
+		list->name = g_renew (guint32, list->name, list->size);
+		list->addr = g_renew (guint32, list->addr, list->size);
+		list->charset = g_renew (guint32, list->charset, list->size);
+		list->at = g_renew (gint32, list->at, list->size);
+		list->group = g_renew (gint32, list->group, list->size);
+	}
+	
+	list->name[index] = flat_list_append_string (list, name);
+	list->addr[index] = addr ? flat_list_append_string (list, addr) : FLAT_LIST_NONE;
+	list->charset[index] = charset ? flat_list_append_string (list, charset) : FLAT_LIST_NONE;
+	list->at[index] = at;
+	list->group[index] = group;
+	list->length++;
+	
+	return (int) index;
+}
+
+/* The address parser either builds InternetAddress objects or
+ * appends to an InternetAddressFlatList, depending on which of
+ * @list and @flat is set. */
+typedef struct {
+	InternetAddressList *list;
+	InternetAddressFlatList *flat;
+	int group;
+	
+	/* whether the last address added was a group */
+	gboolean is_group;
+} AddressBuilder;
+
+static void
+address_builder_add_mailbox (AddressBuilder *builder, const char *name, const char *charset, const char *addr, int at)
+{
+	InternetAddress *ia;
+	
+	builder->is_group = FALSE;
+	
+	if (builder->flat) {
+		flat_list_append (builder->flat, name, charset, addr, at, builder->group);
+		return;
+	}
+	
+	ia = _internet_address_mailbox_new (name, addr, at);
+	ia->charset = g_strdup (charset);
+	
+	_internet_address_list_add (builder->list, ia);
+}
+
+static InternetAddress *
+address_builder_begin_group (AddressBuilder *builder, const char *name, const char *charset, AddressBuilder *saved)
+{
+	InternetAddress *group;
+	
+	*saved = *builder;
+	
+	if (builder->flat) {
+		builder->group = flat_list_append (builder->flat, name, charset, NULL, -1, builder->group);
+		return NULL;
+	}
+	
+	group = internet_address_group_new (name);
+	group->charset = g_strdup (charset);
+	
+	builder->list = ((InternetAddressGroup *) group)->members;
+	
+	return group;
+}
+
+static void
+address_builder_end_group (AddressBuilder *builder, AddressBuilder *saved, InternetAddress *group)
+{
+	*builder = *saved;
+	
+	if (group != NULL)
+		_internet_address_list_add (builder->list, group);
+	
+	builder->is_group = TRUE;
+}
+
 // TODO: rename to angleaddr_parse??
 static gboolean
-mailbox_parse (GMimeParserOptions *options, const char **in, const char *name, InternetAddress **address)
+mailbox_parse (GMimeParserOptions *options, const char **in, const char *name, const char *charset, AddressBuilder *builder)
 {
 	GMimeRfcComplianceMode mode = g_mime_parser_options_get_address_compliance_mode (options);
 	const char *inptr = *in;
@@ -1748,7 +1878,7 @@ mailbox_parse (GMimeParserOptions *options, const char **in, const char *name, I
 		}
 	}
 	
-	*address = _internet_address_mailbox_new (name, addrspec, at);
+	address_builder_add_mailbox (builder, name, charset, addrspec, at);
 	g_free (addrspec);
 	*in = inptr;
 	
@@ -1756,16 +1886,15 @@ mailbox_parse (GMimeParserOptions *options, const char **in, const char *name, I
 	
  error:
 	g_free (addrspec);
-	*address = NULL;
 	*in = inptr;
 	
 	return FALSE;
 }
 
-static gboolean address_list_parse (InternetAddressList *list, GMimeParserOptions *options, const char **in, gboolean is_group, gint64 offset);
+static gboolean address_list_parse (AddressBuilder *builder, GMimeParserOptions *options, const char **in, gboolean is_group, gint64 offset);
 
 static gboolean
-group_parse (InternetAddressGroup *group, GMimeParserOptions *options, const char **in, gint64 offset)
+group_parse (AddressBuilder *builder, GMimeParserOptions *options, const char **in, gint64 offset)
 {
 	const char *inptr = *in;
 	
@@ -1777,7 +1906,7 @@ group_parse (InternetAddressGroup *group, GMimeParserOptions *options, const cha
 		inptr++;
 	
 	if (*inptr != '\0') {
-		address_list_parse (group->members, options, &inptr, TRUE, offset);
+		address_list_parse (builder, options, &inptr, TRUE, offset);
 		
 		if (*inptr != ';') {
 			while (*inptr && *inptr != ';')
@@ -1793,7 +1922,7 @@ group_parse (InternetAddressGroup *group, GMimeParserOptions *options, const cha
 }
 
 static gboolean
-address_parse (GMimeParserOptions *options, AddressParserFlags flags, const char **in, const char **charset, InternetAddress **address, gint64 offset)
+address_parse (GMimeParserOptions *options, AddressParserFlags flags, const char **in, const char **charset, AddressBuilder *builder, gint64 offset)
 {
 	GMimeRfcComplianceMode mode = g_mime_parser_options_get_address_compliance_mode (options);
 	int min_words = g_mime_parser_options_get_allow_addresses_without_domain (options) ? 1 : 0;
@@ -1906,7 +2035,7 @@ address_parse (GMimeParserOptions *options, AddressParserFlags flags, const char
 			inptr++;
 		}
 		
-		*address = _internet_address_mailbox_new (name, addrspec, at);
+		address_builder_add_mailbox (builder, name, *charset, addrspec, at);
 		g_free (addrspec);
 		g_free (name);
 		*in = inptr;
@@ -1916,8 +2045,9 @@ address_parse (GMimeParserOptions *options, AddressParserFlags flags, const char
 	
 	if (*inptr == ':') {
 		/* rfc2822 group address */
-		InternetAddressGroup *group;
 		const char *phrase = start;
+		InternetAddress *group;
+		AddressBuilder saved;
 		gboolean retval;
 		char *name;
 		
@@ -1935,11 +2065,11 @@ address_parse (GMimeParserOptions *options, AddressParserFlags flags, const char
 			name = g_strdup ("");
 		}
 		
-		group = (InternetAddressGroup *) internet_address_group_new (name);
-		*address = (InternetAddress *) group;
+		group = address_builder_begin_group (builder, name, *charset, &saved);
 		g_free (name);
 		
-		retval = group_parse (group, options, &inptr, offset);
+		retval = group_parse (builder, options, &inptr, offset);
+		address_builder_end_group (builder, &saved, group);
 		*in = inptr;
 		
 		return retval;
@@ -1982,7 +2112,7 @@ address_parse (GMimeParserOptions *options, AddressParserFlags flags, const char
 		}
 		
 		if (*inptr == '\0') {
-			*address = _internet_address_mailbox_new (name, addrspec, at);
+			address_builder_add_mailbox (builder, name, *charset, addrspec, at);
 			g_free (addrspec);
 			g_free (name);
 			*in = inptr;
@@ -2018,7 +2148,7 @@ address_parse (GMimeParserOptions *options, AddressParserFlags flags, const char
 				inptr++;
 			}
 			
-			*address = _internet_address_mailbox_new (name, addrspec, at);
+			address_builder_add_mailbox (builder, name, *charset, addrspec, at);
 			g_free (addrspec);
 			g_free (name);
 			*in = inptr;
@@ -2044,7 +2174,7 @@ address_parse (GMimeParserOptions *options, AddressParserFlags flags, const char
 			name = g_strdup ("");
 		}
 		
-		retval = mailbox_parse (options, &inptr, name, address);
+		retval = mailbox_parse (options, &inptr, name, *charset, builder);
 		g_free (name);
 		*in = inptr;
 		
@@ -2055,17 +2185,15 @@ address_parse (GMimeParserOptions *options, AddressParserFlags flags, const char
 	if (g_mime_parser_options_get_warning_callback (options) != NULL)
 		_g_mime_parser_options_warn (options, offset, GMIME_WARN_INVALID_ADDRESS_LIST, *in);
 	
-	*address = NULL;
 	*in = inptr;
 	
 	return FALSE;
 }
 
 static gboolean
-address_list_parse (InternetAddressList *list, GMimeParserOptions *options, const char **in, gboolean is_group, gint64 offset)
+address_list_parse (AddressBuilder *builder, GMimeParserOptions *options, const char **in, gboolean is_group, gint64 offset)
 {
 	gboolean can_warn = g_mime_parser_options_get_warning_callback (options) != NULL;
-	InternetAddress *address;
 	const char *charset;
 	const char *inptr;
 	
@@ -2085,18 +2213,12 @@ address_list_parse (InternetAddressList *list, GMimeParserOptions *options, cons
 		
 		charset = NULL;
 		
-		if (!address_parse (options, ALLOW_ANY, &inptr, &charset, &address, offset)) {
+		if (!address_parse (options, ALLOW_ANY, &inptr, &charset, builder, offset)) {
 			/* skip this address... */
 			while (*inptr && *inptr != ',' && (!is_group || *inptr != ';'))
 				inptr++;
-		} else {
-			_internet_address_list_add (list, address);
-			
-			if (charset)
-				address->charset = g_strdup (charset);
-
-			if (INTERNET_ADDRESS_IS_GROUP(address))
-				separator_between_addrs = TRUE;
+		} else if (builder->is_group) {
+			separator_between_addrs = TRUE;
 		}
 		
 		/* Note: we loop here in case there are any null addresses between commas */
@@ -2143,16 +2265,353 @@ internet_address_list_parse (GMimeParserOptions *options, const char *str)
 InternetAddressList *
 _internet_address_list_parse (GMimeParserOptions *options, const char *str, gint64 offset)
 {
+	AddressBuilder builder = { NULL, NULL, -1, FALSE };
 	InternetAddressList *list;
 	const char *inptr = str;
 	
 	g_return_val_if_fail (str != NULL, NULL);
 	
-	list = internet_address_list_new ();
-	if (!address_list_parse (list, options, &inptr, FALSE, offset) || list->array->len == 0) {
+	builder.list = list = internet_address_list_new ();
+	if (!address_list_parse (&builder, options, &inptr, FALSE, offset) || list->array->len == 0) {
 		g_object_unref (list);
 		return NULL;
 	}
 	
 	return list;
 }
+
+static InternetAddress *
+internet_address_copy (InternetAddress *ia)
+{
+	InternetAddressMailbox *mailbox;
+	InternetAddressGroup *group;
+	InternetAddress *copy;
+	
+	if (INTERNET_ADDRESS_IS_MAILBOX (ia)) {
+		mailbox = (InternetAddressMailbox *) ia;
+		copy = _internet_address_mailbox_new (ia->name, mailbox->addr, mailbox->at);
+		((InternetAddressMailbox *) copy)->idn_addr = g_strdup (mailbox->idn_addr);
+	} else {
+		group = (InternetAddressGroup *) ia;
+		copy = internet_address_group_new (ia->name);
+		_internet_address_list_append_copy (((InternetAddressGroup *) copy)->members, group->members);
+	}
+	
+	copy->charset = g_strdup (ia->charset);
+	
+	return copy;
+}
+
+/**
+ * _internet_address_list_append_copy:
+ * @list: a #InternetAddressList
+ * @append: a #InternetAddressList
+ *
+ * Appends deep copies of the addresses in @append to @list without
+ * emitting a change event on @list.
+ **/
+void
+_internet_address_list_append_copy (InternetAddressList *list, InternetAddressList *append)
+{
+	guint i;
+	
+	for (i = 0; i < append->array->len; i++)
+		_internet_address_list_add (list, internet_address_copy (append->array->pdata[i]));
+}
+
+
+/**
+ * SECTION: internet-address-flat-list
+ * @title: InternetAddressFlatList
+ * @short_description: A compact, read-only list of internet addresses
+ * @see_also: #InternetAddressList
+ *
+ * An #InternetAddressFlatList is a read-only alternative to
+ * #InternetAddressList meant for very large address lists. Rather
+ * than creating an #InternetAddress object for each address, the
+ * parser stores every string in a single buffer and the addresses
+ * themselves as parallel arrays of offsets into that buffer.
+ *
+ * Group members are stored inline, immediately following the group
+ * that contains them.
+ **/
+
+G_DEFINE_BOXED_TYPE (InternetAddressFlatList, internet_address_flat_list, internet_address_flat_list_ref, internet_address_flat_list_unref);
+
+
+/**
+ * internet_address_flat_list_parse:
+ * @options: (nullable): a #GMimeParserOptions or %NULL
+ * @str: a string containing internet addresses
+ *
+ * Parses the given string into a compact list of internet addresses
+ * without creating any #InternetAddress objects.
+ *
+ * Returns: (nullable) (transfer full): a new #InternetAddressFlatList
+ * or %NULL if the input string does not contain any addresses.
+ **/
+InternetAddressFlatList *
+internet_address_flat_list_parse (GMimeParserOptions *options, const char *str)
+{
+	AddressBuilder builder = { NULL, NULL, -1, FALSE };
+	InternetAddressFlatList *list;
+	const char *inptr = str;
+	
+	g_return_val_if_fail (str != NULL, NULL);
+	
+	builder.flat = list = g_slice_new0 (InternetAddressFlatList);
+	list->ref_count = 1;
+	
+	if (!address_list_parse (&builder, options, &inptr, FALSE, -1) || list->length == 0) {
+		internet_address_flat_list_unref (list);
+		return NULL;
+	}
+	
+	/* trim the arrays down to size now that we're done appending */
+	list->name = g_renew (guint32, list->name, list->length);
+	list->addr = g_renew (guint32, list->addr, list->length);
+	list->charset = g_renew (guint32, list->charset, list->length);
+	list->at = g_renew (gint32, list->at, list->length);
+	list->group = g_renew (gint32, list->group, list->length);
+	list->size = list->length;
+	
+	list->blob = g_realloc (list->blob, list->blob_len);
+	list->blob_size = list->blob_len;
+	
+	return list;
+}
+
+
+/**
+ * internet_address_flat_list_ref:
+ * @list: a #InternetAddressFlatList
+ *
+ * Increments the reference count on @list.
+ *
+ * Returns: (transfer full): @list
+ **/
+InternetAddressFlatList *
+internet_address_flat_list_ref (InternetAddressFlatList *list)
+{
+	g_return_val_if_fail (list != NULL, NULL);
+	
+	g_atomic_int_inc (&list->ref_count);
+	
+	return list;
+}
+
+
+/**
+ * internet_address_flat_list_unref:
+ * @list: a #InternetAddressFlatList
+ *
+ * Decrements the reference count on @list, freeing it when the count
+ * drops to 0.
+ **/
+void
+internet_address_flat_list_unref (InternetAddressFlatList *list)
+{
+	g_return_if_fail (list != NULL);
+	
+	if (!g_atomic_int_dec_and_test (&list->ref_count))
+		return;
+	
+	g_free (list->name);
+	g_free (list->addr);
+	g_free (list->charset);
+	g_free (list->at);
+	g_free (list->group);
+	g_free (list->blob);
+	
+	g_slice_free (InternetAddressFlatList, list);
+}
+
+
+/**
+ * internet_address_flat_list_length:
+ * @list: a #InternetAddressFlatList
+ *
+ * Gets the number of addresses in the list, including group members.
+ *
+ * Returns: the number of addresses in the list.
+ **/
+int
+internet_address_flat_list_length (InternetAddressFlatList *list)
+{
+	g_return_val_if_fail (list != NULL, -1);
+	
+	return (int) list->length;
+}
+
+
+/**
+ * internet_address_flat_list_is_group:
+ * @list: a #InternetAddressFlatList
+ * @index: index of the address
+ *
+ * Checks whether the address at @index is a group.
+ *
+ * Returns: %TRUE if the address is a group or %FALSE if it is a mailbox.
+ **/
+gboolean
+internet_address_flat_list_is_group (InternetAddressFlatList *list, int index)
+{
+	g_return_val_if_fail (list != NULL, FALSE);
+	g_return_val_if_fail (index >= 0 && (guint) index < list->length, FALSE);
+	
+	return list->addr[index] == FLAT_LIST_NONE;
+}
+
+
+/**
+ * internet_address_flat_list_get_group:
+ * @list: a #InternetAddressFlatList
+ * @index: index of the address
+ *
+ * Gets the index of the group that contains the address at @index.
+ *
+ * Returns: the index of the containing group or %-1 if the address is
+ * not a group member.
+ **/
+int
+internet_address_flat_list_get_group (InternetAddressFlatList *list, int index)
+{
+	g_return_val_if_fail (list != NULL, -1);
+	g_return_val_if_fail (index >= 0 && (guint) index < list->length, -1);
+	
+	return list->group[index];
+}
+
+
+/**
+ * internet_address_flat_list_get_name:
+ * @list: a #InternetAddressFlatList
+ * @index: index of the address
+ *
+ * Gets the decoded display name of the address at @index.
+ *
+ * Returns: the display name of the address.
+ **/
+const char *
+internet_address_flat_list_get_name (InternetAddressFlatList *list, int index)
+{
+	g_return_val_if_fail (list != NULL, NULL);
+	g_return_val_if_fail (index >= 0 && (guint) index < list->length, NULL);
+	
+	return list->blob + list->name[index];
+}
+
+
+/**
+ * internet_address_flat_list_get_charset:
+ * @list: a #InternetAddressFlatList
+ * @index: index of the address
+ *
+ * Gets the charset the display name of the address at @index was
+ * encoded in.
+ *
+ * Returns: (nullable): the charset of the display name or %NULL.
+ **/
+const char *
+internet_address_flat_list_get_charset (InternetAddressFlatList *list, int index)
+{
+	g_return_val_if_fail (list != NULL, NULL);
+	g_return_val_if_fail (index >= 0 && (guint) index < list->length, NULL);
+	
+	if (list->charset[index] == FLAT_LIST_NONE)
+		return NULL;
+	
+	return list->blob + list->charset[index];
+}
+
+
+/**
+ * internet_address_flat_list_get_addr:
+ * @list: a #InternetAddressFlatList
+ * @index: index of the address
+ *
+ * Gets the addr-spec of the mailbox at @index.
+ *
+ * Returns: (nullable): the addr-spec of the mailbox or %NULL if the
+ * address is a group.
+ **/
+const char *
+internet_address_flat_list_get_addr (InternetAddressFlatList *list, int index)
+{
+	g_return_val_if_fail (list != NULL, NULL);
+	g_return_val_if_fail (index >= 0 && (guint) index < list->length, NULL);
+	
+	if (list->addr[index] == FLAT_LIST_NONE)
+		return NULL;
+	
+	return list->blob + list->addr[index];
+}
+
+
+/**
+ * internet_address_flat_list_get_address:
+ * @list: a #InternetAddressFlatList
+ * @index: index of the address
+ *
+ * Creates a mutable #InternetAddress for the address at @index. If the
+ * address is a group, its members are created as well.
+ *
+ * Returns: (transfer full): a new #InternetAddress.
+ **/
+InternetAddress *
+internet_address_flat_list_get_address (InternetAddressFlatList *list, int index)
+{
+	InternetAddress *ia, *member;
+	guint i;
+	
+	g_return_val_if_fail (list != NULL, NULL);
+	g_return_val_if_fail (index >= 0 && (guint) index < list->length, NULL);
+	
+	if (list->addr[index] != FLAT_LIST_NONE) {
+		ia = _internet_address_mailbox_new (list->blob + list->name[index], list->blob + list->addr[index], list->at[index]);
+	} else {
+		ia = internet_address_group_new (list->blob + list->name[index]);
+		
+		/* the members of a group (and any nested groups) immediately follow it */
+		for (i = index + 1; i < list->length && list->group[i] >= index; i++) {
+			if (list->group[i] != index)
+				continue;
+			
+			member = internet_address_flat_list_get_address (list, (int) i);
+			_internet_address_group_add_member ((InternetAddressGroup *) ia, member);
+		}
+	}
+	
+	if (list->charset[index] != FLAT_LIST_NONE)
+		ia->charset = g_strdup (list->blob + list->charset[index]);
+	
+	return ia;
+}
+
+
+/**
+ * internet_address_flat_list_to_list:
+ * @list: a #InternetAddressFlatList
+ *
+ * Creates a mutable #InternetAddressList containing all of the
+ * addresses in @list.
+ *
+ * Returns: (transfer full): a new #InternetAddressList.
+ **/
+InternetAddressList *
+internet_address_flat_list_to_list (InternetAddressFlatList *list)
+{
+	InternetAddressList *addresses;
+	guint i;
+	
+	g_return_val_if_fail (list != NULL, NULL);
+	
+	addresses = internet_address_list_new ();
+	
+	for (i = 0; i < list->length; i++) {
+		if (list->group[i] == -1)
+			_internet_address_list_add (addresses, internet_address_flat_list_get_address (list, (int) i));
+	}
+	
+	return addresses;
+}
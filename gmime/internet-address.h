@@ -215,6 +215,34 @@ void internet_address_list_encode (InternetAddressList *list, GMimeFormatOptions
 
 InternetAddressList *internet_address_list_parse (GMimeParserOptions *options, const char *str);
 
+
+#define INTERNET_ADDRESS_FLAT_LIST_TYPE        (internet_address_flat_list_get_type ())
+
+/**
+ * InternetAddressFlatList:
+ *
+ * A compact, read-only list of internet addresses.
+ **/
+typedef struct _InternetAddressFlatList InternetAddressFlatList;
+
+GType internet_address_flat_list_get_type (void) G_GNUC_CONST;
+
+InternetAddressFlatList *internet_address_flat_list_parse (GMimeParserOptions *options, const char *str);
+
+InternetAddressFlatList *internet_address_flat_list_ref (InternetAddressFlatList *list);
+void internet_address_flat_list_unref (InternetAddressFlatList *list);
+
+int internet_address_flat_list_length (InternetAddressFlatList *list);
+
+gboolean internet_address_flat_list_is_group (InternetAddressFlatList *list, int index);
+int internet_address_flat_list_get_group (InternetAddressFlatList *list, int index);
+const char *internet_address_flat_list_get_name (InternetAddressFlatList *list, int index);
+const char *internet_address_flat_list_get_charset (InternetAddressFlatList *list, int index);
+const char *internet_address_flat_list_get_addr (InternetAddressFlatList *list, int index);
+
+InternetAddress *internet_address_flat_list_get_address (InternetAddressFlatList *list, int index);
+InternetAddressList *internet_address_flat_list_to_list (InternetAddressFlatList *list);
+
 G_END_DECLS
 
 #endif /* __INTERNET_ADDRESS_H__ */
@@ -0,0 +1,173 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+ *  02110-1301, USA.
+ */
+
+
+/* Generates gmime-sbcs-map-private.h, the byte -> unicode tables used
+ * by the built-in single-byte charset converters in gmime-iconv.c:
+ *
+ *   ./sbcs-map > gmime-sbcs-map-private.h
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iconv.h>
+#include <errno.h>
+
+/* unmapped bytes are marked with a value that is not a character */
+#define SBCS_INVALID 0xffff
+
+/* Note: windows-1255 and windows-1258 are left out because iconv
+ * composes their combining marks with the preceding character, which
+ * a byte -> character table can't do. */
+static struct {
+	const char *name;   /* canonical MIME charset name */
+	const char *iconv;  /* name to give to iconv_open() */
+} charsets[] = {
+	{ "iso-8859-1",   "ISO-8859-1"   },
+	{ "iso-8859-2",   "ISO-8859-2"   },
+	{ "iso-8859-3",   "ISO-8859-3"   },
+	{ "iso-8859-4",   "ISO-8859-4"   },
+	{ "iso-8859-5",   "ISO-8859-5"   },
+	{ "iso-8859-6",   "ISO-8859-6"   },
+	{ "iso-8859-7",   "ISO-8859-7"   },
+	{ "iso-8859-8",   "ISO-8859-8"   },
+	{ "iso-8859-9",   "ISO-8859-9"   },
+	{ "iso-8859-10",  "ISO-8859-10"  },
+	{ "iso-8859-13",  "ISO-8859-13"  },
+	{ "iso-8859-14",  "ISO-8859-14"  },
+	{ "iso-8859-15",  "ISO-8859-15"  },
+	{ "iso-8859-16",  "ISO-8859-16"  },
+	{ "windows-1250", "CP1250"       },
+	{ "windows-1251", "CP1251"       },
+	{ "windows-1252", "CP1252"       },
+	{ "windows-1253", "CP1253"       },
+	{ "windows-1254", "CP1254"       },
+	{ "windows-1256", "CP1256"       },
+	{ "windows-1257", "CP1257"       },
+	{ "koi8-r",       "KOI8-R"       },
+	{ "koi8-u",       "KOI8-U"       },
+	{ NULL,           NULL           }
+};
+
+static unsigned int
+byte_to_ucs (iconv_t cd, unsigned char c)
+{
+	unsigned char out[16];
+	size_t inleft, outleft;
+	char *inbuf, *outbuf;
+	char in = (char) c;
+	
+	inbuf = &in;
+	inleft = 1;
+	outbuf = (char *) out;
+	outleft = sizeof (out);
+	
+	if (iconv (cd, &inbuf, &inleft, &outbuf, &outleft) == (size_t) -1) {
+		iconv (cd, NULL, NULL, NULL, NULL);
+		return SBCS_INVALID;
+	}
+	
+	iconv (cd, NULL, NULL, &outbuf, &outleft);
+	iconv (cd, NULL, NULL, NULL, NULL);
+	
+	if (sizeof (out) - outleft != 4) {
+		/* a byte that maps to a sequence of characters can't be table-driven */
+		fprintf (stderr, "0x%02x maps to %zu bytes of UCS-4\n", c, sizeof (out) - outleft);
+		exit (1);
+	}
+	
+	return (out[0] << 24) | (out[1] << 16) | (out[2] << 8) | out[3];
+}
+
+static void
+table_name (char *buf, const char *name)
+{
+	sprintf (buf, "sbcs_%s", name);
+	
+	while (*buf) {
+		if (*buf == '-')
+			*buf = '_';
+		buf++;
+	}
+}
+
+int main (int argc, char **argv)
+{
+	unsigned int c, i, j;
+	char name[64];
+	iconv_t cd;
+	
+	printf ("/* This file is automatically generated: DO NOT EDIT */\n\n");
+	
+	for (j = 0; charsets[j].name; j++) {
+		if ((cd = iconv_open ("UCS-4BE", charsets[j].iconv)) == (iconv_t) -1) {
+			fprintf (stderr, "iconv_open (UCS-4BE, %s): %s\n",
+				 charsets[j].iconv, strerror (errno));
+			return 1;
+		}
+		
+		/* only ASCII-compatible charsets are supported, so
+		 * only the upper half of each table gets emitted */
+		for (i = 0; i < 128; i++) {
+			if (byte_to_ucs (cd, i) != i) {
+				fprintf (stderr, "%s is not ASCII-compatible at 0x%02x\n",
+					 charsets[j].name, i);
+				return 1;
+			}
+		}
+		
+		table_name (name, charsets[j].name);
+		printf ("static const unsigned short %s[128] = {\n\t", name);
+		for (i = 128; i < 256; i++) {
+			if ((c = byte_to_ucs (cd, i)) > SBCS_INVALID) {
+				fprintf (stderr, "%s: 0x%02x maps outside the BMP\n",
+					 charsets[j].name, i);
+				return 1;
+			}
+			
+			printf ("0x%04x", c);
+			if (i == 255)
+				printf ("\n");
+			else if (((i + 1) & 7) == 0)
+				printf (",\n\t");
+			else
+				printf (", ");
+		}
+		printf ("};\n\n");
+		
+		iconv_close (cd);
+	}
+	
+	printf ("#define SBCS_INVALID 0x%04x\n\n", SBCS_INVALID);
+	
+	printf ("static const struct {\n\tconst char *name;\n\tconst unsigned short *table;\n} sbcs_charsets[] = {\n");
+	for (j = 0; charsets[j].name; j++) {
+		table_name (name, charsets[j].name);
+		printf ("\t{ \"%s\", %s },\n", charsets[j].name, name);
+	}
+	printf ("};\n");
+	
+	return 0;
+}
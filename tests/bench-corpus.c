@@ -0,0 +1,645 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "bench-corpus.h"
+
+/* Note: every corpus is generated from a GRand seeded by the caller so
+ * that the exact same bytes are produced on every run and platform. */
+
+/* size of the attachments at scale 1 */
+#define ATTACHMENT_SIZE (256 * 1024)
+
+/* number of nested multiparts at scale 1 */
+#define NESTING_DEPTH 16
+
+/* number of headers at scale 1 */
+#define HEADER_COUNT 64
+
+static const char *words[] = {
+	"the", "quick", "brown", "fox", "jumps", "over", "lazy", "dog", "message",
+	"parser", "content", "header", "boundary", "encoding", "stream", "filter",
+	"charset", "address", "mailbox", "group", "subject", "lorem", "ipsum",
+	"dolor", "sit", "amet", "consectetur", "adipiscing", "elit", "sed", "do",
+	"eiusmod", "tempor", "incididunt", "ut", "labore", "et", "dolore", "magna",
+	"aliqua", "enim", "ad", "minim", "veniam", "quis", "nostrud", "exercitation"
+};
+
+static const char *intl_words[] = {
+	"caf\xc3\xa9", "na\xc3\xafve", "r\xc3\xa9sum\xc3\xa9", "\xc3\xbc" "ber", "Stra\xc3\x9f" "e",
+	"\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82", "\xd0\xbc\xd0\xb8\xd1\x80",
+	"\xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e", "\xe3\x83\xa1\xe3\x83\xbc\xe3\x83\xab",
+	"\xce\xb5\xce\xbb\xce\xbb\xce\xb7\xce\xbd\xce\xb9\xce\xba\xce\xac", "hello", "world"
+};
+
+static const char *names[] = {
+	"Alice", "Bob", "Carol", "Dave", "Eve", "Frank", "Grace", "Heidi", "Ivan",
+	"Judy", "Mallory", "Niaj", "Olivia", "Peggy", "Rupert", "Sybil", "Trent"
+};
+
+static const char *domains[] = {
+	"example.com", "example.org", "example.net", "mail.example.com", "lists.example.org"
+};
+
+static void
+append_printf (GByteArray *array, const char *format, ...)
+{
+	va_list args;
+	char *buf;
+	
+	va_start (args, format);
+	buf = g_strdup_vprintf (format, args);
+	va_end (args);
+	
+	g_byte_array_append (array, (unsigned char *) buf, strlen (buf));
+	g_free (buf);
+}
+
+static void
+append_string (GByteArray *array, const char *str)
+{
+	g_byte_array_append (array, (const unsigned char *) str, strlen (str));
+}
+
+static const char *
+random_word (GRand *rand)
+{
+	return words[g_rand_int_range (rand, 0, G_N_ELEMENTS (words))];
+}
+
+static void
+append_text (GByteArray *array, GRand *rand, size_t size, gboolean eightbit)
+{
+	size_t start = array->len;
+	size_t linelen = 0;
+	const char *word;
+	size_t n;
+	
+	while (array->len - start < size) {
+		if (eightbit && g_rand_int_range (rand, 0, 8) == 0)
+			word = intl_words[g_rand_int_range (rand, 0, G_N_ELEMENTS (intl_words))];
+		else
+			word = random_word (rand);
+		
+		n = strlen (word);
+		
+		if (linelen > 0 && linelen + n + 1 > 72) {
+			g_byte_array_append (array, (unsigned char *) "\n", 1);
+			linelen = 0;
+		} else if (linelen > 0) {
+			g_byte_array_append (array, (unsigned char *) " ", 1);
+			linelen++;
+		}
+		
+		g_byte_array_append (array, (const unsigned char *) word, n);
+		linelen += n;
+	}
+	
+	g_byte_array_append (array, (unsigned char *) "\n", 1);
+}
+
+static void
+append_data (GByteArray *array, GRand *rand, size_t size)
+{
+	guint32 word;
+	size_t i;
+	
+	for (i = 0; i < size; i += 4) {
+		word = g_rand_int (rand);
+		g_byte_array_append (array, (unsigned char *) &word, MIN (4, size - i));
+	}
+}
+
+static char *
+random_mailbox (GRand *rand)
+{
+	const char *name = names[g_rand_int_range (rand, 0, G_N_ELEMENTS (names))];
+	const char *domain = domains[g_rand_int_range (rand, 0, G_N_ELEMENTS (domains))];
+	char *local = g_ascii_strdown (name, -1);
+	char *mailbox;
+	
+	mailbox = g_strdup_printf ("%s %s <%s.%u@%s>", name, random_word (rand), local,
+				   g_rand_int_range (rand, 0, 1000), domain);
+	g_free (local);
+	
+	return mailbox;
+}
+
+static void
+append_envelope (GByteArray *array, GRand *rand, const char *subject)
+{
+	char *from, *to;
+	
+	from = random_mailbox (rand);
+	to = random_mailbox (rand);
+	
+	append_printf (array, "From: %s\n", from);
+	append_printf (array, "To: %s\n", to);
+	append_printf (array, "Subject: %s\n", subject);
+	append_printf (array, "Date: Mon, %u Jan 2018 %02u:%02u:%02u -0500\n",
+		       g_rand_int_range (rand, 1, 29), g_rand_int_range (rand, 0, 24),
+		       g_rand_int_range (rand, 0, 60), g_rand_int_range (rand, 0, 60));
+	append_printf (array, "Message-Id: <%08x.%08x@%s>\n", g_rand_int (rand), g_rand_int (rand),
+		       domains[g_rand_int_range (rand, 0, G_N_ELEMENTS (domains))]);
+	append_string (array, "MIME-Version: 1.0\n");
+	
+	g_free (from);
+	g_free (to);
+}
+
+static void
+generate_headers (GByteArray *array, GRand *rand, guint scale)
+{
+	guint count = HEADER_COUNT * scale;
+	char *mailbox;
+	guint i, j;
+	
+	for (i = 0; i < count / 4; i++) {
+		append_printf (array, "Received: from %s (%s [192.0.2.%u])\n\tby %s with ESMTP id %08x\n\tfor <%s.%u@%s>; Mon, 1 Jan 2018 %02u:00:00 -0500\n",
+			       domains[i % G_N_ELEMENTS (domains)], domains[(i + 1) % G_N_ELEMENTS (domains)],
+			       i % 256, domains[(i + 2) % G_N_ELEMENTS (domains)], g_rand_int (rand),
+			       random_word (rand), i, domains[i % G_N_ELEMENTS (domains)], i % 24);
+	}
+	
+	append_envelope (array, rand, "a message with lots of headers");
+	
+	append_string (array, "Cc: ");
+	for (i = 0; i < count / 4; i++) {
+		mailbox = random_mailbox (rand);
+		append_printf (array, "%s%s", i > 0 ? ",\n\t" : "", mailbox);
+		g_free (mailbox);
+	}
+	append_string (array, "\n");
+	
+	append_string (array, "References:");
+	for (i = 0; i < count / 4; i++)
+		append_printf (array, "\n\t<%08x.%u@%s>", g_rand_int (rand), i, domains[i % G_N_ELEMENTS (domains)]);
+	append_string (array, "\n");
+	
+	for (i = 0; i < count / 4; i++) {
+		append_printf (array, "X-Header-%u:", i);
+		for (j = 0; j < 8; j++)
+			append_printf (array, " %s", random_word (rand));
+		append_string (array, "\n");
+	}
+	
+	append_string (array, "Content-Type: text/plain; charset=us-ascii\n\n");
+	append_text (array, rand, 1024, FALSE);
+}
+
+static void
+generate_nested (GByteArray *array, GRand *rand, guint scale)
+{
+	guint depth = NESTING_DEPTH * scale;
+	guint i;
+	
+	append_envelope (array, rand, "a deeply nested message");
+	append_printf (array, "Content-Type: multipart/mixed; boundary=\"=-level-0\"\n\n");
+	
+	for (i = 0; i < depth; i++) {
+		append_printf (array, "--=-level-%u\n", i);
+		append_string (array, "Content-Type: text/plain; charset=us-ascii\n\n");
+		append_text (array, rand, 512, FALSE);
+		append_printf (array, "--=-level-%u\n", i);
+		
+		if (i + 1 < depth)
+			append_printf (array, "Content-Type: multipart/mixed; boundary=\"=-level-%u\"\n\n", i + 1);
+		else
+			append_string (array, "Content-Type: text/plain; charset=us-ascii\n\n");
+	}
+	
+	append_text (array, rand, 512, FALSE);
+	
+	for (i = depth; i > 0; i--)
+		append_printf (array, "--=-level-%u--\n", i - 1);
+}
+
+static void
+append_attachment_headers (GByteArray *array, GRand *rand, const char *subject, const char *encoding)
+{
+	append_envelope (array, rand, subject);
+	append_string (array, "Content-Type: multipart/mixed; boundary=\"=-attachment\"\n\n");
+	append_string (array, "--=-attachment\nContent-Type: text/plain; charset=us-ascii\n\n");
+	append_text (array, rand, 2048, FALSE);
+	append_string (array, "--=-attachment\n");
+	append_string (array, "Content-Type: application/octet-stream; name=\"data.bin\"\n");
+	append_string (array, "Content-Disposition: attachment; filename=\"data.bin\"\n");
+	
+	if (encoding != NULL)
+		append_printf (array, "Content-Transfer-Encoding: %s\n", encoding);
+	
+	append_string (array, "\n");
+}
+
+static void
+generate_base64 (GByteArray *array, GRand *rand, guint scale)
+{
+	size_t size = ATTACHMENT_SIZE * scale;
+	GByteArray *data;
+	guint32 save = 0;
+	int state = 0;
+	size_t n;
+	
+	data = g_byte_array_new ();
+	append_data (data, rand, size);
+	
+	append_attachment_headers (array, rand, "a base64 attachment", "base64");
+	
+	n = array->len;
+	g_byte_array_set_size (array, n + GMIME_BASE64_ENCODE_LEN (size));
+	n += g_mime_encoding_base64_encode_close (data->data, data->len, array->data + n, &state, &save);
+	g_byte_array_set_size (array, n);
+	
+	append_string (array, "--=-attachment--\n");
+	g_byte_array_free (data, TRUE);
+}
+
+static void
+generate_quoted_printable (GByteArray *array, GRand *rand, guint scale)
+{
+	size_t size = ATTACHMENT_SIZE * scale;
+	GByteArray *text;
+	guint32 save = 0;
+	int state = -1;
+	size_t n;
+	
+	text = g_byte_array_new ();
+	append_text (text, rand, size, TRUE);
+	
+	append_envelope (array, rand, "a quoted-printable message");
+	append_string (array, "Content-Type: text/plain; charset=utf-8\n");
+	append_string (array, "Content-Transfer-Encoding: quoted-printable\n\n");
+	
+	n = array->len;
+	g_byte_array_set_size (array, n + GMIME_QP_ENCODE_LEN (text->len));
+	n += g_mime_encoding_quoted_encode_close (text->data, text->len, array->data + n, &state, &save);
+	g_byte_array_set_size (array, n);
+	
+	g_byte_array_free (text, TRUE);
+}
+
+static void
+generate_uuencode (GByteArray *array, GRand *rand, guint scale)
+{
+	size_t size = ATTACHMENT_SIZE * scale;
+	unsigned char uubuf[60];
+	GByteArray *data;
+	guint32 save = 0;
+	int state = 0;
+	size_t n;
+	
+	data = g_byte_array_new ();
+	append_data (data, rand, size);
+	
+	append_attachment_headers (array, rand, "a uuencoded attachment", "x-uuencode");
+	append_string (array, "begin 0644 data.bin\n");
+	
+	n = array->len;
+	g_byte_array_set_size (array, n + GMIME_UUENCODE_LEN (size));
+	n += g_mime_encoding_uuencode_close (data->data, data->len, array->data + n, uubuf, &state, &save);
+	g_byte_array_set_size (array, n);
+	
+	append_string (array, "end\n--=-attachment--\n");
+	g_byte_array_free (data, TRUE);
+}
+
+static void
+generate_yenc (GByteArray *array, GRand *rand, guint scale)
+{
+	guint32 pcrc = GMIME_YENCODE_CRC_INIT;
+	guint32 crc = GMIME_YENCODE_CRC_INIT;
+	size_t size = ATTACHMENT_SIZE * scale;
+	int state = GMIME_YENCODE_STATE_INIT;
+	GByteArray *data;
+	size_t n;
+	
+	data = g_byte_array_new ();
+	append_data (data, rand, size);
+	
+	/* yEnc has no MIME encoding of its own; it is embedded in a text part */
+	append_attachment_headers (array, rand, "a yEncoded attachment", "8bit");
+	append_printf (array, "=ybegin line=128 size=%lu name=data.bin\n", (unsigned long) size);
+	
+	/* worst case: every byte is escaped, plus a newline every 128 columns */
+	n = array->len;
+	g_byte_array_set_size (array, n + (size * 2) + (size / 64) + 64);
+	n += g_mime_yencode_close (data->data, data->len, array->data + n, &state, &pcrc, &crc);
+	g_byte_array_set_size (array, n);
+	
+	if (array->data[array->len - 1] != '\n')
+		append_string (array, "\n");
+	
+	append_printf (array, "=yend size=%lu crc32=%08x\n--=-attachment--\n",
+		       (unsigned long) size, GMIME_YENCODE_CRC_FINAL (crc));
+	g_byte_array_free (data, TRUE);
+}
+
+static char *
+random_intl_phrase (GRand *rand, guint count)
+{
+	GString *str = g_string_new ("");
+	guint i;
+	
+	for (i = 0; i < count; i++) {
+		if (i > 0)
+			g_string_append_c (str, ' ');
+		
+		if (g_rand_int_range (rand, 0, 2) == 0)
+			g_string_append (str, intl_words[g_rand_int_range (rand, 0, G_N_ELEMENTS (intl_words))]);
+		else
+			g_string_append (str, random_word (rand));
+	}
+	
+	return g_string_free (str, FALSE);
+}
+
+static void
+generate_rfc2047 (GByteArray *array, GRand *rand, guint scale)
+{
+	guint count = HEADER_COUNT * scale;
+	char *phrase, *encoded;
+	guint i;
+	
+	phrase = random_intl_phrase (rand, 12);
+	encoded = g_mime_utils_header_encode_text (NULL, phrase, "utf-8");
+	append_envelope (array, rand, encoded);
+	g_free (encoded);
+	g_free (phrase);
+	
+	append_string (array, "Cc: ");
+	for (i = 0; i < count / 2; i++) {
+		phrase = random_intl_phrase (rand, 2);
+		encoded = g_mime_utils_header_encode_phrase (NULL, phrase, "utf-8");
+		append_printf (array, "%s%s <user%u@%s>", i > 0 ? ",\n\t" : "", encoded, i,
+			       domains[i % G_N_ELEMENTS (domains)]);
+		g_free (encoded);
+		g_free (phrase);
+	}
+	append_string (array, "\n");
+	
+	for (i = 0; i < count / 2; i++) {
+		phrase = random_intl_phrase (rand, 6);
+		encoded = g_mime_utils_header_encode_text (NULL, phrase, "utf-8");
+		append_printf (array, "X-Comment-%u: %s\n", i, encoded);
+		g_free (encoded);
+		g_free (phrase);
+	}
+	
+	append_string (array, "Content-Type: text/plain; charset=utf-8\nContent-Transfer-Encoding: 8bit\n\n");
+	append_text (array, rand, 4096, TRUE);
+}
+
+
+/**
+ * bench_corpus_name:
+ * @type: a #BenchCorpusType
+ *
+ * Gets the name of the corpus, for use in benchmark reports.
+ *
+ * Returns: the name of the corpus.
+ **/
+const char *
+bench_corpus_name (BenchCorpusType type)
+{
+	switch (type) {
+	case BENCH_CORPUS_HEADERS: return "headers";
+	case BENCH_CORPUS_NESTED: return "nested";
+	case BENCH_CORPUS_BASE64: return "base64";
+	case BENCH_CORPUS_QUOTED_PRINTABLE: return "quoted-printable";
+	case BENCH_CORPUS_UUENCODE: return "uuencode";
+	case BENCH_CORPUS_YENC: return "yenc";
+	case BENCH_CORPUS_RFC2047: return "rfc2047";
+	default: return "unknown";
+	}
+}
+
+
+/**
+ * bench_corpus_generate:
+ * @type: a #BenchCorpusType
+ * @seed: random seed
+ * @scale: size multiplier
+ *
+ * Generates a single message of the given @type. At a @scale of 1,
+ * attachments are 256 KB, messages have ~64 headers and multiparts
+ * are nested 16 levels deep.
+ *
+ * Returns: a new byte array containing the raw message.
+ **/
+GByteArray *
+bench_corpus_generate (BenchCorpusType type, guint32 seed, guint scale)
+{
+	GByteArray *array;
+	GRand *rand;
+	
+	rand = g_rand_new_with_seed (seed);
+	array = g_byte_array_new ();
+	
+	switch (type) {
+	case BENCH_CORPUS_HEADERS:
+		generate_headers (array, rand, scale);
+		break;
+	case BENCH_CORPUS_NESTED:
+		generate_nested (array, rand, scale);
+		break;
+	case BENCH_CORPUS_BASE64:
+		generate_base64 (array, rand, scale);
+		break;
+	case BENCH_CORPUS_QUOTED_PRINTABLE:
+		generate_quoted_printable (array, rand, scale);
+		break;
+	case BENCH_CORPUS_UUENCODE:
+		generate_uuencode (array, rand, scale);
+		break;
+	case BENCH_CORPUS_YENC:
+		generate_yenc (array, rand, scale);
+		break;
+	case BENCH_CORPUS_RFC2047:
+		generate_rfc2047 (array, rand, scale);
+		break;
+	default:
+		g_assert_not_reached ();
+	}
+	
+	g_rand_free (rand);
+	
+	return array;
+}
+
+
+/**
+ * bench_corpus_random_text:
+ * @seed: random seed
+ * @size: approximate size of the text
+ *
+ * Generates @size bytes of UTF-8 text wrapped at 72 columns.
+ *
+ * Returns: a new byte array containing the text.
+ **/
+GByteArray *
+bench_corpus_random_text (guint32 seed, size_t size)
+{
+	GByteArray *array = g_byte_array_new ();
+	GRand *rand = g_rand_new_with_seed (seed);
+	
+	append_text (array, rand, size, TRUE);
+	g_rand_free (rand);
+	
+	return array;
+}
+
+
+/**
+ * bench_corpus_random_data:
+ * @seed: random seed
+ * @size: size of the data
+ *
+ * Generates @size bytes of random binary data.
+ *
+ * Returns: a new byte array containing the data.
+ **/
+GByteArray *
+bench_corpus_random_data (guint32 seed, size_t size)
+{
+	GByteArray *array = g_byte_array_new ();
+	GRand *rand = g_rand_new_with_seed (seed);
+	
+	append_data (array, rand, size);
+	g_rand_free (rand);
+	
+	return array;
+}
+
+
+/**
+ * bench_corpus_address_list:
+ * @seed: random seed
+ * @count: number of addresses
+ *
+ * Generates an address list header value with @count mailboxes, a
+ * mix of plain, quoted and rfc2047-encoded names and groups.
+ *
+ * Returns: a newly allocated string.
+ **/
+char *
+bench_corpus_address_list (guint32 seed, guint count)
+{
+	GRand *rand = g_rand_new_with_seed (seed);
+	GString *str = g_string_new ("");
+	char *mailbox, *phrase, *encoded;
+	guint i;
+	
+	for (i = 0; i < count; i++) {
+		if (i > 0)
+			g_string_append (str, ", ");
+		
+		switch (i % 4) {
+		case 0:
+			mailbox = random_mailbox (rand);
+			g_string_append (str, mailbox);
+			g_free (mailbox);
+			break;
+		case 1:
+			g_string_append_printf (str, "\"%s, %s\" <%s@%s>", names[i % G_N_ELEMENTS (names)],
+						random_word (rand), random_word (rand), domains[i % G_N_ELEMENTS (domains)]);
+			break;
+		case 2:
+			phrase = random_intl_phrase (rand, 2);
+			encoded = g_mime_utils_header_encode_phrase (NULL, phrase, "utf-8");
+			g_string_append_printf (str, "%s <user%u@%s>", encoded, i, domains[i % G_N_ELEMENTS (domains)]);
+			g_free (encoded);
+			g_free (phrase);
+			break;
+		default:
+			g_string_append_printf (str, "%s: a%u@%s, b%u@%s;", random_word (rand), i,
+						domains[i % G_N_ELEMENTS (domains)], i, domains[(i + 1) % G_N_ELEMENTS (domains)]);
+			break;
+		}
+	}
+	
+	g_rand_free (rand);
+	
+	return g_string_free (str, FALSE);
+}
+
+
+/**
+ * bench_corpus_write_mbox:
+ * @filename: output file name
+ * @seed: random seed
+ * @size: approximate size of the mbox in bytes
+ * @count: (out): the number of messages written
+ *
+ * Writes an mbox of roughly @size bytes, cycling through a pool of
+ * small messages of every corpus type. This is meant for generating
+ * multi-gigabyte inputs, so the pool is generated once and reused.
+ *
+ * Returns: the number of bytes written or %-1 on error.
+ **/
+gint64
+bench_corpus_write_mbox (const char *filename, guint32 seed, gint64 size, guint *count)
+{
+	GByteArray *pool[BENCH_CORPUS_LAST * 4];
+	gint64 written = 0;
+	guint i, n = 0;
+	FILE *fp;
+	
+	if (!(fp = fopen (filename, "wb")))
+		return -1;
+	
+	for (i = 0; i < G_N_ELEMENTS (pool); i++)
+		pool[i] = bench_corpus_generate (i % BENCH_CORPUS_LAST, seed + i, 1);
+	
+	while (written < size) {
+		GByteArray *message = pool[n % G_N_ELEMENTS (pool)];
+		char marker[64];
+		size_t len;
+		
+		len = g_snprintf (marker, sizeof (marker), "From bench@example.com Mon Jan  1 00:00:%02u 2018\n", n % 60);
+		
+		if (fwrite (marker, 1, len, fp) != len ||
+		    fwrite (message->data, 1, message->len, fp) != message->len ||
+		    fwrite ("\n", 1, 1, fp) != 1) {
+			written = -1;
+			break;
+		}
+		
+		written += len + message->len + 1;
+		n++;
+	}
+	
+	for (i = 0; i < G_N_ELEMENTS (pool); i++)
+		g_byte_array_free (pool[i], TRUE);
+	
+	if (fclose (fp) != 0)
+		written = -1;
+	
+	*count = n;
+	
+	return written;
+}
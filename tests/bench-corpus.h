@@ -0,0 +1,51 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifndef __BENCH_CORPUS_H__
+#define __BENCH_CORPUS_H__
+
+#include <gmime/gmime.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+	BENCH_CORPUS_HEADERS,
+	BENCH_CORPUS_NESTED,
+	BENCH_CORPUS_BASE64,
+	BENCH_CORPUS_QUOTED_PRINTABLE,
+	BENCH_CORPUS_UUENCODE,
+	BENCH_CORPUS_YENC,
+	BENCH_CORPUS_RFC2047,
+	BENCH_CORPUS_LAST
+} BenchCorpusType;
+
+const char *bench_corpus_name (BenchCorpusType type);
+
+GByteArray *bench_corpus_generate (BenchCorpusType type, guint32 seed, guint scale);
+
+GByteArray *bench_corpus_random_text (guint32 seed, size_t size);
+GByteArray *bench_corpus_random_data (guint32 seed, size_t size);
+char *bench_corpus_address_list (guint32 seed, guint count);
+
+gint64 bench_corpus_write_mbox (const char *filename, guint32 seed, gint64 size, guint *count);
+
+G_END_DECLS
+
+#endif /* __BENCH_CORPUS_H__ */
@@ -0,0 +1,761 @@
+/* -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+/*  GMime
+ *  Copyright (C) 2000-2022 Jeffrey Stedfast
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_RESOURCE_H
+#include <sys/resource.h>
+#endif
+
+#include <gmime/gmime.h>
+
+#include "bench-corpus.h"
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif
+
+/* Note: on glibc we can count allocations by interposing malloc() and
+ * friends in the executable; the library (and GLib) will resolve to
+ * these via the PLT. Every allocator entry point has to be covered,
+ * including the aligned ones that GLib uses, or the counts are off.
+ * Elsewhere, allocations are reported as null. */
+#if defined (__GLIBC__)
+#define HAVE_ALLOCATION_COUNTER
+
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void *__libc_memalign (size_t alignment, size_t size);
+extern void *__libc_valloc (size_t size);
+extern void __libc_free (void *ptr);
+
+static guint64 allocations = 0;
+static guint64 frees = 0;
+
+void *
+malloc (size_t size)
+{
+	__atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+	return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+	__atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+	return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+	if (ptr == NULL || size > 0)
+		__atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+	if (ptr != NULL)
+		__atomic_add_fetch (&frees, 1, __ATOMIC_RELAXED);
+	return __libc_realloc (ptr, size);
+}
+
+void *
+memalign (size_t alignment, size_t size)
+{
+	__atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+	return __libc_memalign (alignment, size);
+}
+
+void *
+aligned_alloc (size_t alignment, size_t size)
+{
+	__atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+	return __libc_memalign (alignment, size);
+}
+
+int
+posix_memalign (void **memptr, size_t alignment, size_t size)
+{
+	void *ptr;
+	
+	if (alignment % sizeof (void *) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0)
+		return EINVAL;
+	
+	__atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+	if (!(ptr = __libc_memalign (alignment, size)))
+		return ENOMEM;
+	
+	*memptr = ptr;
+	
+	return 0;
+}
+
+void *
+valloc (size_t size)
+{
+	__atomic_add_fetch (&allocations, 1, __ATOMIC_RELAXED);
+	return __libc_valloc (size);
+}
+
+void
+free (void *ptr)
+{
+	if (ptr != NULL)
+		__atomic_add_fetch (&frees, 1, __ATOMIC_RELAXED);
+	__libc_free (ptr);
+}
+#endif /* __GLIBC__ */
+
+typedef struct {
+	const char *name;
+	gint64 bytes;
+	gint64 messages;
+	gint64 start;
+	gint64 elapsed;
+	guint64 allocations;
+	guint64 frees;
+	int iterations;
+} Bench;
+
+static char *output_file = NULL;
+static char *corpus_dir = NULL;
+static char *only = NULL;
+static double min_time = 1.0;
+static int mbox_size = 256;
+static int seed = 1;
+static int scale = 16;
+
+static GOptionEntry entries[] = {
+	{ "output", 'o', 0, G_OPTION_ARG_FILENAME, &output_file, "Write the JSON report to FILE (default: stdout)", "FILE" },
+	{ "corpus-dir", 'd', 0, G_OPTION_ARG_FILENAME, &corpus_dir, "Directory for the generated mbox (default: tmp/bench)", "DIR" },
+	{ "scale", 's', 0, G_OPTION_ARG_INT, &scale, "Size multiplier for the generated messages (default: 16)", "N" },
+	{ "mbox-size", 'm', 0, G_OPTION_ARG_INT, &mbox_size, "Size of the generated mbox in MB, 0 to skip (default: 256)", "MB" },
+	{ "min-time", 't', 0, G_OPTION_ARG_DOUBLE, &min_time, "Minimum run time of each benchmark in seconds (default: 1.0)", "SECONDS" },
+	{ "seed", 0, 0, G_OPTION_ARG_INT, &seed, "Seed for the corpus generator (default: 1)", "N" },
+	{ "only", 0, 0, G_OPTION_ARG_STRING, &only, "Only run the benchmarks whose name contains STRING", "STRING" },
+	{ NULL }
+};
+
+static FILE *report = NULL;
+static int reported = 0;
+
+/* Note: getrusage() reports the peak RSS over the lifetime of the
+ * process, so it is only reported once, at the end. On Linux, the
+ * high water mark can be reset by writing "5" to /proc/self/clear_refs,
+ * which lets each benchmark report its own peak. */
+static gboolean peak_rss_reset_ok = FALSE;
+
+static void
+peak_rss_reset (void)
+{
+	peak_rss_reset_ok = FALSE;
+	
+#ifdef __linux__
+	int fd;
+	
+	if ((fd = open ("/proc/self/clear_refs", O_WRONLY)) == -1)
+		return;
+	
+	peak_rss_reset_ok = write (fd, "5", 1) == 1;
+	close (fd);
+#endif
+}
+
+static long
+bench_peak_rss (void)
+{
+	char *status, *line;
+	long rss = -1;
+	
+	if (!peak_rss_reset_ok)
+		return -1;
+	
+	if (!g_file_get_contents ("/proc/self/status", &status, NULL, NULL))
+		return -1;
+	
+	if ((line = strstr (status, "\nVmHWM:")))
+		rss = strtol (line + 7, NULL, 10);
+	
+	g_free (status);
+	
+	return rss;
+}
+
+static long
+lifetime_peak_rss (void)
+{
+#if defined (HAVE_SYS_RESOURCE_H) && defined (HAVE_GETRUSAGE)
+	struct rusage usage;
+	
+	if (getrusage (RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+		/* darwin reports bytes rather than kilobytes */
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+	}
+#endif
+	
+	return -1;
+}
+
+static gboolean
+bench_enabled (const char *name)
+{
+	return only == NULL || strstr (name, only) != NULL;
+}
+
+static void
+bench_start (Bench *bench, const char *name)
+{
+	memset (bench, 0, sizeof (Bench));
+	bench->name = name;
+	peak_rss_reset ();
+#ifdef HAVE_ALLOCATION_COUNTER
+	bench->allocations = __atomic_load_n (&allocations, __ATOMIC_RELAXED);
+	bench->frees = __atomic_load_n (&frees, __ATOMIC_RELAXED);
+#endif
+	bench->start = g_get_monotonic_time ();
+}
+
+static gboolean
+bench_again (Bench *bench)
+{
+	gint64 elapsed = g_get_monotonic_time () - bench->start;
+	
+	return bench->iterations < 3 || elapsed < (gint64) (min_time * G_USEC_PER_SEC);
+}
+
+static void
+bench_stop (Bench *bench)
+{
+	double seconds, mb;
+	long rss;
+	
+	bench->elapsed = g_get_monotonic_time () - bench->start;
+#ifdef HAVE_ALLOCATION_COUNTER
+	bench->allocations = __atomic_load_n (&allocations, __ATOMIC_RELAXED) - bench->allocations;
+	bench->frees = __atomic_load_n (&frees, __ATOMIC_RELAXED) - bench->frees;
+#endif
+	
+	seconds = (double) MAX (bench->elapsed, 1) / G_USEC_PER_SEC;
+	mb = (double) bench->bytes / (1024.0 * 1024.0);
+	rss = bench_peak_rss ();
+	
+	fprintf (report, "%s\n    {\"name\": \"%s\", \"iterations\": %d, \"seconds\": %.6f, \"bytes\": %" G_GINT64_FORMAT
+		 ", \"mb_per_sec\": %.3f", reported++ > 0 ? "," : "", bench->name, bench->iterations,
+		 seconds, bench->bytes, mb / seconds);
+	
+	if (bench->messages > 0)
+		fprintf (report, ", \"messages\": %" G_GINT64_FORMAT ", \"messages_per_sec\": %.3f",
+			 bench->messages, (double) bench->messages / seconds);
+	else
+		fputs (", \"messages\": null, \"messages_per_sec\": null", report);
+	
+#ifdef HAVE_ALLOCATION_COUNTER
+	fprintf (report, ", \"allocations\": %" G_GUINT64_FORMAT ", \"allocations_per_iteration\": %.1f"
+		 ", \"frees\": %" G_GUINT64_FORMAT, bench->allocations,
+		 (double) bench->allocations / MAX (bench->iterations, 1), bench->frees);
+#else
+	fputs (", \"allocations\": null, \"allocations_per_iteration\": null, \"frees\": null", report);
+#endif
+	
+	if (rss >= 0)
+		fprintf (report, ", \"peak_rss_kb\": %ld}", rss);
+	else
+		fputs (", \"peak_rss_kb\": null}", report);
+	
+	fflush (report);
+}
+
+static GMimeStream *
+stream_new_with_data (GByteArray *data)
+{
+	GMimeStream *stream;
+	
+	stream = g_mime_stream_mem_new_with_byte_array (data);
+	g_mime_stream_mem_set_owner ((GMimeStreamMem *) stream, FALSE);
+	
+	return stream;
+}
+
+static GMimeMessage *
+parse_message (GMimeStream *stream)
+{
+	GMimeMessage *message;
+	GMimeParser *parser;
+	
+	g_mime_stream_reset (stream);
+	parser = g_mime_parser_new_with_stream (stream);
+	message = g_mime_parser_construct_message (parser, NULL);
+	g_object_unref (parser);
+	
+	return message;
+}
+
+static void
+bench_parser (BenchCorpusType type)
+{
+	const char *corpus = bench_corpus_name (type);
+	char *parse_name, *write_name;
+	GMimeMessage *message;
+	GMimeStream *stream;
+	GMimeStream *null;
+	GByteArray *data;
+	Bench bench;
+	
+	parse_name = g_strdup_printf ("parse/%s", corpus);
+	write_name = g_strdup_printf ("write/%s", corpus);
+	
+	if (!bench_enabled (parse_name) && !bench_enabled (write_name))
+		goto done;
+	
+	data = bench_corpus_generate (type, seed, scale);
+	stream = stream_new_with_data (data);
+	
+	if (bench_enabled (parse_name)) {
+		bench_start (&bench, parse_name);
+		do {
+			message = parse_message (stream);
+			g_object_unref (message);
+			bench.bytes += data->len;
+			bench.messages++;
+			bench.iterations++;
+		} while (bench_again (&bench));
+		bench_stop (&bench);
+	}
+	
+	if (bench_enabled (write_name)) {
+		message = parse_message (stream);
+		null = g_mime_stream_null_new ();
+		
+		bench_start (&bench, write_name);
+		do {
+			g_mime_stream_reset (null);
+			bench.bytes += g_mime_object_write_to_stream ((GMimeObject *) message, NULL, null);
+			bench.messages++;
+			bench.iterations++;
+		} while (bench_again (&bench));
+		bench_stop (&bench);
+		
+		g_object_unref (message);
+		g_object_unref (null);
+	}
+	
+	g_object_unref (stream);
+	g_byte_array_free (data, TRUE);
+	
+ done:
+	g_free (parse_name);
+	g_free (write_name);
+}
+
+static void
+bench_encoding (GMimeContentEncoding encoding, GByteArray *data)
+{
+	const char *encname = g_mime_content_encoding_to_string (encoding);
+	char *encode_name, *decode_name;
+	GMimeEncoding state;
+	size_t outlen, n;
+	Bench bench;
+	char *outbuf;
+	
+	encode_name = g_strdup_printf ("encode/%s", encname);
+	decode_name = g_strdup_printf ("decode/%s", encname);
+	
+	if (!bench_enabled (encode_name) && !bench_enabled (decode_name))
+		goto done;
+	
+	g_mime_encoding_init_encode (&state, encoding);
+	outbuf = g_malloc (g_mime_encoding_outlen (&state, data->len));
+	outlen = g_mime_encoding_flush (&state, (const char *) data->data, data->len, outbuf);
+	
+	if (bench_enabled (encode_name)) {
+		char *buf = g_malloc (g_mime_encoding_outlen (&state, data->len));
+		
+		bench_start (&bench, encode_name);
+		do {
+			g_mime_encoding_reset (&state);
+			g_mime_encoding_flush (&state, (const char *) data->data, data->len, buf);
+			bench.bytes += data->len;
+			bench.iterations++;
+		} while (bench_again (&bench));
+		bench_stop (&bench);
+		
+		g_free (buf);
+	}
+	
+	if (bench_enabled (decode_name)) {
+		char *buf;
+		
+		g_mime_encoding_init_decode (&state, encoding);
+		buf = g_malloc (g_mime_encoding_outlen (&state, outlen));
+		
+		bench_start (&bench, decode_name);
+		do {
+			g_mime_encoding_reset (&state);
+			n = g_mime_encoding_step (&state, outbuf, outlen, buf);
+			bench.bytes += outlen;
+			bench.iterations++;
+		} while (bench_again (&bench));
+		bench_stop (&bench);
+		
+		if (n != data->len || memcmp (buf, data->data, n) != 0)
+			g_warning ("%s: decoded data does not match the original", decode_name);
+		
+		g_free (buf);
+	}
+	
+	g_free (outbuf);
+	
+ done:
+	g_free (encode_name);
+	g_free (decode_name);
+}
+
+static void
+bench_yenc (GByteArray *data)
+{
+	guint32 pcrc, crc;
+	unsigned char *outbuf, *buf;
+	size_t outlen, n;
+	Bench bench;
+	int state;
+	
+	if (!bench_enabled ("encode/yenc") && !bench_enabled ("decode/yenc"))
+		return;
+	
+	/* worst case: every byte is escaped, plus a newline every 128 columns */
+	outbuf = g_malloc ((data->len * 2) + (data->len / 64) + 64);
+	buf = g_malloc ((data->len * 2) + (data->len / 64) + 64);
+	
+	state = GMIME_YENCODE_STATE_INIT;
+	pcrc = crc = GMIME_YENCODE_CRC_INIT;
+	outlen = g_mime_yencode_close (data->data, data->len, outbuf, &state, &pcrc, &crc);
+	
+	if (bench_enabled ("encode/yenc")) {
+		bench_start (&bench, "encode/yenc");
+		do {
+			state = GMIME_YENCODE_STATE_INIT;
+			pcrc = crc = GMIME_YENCODE_CRC_INIT;
+			g_mime_yencode_close (data->data, data->len, buf, &state, &pcrc, &crc);
+			bench.bytes += data->len;
+			bench.iterations++;
+		} while (bench_again (&bench));
+		bench_stop (&bench);
+	}
+	
+	if (bench_enabled ("decode/yenc")) {
+		bench_start (&bench, "decode/yenc");
+		do {
+			state = GMIME_YDECODE_STATE_INIT;
+			pcrc = crc = GMIME_YENCODE_CRC_INIT;
+			n = g_mime_ydecode_step (outbuf, outlen, buf, &state, &pcrc, &crc);
+			bench.bytes += outlen;
+			bench.iterations++;
+		} while (bench_again (&bench));
+		bench_stop (&bench);
+		
+		if (n != data->len || memcmp (buf, data->data, n) != 0)
+			g_warning ("decode/yenc: decoded data does not match the original");
+	}
+	
+	g_free (outbuf);
+	g_free (buf);
+}
+
+static void
+bench_filter (const char *name, GMimeFilter *filter, GByteArray *data)
+{
+	GMimeStream *stream, *null;
+	size_t nwritten, n;
+	Bench bench;
+	
+	if (!bench_enabled (name)) {
+		g_object_unref (filter);
+		return;
+	}
+	
+	null = g_mime_stream_null_new ();
+	stream = g_mime_stream_filter_new (null);
+	g_mime_stream_filter_add ((GMimeStreamFilter *) stream, filter);
+	g_object_unref (filter);
+	g_object_unref (null);
+	
+	bench_start (&bench, name);
+	do {
+		/* write in chunks, the way the library writes content */
+		for (nwritten = 0; nwritten < data->len; nwritten += n) {
+			n = MIN (4096, data->len - nwritten);
+			g_mime_stream_write (stream, (const char *) data->data + nwritten, n);
+		}
+		
+		g_mime_stream_flush (stream);
+		g_mime_stream_reset (stream);
+		bench.bytes += data->len;
+		bench.iterations++;
+	} while (bench_again (&bench));
+	bench_stop (&bench);
+	
+	g_object_unref (stream);
+}
+
+static void
+bench_charset (const char *name, const char *from, const char *to, GByteArray *data)
+{
+	Bench bench;
+	iconv_t cd;
+	char *out;
+	
+	if (!bench_enabled (name))
+		return;
+	
+	if ((cd = g_mime_iconv_open (to, from)) == (iconv_t) -1) {
+		g_warning ("%s: cannot convert from %s to %s", name, from, to);
+		return;
+	}
+	
+	bench_start (&bench, name);
+	do {
+		out = g_mime_iconv_strndup (cd, (const char *) data->data, data->len);
+		g_free (out);
+		bench.bytes += data->len;
+		bench.iterations++;
+	} while (bench_again (&bench));
+	bench_stop (&bench);
+	
+	g_mime_iconv_close (cd);
+}
+
+static void
+bench_addresses (void)
+{
+	InternetAddressList *list;
+	Bench bench;
+	size_t len;
+	char *str;
+	
+	if (!bench_enabled ("parse/addresses"))
+		return;
+	
+	str = bench_corpus_address_list (seed, 64 * scale);
+	len = strlen (str);
+	
+	bench_start (&bench, "parse/addresses");
+	do {
+		list = internet_address_list_parse (NULL, str);
+		g_object_unref (list);
+		bench.bytes += len;
+		bench.messages++;
+		bench.iterations++;
+	} while (bench_again (&bench));
+	bench_stop (&bench);
+	
+	g_free (str);
+}
+
+static void
+bench_params (void)
+{
+	static const char *names[] = {
+		"boundary", "charset", "Name", "FILENAME", "x-mac-type", "x-unknown"
+	};
+	GMimeParamList *list;
+	Bench bench;
+	guint i;
+	
+	if (!bench_enabled ("lookup/params"))
+		return;
+	
+	/* a list the size of a busy Content-Type or Content-Disposition,
+	 * with the well-known names last so a lookup has to scan */
+	list = g_mime_param_list_parse (NULL, "x-mac-type=\"54455854\"; x-mac-creator=\"4D535744\"; "
+					"x-unix-mode=0644; size=4096; creation-date=\"Mon, 1 Jan 2001 00:00:00 GMT\"; "
+					"format=flowed; delsp=yes; name=\"report.txt\"; filename=\"report.txt\"; "
+					"charset=utf-8; boundary=\"=-abcdefghijklmnop\"");
+	
+	bench_start (&bench, "lookup/params");
+	do {
+		for (i = 0; i < 1024; i++) {
+			g_mime_param_list_get_parameter (list, names[i % G_N_ELEMENTS (names)]);
+			bench.messages++;
+		}
+		
+		bench.iterations++;
+	} while (bench_again (&bench));
+	bench_stop (&bench);
+	
+	g_object_unref (list);
+}
+
+static void
+bench_mbox (void)
+{
+	GMimeMessage *message;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	char *filename;
+	Bench bench;
+	guint count;
+	gint64 size;
+	int fd;
+	
+	if (mbox_size <= 0 || !bench_enabled ("parse/mbox"))
+		return;
+	
+	if (g_mkdir_with_parents (corpus_dir, 0755) == -1) {
+		g_warning ("cannot create %s: %s", corpus_dir, g_strerror (errno));
+		return;
+	}
+	
+	filename = g_build_filename (corpus_dir, "bench.mbox", NULL);
+	
+	if ((size = bench_corpus_write_mbox (filename, seed, (gint64) mbox_size * 1024 * 1024, &count)) == -1) {
+		g_warning ("cannot write %s: %s", filename, g_strerror (errno));
+		g_free (filename);
+		return;
+	}
+	
+	if ((fd = open (filename, O_RDONLY | O_BINARY, 0)) == -1) {
+		g_warning ("cannot open %s: %s", filename, g_strerror (errno));
+		g_free (filename);
+		return;
+	}
+	
+	stream = g_mime_stream_fs_new (fd);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_mime_parser_set_format (parser, GMIME_FORMAT_MBOX);
+	g_object_unref (stream);
+	
+	/* a single pass over the whole mbox; this is meant to be big */
+	bench_start (&bench, "parse/mbox");
+	while (!g_mime_parser_eos (parser)) {
+		if (!(message = g_mime_parser_construct_message (parser, NULL)))
+			break;
+		
+		g_object_unref (message);
+		bench.messages++;
+	}
+	bench.bytes = size;
+	bench.iterations = 1;
+	bench_stop (&bench);
+	
+	if (bench.messages != count)
+		g_warning ("parse/mbox: parsed %" G_GINT64_FORMAT " messages, expected %u", bench.messages, count);
+	
+	g_object_unref (parser);
+	unlink (filename);
+	g_free (filename);
+}
+
+int main (int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *err = NULL;
+	GByteArray *data;
+	GByteArray *text;
+	long rss;
+	guint i;
+	
+	context = g_option_context_new ("- run the GMime benchmarks");
+	g_option_context_add_main_entries (context, entries, NULL);
+	
+	if (!g_option_context_parse (context, &argc, &argv, &err)) {
+		fprintf (stderr, "%s: %s\n", argv[0], err->message);
+		g_option_context_free (context);
+		g_error_free (err);
+		return EXIT_FAILURE;
+	}
+	
+	g_option_context_free (context);
+	
+	if (scale < 1)
+		scale = 1;
+	
+	if (corpus_dir == NULL)
+		corpus_dir = g_build_filename ("tmp", "bench", NULL);
+	
+	if (output_file != NULL) {
+		if (!(report = fopen (output_file, "w"))) {
+			fprintf (stderr, "%s: cannot open %s: %s\n", argv[0], output_file, g_strerror (errno));
+			return EXIT_FAILURE;
+		}
+	} else {
+		report = stdout;
+	}
+	
+	g_mime_init ();
+	
+	fprintf (report, "{\n  \"version\": \"%u.%u.%u\",\n  \"seed\": %d,\n  \"scale\": %d,\n  \"benchmarks\": [",
+		 gmime_major_version, gmime_minor_version, gmime_micro_version, seed, scale);
+	
+	for (i = 0; i < BENCH_CORPUS_LAST; i++)
+		bench_parser (i);
+	
+	data = bench_corpus_random_data (seed, 256 * 1024 * scale);
+	text = bench_corpus_random_text (seed, 256 * 1024 * scale);
+	
+	bench_encoding (GMIME_CONTENT_ENCODING_BASE64, data);
+	bench_encoding (GMIME_CONTENT_ENCODING_QUOTEDPRINTABLE, text);
+	bench_encoding (GMIME_CONTENT_ENCODING_UUENCODE, data);
+	bench_yenc (data);
+	
+	bench_filter ("filter/unix2dos", g_mime_filter_unix2dos_new (FALSE), text);
+	bench_filter ("filter/dos2unix", g_mime_filter_dos2unix_new (FALSE), text);
+	bench_filter ("filter/base64", g_mime_filter_basic_new (GMIME_CONTENT_ENCODING_BASE64, TRUE), data);
+	bench_filter ("filter/charset", g_mime_filter_charset_new ("utf-8", "utf-16"), text);
+	
+	bench_charset ("charset/utf-8-to-utf-16", "utf-8", "utf-16", text);
+	bench_charset ("charset/iso-8859-1-to-utf-8", "iso-8859-1", "utf-8", text);
+	
+	bench_addresses ();
+	
+	bench_params ();
+	
+	bench_mbox ();
+	
+	if ((rss = lifetime_peak_rss ()) >= 0)
+		fprintf (report, "\n  ],\n  \"peak_rss_kb\": %ld\n}\n", rss);
+	else
+		fputs ("\n  ],\n  \"peak_rss_kb\": null\n}\n", report);
+	
+	g_byte_array_free (data, TRUE);
+	g_byte_array_free (text, TRUE);
+	
+	g_mime_shutdown ();
+	
+	if (report != stdout)
+		fclose (report);
+	
+	g_free (corpus_dir);
+	g_free (output_file);
+	g_free (only);
+	
+	return EXIT_SUCCESS;
+}
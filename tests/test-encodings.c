@@ -504,6 +504,109 @@ error:
 	g_byte_array_free (actual, TRUE);
 }
 
+/* worst case: every byte escaped plus a newline for every 64 input bytes */
+#define YENCODE_LEN(x) ((x) * 2 + (x) / 64 + 64)
+
+/* a straightforward byte-at-a-time yEnc encoder to compare against */
+static size_t
+yencode_reference (const unsigned char *inbuf, size_t inlen, unsigned char *outbuf, int *state)
+{
+	unsigned char *outptr = outbuf;
+	int already = *state;
+	unsigned char c;
+	size_t i;
+	
+	for (i = 0; i < inlen; i++) {
+		c = inbuf[i] + 42;
+		
+		if (c == '\0' || c == '\t' || c == '\r' || c == '\n' || c == '=') {
+			*outptr++ = '=';
+			*outptr++ = c + 64;
+			already += 2;
+		} else {
+			*outptr++ = c;
+			already++;
+		}
+		
+		if (already >= 128) {
+			*outptr++ = '\n';
+			already = 0;
+		}
+	}
+	
+	*state = already;
+	
+	return outptr - outbuf;
+}
+
+static void
+test_yenc_crc (void)
+{
+	const char *input = "123456789";
+	guint32 pcrc, crc;
+	char output[64];
+	int state;
+	
+	testsuite_check ("yEnc crc32 check value");
+	
+	state = GMIME_YENCODE_STATE_INIT;
+	pcrc = crc = GMIME_YENCODE_CRC_INIT;
+	g_mime_yencode_close ((const unsigned char *) input, strlen (input), (unsigned char *) output, &state, &pcrc, &crc);
+	
+	if (GMIME_YENCODE_CRC_FINAL (pcrc) != 0xcbf43926 || GMIME_YENCODE_CRC_FINAL (crc) != 0xcbf43926)
+		testsuite_check_failed ("failed: expected 0xcbf43926, got 0x%08x", GMIME_YENCODE_CRC_FINAL (pcrc));
+	else
+		testsuite_check_passed ();
+}
+
+static void
+test_yenc (GByteArray *photo, size_t size)
+{
+	guint32 epcrc = GMIME_YENCODE_CRC_INIT, ecrc = GMIME_YENCODE_CRC_INIT;
+	guint32 dpcrc = GMIME_YENCODE_CRC_INIT, dcrc = GMIME_YENCODE_CRC_INIT;
+	GByteArray *expected, *encoded, *decoded;
+	int rstate = 0, estate = 0, dstate = 0;
+	size_t n, i;
+	
+	testsuite_check ("yEnc encode/decode; buffer-size=%zu", size);
+	
+	expected = g_byte_array_sized_new (YENCODE_LEN (photo->len));
+	g_byte_array_set_size (expected, YENCODE_LEN (photo->len));
+	n = yencode_reference (photo->data, photo->len, expected->data, &rstate);
+	if (rstate != 0)
+		expected->data[n++] = '\n';
+	g_byte_array_set_size (expected, n);
+	
+	/* encode in chunks of @size bytes */
+	encoded = g_byte_array_sized_new (YENCODE_LEN (photo->len));
+	g_byte_array_set_size (encoded, YENCODE_LEN (photo->len));
+	for (i = 0, n = 0; i + size < photo->len; i += size)
+		n += g_mime_yencode_step (photo->data + i, size, encoded->data + n, &estate, &epcrc, &ecrc);
+	n += g_mime_yencode_close (photo->data + i, photo->len - i, encoded->data + n, &estate, &epcrc, &ecrc);
+	g_byte_array_set_size (encoded, n);
+	
+	/* decode in chunks of @size bytes */
+	decoded = g_byte_array_sized_new (encoded->len);
+	g_byte_array_set_size (decoded, encoded->len);
+	for (i = 0, n = 0; i < encoded->len; i += size)
+		n += g_mime_ydecode_step (encoded->data + i, MIN (size, encoded->len - i), decoded->data + n, &dstate, &dpcrc, &dcrc);
+	g_byte_array_set_size (decoded, n);
+	
+	if (encoded->len != expected->len || memcmp (encoded->data, expected->data, encoded->len) != 0)
+		testsuite_check_failed ("yEnc encoding failed: encoded content does not match");
+	else if (decoded->len != photo->len || memcmp (decoded->data, photo->data, photo->len) != 0)
+		testsuite_check_failed ("yEnc decoding failed: decoded content does not match");
+	else if (epcrc != ecrc || dpcrc != dcrc || epcrc != dpcrc)
+		testsuite_check_failed ("yEnc crc mismatch: encoded=0x%08x; decoded=0x%08x",
+					GMIME_YENCODE_CRC_FINAL (epcrc), GMIME_YENCODE_CRC_FINAL (dpcrc));
+	else
+		testsuite_check_passed ();
+	
+	g_byte_array_free (expected, TRUE);
+	g_byte_array_free (encoded, TRUE);
+	g_byte_array_free (decoded, TRUE);
+}
+
 int main (int argc, char **argv)
 {
 	const char *datadir = "data/encodings";
@@ -574,6 +677,14 @@ int main (int argc, char **argv)
 	test_decoder (GMIME_CONTENT_ENCODING_UUENCODE, uu, photo, 1);
 	testsuite_end ();
 	
+	testsuite_start ("yEnc");
+	test_yenc_crc ();
+	test_yenc (photo, 4096);
+	test_yenc (photo, 1024);
+	test_yenc (photo, 16);
+	test_yenc (photo, 1);
+	testsuite_end ();
+	
 	testsuite_start ("quoted-printable");
 	test_quoted_printable_decode_patterns ();
 	test_quoted_printable_encode_space_dos_linebreak ();
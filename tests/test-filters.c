@@ -428,6 +428,153 @@ error:
 	g_byte_array_free (actual, TRUE);
 }
 
+static const char line_endings_input[] = ".start\r\nline\n.dot\r\r\nmid\rx\n..\n.end";
+
+static char *
+filter_in_chunks (GMimeFilter *filter, const char *input, size_t size)
+{
+	size_t inlen = strlen (input);
+	size_t outlen, outprespace, n;
+	GString *output;
+	char *outbuf;
+	size_t i;
+	
+	output = g_string_new ("");
+	
+	for (i = 0; i + size < inlen; i += size) {
+		g_mime_filter_filter (filter, (char *) input + i, size, 0, &outbuf, &outlen, &outprespace);
+		g_string_append_len (output, outbuf, outlen);
+	}
+	
+	n = inlen - i;
+	g_mime_filter_complete (filter, (char *) input + i, n, 0, &outbuf, &outlen, &outprespace);
+	g_string_append_len (output, outbuf, outlen);
+	
+	return g_string_free (output, FALSE);
+}
+
+static void
+test_line_endings (GMimeFilter *filter, const char *what, const char *expected)
+{
+	size_t sizes[] = { 1, 2, 3, 7, 4096 };
+	char *actual;
+	guint i;
+	
+	testsuite_check ("%s", what);
+	
+	for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+		g_mime_filter_reset (filter);
+		actual = filter_in_chunks (filter, line_endings_input, sizes[i]);
+		
+		if (strcmp (actual, expected) != 0) {
+			testsuite_check_failed ("%s failed with buffer-size=%zu", what, sizes[i]);
+			g_free (actual);
+			goto done;
+		}
+		
+		g_free (actual);
+	}
+	
+	testsuite_check_passed ();
+	
+done:
+	g_object_unref (filter);
+}
+
+static GMimeStream *
+base64_dos2unix_stream_new (GMimeStream *source)
+{
+	GMimeStream *stream;
+	GMimeFilter *filter;
+	
+	stream = g_mime_stream_filter_new (source);
+	
+	filter = g_mime_filter_basic_new (GMIME_CONTENT_ENCODING_BASE64, FALSE);
+	g_mime_stream_filter_add ((GMimeStreamFilter *) stream, filter);
+	g_object_unref (filter);
+	
+	filter = g_mime_filter_dos2unix_new (TRUE);
+	g_mime_stream_filter_add ((GMimeStreamFilter *) stream, filter);
+	g_object_unref (filter);
+	
+	return stream;
+}
+
+static void
+test_stream_filter_block_sizes (const char *expected)
+{
+	const char *what = "GMimeStreamFilter (base64 + dos2unix)";
+	size_t sizes[] = { 1, 2, 3, 7, 4096, 64 * 1024 };
+	GMimeStream *source, *stream, *output;
+	GByteArray *array;
+	size_t inlen, i, n;
+	char *encoded, *saved;
+	
+	testsuite_check ("%s", what);
+	
+	encoded = g_base64_encode ((const guchar *) line_endings_input, strlen (line_endings_input));
+	inlen = strlen (encoded);
+	saved = g_strndup (encoded, inlen);
+	
+	for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+		/* read: the stream owns the buffer, so the filters work in place */
+		source = g_mime_stream_mem_new_with_buffer (encoded, inlen);
+		stream = base64_dos2unix_stream_new (source);
+		g_mime_stream_filter_set_block_size ((GMimeStreamFilter *) stream, sizes[i]);
+		g_object_unref (source);
+		
+		if (g_mime_stream_filter_get_block_size ((GMimeStreamFilter *) stream) != sizes[i]) {
+			testsuite_check_failed ("%s failed: block size was not set to %zu", what, sizes[i]);
+			g_object_unref (stream);
+			goto done;
+		}
+		
+		output = g_mime_stream_mem_new ();
+		g_mime_stream_write_to_stream (stream, output);
+		g_object_unref (stream);
+		
+		array = g_mime_stream_mem_get_byte_array ((GMimeStreamMem *) output);
+		if (array->len != strlen (expected) || memcmp (array->data, expected, array->len) != 0) {
+			testsuite_check_failed ("%s failed reading with block-size=%zu", what, sizes[i]);
+			g_object_unref (output);
+			goto done;
+		}
+		
+		g_object_unref (output);
+		
+		/* write: the caller's buffer must be left untouched */
+		output = g_mime_stream_mem_new ();
+		stream = base64_dos2unix_stream_new (output);
+		
+		for (n = 0; n < inlen; n += sizes[i])
+			g_mime_stream_write (stream, encoded + n, MIN (sizes[i], inlen - n));
+		
+		g_mime_stream_flush (stream);
+		g_object_unref (stream);
+		
+		if (memcmp (encoded, saved, inlen) != 0) {
+			testsuite_check_failed ("%s failed: writing %zu bytes at a time modified the caller's buffer", what, sizes[i]);
+			g_object_unref (output);
+			goto done;
+		}
+		
+		array = g_mime_stream_mem_get_byte_array ((GMimeStreamMem *) output);
+		if (array->len != strlen (expected) || memcmp (array->data, expected, array->len) != 0) {
+			testsuite_check_failed ("%s failed writing %zu bytes at a time", what, sizes[i]);
+			g_object_unref (output);
+			goto done;
+		}
+		
+		g_object_unref (output);
+	}
+	
+	testsuite_check_passed ();
+	
+done:
+	g_free (encoded);
+	g_free (saved);
+}
+
 static void
 test_windows (const char *datadir, const char *filename, const char *claimed, const char *expected)
 {
@@ -515,6 +662,15 @@ int main (int argc, char **argv)
 	
 	test_smtp_data (datadir, "smtp-input.txt", "smtp-output.txt");
 	
+	test_line_endings (g_mime_filter_unix2dos_new (TRUE), "GMimeFilterUnix2Dos",
+			   ".start\r\nline\r\n.dot\r\r\nmid\rx\r\n..\r\n.end\r\n");
+	test_line_endings (g_mime_filter_dos2unix_new (TRUE), "GMimeFilterDos2Unix",
+			   ".start\nline\n.dot\r\nmid\rx\n..\n.end\n");
+	test_line_endings (g_mime_filter_smtp_data_new (), "GMimeFilterSmtpData (chunked)",
+			   "..start\r\nline\n..dot\r\r\nmid\rx\n...\n..end");
+	
+	test_stream_filter_block_sizes (".start\nline\n.dot\r\nmid\rx\n..\n.end\n");
+	
 	test_windows (datadir, "french-fable.cp1252.txt", "iso-8859-1", "windows-cp1252");
 	
 	testsuite_end ();
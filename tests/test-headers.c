@@ -26,6 +26,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "testsuite.h"
 
@@ -597,6 +598,172 @@ test_header_formatting (void)
 	g_object_unref (list);
 }
 
+static const char verbatim_message[] =
+	"From: sender@example.com\n"
+	"To: recipient@example.com\n"
+	"Subject: verbatim passthrough\n"
+	"MIME-Version: 1.0\n"
+	"Content-Type: multipart/mixed; boundary=\"boundary\"\n"
+	"\n"
+	"This is the prologue.\n"
+	"--boundary\n"
+	"Content-Type: text/plain\n"
+	"\n"
+	"CRLF line endings\r\n"
+	"are left alone\r\n"
+	"--boundary--\n"
+	"This is the epilogue.\n";
+
+static char *
+write_verbatim (GMimeObject *object, size_t *length)
+{
+	GMimeFormatOptions *format;
+	GMimeStream *stream;
+	GByteArray *buffer;
+	char *text;
+	
+	format = g_mime_format_options_new ();
+	g_mime_format_options_set_verbatim (format, TRUE);
+	
+	stream = g_mime_stream_mem_new ();
+	g_mime_object_write_to_stream (object, format, stream);
+	buffer = g_mime_stream_mem_get_byte_array ((GMimeStreamMem *) stream);
+	text = g_strndup ((char *) buffer->data, buffer->len);
+	*length = buffer->len;
+	
+	g_mime_format_options_free (format);
+	g_object_unref (stream);
+	
+	return text;
+}
+
+static void
+test_verbatim_write (void)
+{
+	size_t inlen = sizeof (verbatim_message) - 1;
+	GMimeMessage *message;
+	GMimeMultipart *multipart;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	GMimePart *part;
+	char *text;
+	size_t n;
+	
+	stream = g_mime_stream_mem_new_with_buffer (verbatim_message, inlen);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_mime_parser_set_persist_stream (parser, TRUE);
+	g_object_unref (stream);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	g_object_unref (parser);
+	
+	testsuite_check ("unmodified message");
+	try {
+		text = write_verbatim ((GMimeObject *) message, &n);
+		if (n != inlen || memcmp (text, verbatim_message, inlen) != 0)
+			throw (exception_new ("output does not match the input:\n%s", text));
+		g_free (text);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("unmodified message: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("added message header");
+	try {
+		g_mime_object_prepend_header ((GMimeObject *) message, "X-Milter", "yes", NULL);
+		
+		text = write_verbatim ((GMimeObject *) message, &n);
+		if (n != inlen + 14 || strncmp (text, "X-Milter: yes\n", 14) != 0 ||
+		    memcmp (text + 14, verbatim_message, inlen) != 0)
+			throw (exception_new ("unexpected output:\n%s", text));
+		g_free (text);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("added message header: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("modified subpart");
+	try {
+		multipart = (GMimeMultipart *) g_mime_message_get_mime_part (message);
+		part = (GMimePart *) g_mime_multipart_get_part (multipart, 0);
+		g_mime_part_set_content_description (part, "modified");
+		
+		text = write_verbatim ((GMimeObject *) message, &n);
+		if (!strstr (text, "Content-Description: modified\n"))
+			throw (exception_new ("modified header not written:\n%s", text));
+		
+		/* the content of the subpart itself should still be copied verbatim */
+		if (!strstr (text, "\nCRLF line endings\r\nare left alone\r\n--boundary--\n"))
+			throw (exception_new ("content not written verbatim:\n%s", text));
+		g_free (text);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("modified subpart: %s", ex->message);
+	} finally;
+	
+	g_object_unref (message);
+	
+	stream = g_mime_stream_mem_new_with_buffer (verbatim_message, inlen);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_mime_parser_set_persist_stream (parser, TRUE);
+	g_object_unref (stream);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	g_object_unref (parser);
+	
+	testsuite_check ("replaced subpart stream");
+	try {
+		multipart = (GMimeMultipart *) g_mime_message_get_mime_part (message);
+		part = (GMimePart *) g_mime_multipart_get_part (multipart, 0);
+		
+		stream = g_mime_stream_mem_new_with_buffer ("replaced\n", 9);
+		g_mime_data_wrapper_set_stream (g_mime_part_get_content (part), stream);
+		g_object_unref (stream);
+		
+		text = write_verbatim ((GMimeObject *) message, &n);
+		if (!strstr (text, "\nreplaced\n--boundary--\n"))
+			throw (exception_new ("replaced content not written:\n%s", text));
+		g_free (text);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("replaced subpart stream: %s", ex->message);
+	} finally;
+	
+	g_object_unref (message);
+	
+	stream = g_mime_stream_mem_new_with_buffer (verbatim_message, inlen);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_mime_parser_set_persist_stream (parser, TRUE);
+	g_object_unref (stream);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	g_object_unref (parser);
+	
+	testsuite_check ("replaced subpart encoding");
+	try {
+		multipart = (GMimeMultipart *) g_mime_message_get_mime_part (message);
+		part = (GMimePart *) g_mime_multipart_get_part (multipart, 0);
+		
+		/* the content now gets decoded as base64 when written */
+		g_mime_data_wrapper_set_encoding (g_mime_part_get_content (part), GMIME_CONTENT_ENCODING_BASE64);
+		
+		text = write_verbatim ((GMimeObject *) message, &n);
+		if (strstr (text, "\nCRLF line endings\r\nare left alone\r\n--boundary--\n"))
+			throw (exception_new ("stale content written:\n%s", text));
+		g_free (text);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("replaced subpart encoding: %s", ex->message);
+	} finally;
+	
+	g_object_unref (message);
+}
+
 int main (int argc, char **argv)
 {
 	g_mime_init ();
@@ -625,6 +792,10 @@ int main (int argc, char **argv)
 	test_header_formatting ();
 	testsuite_end ();
 	
+	testsuite_start ("verbatim writing");
+	test_verbatim_write ();
+	testsuite_end ();
+	
 	g_mime_shutdown ();
 	
 	return testsuite_exit ();
@@ -132,13 +132,341 @@ test_utils (void)
 	testsuite_end ();
 }
 
+static char *
+filter_convert (const char *from, const char *to, const char *text)
+{
+	GMimeStream *stream, *filtered;
+	GMimeFilter *filter;
+	GByteArray *array;
+	char *result;
+	
+	if (!(filter = g_mime_filter_charset_new (from, to)))
+		return NULL;
+	
+	stream = g_mime_stream_mem_new ();
+	filtered = g_mime_stream_filter_new (stream);
+	g_mime_stream_filter_add ((GMimeStreamFilter *) filtered, filter);
+	g_object_unref (filter);
+	
+	g_mime_stream_write_string (filtered, text);
+	g_mime_stream_flush (filtered);
+	g_object_unref (filtered);
+	
+	array = g_mime_stream_mem_get_byte_array ((GMimeStreamMem *) stream);
+	result = g_strndup ((char *) array->data, array->len);
+	g_object_unref (stream);
+	
+	return result;
+}
+
+static void
+test_filter (void)
+{
+	char *expected, *actual;
+	iconv_t cd;
+	int i;
+	
+	testsuite_start ("charset conversion filter");
+	
+	for (i = 0; i < G_N_ELEMENTS (tests); i++) {
+		testsuite_check ("test #%d: %s to UTF-8 and back", i, tests[i].charset);
+		
+		try {
+			/* the filter may use a built-in converter, but must match iconv */
+			if ((cd = g_mime_iconv_open ("UTF-8", tests[i].charset)) == (iconv_t) -1) {
+				throw (exception_new ("could not open conversion for %s to UTF-8",
+						      tests[i].charset));
+			}
+			
+			expected = g_mime_iconv_strdup (cd, tests[i].text);
+			g_mime_iconv_close (cd);
+			
+			if (!(actual = filter_convert (tests[i].charset, "UTF-8", tests[i].text))) {
+				g_free (expected);
+				
+				throw (exception_new ("could not create a filter for %s to UTF-8",
+						      tests[i].charset));
+			}
+			
+			if (strcmp (expected, actual) != 0) {
+				g_free (expected);
+				g_free (actual);
+				
+				throw (exception_new ("filter output did not match iconv"));
+			}
+			
+			g_free (expected);
+			
+			expected = actual;
+			actual = filter_convert ("UTF-8", tests[i].charset, expected);
+			g_free (expected);
+			
+			if (actual == NULL) {
+				throw (exception_new ("could not create a filter for UTF-8 to %s",
+						      tests[i].charset));
+			} else if (strcmp (tests[i].text, actual) != 0) {
+				g_free (actual);
+				
+				throw (exception_new ("strings did not match after conversion"));
+			}
+			
+			testsuite_check_passed ();
+			
+			g_free (actual);
+		} catch (ex) {
+			testsuite_check_failed ("test #%d failed: %s", i, ex->message);
+		} finally;
+	}
+	
+	testsuite_end ();
+}
+
+/* the built-in aliases that g_mime_charset_iconv_name() must resolve
+ * exactly as the old mutex-protected hash table did */
+static struct {
+	const char *charset;
+	const char *iconv_name;
+} known_aliases[] = {
+	{ "utf-8",           "UTF-8"      },
+	{ "utf8",            "UTF-8"      },
+	{ "iso-10646-1",     "UCS-2BE"    },
+	{ "iso_10646-1",     "UCS-2BE"    },
+	{ "iso10646-1",      "UCS-2BE"    },
+	{ "iso-10646",       "UCS-2BE"    },
+	{ "iso_10646",       "UCS-2BE"    },
+	{ "iso10646",        "UCS-2BE"    },
+	{ "ks_c_5601-1987",  "EUC-KR"     },
+	{ "5601",            "EUC-KR"     },
+	{ "ksc-5601",        "EUC-KR"     },
+	{ "ksc-5601-1987",   "EUC-KR"     },
+	{ "ksc-5601_1987",   "EUC-KR"     },
+	{ "ks_c_5861-1992",  "EUC-KR"     },
+	{ "euckr-0",         "EUC-KR"     },
+	{ "big5-0",          "BIG5"       },
+	{ "big5.eten-0",     "BIG5"       },
+	{ "big5hkscs-0",     "BIG5HKSCS"  },
+	{ "gb2312",          "GBK"        },
+	{ "gb-2312",         "GBK"        },
+	{ "gb2312-0",        "GBK"        },
+	{ "gb2312-80",       "GBK"        },
+	{ "gb2312.1980-0",   "GBK"        },
+	{ "euc-cn",          "GBK"        },
+	{ "gb18030-0",       "gb18030"    },
+	{ "gbk-0",           "GBK"        },
+	{ "eucjp-0",         "eucJP"      },
+	{ "ujis-0",          "ujis"       },
+	{ "UTF-8",           "UTF-8"      },
+	{ "GB2312",          "GBK"        },
+	{ "Big5-0",          "BIG5"       },
+};
+
+/* names whose iconv names are computed by rule; the spelling of the
+ * result is platform specific, so only letters and digits are compared */
+static struct {
+	const char *charset;
+	const char *iconv_name;
+} rule_aliases[] = {
+	{ "iso-8859-1",      "iso88591"    },
+	{ "iso-8859-2",      "iso88592"    },
+	{ "iso-8859-15",     "iso885915"   },
+	{ "ISO_8859-7",      "iso88597"    },
+	{ "iso-2022-jp",     "iso2022jp"   },
+	{ "windows-1250",    "cp1250"      },
+	{ "windows-1252",    "cp1252"      },
+	{ "windows-cp1251",  "cp1251"      },
+	{ "microsoft-1253",  "cp1253"      },
+};
+
+#define N_UNKNOWN_CHARSETS 1024
+#define N_LOOKUP_THREADS 8
+#define N_LOOKUP_ROUNDS 16
+
+typedef struct {
+	const char **names;
+	const char **results;
+	guint n_names;
+	guint offset;
+	gboolean consistent;
+} LookupThread;
+
+static gpointer
+charset_lookup_thread (gpointer user_data)
+{
+	LookupThread *thread = user_data;
+	const char *iconv_name;
+	guint round, i, n;
+	
+	thread->consistent = TRUE;
+	
+	for (round = 0; round < N_LOOKUP_ROUNDS; round++) {
+		for (i = 0; i < thread->n_names; i++) {
+			/* each thread walks the names from a different starting point */
+			n = (i + thread->offset) % thread->n_names;
+			
+			iconv_name = g_mime_charset_iconv_name (thread->names[n]);
+			
+			if (thread->results[n] == NULL)
+				thread->results[n] = iconv_name;
+			else if (thread->results[n] != iconv_name)
+				thread->consistent = FALSE;
+		}
+	}
+	
+	return NULL;
+}
+
+static char *
+charset_normalize (const char *iconv_name)
+{
+	GString *str = g_string_new ("");
+	const char *inptr;
+	
+	for (inptr = iconv_name; *inptr; inptr++) {
+		if (g_ascii_isalnum (*inptr))
+			g_string_append_c (str, g_ascii_tolower (*inptr));
+	}
+	
+	return g_string_free (str, FALSE);
+}
+
+static void
+test_charset_names (void)
+{
+	LookupThread threads[N_LOOKUP_THREADS];
+	GThread *workers[N_LOOKUP_THREADS];
+	guint n_known, n_rules, n_names;
+	const char *iconv_name;
+	char **unknown;
+	const char **names;
+	char *normalized;
+	guint i, t;
+	
+	testsuite_start ("charset name lookups");
+	
+	n_known = G_N_ELEMENTS (known_aliases);
+	n_rules = G_N_ELEMENTS (rule_aliases);
+	n_names = n_known + n_rules + N_UNKNOWN_CHARSETS;
+	
+	names = g_new (const char *, n_names);
+	unknown = g_new (char *, N_UNKNOWN_CHARSETS);
+	
+	for (i = 0; i < n_known; i++)
+		names[i] = known_aliases[i].charset;
+	
+	for (i = 0; i < n_rules; i++)
+		names[n_known + i] = rule_aliases[i].charset;
+	
+	/* more names than there are overflow buckets, so that every bucket
+	 * gets a chain that several threads prepend to at the same time */
+	for (i = 0; i < N_UNKNOWN_CHARSETS; i++) {
+		unknown[i] = g_strdup_printf ("x-Unknown-Charset-%u", i);
+		names[n_known + n_rules + i] = unknown[i];
+	}
+	
+	for (t = 0; t < N_LOOKUP_THREADS; t++) {
+		threads[t].results = g_new0 (const char *, n_names);
+		threads[t].offset = (n_names / N_LOOKUP_THREADS) * t;
+		threads[t].n_names = n_names;
+		threads[t].names = names;
+	}
+	
+	for (t = 0; t < N_LOOKUP_THREADS; t++)
+		workers[t] = g_thread_new ("charset-lookup", charset_lookup_thread, &threads[t]);
+	
+	for (t = 0; t < N_LOOKUP_THREADS; t++)
+		g_thread_join (workers[t]);
+	
+	testsuite_check ("concurrent lookups are stable");
+	try {
+		for (t = 0; t < N_LOOKUP_THREADS; t++) {
+			if (!threads[t].consistent)
+				throw (exception_new ("thread %u got different strings for the same name", t));
+			
+			for (i = 0; i < n_names; i++) {
+				if (threads[t].results[i] != threads[0].results[i])
+					throw (exception_new ("threads 0 and %u got different strings for %s", t, names[i]));
+			}
+		}
+		
+		for (i = 0; i < n_names; i++) {
+			if (g_mime_charset_iconv_name (names[i]) != threads[0].results[i])
+				throw (exception_new ("%s resolved to a different string after the threads exited", names[i]));
+		}
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("concurrent lookups are stable: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("built-in aliases");
+	try {
+		for (i = 0; i < n_known; i++) {
+			iconv_name = threads[0].results[i];
+			
+			if (strcmp (iconv_name, known_aliases[i].iconv_name) != 0)
+				throw (exception_new ("%s resolved to %s, expected %s", known_aliases[i].charset,
+						      iconv_name, known_aliases[i].iconv_name));
+		}
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("built-in aliases: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("rule-based names");
+	try {
+		for (i = 0; i < n_rules; i++) {
+			normalized = charset_normalize (threads[0].results[n_known + i]);
+			
+			if (strcmp (normalized, rule_aliases[i].iconv_name) != 0) {
+				g_free (normalized);
+				throw (exception_new ("%s resolved to %s", rule_aliases[i].charset,
+						      threads[0].results[n_known + i]));
+			}
+			
+			g_free (normalized);
+		}
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("rule-based names: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("unknown names");
+	try {
+		/* names that match no rule are passed through as given */
+		for (i = 0; i < N_UNKNOWN_CHARSETS; i++) {
+			iconv_name = threads[0].results[n_known + n_rules + i];
+			
+			if (strcmp (iconv_name, unknown[i]) != 0)
+				throw (exception_new ("%s resolved to %s", unknown[i], iconv_name));
+		}
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("unknown names: %s", ex->message);
+	} finally;
+	
+	for (t = 0; t < N_LOOKUP_THREADS; t++)
+		g_free (threads[t].results);
+	
+	for (i = 0; i < N_UNKNOWN_CHARSETS; i++)
+		g_free (unknown[i]);
+	g_free (unknown);
+	g_free (names);
+	
+	testsuite_end ();
+}
+
 int main (int argc, char **argv)
 {
 	g_mime_init ();
 	
 	testsuite_init (argc, argv);
 	
+	test_charset_names ();
 	test_utils ();
+	test_filter ();
 	
 	g_mime_shutdown ();
 	
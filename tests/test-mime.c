@@ -264,6 +264,40 @@ test_addrspec (GMimeParserOptions *options, gboolean test_broken)
 			g_object_unref (addrlist);
 	}
 	
+	for (i = 0; i < G_N_ELEMENTS (addrspec); i++) {
+		InternetAddressFlatList *flat = NULL;
+		
+		addrlist = NULL;
+		str = NULL;
+		
+		testsuite_check ("addrspec[%u] (flat)", i);
+		try {
+			if (!(flat = internet_address_flat_list_parse (options, addrspec[i].input)))
+				throw (exception_new ("could not parse: %s", addrspec[i].input));
+			
+			charset = internet_address_flat_list_get_charset (flat, 0);
+			if ((addrspec[i].charset == NULL) != (charset == NULL) ||
+			    (charset != NULL && g_ascii_strcasecmp (addrspec[i].charset, charset) != 0))
+				throw (exception_new ("charsets do not match: %s", addrspec[i].input));
+			
+			addrlist = internet_address_flat_list_to_list (flat);
+			
+			str = internet_address_list_to_string (addrlist, format, TRUE);
+			if (strcmp (addrspec[i].encoded, str) != 0)
+				throw (exception_new ("encoded strings do not match.\nexpected: %s\nactual: %s", addrspec[i].encoded, str));
+			
+			testsuite_check_passed ();
+		} catch (ex) {
+			testsuite_check_failed ("addrspec[%u] (flat): %s", i, ex->message);
+		} finally;
+		
+		g_free (str);
+		if (addrlist)
+			g_object_unref (addrlist);
+		if (flat)
+			internet_address_flat_list_unref (flat);
+	}
+	
 	if (test_broken) {
 		for (i = 0; i < G_N_ELEMENTS (broken_addrspec); i++) {
 			addrlist = NULL;
@@ -396,6 +430,30 @@ test_date_parser (void)
 			testsuite_check_failed ("Date: '%s': %s", dates[i].in, ex->message);
 		} finally;
 	}
+	
+	for (i = 0; i < G_N_ELEMENTS (dates); i++) {
+		testsuite_check ("Date (unix): '%s'", dates[i].in);
+		try {
+			gint64 unix_time;
+			
+			if (!g_mime_utils_header_decode_date_unix (dates[i].in, &unix_time, &tz_offset)) {
+				if (dates[i].date != 0)
+					throw (exception_new ("failed to parse date: %s", dates[i].in));
+				testsuite_check_passed ();
+				continue;
+			}
+			
+			if (unix_time != (gint64) dates[i].date)
+				throw (exception_new ("time_t's do not match: actual: %" G_GINT64_FORMAT "; expected: %ld", unix_time, dates[i].date));
+			
+			if (tz_offset != dates[i].tzone)
+				throw (exception_new ("timezones do not match"));
+			
+			testsuite_check_passed ();
+		} catch (ex) {
+			testsuite_check_failed ("Date (unix): '%s': %s", dates[i].in, ex->message);
+		} finally;
+	}
 }
 
 static struct {
@@ -434,6 +492,12 @@ static struct {
 	{ "=?iso-8859-1?q?Jobbans=F6kan?= - duktig =?iso-8859-1?q?researcher=2Fomv=E4rldsbevakare=2Fomv=E4rldsan?= =?us-ascii?q?alytiker?=",
 	  "Jobbansökan - duktig researcher/omvärldsbevakare/omvärldsanalytiker",
 	  "=?iso-8859-1?q?Jobbans=F6kan?= - duktig =?iso-8859-1?q?researcher=2Fomv=E4rldsbevakare=2Fomv=E4rldsana?= =?us-ascii?q?lytiker?=" },
+	{ "Plain us-ascii subject with an = sign and a ? mark",
+	  "Plain us-ascii subject with an = sign and a ? mark",
+	  "Plain us-ascii subject with an = sign and a ? mark" },
+	{ "=?UTF-8?Q?caf=C3=A9?= =?utf-8?b?Y2Fmw6k=?=",
+	  "caf\xc3\xa9" "caf\xc3\xa9",
+	  "=?iso-8859-1?q?caf=E9caf=E9?=" },
 };
 
 static struct {
@@ -706,6 +770,178 @@ test_rfc2184 (GMimeParserOptions *options)
 }
 
 
+static const char header_cache_message[] =
+	"From: sender@example.com\n"
+	"Subject: header cache\n"
+	"MIME-Version: 1.0\n"
+	"Content-Type: multipart/mixed; boundary=\"cache\"\n"
+	"\n"
+	"--cache\n"
+	"Content-Type: text/plain; charset=iso-8859-1; format=flowed\n"
+	"\n"
+	"first\n"
+	"--cache\n"
+	"Content-Type: text/plain; charset=iso-8859-1; format=flowed\n"
+	"\n"
+	"second\n"
+	"--cache\n"
+	"Content-Type: text/plain; charset=iso-8859-1; format=flowed\n"
+	"\n"
+	"third\n"
+	"--cache--\n";
+
+static void
+test_header_cache (void)
+{
+	const char *ctype = "text/plain; CharSet=iso-8859-1; format=flowed; x-custom=\"a b\"";
+	const char *disp = "attachment; filename=\"report.pdf\"; size=1024";
+	GMimeContentDisposition *disposition[2] = { NULL, NULL };
+	GMimeContentType *content_type[3] = { NULL, NULL, NULL };
+	GMimeParserOptions *options, *clone;
+	GMimeContentType *parsed[3];
+	GMimeMultipart *multipart;
+	GMimeMessage *message;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	const char *value;
+	guint hits, i;
+	
+	options = g_mime_parser_options_new ();
+	g_mime_parser_options_set_header_cache_size (options, 16);
+	
+	testsuite_check ("parameter lookups");
+	try {
+		content_type[0] = g_mime_content_type_parse (options, ctype);
+		
+		if (!(value = g_mime_content_type_get_parameter (content_type[0], "charset")) || strcmp (value, "iso-8859-1") != 0)
+			throw (exception_new ("charset does not match: %s", value ? value : "(null)"));
+		
+		if (!(value = g_mime_content_type_get_parameter (content_type[0], "X-CUSTOM")) || strcmp (value, "a b") != 0)
+			throw (exception_new ("x-custom does not match: %s", value ? value : "(null)"));
+		
+		if (g_mime_content_type_get_parameter (content_type[0], "boundary") != NULL)
+			throw (exception_new ("unexpected boundary parameter"));
+		
+		if (!g_mime_param_list_remove (content_type[0]->params, "FORMAT"))
+			throw (exception_new ("failed to remove the format parameter"));
+		
+		if (g_mime_content_type_get_parameter (content_type[0], "format") != NULL)
+			throw (exception_new ("format parameter was not removed"));
+		
+		if (!(value = g_mime_content_type_get_parameter (content_type[0], "x-custom")) || strcmp (value, "a b") != 0)
+			throw (exception_new ("x-custom does not match after remove: %s", value ? value : "(null)"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("parameter lookups: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("cached Content-Type");
+	try {
+		content_type[1] = g_mime_content_type_parse (options, ctype);
+		g_mime_content_type_set_parameter (content_type[1], "charset", "utf-8");
+		content_type[2] = g_mime_content_type_parse (options, ctype);
+		
+		if (content_type[1] == content_type[2] || content_type[1]->params == content_type[2]->params)
+			throw (exception_new ("cached Content-Types are shared"));
+		
+		if (!(value = g_mime_content_type_get_parameter (content_type[2], "charset")) || strcmp (value, "iso-8859-1") != 0)
+			throw (exception_new ("cached charset was modified: %s", value ? value : "(null)"));
+		
+		if (!(value = g_mime_content_type_get_parameter (content_type[2], "format")) || strcmp (value, "flowed") != 0)
+			throw (exception_new ("cached format does not match: %s", value ? value : "(null)"));
+		
+		if (g_mime_param_list_length (content_type[2]->params) != 3)
+			throw (exception_new ("cached parameter count does not match"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("cached Content-Type: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("cached Content-Disposition");
+	try {
+		disposition[0] = g_mime_content_disposition_parse (options, disp);
+		g_mime_content_disposition_set_parameter (disposition[0], "filename", "other.pdf");
+		disposition[1] = g_mime_content_disposition_parse (options, disp);
+		
+		if (strcmp (g_mime_content_disposition_get_disposition (disposition[1]), "attachment") != 0)
+			throw (exception_new ("cached disposition does not match"));
+		
+		if (!(value = g_mime_content_disposition_get_parameter (disposition[1], "filename")) || strcmp (value, "report.pdf") != 0)
+			throw (exception_new ("cached filename was modified: %s", value ? value : "(null)"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("cached Content-Disposition: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("cache shared by cloned options");
+	try {
+		/* the parser and every header list work with clones of these options */
+		clone = g_mime_parser_options_clone (options);
+		hits = g_mime_parser_options_get_header_cache_hits (options);
+		
+		stream = g_mime_stream_mem_new_with_buffer (header_cache_message, sizeof (header_cache_message) - 1);
+		parser = g_mime_parser_new_with_stream (stream);
+		message = g_mime_parser_construct_message (parser, clone);
+		g_mime_parser_options_free (clone);
+		g_object_unref (parser);
+		g_object_unref (stream);
+		
+		if (message == NULL)
+			throw (exception_new ("failed to parse the message"));
+		
+		multipart = (GMimeMultipart *) message->mime_part;
+		if (!GMIME_IS_MULTIPART (multipart) || g_mime_multipart_get_count (multipart) != 3) {
+			g_object_unref (message);
+			throw (exception_new ("unexpected message structure"));
+		}
+		
+		/* the first part's Content-Type is parsed, the other two are copied */
+		if (g_mime_parser_options_get_header_cache_hits (options) < hits + 2) {
+			g_object_unref (message);
+			throw (exception_new ("%u cache hits, expected at least 2",
+					      g_mime_parser_options_get_header_cache_hits (options) - hits));
+		}
+		
+		for (i = 0; i < 3; i++)
+			parsed[i] = g_mime_object_get_content_type (g_mime_multipart_get_part (multipart, i));
+		
+		g_mime_content_type_set_parameter (parsed[0], "charset", "utf-8");
+		
+		for (i = 1; i < 3; i++) {
+			if (parsed[i] == parsed[0] || parsed[i]->params == parsed[0]->params) {
+				g_object_unref (message);
+				throw (exception_new ("part %u shares its Content-Type with part 0", i));
+			}
+			
+			if (!(value = g_mime_content_type_get_parameter (parsed[i], "charset")) || strcmp (value, "iso-8859-1") != 0) {
+				g_object_unref (message);
+				throw (exception_new ("part %u charset was modified", i));
+			}
+		}
+		
+		g_object_unref (message);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("cache shared by cloned options: %s", ex->message);
+	} finally;
+	
+	for (i = 0; i < G_N_ELEMENTS (content_type); i++) {
+		if (content_type[i] != NULL)
+			g_object_unref (content_type[i]);
+	}
+	
+	for (i = 0; i < G_N_ELEMENTS (disposition); i++) {
+		if (disposition[i] != NULL)
+			g_object_unref (disposition[i]);
+	}
+	
+	g_mime_parser_options_free (options);
+}
+
 static struct {
 	const char *input;
 	const char *unquoted;
@@ -818,6 +1054,1336 @@ test_references (GMimeParserOptions *options)
 	}
 }
 
+static void
+test_id_generator (void)
+{
+	char msgid[GMIME_ID_GENERATOR_LOCAL_PART_MAX_LEN + 16], prev[sizeof (msgid)];
+	char boundary[GMIME_ID_GENERATOR_BOUNDARY_LEN + 1];
+	GMimeIdGenerator *generator;
+	size_t n;
+	
+	generator = g_mime_id_generator_new ("example.com");
+	
+	testsuite_check ("message-ids");
+	try {
+		prev[0] = '\0';
+		
+		for (n = 0; n < 100; n++) {
+			if (g_mime_id_generator_format_message_id (generator, msgid, sizeof (msgid)) != strlen (msgid))
+				throw (exception_new ("returned length does not match"));
+			
+			if (!g_str_has_suffix (msgid, "@example.com"))
+				throw (exception_new ("unexpected domain: %s", msgid));
+			
+			if (!strcmp (msgid, prev))
+				throw (exception_new ("duplicate message-id: %s", msgid));
+			
+			strcpy (prev, msgid);
+		}
+		
+		if (g_mime_id_generator_format_message_id (generator, msgid, 8) < 8 || msgid[0] != '\0')
+			throw (exception_new ("short buffer was not detected"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("message-ids: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("boundaries");
+	try {
+		n = g_mime_id_generator_format_boundary (generator, boundary, sizeof (boundary));
+		
+		if (n != GMIME_ID_GENERATOR_BOUNDARY_LEN || strlen (boundary) != n)
+			throw (exception_new ("unexpected boundary length"));
+		
+		if (strncmp (boundary, "=-", 2) != 0)
+			throw (exception_new ("unexpected boundary: %s", boundary));
+		
+		if (g_mime_id_generator_format_boundary (generator, boundary, n) != n || boundary[0] != '\0')
+			throw (exception_new ("short buffer was not detected"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("boundaries: %s", ex->message);
+	} finally;
+	
+	g_mime_id_generator_unref (generator);
+}
+
+static const char bodystructure_message[] =
+	"From: Joe <joe@example.com>\n"
+	"To: \"Jane Doe\" <jane@example.org>, friends: a@b.c;\n"
+	"Subject: bodystructure\n"
+	"Date: Mon, 17 Jan 2000 10:00:00 -0500\n"
+	"Message-Id: <1@example.com>\n"
+	"MIME-Version: 1.0\n"
+	"Content-Type: multipart/mixed; boundary=\"xyz\"\n"
+	"\n"
+	"--xyz\n"
+	"Content-Type: text/plain; charset=us-ascii; name*=utf-8''caf%C3%A9.txt\n"
+	"\n"
+	"line one\n"
+	"line two\n"
+	"--xyz\n"
+	"Content-Type: message/rfc822\n"
+	"\n"
+	"Subject: inner\n"
+	"\n"
+	"body\n"
+	"--xyz--\n";
+
+static const char bodystructure_envelope[] =
+	"(\"Mon, 17 Jan 2000 10:00:00 -0500\" \"bodystructure\" "
+	"((\"Joe\" NIL \"joe\" \"example.com\")) "
+	"((\"Joe\" NIL \"joe\" \"example.com\")) "
+	"((\"Joe\" NIL \"joe\" \"example.com\")) "
+	"((\"Jane Doe\" NIL \"jane\" \"example.org\")(NIL NIL \"friends\" NIL)(NIL NIL \"a\" \"b.c\")(NIL NIL NIL NIL)) "
+	"NIL NIL NIL \"<1@example.com>\")";
+
+static const char bodystructure_body[] =
+	"((\"text\" \"plain\" (\"charset\" \"us-ascii\" \"name*\" \"UTF-8''caf%C3%A9.txt\") NIL NIL \"7BIT\" 17 2)"
+	"(\"message\" \"rfc822\" NIL NIL NIL \"7BIT\" 20 "
+	"(NIL \"inner\" NIL NIL NIL NIL NIL NIL NIL NIL) "
+	"(\"text\" \"plain\" NIL NIL NIL \"7BIT\" 4 1) 3) \"mixed\")";
+
+static void
+test_bodystructure (void)
+{
+	GMimeMessagePart *message_part;
+	GMimeMultipart *multipart;
+	GMimeMessage *message;
+	gint64 octets, lines;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	char *str;
+	
+	stream = g_mime_stream_mem_new_with_buffer (bodystructure_message, sizeof (bodystructure_message) - 1);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_object_unref (stream);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	g_object_unref (parser);
+	
+	multipart = (GMimeMultipart *) g_mime_message_get_mime_part (message);
+	message_part = (GMimeMessagePart *) g_mime_multipart_get_part (multipart, 1);
+	
+	testsuite_check ("recorded content sizes");
+	try {
+		if (!g_mime_object_get_content_size (g_mime_multipart_get_part (multipart, 0), &octets, &lines))
+			throw (exception_new ("text/plain size unknown"));
+		
+		if (octets != 17 || lines != 2)
+			throw (exception_new ("text/plain: expected 17 octets and 2 lines, got %" G_GINT64_FORMAT
+					      " and %" G_GINT64_FORMAT, octets, lines));
+		
+		if (!g_mime_object_get_content_size ((GMimeObject *) message_part, &octets, &lines))
+			throw (exception_new ("message/rfc822 size unknown"));
+		
+		if (octets != 20 || lines != 3)
+			throw (exception_new ("message/rfc822: expected 20 octets and 3 lines, got %" G_GINT64_FORMAT
+					      " and %" G_GINT64_FORMAT, octets, lines));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("recorded content sizes: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("envelope");
+	try {
+		str = g_mime_message_get_envelope (message);
+		if (strcmp (str, bodystructure_envelope) != 0)
+			throw (exception_new ("unexpected envelope: %s", str));
+		g_free (str);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("envelope: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("bodystructure");
+	try {
+		str = g_mime_object_get_bodystructure ((GMimeObject *) message, FALSE);
+		if (strcmp (str, bodystructure_body) != 0)
+			throw (exception_new ("unexpected bodystructure: %s", str));
+		g_free (str);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("bodystructure: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("modified message/rfc822");
+	try {
+		g_mime_object_append_header ((GMimeObject *) message_part->message, "X-Modified", "yes", NULL);
+		
+		if (g_mime_object_get_content_size ((GMimeObject *) message_part, &octets, &lines))
+			throw (exception_new ("size should no longer be known"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("modified message/rfc822: %s", ex->message);
+	} finally;
+	
+	g_object_unref (message);
+}
+
+static void
+test_frozen_message (void)
+{
+	GMimeFrozenMessage *frozen;
+	GMimeMultipart *multipart;
+	GMimeMessage *message;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	const char *value;
+	char *str;
+	
+	stream = g_mime_stream_mem_new_with_buffer (bodystructure_message, sizeof (bodystructure_message) - 1);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_object_unref (stream);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	g_object_unref (parser);
+	
+	frozen = g_mime_message_freeze (message);
+	g_object_unref (message);
+	
+	testsuite_check ("freeze");
+	try {
+		if (!(value = g_mime_frozen_message_get_subject (frozen)) || strcmp (value, "bodystructure") != 0)
+			throw (exception_new ("subject does not match: %s", value ? value : "(null)"));
+		
+		if (!(value = g_mime_frozen_message_get_message_id (frozen)) || strcmp (value, "1@example.com") != 0)
+			throw (exception_new ("message-id does not match: %s", value ? value : "(null)"));
+		
+		if (g_mime_frozen_message_get_date (frozen) == NULL)
+			throw (exception_new ("date was not parsed"));
+		
+		if (!(value = g_mime_frozen_message_get_addresses (frozen, GMIME_ADDRESS_TYPE_FROM)) || !strstr (value, "joe@example.com"))
+			throw (exception_new ("from does not match: %s", value ? value : "(null)"));
+		
+		if (g_mime_frozen_message_get_addresses (frozen, GMIME_ADDRESS_TYPE_CC) != NULL)
+			throw (exception_new ("unexpected cc addresses"));
+		
+		/* message, multipart, text/plain, message/rfc822, inner message, inner text/plain */
+		if (g_mime_frozen_message_get_part_count (frozen) != 6)
+			throw (exception_new ("expected 6 parts, got %d", g_mime_frozen_message_get_part_count (frozen)));
+		
+		if (g_mime_frozen_message_get_part_type (frozen, 0) != GMIME_FROZEN_PART_MESSAGE ||
+		    g_mime_frozen_message_get_part_type (frozen, 1) != GMIME_FROZEN_PART_MULTIPART ||
+		    g_mime_frozen_message_get_part_type (frozen, 2) != GMIME_FROZEN_PART_LEAF ||
+		    g_mime_frozen_message_get_part_type (frozen, 3) != GMIME_FROZEN_PART_MESSAGE_PART ||
+		    g_mime_frozen_message_get_part_type (frozen, 4) != GMIME_FROZEN_PART_MESSAGE ||
+		    g_mime_frozen_message_get_part_type (frozen, 5) != GMIME_FROZEN_PART_LEAF)
+			throw (exception_new ("part types do not match"));
+		
+		if (g_mime_frozen_message_get_first_child (frozen, 1) != 2 ||
+		    g_mime_frozen_message_get_next_sibling (frozen, 2) != 3 ||
+		    g_mime_frozen_message_get_next_sibling (frozen, 3) != -1 ||
+		    g_mime_frozen_message_get_first_child (frozen, 3) != 4 ||
+		    g_mime_frozen_message_get_parent (frozen, 5) != 4 ||
+		    g_mime_frozen_message_get_parent (frozen, 0) != -1)
+			throw (exception_new ("part links do not match"));
+		
+		if (!g_mime_frozen_message_is_type (frozen, 1, "multipart", "mixed"))
+			throw (exception_new ("part 1 is not multipart/mixed"));
+		
+		if (!(value = g_mime_frozen_message_get_content_type_parameter (frozen, 1, "Boundary")) || strcmp (value, "xyz") != 0)
+			throw (exception_new ("boundary does not match: %s", value ? value : "(null)"));
+		
+		if (!g_mime_frozen_message_is_type (frozen, 2, "text", "*"))
+			throw (exception_new ("part 2 is not text/*"));
+		
+		if (!(value = g_mime_frozen_message_get_header (frozen, 4, "subject")) || strcmp (value, "inner") != 0)
+			throw (exception_new ("inner subject does not match: %s", value ? value : "(null)"));
+		
+		if (g_mime_frozen_message_get_content (frozen, 2) == NULL)
+			throw (exception_new ("text/plain part has no content"));
+		
+		if (g_mime_frozen_message_get_content (frozen, 1) != NULL)
+			throw (exception_new ("multipart has content"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("freeze: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("thaw");
+	message = g_mime_frozen_message_thaw (frozen, NULL);
+	try {
+		str = g_mime_message_get_envelope (message);
+		value = strcmp (str, bodystructure_envelope) != 0 ? "unexpected envelope" : NULL;
+		g_free (str);
+		
+		if (value != NULL)
+			throw (exception_new ("%s", value));
+		
+		multipart = (GMimeMultipart *) g_mime_message_get_mime_part (message);
+		if (!GMIME_IS_MULTIPART (multipart) || g_mime_multipart_get_count (multipart) != 2)
+			throw (exception_new ("thawed multipart does not match"));
+		
+		if (!GMIME_IS_TEXT_PART (g_mime_multipart_get_part (multipart, 0)))
+			throw (exception_new ("thawed text part does not match"));
+		
+		g_mime_message_set_subject (message, "modified", NULL);
+		
+		if (strcmp (g_mime_frozen_message_get_subject (frozen), "bodystructure") != 0)
+			throw (exception_new ("frozen message was modified"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("thaw: %s", ex->message);
+	} finally;
+	
+	g_object_unref (message);
+	g_mime_frozen_message_unref (frozen);
+}
+
+/* mirrors the version 1 layout in gmime-frozen-message.c */
+typedef struct {
+	char magic[8];
+	guint32 version;
+	guint32 byte_order;
+	guint32 n_headers;
+	guint32 n_contents;
+	guint32 n_parts;
+	guint32 n_params;
+	guint32 strings_len;
+	guint32 message_id;
+	guint32 subject;
+	guint32 addresses[GMIME_ADDRESS_TYPE_BCC + 1];
+	guint32 reserved;
+} TestFrozenLayout;
+
+typedef struct {
+	guint32 name;
+	guint32 raw_name;
+	guint32 raw_value;
+	guint32 value;
+	gint64 offset;
+} TestFrozenHeader;
+
+typedef struct {
+	guint32 type;
+	gint32 parent;
+	gint32 first_child;
+	gint32 next_sibling;
+	guint32 fields[11];
+	gint32 content;
+} TestFrozenPart;
+
+/* returns TRUE if the corrupted copy of @bytes loads (or could not be corrupted) */
+static gboolean
+frozen_bytes_load_corrupted (GBytes *bytes, GMimeStream *stream, gboolean link_twice)
+{
+	GMimeFrozenMessage *loaded;
+	TestFrozenLayout *layout;
+	TestFrozenHeader *header;
+	TestFrozenPart *parts;
+	gboolean corrupted = FALSE;
+	GBytes *copy;
+	size_t size;
+	char *data;
+	guint32 i;
+	
+	size = g_bytes_get_size (bytes);
+	data = g_malloc (size);
+	memcpy (data, g_bytes_get_data (bytes, NULL), size);
+	layout = (TestFrozenLayout *) data;
+	header = (TestFrozenHeader *) (data + sizeof (TestFrozenLayout));
+	parts = (TestFrozenPart *) (data + sizeof (TestFrozenLayout) + layout->n_headers * sizeof (TestFrozenHeader) + layout->n_contents * (2 * sizeof (gint64)));
+	
+	if (link_twice) {
+		/* make a leaf's next sibling its child as well */
+		for (i = 0; i < layout->n_parts && !corrupted; i++) {
+			if (parts[i].first_child == -1 && parts[i].next_sibling != -1) {
+				parts[i].first_child = parts[i].next_sibling;
+				corrupted = TRUE;
+			}
+		}
+	} else if (layout->n_headers > 0) {
+		/* headers must have a raw name */
+		header->raw_name = G_MAXUINT32;
+		corrupted = TRUE;
+	}
+	
+	copy = g_bytes_new_take (data, size);
+	loaded = corrupted ? g_mime_frozen_message_load (copy, stream, NULL) : NULL;
+	g_bytes_unref (copy);
+	
+	if (loaded != NULL) {
+		g_mime_frozen_message_unref (loaded);
+		return TRUE;
+	}
+	
+	return !corrupted;
+}
+
+static void
+test_frozen_message_save (void)
+{
+	GMimeFrozenMessage *frozen, *loaded;
+	GMimeMultipart *multipart;
+	GBytes *bytes, *truncated;
+	GMimeMessage *message;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	GError *err = NULL;
+	const char *value;
+	char *str;
+	
+	stream = g_mime_stream_mem_new_with_buffer (bodystructure_message, sizeof (bodystructure_message) - 1);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_mime_parser_set_persist_stream (parser, FALSE);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	frozen = g_mime_message_freeze (message);
+	g_object_unref (message);
+	
+	testsuite_check ("save without a persistent stream");
+	try {
+		if ((bytes = g_mime_frozen_message_save (frozen, &err)) != NULL) {
+			g_bytes_unref (bytes);
+			throw (exception_new ("saved a message whose content is not in the stream"));
+		}
+		
+		if (err == NULL || err->code != GMIME_ERROR_NOT_SUPPORTED)
+			throw (exception_new ("unexpected error"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("save without a persistent stream: %s", ex->message);
+	} finally;
+	
+	g_mime_frozen_message_unref (frozen);
+	g_clear_error (&err);
+	
+	g_mime_stream_reset (stream);
+	g_mime_parser_init_with_stream (parser, stream);
+	g_mime_parser_set_persist_stream (parser, TRUE);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	frozen = g_mime_message_freeze (message);
+	g_object_unref (message);
+	g_object_unref (parser);
+	
+	bytes = g_mime_frozen_message_save (frozen, NULL);
+	g_mime_frozen_message_unref (frozen);
+	
+	testsuite_check ("save and load");
+	message = NULL;
+	loaded = NULL;
+	try {
+		if (bytes == NULL)
+			throw (exception_new ("failed to save the message"));
+		
+		if (!(loaded = g_mime_frozen_message_load (bytes, stream, NULL)))
+			throw (exception_new ("failed to load the message"));
+		
+		if (!(value = g_mime_frozen_message_get_subject (loaded)) || strcmp (value, "bodystructure") != 0)
+			throw (exception_new ("subject does not match: %s", value ? value : "(null)"));
+		
+		message = g_mime_frozen_message_thaw (loaded, NULL);
+		str = g_mime_message_get_envelope (message);
+		value = strcmp (str, bodystructure_envelope) != 0 ? "unexpected envelope" : NULL;
+		g_free (str);
+		
+		if (value != NULL)
+			throw (exception_new ("%s", value));
+		
+		multipart = (GMimeMultipart *) g_mime_message_get_mime_part (message);
+		if (!GMIME_IS_MULTIPART (multipart) || !GMIME_IS_TEXT_PART (g_mime_multipart_get_part (multipart, 0)))
+			throw (exception_new ("loaded structure does not match"));
+		
+		str = g_mime_text_part_get_text ((GMimeTextPart *) g_mime_multipart_get_part (multipart, 0));
+		value = strncmp (str, "line one\nline two", 17) != 0 ? "unexpected content" : NULL;
+		g_free (str);
+		
+		if (value != NULL)
+			throw (exception_new ("%s", value));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("save and load: %s", ex->message);
+	} finally;
+	
+	if (message != NULL)
+		g_object_unref (message);
+	
+	if (loaded != NULL)
+		g_mime_frozen_message_unref (loaded);
+	
+	testsuite_check ("load invalid data");
+	try {
+		if (bytes == NULL)
+			throw (exception_new ("nothing to load"));
+		
+		truncated = g_bytes_new_from_bytes (bytes, 0, g_bytes_get_size (bytes) - 1);
+		loaded = g_mime_frozen_message_load (truncated, stream, NULL);
+		g_bytes_unref (truncated);
+		
+		if (loaded != NULL) {
+			g_mime_frozen_message_unref (loaded);
+			throw (exception_new ("loaded truncated data"));
+		}
+		
+		if (frozen_bytes_load_corrupted (bytes, stream, FALSE))
+			throw (exception_new ("loaded a header without a raw name"));
+		
+		if (frozen_bytes_load_corrupted (bytes, stream, TRUE))
+			throw (exception_new ("loaded a part linked to twice"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("load invalid data: %s", ex->message);
+	} finally;
+	
+	if (bytes != NULL)
+		g_bytes_unref (bytes);
+	g_object_unref (stream);
+}
+
+static void
+test_write_to_buffer (void)
+{
+	GMimeMessage *message;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	char buf[64], *str;
+	ssize_t len, n;
+	
+	stream = g_mime_stream_mem_new_with_buffer (bodystructure_message, sizeof (bodystructure_message) - 1);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_object_unref (stream);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	g_object_unref (parser);
+	
+	testsuite_check ("g_mime_object_to_string()");
+	try {
+		str = g_mime_object_to_string ((GMimeObject *) message, NULL);
+		n = strcmp (str, bodystructure_message);
+		g_free (str);
+		
+		if (n != 0)
+			throw (exception_new ("serialized message does not match"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("g_mime_object_to_string(): %s", ex->message);
+	} finally;
+	
+	testsuite_check ("g_mime_object_write_to_buffer()");
+	try {
+		memset (buf, '*', sizeof (buf));
+		if ((n = g_mime_object_write_to_buffer ((GMimeObject *) message, NULL, buf, sizeof (buf))) != sizeof (bodystructure_message) - 1)
+			throw (exception_new ("unexpected length: %" G_GSSIZE_FORMAT, n));
+		
+		if (memcmp (buf, bodystructure_message, sizeof (buf)) != 0)
+			throw (exception_new ("buffer does not start with the serialized message"));
+		
+		str = g_malloc (n + 1);
+		str[n] = '*';
+		
+		len = g_mime_object_write_to_buffer ((GMimeObject *) message, NULL, str, n);
+		n = len == n && str[n] == '*' ? memcmp (str, bodystructure_message, len) : 1;
+		g_free (str);
+		
+		if (n != 0)
+			throw (exception_new ("buffer contents do not match"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("g_mime_object_write_to_buffer(): %s", ex->message);
+	} finally;
+	
+	testsuite_check ("g_mime_object_get_headers()");
+	try {
+		str = g_mime_object_get_headers ((GMimeObject *) message, NULL);
+		len = strlen (str);
+		n = strncmp (str, bodystructure_message, len) == 0 && !strncmp (bodystructure_message + len, "\n--xyz\n", 7) ? 0 : 1;
+		g_free (str);
+		
+		if (n != 0)
+			throw (exception_new ("headers do not match"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("g_mime_object_get_headers(): %s", ex->message);
+	} finally;
+	
+	g_object_unref (message);
+}
+
+/* a memory stream that notes when it is read from any thread other than the main one */
+typedef struct {
+	GMimeStreamMem parent_object;
+} TestStreamThreads;
+
+typedef struct {
+	GMimeStreamMemClass parent_class;
+} TestStreamThreadsClass;
+
+static GMimeStreamClass *stream_mem_class = NULL;
+static gint read_from_thread = 0;
+static GThread *main_thread = NULL;
+
+static ssize_t
+test_stream_threads_read (GMimeStream *stream, char *buf, size_t len)
+{
+	if (g_thread_self () != main_thread)
+		g_atomic_int_set (&read_from_thread, 1);
+	
+	return stream_mem_class->read (stream, buf, len);
+}
+
+static void
+test_stream_threads_class_init (TestStreamThreadsClass *klass, gpointer class_data)
+{
+	GMimeStreamClass *stream_class = GMIME_STREAM_CLASS (klass);
+	
+	stream_mem_class = g_type_class_peek_parent (klass);
+	
+	stream_class->read = test_stream_threads_read;
+}
+
+static GType
+test_stream_threads_get_type (void)
+{
+	static GType type = 0;
+	
+	if (!type) {
+		static const GTypeInfo info = {
+			sizeof (TestStreamThreadsClass),
+			NULL, /* base_class_init */
+			NULL, /* base_class_finalize */
+			(GClassInitFunc) test_stream_threads_class_init,
+			NULL, /* class_finalize */
+			NULL, /* class_data */
+			sizeof (TestStreamThreads),
+			0,    /* n_preallocs */
+			NULL, /* instance_init */
+		};
+		
+		type = g_type_register_static (GMIME_TYPE_STREAM_MEM, "TestStreamThreads", &info, 0);
+	}
+	
+	return type;
+}
+
+static GMimeStream *
+test_stream_threads_new (const char *data, size_t len)
+{
+	GMimeStream *stream;
+	
+	stream = g_object_new (test_stream_threads_get_type (), NULL);
+	g_mime_stream_construct (stream, 0, -1);
+	g_mime_stream_mem_set_byte_array ((GMimeStreamMem *) stream, g_byte_array_new ());
+	g_mime_stream_mem_set_owner ((GMimeStreamMem *) stream, TRUE);
+	
+	g_mime_stream_write (stream, data, len);
+	g_mime_stream_reset (stream);
+	
+	return stream;
+}
+
+static void
+test_parallel_encode (void)
+{
+	GMimeContentEncoding encodings[4];
+	GMimeFormatOptions *format;
+	GMimeMultipart *multipart;
+	GMimeDataWrapper *content;
+	char *serial, *parallel;
+	GMimeTextPart *text;
+	GMimeStream *stream;
+	GMimePart *part;
+	char *data;
+	guint i;
+	
+	data = g_malloc (200000);
+	for (i = 0; i < 200000; i++)
+		data[i] = (char) ((i * 7) % 256);
+	
+	multipart = g_mime_multipart_new_with_subtype ("mixed");
+	g_mime_multipart_set_boundary (multipart, "=-parallel-encode");
+	
+	text = g_mime_text_part_new_with_subtype ("plain");
+	g_mime_text_part_set_text (text, "attachments follow\n");
+	g_mime_multipart_add (multipart, (GMimeObject *) text);
+	g_object_unref (text);
+	
+	for (i = 0; i < 4; i++) {
+		part = g_mime_part_new_with_type ("application", "octet-stream");
+		stream = test_stream_threads_new (data + i, 200000 - i * 1000);
+		content = g_mime_data_wrapper_new_with_stream (stream, GMIME_CONTENT_ENCODING_DEFAULT);
+		g_mime_part_set_content (part, content);
+		g_mime_part_set_content_encoding (part, i == 3 ? GMIME_CONTENT_ENCODING_QUOTEDPRINTABLE : GMIME_CONTENT_ENCODING_BASE64);
+		g_mime_multipart_add (multipart, (GMimeObject *) part);
+		g_object_unref (content);
+		g_object_unref (stream);
+		g_object_unref (part);
+	}
+	
+	g_free (data);
+	
+	format = g_mime_format_options_new ();
+	g_mime_format_options_set_max_threads (format, 4);
+	main_thread = g_thread_self ();
+	
+	testsuite_check ("parallel encoding");
+	try {
+		g_atomic_int_set (&read_from_thread, 0);
+		serial = g_mime_object_to_string ((GMimeObject *) multipart, NULL);
+		
+		if (g_atomic_int_get (&read_from_thread)) {
+			g_free (serial);
+			throw (exception_new ("content was read on another thread without max-threads set"));
+		}
+		
+		parallel = g_mime_object_to_string ((GMimeObject *) multipart, format);
+		i = strcmp (serial, parallel);
+		g_free (parallel);
+		g_free (serial);
+		
+		if (i != 0)
+			throw (exception_new ("output differs from serial encoding"));
+		
+		if (!g_atomic_int_get (&read_from_thread))
+			throw (exception_new ("no part was encoded on the thread pool"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("parallel encoding: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("parallel g_mime_object_encode()");
+	try {
+		for (i = 0; i < 4; i++) {
+			part = (GMimePart *) g_mime_multipart_get_part (multipart, i + 1);
+			g_mime_part_set_content_encoding (part, GMIME_CONTENT_ENCODING_DEFAULT);
+		}
+		
+		g_atomic_int_set (&read_from_thread, 0);
+		g_mime_object_encode ((GMimeObject *) multipart, GMIME_ENCODING_CONSTRAINT_7BIT);
+		
+		if (g_atomic_int_get (&read_from_thread))
+			throw (exception_new ("content was scanned on another thread without max-threads set"));
+		
+		for (i = 0; i < 4; i++) {
+			part = (GMimePart *) g_mime_multipart_get_part (multipart, i + 1);
+			encodings[i] = g_mime_part_get_content_encoding (part);
+			g_mime_part_set_content_encoding (part, GMIME_CONTENT_ENCODING_DEFAULT);
+		}
+		
+		g_mime_format_options_set_max_threads (g_mime_format_options_get_default (), 4);
+		g_mime_object_encode ((GMimeObject *) multipart, GMIME_ENCODING_CONSTRAINT_7BIT);
+		g_mime_format_options_set_max_threads (g_mime_format_options_get_default (), 1);
+		
+		for (i = 0; i < 4; i++) {
+			part = (GMimePart *) g_mime_multipart_get_part (multipart, i + 1);
+			if (g_mime_part_get_content_encoding (part) != encodings[i])
+				throw (exception_new ("part %u was given a different encoding than a serial encode", i + 1));
+		}
+		
+		if (!g_atomic_int_get (&read_from_thread))
+			throw (exception_new ("no part was scanned on the thread pool"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("parallel g_mime_object_encode(): %s", ex->message);
+	} finally;
+	
+	g_mime_format_options_free (format);
+	g_object_unref (multipart);
+}
+
+static guint64
+fnv1a_64 (const unsigned char *buf, size_t len)
+{
+	guint64 hash = G_GUINT64_CONSTANT (14695981039346656037);
+	size_t i;
+	
+	for (i = 0; i < len; i++) {
+		hash ^= buf[i];
+		hash *= G_GUINT64_CONSTANT (1099511628211);
+	}
+	
+	return hash;
+}
+
+static char *
+check_fingerprint (GMimePart *part)
+{
+	unsigned char digest[32], expected[32];
+	gsize digest_len = sizeof (expected);
+	gint64 length, sha256_length;
+	GChecksum *checksum;
+	GByteArray *array;
+	GMimeStream *mem;
+	char *error = NULL;
+	guint64 hash;
+	
+	if (!g_mime_part_get_content_hash (part, &hash, &length))
+		return g_strdup ("no content hash");
+	
+	if (!g_mime_part_get_content_sha256 (part, digest, &sha256_length))
+		return g_strdup ("no SHA-256 digest");
+	
+	mem = g_mime_stream_mem_new ();
+	g_mime_data_wrapper_write_to_stream (g_mime_part_get_content (part), mem);
+	array = g_mime_stream_mem_get_byte_array ((GMimeStreamMem *) mem);
+	
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+	g_checksum_update (checksum, array->data, array->len);
+	g_checksum_get_digest (checksum, expected, &digest_len);
+	g_checksum_free (checksum);
+	
+	if (length != (gint64) array->len || sha256_length != length)
+		error = g_strdup_printf ("length: %" G_GINT64_FORMAT " != %u", length, array->len);
+	else if (hash != fnv1a_64 (array->data, array->len))
+		error = g_strdup ("hash does not match the decoded content");
+	else if (memcmp (digest, expected, sizeof (digest)) != 0)
+		error = g_strdup ("SHA-256 digest does not match the decoded content");
+	
+	g_object_unref (mem);
+	
+	return error;
+}
+
+static void
+test_fingerprint (void)
+{
+	GMimeContentEncoding encodings[] = { GMIME_CONTENT_ENCODING_BASE64, GMIME_CONTENT_ENCODING_QUOTEDPRINTABLE,
+					     GMIME_CONTENT_ENCODING_UUENCODE, GMIME_CONTENT_ENCODING_8BIT };
+	GMimeMultipart *multipart, *parsed;
+	GMimeFormatOptions *format;
+	GMimeDataWrapper *content;
+	guint i, n, persist, dos;
+	char *data, *text[2], *error;
+	gboolean kept;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	GMimePart *part;
+	
+	data = g_malloc (20000);
+	for (i = 0; i < 20000; i++)
+		data[i] = (i % 61) == 60 ? '\n' : (char) (' ' + (i * 7) % 95);
+	
+	multipart = g_mime_multipart_new_with_subtype ("mixed");
+	
+	for (i = 0; i < G_N_ELEMENTS (encodings); i++) {
+		part = g_mime_part_new_with_type ("application", "octet-stream");
+		g_mime_part_set_filename (part, "attachment.dat");
+		stream = g_mime_stream_mem_new_with_buffer (data + i, 20000 - i * 1000);
+		content = g_mime_data_wrapper_new_with_stream (stream, GMIME_CONTENT_ENCODING_DEFAULT);
+		g_mime_part_set_content (part, content);
+		g_mime_part_set_content_encoding (part, encodings[i]);
+		g_mime_multipart_add (multipart, (GMimeObject *) part);
+		g_object_unref (content);
+		g_object_unref (stream);
+		g_object_unref (part);
+	}
+	
+	g_free (data);
+	
+	/* with CRLF, the newline that belongs to each boundary is 2 bytes long */
+	format = g_mime_format_options_new ();
+	g_mime_format_options_set_newline_format (format, GMIME_NEWLINE_FORMAT_DOS);
+	text[0] = g_mime_object_to_string ((GMimeObject *) multipart, NULL);
+	text[1] = g_mime_object_to_string ((GMimeObject *) multipart, format);
+	g_mime_format_options_free (format);
+	g_object_unref (multipart);
+	
+	for (n = 0; n < 4; n++) {
+		persist = n & 1;
+		dos = n >> 1;
+		
+		testsuite_check ("fingerprints (%s, %s)", persist ? "persistent" : "non-persistent", dos ? "CRLF" : "LF");
+		try {
+			stream = g_mime_stream_mem_new_with_buffer (text[dos], strlen (text[dos]));
+			parser = g_mime_parser_new_with_stream (stream);
+			g_mime_parser_set_format (parser, GMIME_FORMAT_MIME_PART);
+			g_mime_parser_set_persist_stream (parser, persist);
+			g_mime_parser_set_fingerprint (parser, GMIME_FINGERPRINT_HASH | GMIME_FINGERPRINT_SHA256);
+			parsed = (GMimeMultipart *) g_mime_parser_construct_part (parser, NULL);
+			g_object_unref (parser);
+			g_object_unref (stream);
+			
+			if (parsed == NULL || !GMIME_IS_MULTIPART (parsed))
+				throw (exception_new ("failed to parse the multipart"));
+			
+			if (g_mime_multipart_get_count (parsed) != (int) G_N_ELEMENTS (encodings)) {
+				g_object_unref (parsed);
+				throw (exception_new ("wrong number of parts"));
+			}
+			
+			for (i = 0; i < G_N_ELEMENTS (encodings); i++) {
+				part = (GMimePart *) g_mime_multipart_get_part (parsed, i);
+				
+				if ((error = check_fingerprint (part)) != NULL) {
+					Exception *ex;
+					
+					ex = exception_new ("part %u: %s", i, error);
+					g_object_unref (parsed);
+					g_free (error);
+					throw (ex);
+				}
+			}
+			
+			/* replacing the content discards the fingerprints */
+			part = (GMimePart *) g_mime_multipart_get_part (parsed, 0);
+			stream = g_mime_stream_mem_new ();
+			content = g_mime_data_wrapper_new_with_stream (stream, GMIME_CONTENT_ENCODING_DEFAULT);
+			g_mime_part_set_content (part, content);
+			g_object_unref (content);
+			
+			if (g_mime_part_get_content_hash (part, NULL, NULL) || g_mime_part_get_content_sha256 (part, NULL, NULL)) {
+				g_object_unref (parsed);
+				g_object_unref (stream);
+				throw (exception_new ("fingerprints were kept after the content was replaced"));
+			}
+			
+			/* ...and so does changing the stream or the encoding of the content */
+			part = (GMimePart *) g_mime_multipart_get_part (parsed, 1);
+			g_mime_data_wrapper_set_stream (g_mime_part_get_content (part), stream);
+			g_object_unref (stream);
+			
+			if (g_mime_part_get_content_hash (part, NULL, NULL) || g_mime_part_get_content_sha256 (part, NULL, NULL)) {
+				g_object_unref (parsed);
+				throw (exception_new ("fingerprints were kept after the content stream was changed"));
+			}
+			
+			part = (GMimePart *) g_mime_multipart_get_part (parsed, 2);
+			g_mime_data_wrapper_set_encoding (g_mime_part_get_content (part), GMIME_CONTENT_ENCODING_DEFAULT);
+			kept = g_mime_part_get_content_hash (part, NULL, NULL) || g_mime_part_get_content_sha256 (part, NULL, NULL);
+			g_object_unref (parsed);
+			
+			if (kept)
+				throw (exception_new ("fingerprints were kept after the content encoding was changed"));
+			
+			testsuite_check_passed ();
+		} catch (ex) {
+			testsuite_check_failed ("fingerprints (%s, %s): %s", persist ? "persistent" : "non-persistent",
+						dos ? "CRLF" : "LF", ex->message);
+		} finally;
+	}
+	
+	g_free (text[0]);
+	g_free (text[1]);
+}
+
+static void
+test_stats (void)
+{
+	GMimeParserStats pstats;
+	GMimeStreamStats sstats;
+	GMimeMessage *message;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	guint64 count;
+	
+	stream = g_mime_stream_mem_new_with_buffer (bodystructure_message, sizeof (bodystructure_message) - 1);
+	parser = g_mime_parser_new_with_stream (stream);
+	
+	g_mime_stats_reset ();
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	
+	testsuite_check ("parser stats");
+	try {
+		if (g_mime_parser_get_stats (parser, &pstats) != g_mime_stats_enabled ())
+			throw (exception_new ("g_mime_parser_get_stats() disagrees with g_mime_stats_enabled()"));
+		
+		if (!g_mime_stats_enabled ()) {
+			if (pstats.bytes_read != 0 || pstats.parts != 0 || pstats.max_depth != 0)
+				throw (exception_new ("stats should be zeroed when disabled"));
+		} else {
+			if (pstats.bytes_read != sizeof (bodystructure_message) - 1)
+				throw (exception_new ("bytes_read: %" G_GUINT64_FORMAT, pstats.bytes_read));
+			
+			if (pstats.fill_calls == 0)
+				throw (exception_new ("fill_calls should be non-zero"));
+			
+			if (pstats.headers != 10)
+				throw (exception_new ("headers: expected 10, got %" G_GUINT64_FORMAT, pstats.headers));
+			
+			if (pstats.parts != 6)
+				throw (exception_new ("parts: expected 6, got %" G_GUINT64_FORMAT, pstats.parts));
+			
+			if (pstats.boundary_checks == 0)
+				throw (exception_new ("boundary_checks should be non-zero"));
+			
+			if (pstats.max_depth != 3)
+				throw (exception_new ("max_depth: expected 3, got %u", pstats.max_depth));
+		}
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("parser stats: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("stream stats");
+	try {
+		if (g_mime_stream_get_stats (stream, &sstats) != g_mime_stats_enabled ())
+			throw (exception_new ("g_mime_stream_get_stats() disagrees with g_mime_stats_enabled()"));
+		
+		if (g_mime_stats_enabled ()) {
+			if (sstats.reads == 0 || sstats.bytes_read != sizeof (bodystructure_message) - 1)
+				throw (exception_new ("%" G_GUINT64_FORMAT " reads, %" G_GUINT64_FORMAT " bytes",
+						      sstats.reads, sstats.bytes_read));
+			
+			if (sstats.writes != 0 || sstats.bytes_written != 0)
+				throw (exception_new ("nothing should have been written"));
+		} else if (sstats.reads != 0 || sstats.bytes_read != 0) {
+			throw (exception_new ("stats should be zeroed when disabled"));
+		}
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("stream stats: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("allocation stats");
+	try {
+		if (g_mime_stats_get_allocations (GMIME_STATS_SUBSYSTEM_HEADERS, &count, NULL) != g_mime_stats_enabled ())
+			throw (exception_new ("g_mime_stats_get_allocations() disagrees with g_mime_stats_enabled()"));
+		
+		if (g_mime_stats_enabled () ? count < 10 : count != 0)
+			throw (exception_new ("unexpected header allocation count: %" G_GUINT64_FORMAT, count));
+		
+		g_mime_stats_get_allocations (GMIME_STATS_SUBSYSTEM_PARAMS, &count, NULL);
+		if (g_mime_stats_enabled () ? count == 0 : count != 0)
+			throw (exception_new ("unexpected param allocation count: %" G_GUINT64_FORMAT, count));
+		
+		g_mime_stats_reset ();
+		g_mime_stats_get_allocations (GMIME_STATS_SUBSYSTEM_HEADERS, &count, NULL);
+		if (count != 0)
+			throw (exception_new ("reset did not clear the counters"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("allocation stats: %s", ex->message);
+	} finally;
+	
+	g_object_unref (message);
+	g_object_unref (parser);
+	g_object_unref (stream);
+}
+
+static void
+count_header (GMimeParser *parser, const char *header, const char *value, gint64 offset, gpointer user_data)
+{
+	int *count = user_data;
+	
+	(*count)++;
+}
+
+static void
+test_feed (void)
+{
+	size_t sizes[] = { 1, 2, 7, 64, sizeof (bodystructure_message) - 1 };
+	size_t inlen = sizeof (bodystructure_message) - 1;
+	GMimeMessage *message;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	char *expected, *str;
+	int subjects = 0;
+	size_t i, n, hlen;
+	
+	stream = g_mime_stream_mem_new_with_buffer (bodystructure_message, inlen);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_object_unref (stream);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	expected = g_mime_object_to_string ((GMimeObject *) message, NULL);
+	g_object_unref (message);
+	g_object_unref (parser);
+	
+	for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+		testsuite_check ("%zu byte chunks", sizes[i]);
+		try {
+			parser = g_mime_parser_new ();
+			
+			for (n = 0; n < inlen; n += sizes[i])
+				g_mime_parser_feed (parser, NULL, bodystructure_message + n, MIN (sizes[i], inlen - n));
+			g_mime_parser_feed_eof (parser, NULL);
+			
+			message = g_mime_parser_construct_message (parser, NULL);
+			g_object_unref (parser);
+			
+			if (message == NULL)
+				throw (exception_new ("failed to construct message"));
+			
+			str = g_mime_object_to_string ((GMimeObject *) message, NULL);
+			g_object_unref (message);
+			
+			if (strcmp (str, expected) != 0) {
+				g_free (str);
+				throw (exception_new ("message does not match the one parsed from a stream"));
+			}
+			
+			g_free (str);
+			
+			testsuite_check_passed ();
+		} catch (ex) {
+			testsuite_check_failed ("%zu byte chunks: %s", sizes[i], ex->message);
+		} finally;
+	}
+	
+	g_free (expected);
+	
+	testsuite_check ("headers parsed before EOF");
+	try {
+		hlen = (strstr (bodystructure_message, "\n\n") + 2) - bodystructure_message;
+		
+		parser = g_mime_parser_new ();
+		g_mime_parser_set_header_regex (parser, "^Subject$", count_header, &subjects);
+		
+		/* everything but the blank line that ends the header block */
+		g_mime_parser_feed (parser, NULL, bodystructure_message, hlen - 1);
+		
+		if (subjects != 1)
+			throw (exception_new ("Subject seen %d times before the end of the headers", subjects));
+		
+		if (g_mime_parser_get_headers_end (parser) != -1)
+			throw (exception_new ("headers ended before the blank line was fed"));
+		
+		g_mime_parser_feed (parser, NULL, bodystructure_message + hlen - 1, 1);
+		
+		if (g_mime_parser_get_headers_end (parser) != (gint64) (hlen - 1))
+			throw (exception_new ("headers end at %" G_GINT64_FORMAT ", expected %zu",
+					      g_mime_parser_get_headers_end (parser), hlen - 1));
+		
+		g_mime_parser_feed (parser, NULL, bodystructure_message + hlen, inlen - hlen);
+		g_mime_parser_feed_eof (parser, NULL);
+		
+		message = g_mime_parser_construct_message (parser, NULL);
+		g_object_unref (parser);
+		
+		if (message == NULL)
+			throw (exception_new ("failed to construct message"));
+		
+		g_object_unref (message);
+		
+		/* the Subject of the embedded message is only parsed after EOF */
+		if (subjects != 2)
+			throw (exception_new ("Subject seen %d times in total", subjects));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("headers parsed before EOF: %s", ex->message);
+	} finally;
+}
+
+typedef struct {
+	GMainLoop *loop;
+	GMimeMessage *message;
+	ssize_t nwritten;
+	GError *err;
+} AsyncResult;
+
+static void
+parsed_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	AsyncResult *res = user_data;
+	
+	res->message = g_mime_parser_construct_message_finish ((GMimeParser *) source, result, &res->err);
+	g_main_loop_quit (res->loop);
+}
+
+static void
+written_cb (GObject *source, GAsyncResult *result, gpointer user_data)
+{
+	AsyncResult *res = user_data;
+	
+	res->nwritten = g_mime_object_write_to_stream_finish ((GMimeObject *) source, result, &res->err);
+	g_main_loop_quit (res->loop);
+}
+
+static void
+test_async (void)
+{
+	size_t inlen = sizeof (bodystructure_message) - 1;
+	GCancellable *cancellable;
+	GOutputStream *ostream;
+	GInputStream *istream;
+	AsyncResult res, cres;
+	GMimeMessage *message;
+	GMimeDataWrapper *content;
+	GMimeParser *parser;
+	GMimeStream *stream;
+	char *expected, *str;
+	GMimePart *part;
+	char *data;
+	guint i;
+	
+	stream = g_mime_stream_mem_new_with_buffer (bodystructure_message, inlen);
+	parser = g_mime_parser_new_with_stream (stream);
+	g_object_unref (stream);
+	
+	message = g_mime_parser_construct_message (parser, NULL);
+	expected = g_mime_object_to_string ((GMimeObject *) message, NULL);
+	g_object_unref (message);
+	g_object_unref (parser);
+	
+	memset (&res, 0, sizeof (res));
+	res.loop = g_main_loop_new (NULL, FALSE);
+	
+	testsuite_check ("g_mime_parser_construct_message_async");
+	try {
+		istream = g_memory_input_stream_new_from_data (bodystructure_message, inlen, NULL);
+		parser = g_mime_parser_new ();
+		
+		g_mime_parser_construct_message_async (parser, istream, NULL, G_PRIORITY_DEFAULT, NULL, parsed_cb, &res);
+		g_main_loop_run (res.loop);
+		g_object_unref (istream);
+		g_object_unref (parser);
+		
+		if (res.message == NULL)
+			throw (exception_new ("failed to parse: %s", res.err ? res.err->message : "no error set"));
+		
+		str = g_mime_object_to_string ((GMimeObject *) res.message, NULL);
+		if (strcmp (str, expected) != 0) {
+			g_free (str);
+			throw (exception_new ("message does not match the one parsed from a stream"));
+		}
+		g_free (str);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("g_mime_parser_construct_message_async: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("g_mime_object_write_to_stream_async");
+	try {
+		if (res.message == NULL)
+			throw (exception_new ("no message to write"));
+		
+		ostream = g_memory_output_stream_new_resizable ();
+		g_mime_object_write_to_stream_async ((GMimeObject *) res.message, NULL, ostream, G_PRIORITY_DEFAULT,
+						     NULL, written_cb, &res);
+		g_main_loop_run (res.loop);
+		
+		if (res.nwritten != (ssize_t) strlen (expected)) {
+			g_object_unref (ostream);
+			throw (exception_new ("wrote %zd bytes, expected %zu", res.nwritten, strlen (expected)));
+		}
+		
+		if (memcmp (g_memory_output_stream_get_data ((GMemoryOutputStream *) ostream), expected, res.nwritten) != 0) {
+			g_object_unref (ostream);
+			throw (exception_new ("written message does not match"));
+		}
+		
+		g_object_unref (ostream);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("g_mime_object_write_to_stream_async: %s", ex->message);
+	} finally;
+	
+	data = g_malloc (300000);
+	for (i = 0; i < 300000; i++)
+		data[i] = (char) ((i * 13) % 256);
+	
+	part = g_mime_part_new_with_type ("application", "octet-stream");
+	stream = g_mime_stream_mem_new_with_buffer (data, 300000);
+	content = g_mime_data_wrapper_new_with_stream (stream, GMIME_CONTENT_ENCODING_DEFAULT);
+	g_mime_part_set_content (part, content);
+	g_mime_part_set_content_encoding (part, GMIME_CONTENT_ENCODING_BASE64);
+	g_object_unref (content);
+	g_object_unref (stream);
+	g_free (data);
+	
+	/* large enough to be handed to the main loop in several chunks */
+	testsuite_check ("g_mime_object_write_to_stream_async (large part)");
+	try {
+		str = g_mime_object_to_string ((GMimeObject *) part, NULL);
+		
+		ostream = g_memory_output_stream_new_resizable ();
+		g_mime_object_write_to_stream_async ((GMimeObject *) part, NULL, ostream, G_PRIORITY_LOW,
+						     NULL, written_cb, &res);
+		g_main_loop_run (res.loop);
+		
+		if (res.nwritten != (ssize_t) strlen (str) ||
+		    memcmp (g_memory_output_stream_get_data ((GMemoryOutputStream *) ostream), str, strlen (str)) != 0) {
+			g_object_unref (ostream);
+			g_free (str);
+			throw (exception_new ("written part does not match"));
+		}
+		
+		g_object_unref (ostream);
+		g_free (str);
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("g_mime_object_write_to_stream_async (large part): %s", ex->message);
+	} finally;
+	
+	g_object_unref (part);
+	
+	memset (&cres, 0, sizeof (cres));
+	cres.loop = res.loop;
+	
+	cancellable = g_cancellable_new ();
+	g_cancellable_cancel (cancellable);
+	
+	testsuite_check ("cancelled operations");
+	try {
+		istream = g_memory_input_stream_new_from_data (bodystructure_message, inlen, NULL);
+		parser = g_mime_parser_new ();
+		
+		g_mime_parser_construct_message_async (parser, istream, NULL, G_PRIORITY_DEFAULT, cancellable, parsed_cb, &cres);
+		g_main_loop_run (cres.loop);
+		g_object_unref (istream);
+		g_object_unref (parser);
+		
+		if (cres.message != NULL)
+			throw (exception_new ("cancelled parse returned a message"));
+		
+		if (!g_error_matches (cres.err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			throw (exception_new ("cancelled parse failed with: %s", cres.err ? cres.err->message : "no error set"));
+		
+		g_clear_error (&cres.err);
+		
+		if (res.message == NULL)
+			throw (exception_new ("no message to write"));
+		
+		ostream = g_memory_output_stream_new_resizable ();
+		g_mime_object_write_to_stream_async ((GMimeObject *) res.message, NULL, ostream, G_PRIORITY_DEFAULT,
+						     cancellable, written_cb, &cres);
+		g_main_loop_run (cres.loop);
+		
+		if (g_memory_output_stream_get_data_size ((GMemoryOutputStream *) ostream) != 0) {
+			g_object_unref (ostream);
+			throw (exception_new ("cancelled write produced output"));
+		}
+		
+		g_object_unref (ostream);
+		
+		if (cres.nwritten != -1)
+			throw (exception_new ("cancelled write returned %zd", cres.nwritten));
+		
+		if (!g_error_matches (cres.err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+			throw (exception_new ("cancelled write failed with: %s", cres.err ? cres.err->message : "no error set"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("cancelled operations: %s", ex->message);
+	} finally;
+	
+	g_object_unref (cancellable);
+	if (cres.err)
+		g_error_free (cres.err);
+	
+	if (res.message)
+		g_object_unref (res.message);
+	if (res.err)
+		g_error_free (res.err);
+	g_main_loop_unref (res.loop);
+	g_free (expected);
+}
+
 int main (int argc, char **argv)
 {
 	GMimeParserOptions *options = g_mime_parser_options_new ();
@@ -854,6 +2420,10 @@ int main (int argc, char **argv)
 	test_rfc2184 (options);
 	testsuite_end ();
 	
+	testsuite_start ("parameter lookups and header cache");
+	test_header_cache ();
+	testsuite_end ();
+	
 	testsuite_start ("quoted-strings");
 	test_qstring ();
 	testsuite_end ();
@@ -866,6 +2436,40 @@ int main (int argc, char **argv)
 	test_references (options);
 	testsuite_end ();
 	
+	testsuite_start ("message-id and boundary generator");
+	test_id_generator ();
+	testsuite_end ();
+	
+	testsuite_start ("imap bodystructure");
+	test_bodystructure ();
+	testsuite_end ();
+	
+	testsuite_start ("frozen messages");
+	test_frozen_message ();
+	test_frozen_message_save ();
+	testsuite_end ();
+	
+	testsuite_start ("serializing to memory");
+	test_write_to_buffer ();
+	test_parallel_encode ();
+	testsuite_end ();
+	
+	testsuite_start ("content fingerprints");
+	test_fingerprint ();
+	testsuite_end ();
+	
+	testsuite_start ("parser and stream statistics");
+	test_stats ();
+	testsuite_end ();
+	
+	testsuite_start ("push parser");
+	test_feed ();
+	testsuite_end ();
+	
+	testsuite_start ("async parse and write");
+	test_async ();
+	testsuite_end ();
+	
 	g_mime_parser_options_free (options);
 	
 	g_mime_shutdown ();
@@ -433,6 +433,344 @@ test_multipart_encrypted (GMimeCryptoContext *ctx, gboolean sign,
 	return ret;
 }
 
+#define LARGE_ENCRYPTED_CONTENT "This is a test of large multipart/encrypted.\n"
+
+/* must match the threshold used by GMIME_DECRYPT_SPILL_TO_DISK */
+#define SPILL_THRESHOLD (1024 * 1024)
+
+static GMimeStream *
+random_stream_new (size_t size)
+{
+	GMimeStream *stream;
+	GByteArray *array;
+	GRand *rand;
+	size_t i;
+	
+	/* random data does not compress, so the ciphertext stays large */
+	rand = g_rand_new_with_seed (size);
+	array = g_byte_array_sized_new (size);
+	g_byte_array_set_size (array, size);
+	
+	for (i = 0; i < size; i++)
+		array->data[i] = (unsigned char) g_rand_int_range (rand, 0, 256);
+	
+	g_rand_free (rand);
+	
+	stream = g_mime_stream_mem_new_with_byte_array (array);
+	
+	return stream;
+}
+
+static void
+wrap_encrypted_message (GMimeObject *body, GMimeStream **stream_out)
+{
+	GMimeFormatOptions *format = g_mime_format_options_get_default ();
+	InternetAddressList *list;
+	InternetAddress *mailbox;
+	GMimeMessage *message;
+	GMimeStream *stream;
+	
+	message = g_mime_message_new (TRUE);
+	
+	mailbox = internet_address_mailbox_new ("Jeffrey Stedfast", "fejj@helixcode.com");
+	list = g_mime_message_get_from (message);
+	internet_address_list_add (list, mailbox);
+	g_object_unref (mailbox);
+	
+	g_mime_message_set_subject (message, "This is a large test message", NULL);
+	g_mime_message_set_mime_part (message, body);
+	
+	stream = g_mime_stream_mem_new ();
+	g_mime_object_write_to_stream ((GMimeObject *) message, format, stream);
+	g_mime_stream_reset (stream);
+	g_object_unref (message);
+	
+	*stream_out = stream;
+}
+
+static void
+create_large_encrypted_message (GMimeCryptoContext *ctx, size_t size, GMimeContentEncoding encoding,
+				GMimeStream **cleartext_out, GMimeStream **stream_out)
+{
+	GMimeFormatOptions *format = g_mime_format_options_get_default ();
+	GMimeStream *cleartext, *stream;
+	GMimeMultipartEncrypted *mpe;
+	GMimeDataWrapper *content;
+	GMimeMultipart *multipart;
+	GMimeObject *encrypted;
+	GPtrArray *recipients;
+	GMimeTextPart *text;
+	Exception *ex = NULL;
+	GError *err = NULL;
+	GMimePart *part;
+	
+	multipart = g_mime_multipart_new ();
+	
+	text = g_mime_text_part_new ();
+	g_mime_text_part_set_text (text, LARGE_ENCRYPTED_CONTENT);
+	g_mime_multipart_add (multipart, (GMimeObject *) text);
+	g_object_unref (text);
+	
+	stream = random_stream_new (size);
+	content = g_mime_data_wrapper_new_with_stream (stream, GMIME_CONTENT_ENCODING_DEFAULT);
+	g_object_unref (stream);
+	
+	part = g_mime_part_new_with_type ("application", "octet-stream");
+	g_mime_part_set_content (part, content);
+	g_mime_part_set_content_encoding (part, GMIME_CONTENT_ENCODING_BASE64);
+	g_mime_multipart_add (multipart, (GMimeObject *) part);
+	g_object_unref (content);
+	g_object_unref (part);
+	
+	/* hold onto this for comparison later */
+	cleartext = g_mime_stream_mem_new ();
+	g_mime_object_write_to_stream ((GMimeObject *) multipart, format, cleartext);
+	g_mime_stream_reset (cleartext);
+	
+	recipients = g_ptr_array_new ();
+	g_ptr_array_add (recipients, "no.user@no.domain");
+	mpe = g_mime_multipart_encrypted_encrypt (ctx, (GMimeObject *) multipart, FALSE, NULL,
+						  GMIME_ENCRYPT_ALWAYS_TRUST, recipients, &err);
+	g_ptr_array_free (recipients, TRUE);
+	g_object_unref (multipart);
+	
+	if (err != NULL) {
+		ex = exception_new ("encryption failed: %s", err->message);
+		g_object_unref (cleartext);
+		g_error_free (err);
+		throw (ex);
+	}
+	
+	/* the ciphertext is armored, so it is 7bit unless told otherwise */
+	encrypted = g_mime_multipart_get_part ((GMimeMultipart *) mpe, GMIME_MULTIPART_ENCRYPTED_CONTENT);
+	g_mime_part_set_content_encoding ((GMimePart *) encrypted, encoding);
+	
+	wrap_encrypted_message ((GMimeObject *) mpe, stream_out);
+	g_object_unref (mpe);
+	
+	*cleartext_out = cleartext;
+}
+
+static GMimeMultipartEncrypted *
+parse_encrypted_message (GMimeStream *stream, GMimeMessage **message_out)
+{
+	GMimeMessage *message;
+	GMimeParser *parser;
+	
+	g_mime_stream_reset (stream);
+	
+	parser = g_mime_parser_new ();
+	g_mime_parser_init_with_stream (parser, stream);
+	message = g_mime_parser_construct_message (parser, NULL);
+	g_object_unref (parser);
+	
+	if (!GMIME_IS_MULTIPART_ENCRYPTED (message->mime_part)) {
+		g_object_unref (message);
+		throw (exception_new ("resultant top-level mime part not a multipart/encrypted?"));
+	}
+	
+	*message_out = message;
+	
+	return (GMimeMultipartEncrypted *) message->mime_part;
+}
+
+static gboolean
+part_is_on_disk (GMimeObject *object)
+{
+	GMimeDataWrapper *content = g_mime_part_get_content ((GMimePart *) object);
+	
+	return GMIME_IS_STREAM_FS (g_mime_data_wrapper_get_stream (content));
+}
+
+static void
+test_decrypt_spill (GMimeCryptoContext *ctx, size_t size, GMimeContentEncoding encoding)
+{
+	GMimeFormatOptions *format = g_mime_format_options_get_default ();
+	GMimeStream *cleartext, *stream, *test_stream;
+	gboolean spill = size > SPILL_THRESHOLD;
+	GMimeMultipartEncrypted *mpe;
+	GMimeObject *decrypted, *leaf;
+	GMimeMessage *message;
+	GByteArray *buf[2];
+	Exception *ex = NULL;
+	GError *err = NULL;
+	
+	create_large_encrypted_message (ctx, size, encoding, &cleartext, &stream);
+	mpe = parse_encrypted_message (stream, &message);
+	g_object_unref (stream);
+	
+	if (!(decrypted = g_mime_multipart_encrypted_decrypt (mpe, GMIME_DECRYPT_SPILL_TO_DISK, NULL, NULL, &err))) {
+		ex = exception_new ("decryption failed: %s", err->message);
+		g_object_unref (cleartext);
+		g_object_unref (message);
+		g_error_free (err);
+		throw (ex);
+	}
+	
+	if (!GMIME_IS_MULTIPART (decrypted) || g_mime_multipart_get_count ((GMimeMultipart *) decrypted) != 2) {
+		ex = exception_new ("decrypted part is not the expected multipart");
+	} else {
+		leaf = g_mime_multipart_get_part ((GMimeMultipart *) decrypted, 0);
+		if (part_is_on_disk (leaf))
+			ex = exception_new ("small leaf part was left on disk");
+		
+		leaf = g_mime_multipart_get_part ((GMimeMultipart *) decrypted, 1);
+		if (ex == NULL && part_is_on_disk (leaf) != spill)
+			ex = exception_new (spill ? "large leaf part was loaded into memory" : "leaf part was spilled to disk");
+	}
+	
+	if (ex == NULL) {
+		test_stream = g_mime_stream_mem_new ();
+		g_mime_object_write_to_stream (decrypted, format, test_stream);
+		
+		buf[0] = g_mime_stream_mem_get_byte_array ((GMimeStreamMem *) cleartext);
+		buf[1] = g_mime_stream_mem_get_byte_array ((GMimeStreamMem *) test_stream);
+		
+		if (buf[0]->len != buf[1]->len || memcmp (buf[0]->data, buf[1]->data, buf[0]->len) != 0)
+			ex = exception_new ("decrypted data does not match original cleartext");
+		
+		g_object_unref (test_stream);
+	}
+	
+	g_object_unref (decrypted);
+	
+	if (ex == NULL && spill) {
+		/* without the flag, nothing may be written to disk */
+		if (!(decrypted = g_mime_multipart_encrypted_decrypt (mpe, GMIME_DECRYPT_NONE, NULL, NULL, &err))) {
+			ex = exception_new ("decryption without spilling failed: %s", err->message);
+			g_error_free (err);
+		} else {
+			leaf = g_mime_multipart_get_part ((GMimeMultipart *) decrypted, 1);
+			if (part_is_on_disk (leaf))
+				ex = exception_new ("leaf part was spilled to disk without GMIME_DECRYPT_SPILL_TO_DISK");
+			
+			g_object_unref (decrypted);
+		}
+	}
+	
+	g_object_unref (cleartext);
+	g_object_unref (message);
+	
+	if (ex != NULL)
+		throw (ex);
+}
+
+static int
+count_temp_files (void)
+{
+	const char *name;
+	int count = 0;
+	GDir *dir;
+	
+	if (!(dir = g_dir_open (g_get_tmp_dir (), 0, NULL)))
+		return -1;
+	
+	while ((name = g_dir_read_name (dir))) {
+		if (!strncmp (name, "gmime-", 6))
+			count++;
+	}
+	
+	g_dir_close (dir);
+	
+	return count;
+}
+
+static int
+count_open_fds (void)
+{
+	int count = 0;
+	GDir *dir;
+	
+	if (!(dir = g_dir_open ("/proc/self/fd", 0, NULL)))
+		return -1;
+	
+	while (g_dir_read_name (dir))
+		count++;
+	
+	g_dir_close (dir);
+	
+	return count;
+}
+
+static void
+test_decrypt_spill_error (void)
+{
+	GMimeMultipartEncrypted *mpe;
+	GMimeStream *stream, *armor;
+	GMimeDataWrapper *content;
+	GMimeObject *decrypted;
+	int nfiles, nfds, i;
+	GMimeMessage *message;
+	Exception *ex = NULL;
+	GError *err = NULL;
+	GMimePart *part;
+	GRand *rand;
+	char c;
+	
+	/* bogus ciphertext that is large enough to be spilled to disk */
+	rand = g_rand_new_with_seed (4880);
+	armor = g_mime_stream_mem_new ();
+	g_mime_stream_write_string (armor, "-----BEGIN PGP MESSAGE-----\n\n");
+	for (i = 0; i < 2 * SPILL_THRESHOLD; i++) {
+		c = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[g_rand_int_range (rand, 0, 64)];
+		g_mime_stream_write (armor, &c, 1);
+		if ((i % 64) == 63)
+			g_mime_stream_write (armor, "\n", 1);
+	}
+	g_mime_stream_write_string (armor, "\n-----END PGP MESSAGE-----\n");
+	g_mime_stream_reset (armor);
+	g_rand_free (rand);
+	
+	mpe = g_mime_multipart_encrypted_new ();
+	g_mime_object_set_content_type_parameter ((GMimeObject *) mpe, "protocol", "application/pgp-encrypted");
+	
+	part = g_mime_part_new_with_type ("application", "pgp-encrypted");
+	stream = g_mime_stream_mem_new ();
+	g_mime_stream_write_string (stream, "Version: 1\n");
+	g_mime_stream_reset (stream);
+	content = g_mime_data_wrapper_new_with_stream (stream, GMIME_CONTENT_ENCODING_DEFAULT);
+	g_mime_part_set_content (part, content);
+	g_mime_multipart_add ((GMimeMultipart *) mpe, (GMimeObject *) part);
+	g_object_unref (content);
+	g_object_unref (stream);
+	g_object_unref (part);
+	
+	part = g_mime_part_new_with_type ("application", "octet-stream");
+	content = g_mime_data_wrapper_new_with_stream (armor, GMIME_CONTENT_ENCODING_DEFAULT);
+	g_mime_part_set_content (part, content);
+	g_mime_part_set_content_encoding (part, GMIME_CONTENT_ENCODING_BASE64);
+	g_mime_multipart_add ((GMimeMultipart *) mpe, (GMimeObject *) part);
+	g_object_unref (content);
+	g_object_unref (armor);
+	g_object_unref (part);
+	
+	wrap_encrypted_message ((GMimeObject *) mpe, &stream);
+	g_object_unref (mpe);
+	
+	mpe = parse_encrypted_message (stream, &message);
+	g_object_unref (stream);
+	
+	nfiles = count_temp_files ();
+	nfds = count_open_fds ();
+	
+	if ((decrypted = g_mime_multipart_encrypted_decrypt (mpe, GMIME_DECRYPT_SPILL_TO_DISK, NULL, NULL, &err))) {
+		ex = exception_new ("bogus ciphertext was decrypted");
+		g_object_unref (decrypted);
+	} else {
+		g_clear_error (&err);
+		
+		if (count_temp_files () != nfiles)
+			ex = exception_new ("temporary files were left behind");
+		else if (count_open_fds () != nfds)
+			ex = exception_new ("file descriptors were leaked");
+	}
+	
+	g_object_unref (message);
+	
+	if (ex != NULL)
+		throw (ex);
+}
+
 static void
 import_key (GMimeCryptoContext *ctx, const char *path)
 {
@@ -719,6 +1057,32 @@ int main (int argc, char *argv[])
 	
 	g_free (session_key);
 	
+	testsuite_check ("multipart/encrypted below the spill threshold");
+	try {
+		test_decrypt_spill (ctx, 64 * 1024, GMIME_CONTENT_ENCODING_7BIT);
+		test_decrypt_spill (ctx, 64 * 1024, GMIME_CONTENT_ENCODING_BASE64);
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("multipart/encrypted below the spill threshold failed: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("multipart/encrypted above the spill threshold");
+	try {
+		test_decrypt_spill (ctx, 3 * SPILL_THRESHOLD / 2, GMIME_CONTENT_ENCODING_7BIT);
+		test_decrypt_spill (ctx, 3 * SPILL_THRESHOLD / 2, GMIME_CONTENT_ENCODING_BASE64);
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("multipart/encrypted above the spill threshold failed: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("multipart/encrypted spill cleanup on error");
+	try {
+		test_decrypt_spill_error ();
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("multipart/encrypted spill cleanup on error failed: %s", ex->message);
+	} finally;
+	
 	testsuite_check ("rfc4880 sign");
 	try {
 		test_openpgp_sign ();
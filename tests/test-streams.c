@@ -463,6 +463,42 @@ check_stream_buffer (const char *input, const char *output, const char *filename
 	return TRUE;
 }
 
+static gboolean
+check_stream_chunked (const char *input, const char *output, const char *filename, gint64 start, gint64 end)
+{
+	GMimeStream *streams[2], *stream;
+	Exception *ex = NULL;
+	int fd[2];
+	
+	if ((fd[0] = open (input, O_RDONLY, 0)) == -1)
+		return FALSE;
+	
+	if ((fd[1] = open (output, O_RDONLY, 0)) == -1) {
+		close (fd[0]);
+		return FALSE;
+	}
+	
+	streams[0] = g_mime_stream_fs_new (fd[0]);
+	stream = g_mime_stream_chunked_new ();
+	g_mime_stream_write_to_stream (streams[0], stream);
+	g_object_unref (streams[0]);
+	streams[0] = g_mime_stream_substream (stream, start, end);
+	g_object_unref (stream);
+	
+	streams[1] = g_mime_stream_fs_new (fd[1]);
+	
+	if (!streams_match (streams, filename))
+		ex = exception_new ("GMimeStreamChunked streams did not match for `%s'", filename);
+	
+	g_object_unref (streams[0]);
+	g_object_unref (streams[1]);
+	
+	if (ex != NULL)
+		throw (ex);
+	
+	return TRUE;
+}
+
 static gboolean
 check_stream_gio (const char *input, const char *output, const char *filename, gint64 start, gint64 end)
 {
@@ -539,6 +575,7 @@ static struct {
 	{ "GMimeStreamMmap",   check_stream_mmap   },
 #endif /* HAVE_MMAP */
 	{ "GMimeStreamBuffer", check_stream_buffer },
+	{ "GMimeStreamChunked", check_stream_chunked },
 	{ "GMimeStreamGIO",    check_stream_gio    },
 };
 
@@ -600,6 +637,92 @@ test_streams (GDir *dir, const char *datadir, const char *filename)
 }
 
 
+static void
+test_stream_chunked (void)
+{
+	GMimeStream *stream, *substream;
+	char buf[4096], *data;
+	gint64 offset;
+	GBytes *bytes;
+	size_t i, n;
+	
+	/* large enough to span several chunks */
+	data = g_malloc (300000);
+	for (i = 0; i < 300000; i++)
+		data[i] = (char) (i % 251);
+	
+	stream = g_mime_stream_chunked_new ();
+	
+	testsuite_check ("GMimeStreamChunked::write()");
+	try {
+		/* odd-sized writes so that they straddle the chunk boundaries */
+		for (i = 0; i < 300000; i += n) {
+			n = MIN (300000 - i, 1021);
+			if (g_mime_stream_write (stream, data + i, n) != (ssize_t) n)
+				throw (exception_new ("short write at %" G_GSIZE_FORMAT, i));
+		}
+		
+		if (g_mime_stream_length (stream) != 300000)
+			throw (exception_new ("unexpected length: %" G_GINT64_FORMAT, g_mime_stream_length (stream)));
+		
+		bytes = g_mime_stream_chunked_get_bytes ((GMimeStreamChunked *) stream);
+		n = g_bytes_get_size (bytes);
+		i = n == 300000 ? memcmp (g_bytes_get_data (bytes, NULL), data, n) : 1;
+		g_bytes_unref (bytes);
+		
+		if (i != 0)
+			throw (exception_new ("contents do not match"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("GMimeStreamChunked::write() failed: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("GMimeStreamChunked::seek()");
+	try {
+		offset = 65536 - 7;
+		if (g_mime_stream_seek (stream, offset, GMIME_STREAM_SEEK_SET) != offset)
+			throw (exception_new ("seek failed"));
+		
+		if (g_mime_stream_read (stream, buf, 100) != 100 || memcmp (buf, data + offset, 100) != 0)
+			throw (exception_new ("read after seek does not match"));
+		
+		/* seeking past the end grows the stream with zeros */
+		if (g_mime_stream_seek (stream, 10, GMIME_STREAM_SEEK_END) != 300010)
+			throw (exception_new ("seek past the end failed"));
+		
+		g_mime_stream_seek (stream, 300000, GMIME_STREAM_SEEK_SET);
+		if (g_mime_stream_read (stream, buf, sizeof (buf)) != 10 || memcmp (buf, "\0\0\0\0\0\0\0\0\0\0", 10) != 0)
+			throw (exception_new ("stream was not grown with zeros"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("GMimeStreamChunked::seek() failed: %s", ex->message);
+	} finally;
+	
+	testsuite_check ("GMimeStreamChunked::substream()");
+	try {
+		substream = g_mime_stream_substream (stream, 131000, 140000);
+		
+		bytes = g_mime_stream_chunked_get_bytes ((GMimeStreamChunked *) substream);
+		n = g_bytes_get_size (bytes);
+		i = n == 9000 ? memcmp (g_bytes_get_data (bytes, NULL), data + 131000, n) : 1;
+		g_bytes_unref (bytes);
+		g_object_unref (substream);
+		
+		if (i != 0)
+			throw (exception_new ("substream contents do not match"));
+		
+		testsuite_check_passed ();
+	} catch (ex) {
+		testsuite_check_failed ("GMimeStreamChunked::substream() failed: %s", ex->message);
+	} finally;
+	
+	g_object_unref (stream);
+	g_free (data);
+}
+
+
 static size_t
 gen_random_stream (int randfd, GMimeStream *stream)
 {
@@ -731,6 +854,8 @@ int main (int argc, char **argv)
 	
 	testsuite_start ("Stream tests");
 	
+	test_stream_chunked ();
+	
 	p = g_stpcpy (path, datadir);
 	*p++ = G_DIR_SEPARATOR;
 	strcpy (p, "output");